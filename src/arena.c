@@ -0,0 +1,223 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "xalloc.h"
+
+// Allocations larger than a quarter chunk get a chunk of their own
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGN _Alignof(max_align_t)
+
+#define ALIGN_UP(n, align) (((n) + (align) - 1) & ~((align) - 1))
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	char *pos;
+	char *end;
+};
+
+struct arena {
+	// The first chunk is the one allocations are bumped from
+	struct arena_chunk *chunks;
+	size_t size;
+	// All chunks ordered by address, to find the owner of a pointer
+	// by binary search, see arena_owns()
+	struct arena_chunk **by_address;
+	size_t chunk_count;
+	size_t by_address_capacity;
+};
+
+static _Thread_local struct arena *active_arena = NULL;
+
+static char *chunk_data(struct arena_chunk *chunk)
+{
+	return (char *)chunk + ALIGN_UP(sizeof(struct arena_chunk), ARENA_ALIGN);
+}
+
+static struct arena_chunk *alloc_chunk(size_t data_size)
+{
+	const size_t header_size = ALIGN_UP(sizeof(struct arena_chunk), ARENA_ALIGN);
+	struct arena_chunk *chunk = xmalloc(header_size + data_size);
+
+	chunk->next = NULL;
+	chunk->pos = chunk_data(chunk);
+	chunk->end = chunk->pos + data_size;
+
+	return chunk;
+}
+
+// Insert a new chunk into the address index.  Only done once per chunk,
+// so the linear insertion is amortized over its allocations.
+static void index_chunk(struct arena *arena, struct arena_chunk *chunk)
+{
+	if (arena->chunk_count == arena->by_address_capacity) {
+		arena->by_address_capacity = arena->by_address_capacity ? 2 * arena->by_address_capacity : 8;
+		arena->by_address = xrealloc(arena->by_address,
+		                             arena->by_address_capacity * sizeof(struct arena_chunk *));
+	}
+
+	size_t i = arena->chunk_count;
+	while (i > 0 && (uintptr_t)arena->by_address[i - 1] > (uintptr_t)chunk) {
+		arena->by_address[i] = arena->by_address[i - 1];
+		i--;
+	}
+	arena->by_address[i] = chunk;
+	arena->chunk_count++;
+}
+
+struct arena *alloc_arena(void)
+{
+	struct arena *arena = xmalloc(sizeof(struct arena));
+
+	arena->chunks = NULL;
+	arena->size = 0;
+	arena->by_address = NULL;
+	arena->chunk_count = 0;
+	arena->by_address_capacity = 0;
+
+	return arena;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	size = ALIGN_UP(size ? size : 1, ARENA_ALIGN);
+
+	struct arena_chunk *chunk = arena->chunks;
+	if (chunk && (size_t)(chunk->end - chunk->pos) >= size) {
+		void *ret = chunk->pos;
+		chunk->pos += size;
+		return ret;
+	}
+
+	if (size > ARENA_CHUNK_SIZE / 4) {
+		// Keep bumping from the current chunk afterwards
+		struct arena_chunk *large = alloc_chunk(size);
+		arena->size += size;
+		index_chunk(arena, large);
+		if (chunk) {
+			large->next = chunk->next;
+			chunk->next = large;
+		} else {
+			arena->chunks = large;
+		}
+		large->pos = large->end;
+		return chunk_data(large);
+	}
+
+	chunk = alloc_chunk(ARENA_CHUNK_SIZE);
+	arena->size += ARENA_CHUNK_SIZE;
+	index_chunk(arena, chunk);
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+
+	void *ret = chunk->pos;
+	chunk->pos += size;
+	return ret;
+}
+
+void *arena_calloc(struct arena *arena, size_t size)
+{
+	void *ret = arena_alloc(arena, size);
+
+	memset(ret, 0, size);
+
+	return ret;
+}
+
+char *arena_strdup(struct arena *arena, const char *str)
+{
+	return arena_strndup(arena, str, strlen(str));
+}
+
+char *arena_strndup(struct arena *arena, const char *str, size_t len)
+{
+	const char *nul = memchr(str, '\0', len);
+	if (nul) {
+		len = (size_t)(nul - str);
+	}
+
+	char *ret = arena_alloc(arena, len + 1);
+	memcpy(ret, str, len);
+	ret[len] = '\0';
+
+	return ret;
+}
+
+static int chunk_contains(const struct arena_chunk *chunk, uintptr_t addr)
+{
+	return addr >= (uintptr_t)chunk && addr < (uintptr_t)chunk->end;
+}
+
+int arena_owns(const struct arena *arena, const void *ptr)
+{
+	const uintptr_t addr = (uintptr_t)ptr;
+
+	// Memory freed while parsing was mostly just bumped
+	if (arena->chunks && chunk_contains(arena->chunks, addr)) {
+		return 1;
+	}
+
+	// Find the last chunk starting at or below addr
+	size_t low = 0;
+	size_t high = arena->chunk_count;
+	while (low < high) {
+		const size_t mid = low + (high - low) / 2;
+		if ((uintptr_t)arena->by_address[mid] <= addr) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low > 0 && chunk_contains(arena->by_address[low - 1], addr);
+}
+
+size_t arena_size(const struct arena *arena)
+{
+	return arena->size;
+}
+
+void free_arena(struct arena *arena)
+{
+	if (!arena) {
+		return;
+	}
+
+	struct arena_chunk *chunk = arena->chunks;
+	while (chunk) {
+		struct arena_chunk *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+
+	free(arena->by_address);
+	free(arena);
+}
+
+void set_active_arena(struct arena *arena)
+{
+	active_arena = arena;
+}
+
+struct arena *get_active_arena(void)
+{
+	return active_arena;
+}
@@ -0,0 +1,62 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// A bump allocator owning memory which is only released all at once
+struct arena;
+
+struct arena *alloc_arena(void);
+
+/**********************************
+* Allocate size bytes, suitably aligned for any type, from the arena.
+* The memory is released by free_arena() and must not be passed to free().
+**********************************/
+void *arena_alloc(struct arena *arena, size_t size);
+
+void *arena_calloc(struct arena *arena, size_t size);
+
+char *arena_strdup(struct arena *arena, const char *str);
+
+char *arena_strndup(struct arena *arena, const char *str, size_t len);
+
+/**********************************
+* Return 1 if ptr points into memory allocated from the arena,
+* and 0 otherwise.
+* Takes constant time for the chunk being bumped from, and logarithmic
+* time in the number of chunks otherwise.
+**********************************/
+int arena_owns(const struct arena *arena, const void *ptr);
+
+// Return the number of bytes reserved by the arena
+size_t arena_size(const struct arena *arena);
+
+void free_arena(struct arena *arena);
+
+/**********************************
+* Set the arena policy trees are allocated from in the calling thread,
+* or NULL to allocate them from the heap.
+* Reset it before freeing the arena.
+**********************************/
+void set_active_arena(struct arena *arena);
+
+struct arena *get_active_arena(void);
+
+#endif
@@ -0,0 +1,220 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include "call_graph.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "intern.h"
+#include "tree.h"
+#include "util.h"
+#include "xalloc.h"
+
+no_sanitize_unsigned_integer_
+static struct call_graph_node *get_node(struct call_graph *graph, const char *if_name)
+{
+	const char *atom = intern(if_name);
+	struct call_graph_node *node;
+
+	HASH_FIND_PTR(graph->nodes, &atom, node);
+	if (!node) {
+		node = xcalloc(1, sizeof(struct call_graph_node));
+		node->name = atom;
+		HASH_ADD_PTR(graph->nodes, name, node);
+	}
+
+	return node;
+}
+
+static void add_edge(struct call_graph_edge **edges, struct call_graph_node *node,
+                     const struct policy_node *def)
+{
+	struct call_graph_edge *edge = xmalloc(sizeof(struct call_graph_edge));
+
+	edge->node = node;
+	edge->def = def;
+	edge->next = *edges;
+	*edges = edge;
+}
+
+// Remove the edge added for def, and return the node it leads to
+static struct call_graph_node *remove_edge(struct call_graph_edge **edges,
+                                           const struct policy_node *def)
+{
+	for (struct call_graph_edge **cur = edges; *cur; cur = &(*cur)->next) {
+		struct call_graph_edge *edge = *cur;
+		if (edge->def == def) {
+			struct call_graph_node *node = edge->node;
+			*cur = edge->next;
+			free(edge);
+			return node;
+		}
+	}
+
+	return NULL;
+}
+
+static void free_edges(struct call_graph_edge *edge)
+{
+	while (edge) {
+		struct call_graph_edge *next = edge->next;
+		free(edge);
+		edge = next;
+	}
+}
+
+// Drop nodes which neither call nor are called first anymore
+static void remove_if_unused(struct call_graph *graph, struct call_graph_node *node)
+{
+	if (!node->first_calls && !node->callers) {
+		HASH_DEL(graph->nodes, node);
+		free(node);
+	}
+}
+
+// The first statement of the interface definition, besides require blocks
+static const struct policy_node *first_statement(const struct policy_node *def)
+{
+	const struct policy_node *child = def->first_child;
+
+	while (child &&
+	       (child->flavor == NODE_START_BLOCK ||
+	        child->flavor == NODE_REQUIRE ||
+	        child->flavor == NODE_GEN_REQ)) {
+		child = child->next;
+	}
+
+	return child;
+}
+
+// The interface called by the first statement of the interface
+// definition, or NULL
+static const char *first_call(const struct policy_node *def)
+{
+	const struct policy_node *first = first_statement(def);
+
+	if (!first || first->flavor != NODE_IF_CALL) {
+		return NULL;
+	}
+
+	return first->data.ic_data->name;
+}
+
+void add_file_to_call_graph(struct call_graph *graph, const struct policy_file *file)
+{
+	for (const struct policy_node *cur = file->ast; cur; cur = dfs_next(cur)) {
+		if (cur->flavor != NODE_INTERFACE_DEF) {
+			continue;
+		}
+
+		const char *called_name = first_call(cur);
+		if (!called_name) {
+			continue;
+		}
+
+		struct call_graph_node *caller = get_node(graph, cur->data.str);
+		struct call_graph_node *called = get_node(graph, called_name);
+
+		add_edge(&caller->first_calls, called, cur);
+		add_edge(&called->callers, caller, cur);
+	}
+}
+
+no_sanitize_unsigned_integer_
+void remove_file_from_call_graph(struct call_graph *graph, const struct policy_file *file)
+{
+	for (const struct policy_node *cur = file->ast; cur; cur = dfs_next(cur)) {
+		if (cur->flavor != NODE_INTERFACE_DEF || !first_call(cur)) {
+			continue;
+		}
+
+		const char *atom = find_atom(cur->data.str);
+		struct call_graph_node *caller = NULL;
+		if (atom) {
+			HASH_FIND_PTR(graph->nodes, &atom, caller);
+		}
+		if (!caller) {
+			continue;
+		}
+
+		struct call_graph_node *called = remove_edge(&caller->first_calls, cur);
+		if (called) {
+			remove_edge(&called->callers, cur);
+			remove_if_unused(graph, called);
+		}
+		// An interface calling itself first was dropped already
+		if (called != caller) {
+			remove_if_unused(graph, caller);
+		}
+	}
+}
+
+struct call_graph *build_call_graph(const struct policy_file_list *files)
+{
+	struct call_graph *graph = xcalloc(1, sizeof(struct call_graph));
+
+	for (const struct policy_file_node *file = files->head; file; file = file->next) {
+		add_file_to_call_graph(graph, file->file);
+	}
+
+	return graph;
+}
+
+void propagate_to_callers(const struct call_graph *graph,
+                          int (*is_marked)(const char *if_name),
+                          void (*mark)(const char *if_name))
+{
+	const unsigned int count = HASH_COUNT(graph->nodes);
+	const struct call_graph_node **worklist = xmalloc((count + 1) * sizeof(struct call_graph_node *));
+	unsigned int pending = 0;
+
+	// Each node is pushed at most once: when it is found marked at first,
+	// or when it gets marked
+	for (const struct call_graph_node *node = graph->nodes; node; node = node->hh.next) {
+		if (is_marked(node->name)) {
+			worklist[pending++] = node;
+		}
+	}
+
+	while (pending > 0) {
+		const struct call_graph_node *node = worklist[--pending];
+
+		for (const struct call_graph_edge *edge = node->callers; edge; edge = edge->next) {
+			if (!is_marked(edge->node->name)) {
+				mark(edge->node->name);
+				worklist[pending++] = edge->node;
+			}
+		}
+	}
+
+	free(worklist);
+}
+
+void free_call_graph(struct call_graph *graph)
+{
+	struct call_graph_node *node, *tmp;
+
+	HASH_ITER(hh, graph->nodes, node, tmp) {
+		HASH_DEL(graph->nodes, node);
+		free_edges(node->first_calls);
+		free_edges(node->callers);
+		free(node);
+	}
+
+	free(graph);
+}
@@ -0,0 +1,74 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#ifndef CALL_GRAPH_H
+#define CALL_GRAPH_H
+
+#include <uthash.h>
+
+#include "file_list.h"
+
+/**********************************
+* The graph of the first calls of interfaces: an interface calls another one
+* first if the interface call is the first statement of its definition,
+* besides require blocks.  Such an interface mostly delegates to the one
+* called, and inherits some of its properties, e.g. being a transform
+* interface.
+**********************************/
+
+struct call_graph_edge {
+	struct call_graph_node *node;
+	const struct policy_node *def;          // the definition calling first
+	struct call_graph_edge *next;
+};
+
+struct call_graph_node {
+	const char *name;                       // an atom
+	struct call_graph_edge *first_calls;    // one per definition calling another interface first
+	struct call_graph_edge *callers;        // the interfaces calling this one first
+	UT_hash_handle hh;
+};
+
+struct call_graph {
+	struct call_graph_node *nodes;
+};
+
+// Build the graph from the interface definitions in the files
+struct call_graph *build_call_graph(const struct policy_file_list *files);
+
+/**********************************
+* Add the first calls of the interface definitions in the file to the
+* graph, or remove them again, e.g. when the file changes.  Remove them
+* before the AST of the file is freed, as the edges refer to it.
+**********************************/
+void add_file_to_call_graph(struct call_graph *graph, const struct policy_file *file);
+void remove_file_from_call_graph(struct call_graph *graph, const struct policy_file *file);
+
+/**********************************
+* Mark all interfaces which call a marked interface first, directly or
+* through other interfaces, in a single pass over the graph.
+* graph - the call graph
+* is_marked - whether an interface is marked, e.g. is_transform_if()
+* mark - mark an interface, e.g. mark_transform_if()
+**********************************/
+void propagate_to_callers(const struct call_graph *graph,
+                          int (*is_marked)(const char *if_name),
+                          void (*mark)(const char *if_name));
+
+void free_call_graph(struct call_graph *graph);
+
+#endif
@@ -15,10 +15,13 @@
 */
 
 #define _GNU_SOURCE
+#include <ctype.h>
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "check_hooks.h"
 #include "color.h"
@@ -28,63 +31,294 @@ int found_issue = 0;
 int suppress_output = 0;
 int full_path = 0;
 
+static _Thread_local FILE *result_stream = NULL;
+static _Thread_local unsigned int *issue_counts = NULL;
+static _Thread_local struct check_profile *check_profiles = NULL;
+static _Thread_local struct pending_note *pending_notes = NULL;
+
+// Each known check has a bit in the disabled_checks of nodes.  The bits of
+// the checks of a severity follow each other in the order of their number.
+enum check_bit_bases {
+	X_BIT_BASE = 0,
+	C_BIT_BASE = X_BIT_BASE + X_END - 1,
+	S_BIT_BASE = C_BIT_BASE + C_END - 1,
+	W_BIT_BASE = S_BIT_BASE + S_END - 1,
+	E_BIT_BASE = W_BIT_BASE + W_END - 1,
+	F_BIT_BASE = E_BIT_BASE + E_END - 1,
+	CHECK_BIT_COUNT = F_BIT_BASE + F_ID_INTERNAL
+};
+
+_Static_assert(CHECK_BIT_COUNT <= 64, "check IDs do not fit into disabled_checks");
+
+// Set the first bit and the number of bits of the checks of a severity.
+// Returns false if the severity is not known.
+static bool severity_bit_range(char severity, unsigned int *base, unsigned int *count)
+{
+	switch (severity) {
+	case 'X':
+		*base = X_BIT_BASE;
+		*count = X_END - 1;
+		break;
+	case 'C':
+		*base = C_BIT_BASE;
+		*count = C_END - 1;
+		break;
+	case 'S':
+		*base = S_BIT_BASE;
+		*count = S_END - 1;
+		break;
+	case 'W':
+		*base = W_BIT_BASE;
+		*count = W_END - 1;
+		break;
+	case 'E':
+		*base = E_BIT_BASE;
+		*count = E_END - 1;
+		break;
+	case 'F':
+		*base = F_BIT_BASE;
+		*count = F_ID_INTERNAL;
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t check_bit(char severity, unsigned int id)
+{
+	unsigned int base;
+	unsigned int count;
+
+	if (!severity_bit_range(severity, &base, &count) || id == 0 || id > count) {
+		return 0;
+	}
+
+	return UINT64_C(1) << (base + id - 1);
+}
+
+uint64_t severity_check_bits(char severity)
+{
+	unsigned int base;
+	unsigned int count;
+
+	if (!severity_bit_range(severity, &base, &count)) {
+		return 0;
+	}
+
+	return ((UINT64_C(1) << count) - 1) << base;
+}
+
+// Return the bit of the check ID of len characters at str.  Only IDs
+// written like in display_check_result() are known.
+static uint64_t check_token_bit(const char *str, size_t len)
+{
+	if (len != 5 || str[1] != '-' ||
+	    !isdigit((unsigned char)str[2]) ||
+	    !isdigit((unsigned char)str[3]) ||
+	    !isdigit((unsigned char)str[4])) {
+		return 0;
+	}
+
+	const unsigned int id = (unsigned)(str[2] - '0') * 100 +
+	                        (unsigned)(str[3] - '0') * 10 +
+	                        (unsigned)(str[4] - '0');
+
+	return check_bit(str[0], id);
+}
+
+uint64_t check_id_bit(const char *check_id)
+{
+	return check_token_bit(check_id, strlen(check_id));
+}
+
+// Return the next check ID in a comma separated list and set len to its
+// length, or return NULL at the end of the list
+static const char *next_check_token(const char *list, size_t *len)
+{
+	list += strspn(list, ", \t\r\n");
+	if (*list == '\0') {
+		return NULL;
+	}
+
+	*len = strcspn(list, ", \t\r\n");
+	return list;
+}
+
+uint64_t parse_disabled_checks(const char *list)
+{
+	uint64_t bits = 0;
+	size_t len;
+
+	if (!list) {
+		return 0;
+	}
+
+	for (const char *tok = next_check_token(list, &len); tok; tok = next_check_token(tok + len, &len)) {
+		bits |= check_token_bit(tok, len);
+	}
+
+	return bits;
+}
+
+// Whether the check is disabled for the node.  Checks without a bit,
+// which are not known check IDs, are looked up in the comment itself.
+static bool is_check_disabled(const struct check_node *check, const struct policy_node *node)
+{
+	if (check->disable_bit) {
+		return (node->disabled_checks & check->disable_bit) != 0;
+	}
+
+	if (!node->exceptions) {
+		return false;
+	}
+
+	const size_t id_len = strlen(check->check_id);
+	size_t len;
+	for (const char *tok = next_check_token(node->exceptions, &len); tok; tok = next_check_token(tok + len, &len)) {
+		if (len == id_len && 0 == strncmp(tok, check->check_id, len)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Append a check to the checks of a node flavor, and return it
+static struct check_node *append_check_node(struct checks *ck, enum node_flavor check_flavor)
+{
+	const unsigned int count = ck->check_counts[check_flavor];
+
+	// Grow the array whenever the count reaches a power of two
+	if ((count & (count - 1)) == 0) {
+		ck->check_nodes[check_flavor] = xrealloc(ck->check_nodes[check_flavor],
+		                                         (count ? count * 2 : 1) * sizeof(struct check_node));
+	}
+
+	ck->check_counts[check_flavor] = count + 1;
+
+	return &ck->check_nodes[check_flavor][count];
+}
+
+enum selint_error add_file_check(enum node_flavor check_flavor,
+                                 unsigned int file_flavors,
+                                 struct checks *ck,
+                                 const char *check_id,
+                                 struct check_result *(*check_function)(const struct check_data *check_data,
+                                                                        const struct policy_node *node))
+{
+	struct check_node *loc = append_check_node(ck, check_flavor);
+
+	loc->check_function = check_function;
+	loc->check_id = check_id;
+	loc->disable_bit = check_id_bit(check_id);
+	loc->file_flavors = file_flavors;
+	loc->issues_found = 0;
+	loc->index = ck->check_node_count++;
+
+	return SELINT_SUCCESS;
+}
+
 enum selint_error add_check(enum node_flavor check_flavor, struct checks *ck,
                             const char *check_id,
                             struct check_result *(*check_function)(const struct check_data *check_data,
                                                                    const struct policy_node *node))
 {
-	struct check_node *loc;
+	return add_file_check(check_flavor, ALL_FILE_FLAVORS, ck, check_id, check_function);
+}
+
+struct checks *select_file_checks(const struct checks *ck, enum file_flavor flavor)
+{
+	struct checks *selected = xcalloc(1, sizeof(struct checks));
 
-	if (ck->check_nodes[check_flavor]) {
-		loc = ck->check_nodes[check_flavor];
-		while (loc->next) {
-			loc = loc->next;
+	for (int i = 0; i <= NODE_ERROR; i++) {
+		for (unsigned int j = 0; j < ck->check_counts[i]; j++) {
+			const struct check_node *cur = &ck->check_nodes[i][j];
+			if (cur->file_flavors & FILE_FLAVOR_BIT(flavor)) {
+				*append_check_node(selected, (enum node_flavor)i) = *cur;
+			}
 		}
-		loc->next = xmalloc(sizeof(struct check_node));
-		loc = loc->next;
-	} else {
-		ck->check_nodes[check_flavor] = xmalloc(sizeof(struct check_node));
-		loc = ck->check_nodes[check_flavor];
 	}
 
-	loc->check_function = check_function;
-	loc->check_id = xstrdup(check_id);
-	loc->issues_found = 0;
-	loc->next = NULL;
+	// The indexes are the ones of ck
+	selected->check_node_count = ck->check_node_count;
 
-	return SELINT_SUCCESS;
+	return selected;
 }
 
 enum selint_error call_checks(struct checks *ck,
                               const struct check_data *data,
                               const struct policy_node *node)
 {
-	return call_checks_for_node_type(ck->check_nodes[node->flavor], data, node);
+	return call_checks_for_node_type(ck->check_nodes[node->flavor],
+	                                 ck->check_counts[node->flavor],
+	                                 data, node);
+}
+
+static uint64_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+	return (uint64_t)(end->tv_sec - start->tv_sec) * 1000000000 +
+	       (uint64_t)end->tv_nsec - (uint64_t)start->tv_nsec;
 }
 
-enum selint_error call_checks_for_node_type(struct check_node *ck_list,
+// Call a check and record what it cost in its profile
+static struct check_result *call_profiled_check(const struct check_node *check,
+                                                const struct check_data *data,
+                                                const struct policy_node *node)
+{
+	struct check_profile *profile = &check_profiles[check->index];
+	const size_t allocated = xalloc_counted_bytes;
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	struct check_result *res = check->check_function(data, node);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	const uint64_t ns = elapsed_ns(&start, &end);
+	profile->calls++;
+	profile->total_ns += ns;
+	if (ns > profile->max_ns) {
+		profile->max_ns = ns;
+	}
+	if (res) {
+		profile->findings++;
+	}
+	profile->alloc_bytes += xalloc_counted_bytes - allocated;
+
+	return res;
+}
+
+enum selint_error call_checks_for_node_type(struct check_node *checks,
+                                            unsigned int count,
                                             const struct check_data *data,
                                             const struct policy_node *node)
 {
+	for (unsigned int i = 0; i < count; i++) {
+		struct check_node *cur = &checks[i];
 
-	struct check_node *cur = ck_list;
-
-	while (cur) {
-		if (node->exceptions && strstr(node->exceptions, cur->check_id)) {
-			cur = cur->next;
+		if (is_check_disabled(cur, node)) {
 			continue;
 		}
-		struct check_result *res = cur->check_function(data, node);
+		struct check_result *res;
+		if (check_profiles) {
+			res = call_profiled_check(cur, data, node);
+		} else {
+			res = cur->check_function(data, node);
+		}
 		if (res) {
-			found_issue = 1;
-			cur->issues_found++;
+			if (issue_counts) {
+				issue_counts[cur->index]++;
+			} else {
+				found_issue = 1;
+				cur->issues_found++;
+			}
 			res->lineno = node->lineno;
 			if (!suppress_output) {
 				display_check_result(res, data);
 			}
 			free_check_result(res);
 		}
-		cur = cur->next;
 	}
 	return SELINT_SUCCESS;
 }
@@ -109,14 +343,163 @@ void display_check_result(const struct check_result *res, const struct check_dat
 		}
 	}
 
-	printf("%s:%*u: %s(%c)%s: %s (%c-%03u)\n",
-	       name,
-	       padding,
-	       res->lineno,
-	       color_severity(res->severity),
-	       res->severity,
-	       color_reset(),
-	       res->message, res->severity, res->check_id);
+	fprintf(get_result_stream(),
+	        "%s:%*u: %s(%c)%s: %s (%c-%03u)\n",
+	        name,
+	        padding,
+	        res->lineno,
+	        color_severity(res->severity),
+	        res->severity,
+	        color_reset(),
+	        res->message, res->severity, res->check_id);
+}
+
+void set_result_stream(FILE *stream)
+{
+	result_stream = stream;
+}
+
+FILE *get_result_stream(void)
+{
+	return result_stream ? result_stream : stdout;
+}
+
+void set_issue_counters(unsigned int *counts)
+{
+	issue_counts = counts;
+}
+
+void add_issue_counts(struct checks *ck, const unsigned int *counts)
+{
+	for (int i = 0; i <= NODE_ERROR; i++) {
+		for (unsigned int j = 0; j < ck->check_counts[i]; j++) {
+			struct check_node *cur = &ck->check_nodes[i][j];
+			if (counts[cur->index] > 0) {
+				found_issue = 1;
+				cur->issues_found += counts[cur->index];
+			}
+		}
+	}
+}
+
+void enable_check_profiling(struct checks *ck)
+{
+	if (!ck->profiles && ck->check_node_count > 0) {
+		ck->profiles = xcalloc(ck->check_node_count, sizeof(struct check_profile));
+	}
+	xalloc_counting = 1;
+}
+
+void set_check_profiles(struct check_profile *profiles)
+{
+	check_profiles = profiles;
+}
+
+void add_check_profiles(struct checks *ck, const struct check_profile *profiles)
+{
+	for (unsigned int i = 0; i < ck->check_node_count; i++) {
+		struct check_profile *to = &ck->profiles[i];
+		const struct check_profile *from = &profiles[i];
+
+		to->calls += from->calls;
+		to->total_ns += from->total_ns;
+		if (from->max_ns > to->max_ns) {
+			to->max_ns = from->max_ns;
+		}
+		to->findings += from->findings;
+		to->alloc_bytes += from->alloc_bytes;
+	}
+}
+
+void reset_issue_counts(struct checks *ck)
+{
+	for (int i = 0; i <= NODE_ERROR; i++) {
+		for (unsigned int j = 0; j < ck->check_counts[i]; j++) {
+			ck->check_nodes[i][j].issues_found = 0;
+		}
+	}
+
+	found_issue = 0;
+}
+
+void display_note_once(bool *shown, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+
+	if (!result_stream) {
+		if (!*shown) {
+			vprintf(format, args);
+			*shown = true;
+		}
+		va_end(args);
+		return;
+	}
+
+	struct pending_note **tail = &pending_notes;
+	while (*tail) {
+		if ((*tail)->shown == shown) {
+			// Only the first one can be displayed
+			va_end(args);
+			return;
+		}
+		tail = &(*tail)->next;
+	}
+
+	struct pending_note *note = xmalloc(sizeof(struct pending_note));
+	note->shown = shown;
+	if (vasprintf(&note->text, format, args) == -1) {
+		note->text = NULL;
+	}
+	note->pos = ftell(result_stream);
+	note->next = NULL;
+	va_end(args);
+
+	*tail = note;
+}
+
+struct pending_note *take_pending_notes(void)
+{
+	struct pending_note *notes = pending_notes;
+	pending_notes = NULL;
+	return notes;
+}
+
+void write_result_buffer(const char *buf, size_t len, struct pending_note *notes)
+{
+	size_t written = 0;
+
+	while (notes) {
+		struct pending_note *note = notes;
+		notes = notes->next;
+
+		const size_t pos = note->pos > 0 ? (size_t)note->pos : 0;
+		if (pos > written && pos <= len) {
+			fwrite(buf + written, 1, pos - written, stdout);
+			written = pos;
+		}
+		if (note->text && !*note->shown) {
+			fputs(note->text, stdout);
+			*note->shown = true;
+		}
+
+		free(note->text);
+		free(note);
+	}
+
+	if (len > written) {
+		fwrite(buf + written, 1, len - written, stdout);
+	}
+}
+
+void free_pending_notes(struct pending_note *notes)
+{
+	while (notes) {
+		struct pending_note *tmp = notes;
+		notes = notes->next;
+		free(tmp->text);
+		free(tmp);
+	}
 }
 
 struct check_result *alloc_internal_error(const char *string)
@@ -183,22 +566,6 @@ int is_valid_check(const char *check_str)
 	}
 }
 
-// Return the number of check nodes in the checks structure
-static unsigned int count_check_nodes(const struct checks *ck)
-{
-	unsigned int count = 0;
-	for (int i=0; i <= NODE_ERROR; i++) {
-		if (ck->check_nodes[i]) {
-			struct check_node *cur = ck->check_nodes[i];
-			while (cur) {
-				count++;
-				cur = cur->next;
-			}
-		}
-	}
-	return count;
-}
-
 static int id_priority(char id)
 {
 	switch (id) {
@@ -217,42 +584,44 @@ static int id_priority(char id)
 	}
 }
 
-// Return negative if n1 goes before n2, positive if n1 goes after n2 or equal if they are equivalent
-static int comp_check_nodes(const void *n1, const void *n2)
+// Return negative if id1 goes before id2, positive if id1 goes after id2 or equal if they are equivalent
+static int comp_check_ids(const char *id1, const char *id2)
 {
-	const struct check_node *node1 = *(const struct check_node *const *)n1;
-	const struct check_node *node2 = *(const struct check_node *const *)n2;
-
-	int check1_priority = id_priority(node1->check_id[0]);
-	int check2_priority = id_priority(node2->check_id[0]);
+	int check1_priority = id_priority(id1[0]);
+	int check2_priority = id_priority(id2[0]);
 
 	int r = (check1_priority > check2_priority) - (check1_priority < check2_priority);
 	if (r != 0) {
 		return r;
 	}
 
-	int node1_id = atoi(node1->check_id + 2);
-	int node2_id = atoi(node2->check_id + 2);
+	int node1_id = atoi(id1 + 2);
+	int node2_id = atoi(id2 + 2);
 
 	return (node1_id > node2_id) - (node1_id < node2_id);
 }
 
+// Return negative if n1 goes before n2, positive if n1 goes after n2 or equal if they are equivalent
+static int comp_check_nodes(const void *n1, const void *n2)
+{
+	const struct check_node *node1 = *(const struct check_node *const *)n1;
+	const struct check_node *node2 = *(const struct check_node *const *)n2;
+
+	return comp_check_ids(node1->check_id, node2->check_id);
+}
+
 void display_check_issue_counts(const struct checks *ck)
 {
-	size_t num_nodes = count_check_nodes(ck);
+	size_t num_nodes = ck->check_node_count;
 	unsigned int printed_something = 0;
 
 	// Build flat array of check nodes
-	struct check_node **node_arr = xcalloc(num_nodes, sizeof(struct check_node *));
+	const struct check_node **node_arr = xcalloc(num_nodes, sizeof(struct check_node *));
 	unsigned int node_arr_index = 0;
 	for (int i=0; i <= NODE_ERROR; i++) {
-		if (ck->check_nodes[i]) {
-			struct check_node *cur = ck->check_nodes[i];
-			while (cur) {
-				node_arr[node_arr_index] = cur;
-				cur = cur->next;
-				node_arr_index++;
-			}
+		for (unsigned int j = 0; j < ck->check_counts[i]; j++) {
+			node_arr[node_arr_index] = &ck->check_nodes[i][j];
+			node_arr_index++;
 		}
 	}
 
@@ -290,6 +659,124 @@ void display_check_issue_counts(const struct checks *ck)
 	free(node_arr);
 }
 
+// The profiles of all check nodes of a check ID
+struct profile_row {
+	const char *check_id;
+	struct check_profile profile;
+};
+
+// Order rows by decreasing total time, then by check ID
+static int comp_profile_rows(const void *r1, const void *r2)
+{
+	const struct profile_row *row1 = r1;
+	const struct profile_row *row2 = r2;
+
+	if (row1->profile.total_ns != row2->profile.total_ns) {
+		return row1->profile.total_ns < row2->profile.total_ns ? 1 : -1;
+	}
+
+	return comp_check_ids(row1->check_id, row2->check_id);
+}
+
+// Sum up the profiles of the check nodes of each check ID called so far.
+// Returns the rows sorted for display, or NULL if no check was called.
+static struct profile_row *collect_profile_rows(const struct checks *ck, unsigned int *row_count)
+{
+	*row_count = 0;
+	if (!ck->profiles) {
+		return NULL;
+	}
+
+	struct profile_row *rows = xcalloc(ck->check_node_count, sizeof(struct profile_row));
+	for (int i = 0; i <= NODE_ERROR; i++) {
+		for (unsigned int j = 0; j < ck->check_counts[i]; j++) {
+			const struct check_node *cur = &ck->check_nodes[i][j];
+			const struct check_profile *from = &ck->profiles[cur->index];
+			if (from->calls == 0) {
+				continue;
+			}
+
+			unsigned int k = 0;
+			while (k < *row_count && 0 != strcmp(rows[k].check_id, cur->check_id)) {
+				k++;
+			}
+			if (k == *row_count) {
+				rows[k].check_id = cur->check_id;
+				(*row_count)++;
+			}
+
+			struct check_profile *to = &rows[k].profile;
+			to->calls += from->calls;
+			to->total_ns += from->total_ns;
+			if (from->max_ns > to->max_ns) {
+				to->max_ns = from->max_ns;
+			}
+			to->findings += from->findings;
+			to->alloc_bytes += from->alloc_bytes;
+		}
+	}
+
+	if (*row_count == 0) {
+		free(rows);
+		return NULL;
+	}
+
+	qsort(rows, *row_count, sizeof(struct profile_row), comp_profile_rows);
+
+	return rows;
+}
+
+void display_check_profiles(const struct checks *ck)
+{
+	unsigned int row_count;
+	struct profile_row *rows = collect_profile_rows(ck, &row_count);
+
+	printf("Check profile, by total time:\n");
+	if (!rows) {
+		printf("%s(none)%s\n", color_ok(), color_reset());
+		return;
+	}
+
+	printf("%-8s %12s %12s %12s %10s %14s\n",
+	       "Check", "Calls", "Total ms", "Max us", "Findings", "Alloc bytes");
+	for (unsigned int i = 0; i < row_count; i++) {
+		const struct check_profile *p = &rows[i].profile;
+		printf("%s%-8s%s %12lu %12.3f %12.3f %10lu %14zu\n",
+		       color_severity(rows[i].check_id[0]), rows[i].check_id, color_reset(),
+		       p->calls,
+		       (double)p->total_ns / 1e6,
+		       (double)p->max_ns / 1e3,
+		       p->findings,
+		       p->alloc_bytes);
+	}
+
+	free(rows);
+}
+
+void write_check_profiles(const struct checks *ck, FILE *out)
+{
+	unsigned int row_count;
+	struct profile_row *rows = collect_profile_rows(ck, &row_count);
+
+	fprintf(out, "{\n  \"checks\": [");
+	for (unsigned int i = 0; i < row_count; i++) {
+		const struct check_profile *p = &rows[i].profile;
+		fprintf(out,
+		        "%s\n    { \"id\": \"%s\", \"calls\": %lu, \"total_ns\": %" PRIu64
+		        ", \"max_ns\": %" PRIu64 ", \"findings\": %lu, \"alloc_bytes\": %zu }",
+		        i == 0 ? "" : ",",
+		        rows[i].check_id,
+		        p->calls,
+		        p->total_ns,
+		        p->max_ns,
+		        p->findings,
+		        p->alloc_bytes);
+	}
+	fprintf(out, "%s]\n}\n", row_count > 0 ? "\n  " : "");
+
+	free(rows);
+}
+
 void free_check_result(struct check_result *res)
 {
 	if (res) {
@@ -328,17 +815,8 @@ void free_checks(struct checks *to_free)
 	}
 
 	for (int i=0; i < NODE_ERROR + 1; i++) {
-		free_check_node(to_free->check_nodes[i]);
+		free(to_free->check_nodes[i]);
 	}
+	free(to_free->profiles);
 	free(to_free);
 }
-
-void free_check_node(struct check_node *to_free)
-{
-	while (to_free) {
-		struct check_node *tmp = to_free;
-		to_free = to_free->next;
-		free(tmp->check_id);
-		free(tmp);
-	}
-}
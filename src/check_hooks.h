@@ -17,6 +17,10 @@
 #ifndef CHECK_HOOKS_H
 #define CHECK_HOOKS_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
 #include "tree.h"
 #include "selint_error.h"
 #include "selint_config.h"
@@ -93,6 +97,11 @@ enum file_flavor {
 	FILE_FC_FILE
 };
 
+#define FILE_FLAVOR_BIT(flavor) (1U << (flavor))
+#define ALL_FILE_FLAVORS (FILE_FLAVOR_BIT(FILE_TE_FILE) | \
+                          FILE_FLAVOR_BIT(FILE_IF_FILE) | \
+                          FILE_FLAVOR_BIT(FILE_FC_FILE))
+
 struct check_data {
 	char *mod_name;
 	const char *filepath;
@@ -113,13 +122,43 @@ struct check_result {
 struct check_node {
 	struct check_result *(*check_function) (const struct check_data * data,
 	                                        const struct policy_node * node);
-	char *check_id;
+	const char *check_id;
+	// Bit of the check in the disabled_checks of nodes, see check_bit()
+	uint64_t disable_bit;
+	// The flavors of files the check is called for, see FILE_FLAVOR_BIT()
+	unsigned int file_flavors;
 	unsigned int issues_found;
-	struct check_node *next;
+	// Position in the issue counter array, see set_issue_counters()
+	unsigned int index;
+};
+
+// What a check cost during a run, see enable_check_profiling()
+struct check_profile {
+	unsigned long calls;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	unsigned long findings;
+	// Bytes requested through xalloc.h while the check ran, counting the
+	// whole new size of each xrealloc(), see xalloc_counted_bytes
+	size_t alloc_bytes;
 };
 
 struct checks {
+	// The checks called for each node flavor, in the order they were added
 	struct check_node *check_nodes[NODE_ERROR + 1];
+	unsigned int check_counts[NODE_ERROR + 1];
+	unsigned int check_node_count;
+	// The profiles of the checks indexed like issue counters, or NULL
+	// unless profiling is enabled
+	struct check_profile *profiles;
+};
+
+// A note displayed by display_note_once() while the output was redirected
+struct pending_note {
+	bool *shown;
+	char *text;
+	long pos;
+	struct pending_note *next;
 };
 
 // Whether an issue was found
@@ -130,10 +169,10 @@ extern int suppress_output;
 extern int full_path;
 
 /*********************************************
-* Add an check to be called on check_flavor nodes
+* Add an check to be called on check_flavor nodes of all files
 * check_flavor - The flavor of node to call the check for
 * ck - The check structure to add the check to
-* check_id - The ID code for the check
+* check_id - The ID code for the check.  It is not copied, and must outlive ck
 * check_function - the check to add
 * returns SELINT_SUCCESS or an error code on failure
 *********************************************/
@@ -146,6 +185,33 @@ enum selint_error add_check(enum node_flavor check_flavor, struct checks *ck,
                                                                    policy_node
                                                                    * node));
 
+/*********************************************
+* Add a check to be called on check_flavor nodes of some flavors of files
+* check_flavor - The flavor of node to call the check for
+* file_flavors - The flavors of files to call the check for, as a mask
+* of FILE_FLAVOR_BIT()
+* ck - The check structure to add the check to
+* check_id - The ID code for the check.  It is not copied, and must outlive ck
+* check_function - the check to add
+* returns SELINT_SUCCESS or an error code on failure
+*********************************************/
+enum selint_error add_file_check(enum node_flavor check_flavor,
+                                 unsigned int file_flavors,
+                                 struct checks *ck,
+                                 const char *check_id,
+                                 struct check_result *(*check_function)(const struct check_data *check_data,
+                                                                        const struct policy_node *node));
+
+/*********************************************
+* Select the checks called for a flavor of files, to dispatch the nodes of
+* those files to them only.  The selected checks keep their index, so they
+* count issues with the issue counters of ck, see set_issue_counters().
+* ck - The checks to select from
+* flavor - The flavor of files
+* returns a new checks structure to be freed with free_checks()
+*********************************************/
+struct checks *select_file_checks(const struct checks *ck, enum file_flavor flavor);
+
 /*********************************************
 * Call all registered checks for node->flavor node types
 * and write any error messages to STDOUT
@@ -160,13 +226,15 @@ enum selint_error call_checks(struct checks *ck,
 
 /*********************************************
 * Helper function for call_checks that takes the appropriate
-* list of checks for the node flavor and writes any error messages to STDOUT
-* ck_list - The checks to run
+* array of checks for the node flavor and writes any error messages to STDOUT
+* checks - The checks to run
+* count - The number of checks
 * data - Metadata about the file
 * node - the node to check
 * returns SELINT_SUCCESS or an error code on failure
 *********************************************/
-enum selint_error call_checks_for_node_type(struct check_node *ck_list,
+enum selint_error call_checks_for_node_type(struct check_node *checks,
+                                            unsigned int count,
                                             const struct check_data *data,
                                             const struct policy_node *node);
 
@@ -178,6 +246,109 @@ enum selint_error call_checks_for_node_type(struct check_node *ck_list,
 void display_check_result(const struct check_result *res,
                           const struct check_data *data);
 
+/*********************************************
+* Redirect check results and parser errors reported by the calling thread
+* to stream.  Used to buffer the output of files processed concurrently.
+* stream - The stream to print to, or NULL to print to stdout again
+*********************************************/
+void set_result_stream(FILE *stream);
+
+/*********************************************
+* Return the stream results of the calling thread are printed to
+*********************************************/
+FILE *get_result_stream(void);
+
+/*********************************************
+* Count issues found by the calling thread in counts, indexed by the index
+* of the check node, instead of in the check nodes themselves.
+* Used to run checks concurrently.
+* counts - An array of check_node_count counters, or NULL to count in the
+* check nodes again
+*********************************************/
+void set_issue_counters(unsigned int *counts);
+
+/*********************************************
+* Add the issues counted by set_issue_counters() to the check nodes
+* ck - The checks structure
+* counts - The counters to add
+*********************************************/
+void add_issue_counts(struct checks *ck, const unsigned int *counts);
+
+/*********************************************
+* Profile the checks of ck from now on.  Must be called once all checks
+* are added.  Profiles are recorded by the threads their checks run on,
+* see set_check_profiles().
+* ck - The checks to profile
+*********************************************/
+void enable_check_profiling(struct checks *ck);
+
+/*********************************************
+* Record the invocations of checks by the calling thread in profiles,
+* indexed by the index of the check node.  Checks are only timed while
+* profiles are set.
+* profiles - An array of check_node_count profiles, or NULL to stop
+* profiling the calling thread
+*********************************************/
+void set_check_profiles(struct check_profile *profiles);
+
+/*********************************************
+* Add profiles recorded through set_check_profiles() to those of ck
+* ck - The checks structure, with profiling enabled
+* profiles - The profiles to add
+*********************************************/
+void add_check_profiles(struct checks *ck, const struct check_profile *profiles);
+
+/*********************************************
+* Display the profiles of the checks called in a run, per check ID and
+* by decreasing total time
+* ck - The checks structure, with profiling enabled
+*********************************************/
+void display_check_profiles(const struct checks *ck);
+
+/*********************************************
+* Write the profiles of the checks called in a run as JSON, in the order
+* display_check_profiles() displays them
+* ck - The checks structure, with profiling enabled
+* out - The stream to write to
+*********************************************/
+void write_check_profiles(const struct checks *ck, FILE *out);
+
+/*********************************************
+* Forget all issues found so far, to count the issues of a new run
+* ck - The checks to reset the counts of
+*********************************************/
+void reset_issue_counts(struct checks *ck);
+
+/*********************************************
+* Display a note about the run, unless it has been shown already.
+* While the output of the calling thread is redirected, the note is kept
+* pending until write_result_buffer() inserts it into the output.
+* shown - Flag set once the note has been displayed
+* format - A printf style format string
+*********************************************/
+__attribute__ ((format(printf, 2, 3)))
+void display_note_once(bool *shown, const char *format, ...);
+
+/*********************************************
+* Return the notes kept pending by the calling thread, and reset them
+*********************************************/
+struct pending_note *take_pending_notes(void);
+
+/*********************************************
+* Print output buffered from a redirected result stream to stdout, and
+* display its pending notes not shown yet at the position they were issued.
+* Frees notes.
+* buf - The buffered output
+* len - The length of the buffered output
+* notes - The pending notes of the buffered output
+*********************************************/
+void write_result_buffer(const char *buf, size_t len, struct pending_note *notes);
+
+/*********************************************
+* Free pending notes without displaying them
+*********************************************/
+void free_pending_notes(struct pending_note *notes);
+
 /*********************************************
 * Creates a check_result, using a printf style format string and optional
 * arguments to generate a message
@@ -211,6 +382,37 @@ bool is_valid_severity(char check_char);
 *********************************************/
 int is_valid_check(const char *check_str);
 
+/*********************************************
+* Return the bit of a check in the disabled_checks bitset of a node.
+* Each known check ID maps to a bit of its own.
+* severity - The severity character of the check
+* id - The number of the check
+* returns the bit, or 0 if the check is not known
+*********************************************/
+uint64_t check_bit(char severity, unsigned int id);
+
+/*********************************************
+* Return the bit of a check in the disabled_checks bitset of a node
+* check_id - The check ID string, such as "W-001"
+* returns the bit, or 0 if check_id is not a known check
+*********************************************/
+uint64_t check_id_bit(const char *check_id);
+
+/*********************************************
+* Return the bits of all known checks of a severity
+* severity - The severity character of the checks
+* returns the bits, or 0 if the severity is not known
+*********************************************/
+uint64_t severity_check_bits(char severity);
+
+/*********************************************
+* Parse the list of check IDs of an selint-disable comment into a bitset.
+* IDs must match exactly, so W-01 does not disable W-010.
+* list - The comma separated check IDs, or NULL
+* returns the bits of the known checks listed
+*********************************************/
+uint64_t parse_disabled_checks(const char *list);
+
 /*********************************************
 * Display a count of issues found in a run, but check ID.
 * Don't display checks with no issues found
@@ -223,6 +425,4 @@ void free_check_result(struct check_result *);
 
 void free_checks(struct checks *to_free);
 
-void free_check_node(struct check_node *to_free);
-
 #endif
@@ -0,0 +1,512 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <fcntl.h>
+#include <fts.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "config.h"
+
+#include "context_snapshot.h"
+#include "maps.h"
+#include "runner.h"
+#include "selint_context.h"
+#include "serialize.h"
+#include "startup.h"
+#include "util.h"
+#include "xalloc.h"
+
+// Snapshots are framed by the magic and a checksum, see serialize.h.
+// Strings are stored with their terminating NUL, so they are used in place.
+#define SNAPSHOT_MAGIC "SELINTCS"
+#define SNAPSHOT_MAGIC_LEN 8
+
+static int compare_names(const FTSENT **a, const FTSENT **b)
+{
+	return strcmp((*a)->fts_name, (*b)->fts_name);
+}
+
+// Hash the paths, sizes and modification times of all .if files below dir,
+// visited in a fixed order.  If files is not NULL, the files are added to it
+// and their layers are recorded like load_devel_headers() does.
+static uint64_t fingerprint_headers(const char *dir, uint64_t *count,
+                                    struct policy_file_list *files)
+{
+	char *dir_copy = xstrdup(dir);
+	char *const paths[2] = { dir_copy, NULL };
+	uint64_t hash[2];
+
+	serial_hash_init(hash);
+	*count = 0;
+
+	FTS *ftsp = fts_open(paths, FTS_PHYSICAL, compare_names);
+	if (!ftsp) {
+		free(dir_copy);
+		return hash[0];
+	}
+
+	const FTSENT *file = fts_read(ftsp);
+	while (file) {
+		const char *suffix = (file->fts_pathlen > 3) ? (file->fts_path + file->fts_pathlen - 3) : NULL;
+		if (suffix && !strcmp(suffix, ".if") && file->fts_info == FTS_F) {
+			const uint64_t stamp[3] = {
+				(uint64_t)file->fts_statp->st_size,
+				(uint64_t)file->fts_statp->st_mtim.tv_sec,
+				(uint64_t)file->fts_statp->st_mtim.tv_nsec,
+			};
+			serial_hash_bytes(hash, file->fts_path, file->fts_pathlen + 1);
+			serial_hash_bytes(hash, stamp, sizeof(stamp));
+			(*count)++;
+
+			if (files) {
+				file_list_push_back(files, make_policy_file(file->fts_path, NULL));
+				char *mod_name = xstrdup(file->fts_name);
+				mod_name[file->fts_namelen - 3] = '\0';
+				insert_into_mod_layers_map(mod_name, file->fts_parent->fts_name);
+				free(mod_name);
+			}
+		}
+		file = fts_read(ftsp);
+	}
+
+	fts_close(ftsp);
+	free(dir_copy);
+
+	return hash[0];
+}
+
+/*
+ * Serializing
+ */
+
+// Strings are stored as their length including the NUL, and 0 for NULL
+static void put_str(struct serial_writer *w, const char *str)
+{
+	serial_put_data(w, str, str ? strlen(str) + 1 : 0);
+}
+
+static void count_pair(__attribute__((unused)) const char *key,
+                       __attribute__((unused)) const char *value, void *ctx)
+{
+	(*(uint64_t *)ctx)++;
+}
+
+static void put_pair(const char *key, const char *value, void *ctx)
+{
+	put_str(ctx, key);
+	put_str(ctx, value);
+}
+
+static void count_if(__attribute__((unused)) const struct if_hash_elem *elem, void *ctx)
+{
+	(*(uint64_t *)ctx)++;
+}
+
+static void put_if(const struct if_hash_elem *elem, void *ctx)
+{
+	put_str(ctx, elem->name);
+	put_str(ctx, elem->module);
+	serial_put_varint(ctx, elem->flags);
+}
+
+static void count_template(__attribute__((unused)) const struct template_hash_elem *template, void *ctx)
+{
+	(*(uint64_t *)ctx)++;
+}
+
+static void put_template(const struct template_hash_elem *template, void *ctx)
+{
+	struct serial_writer *w = ctx;
+	uint64_t count = 0;
+
+	put_str(w, template->name);
+
+	for (const struct decl_list *cur = template->declarations; cur; cur = cur->next) {
+		count++;
+	}
+	serial_put_varint(w, count);
+	for (const struct decl_list *cur = template->declarations; cur; cur = cur->next) {
+		serial_put_varint(w, cur->decl->flavor);
+		put_str(w, cur->decl->name);
+	}
+
+	count = 0;
+	for (const struct if_call_list *cur = template->calls; cur; cur = cur->next) {
+		count++;
+	}
+	serial_put_varint(w, count);
+	for (const struct if_call_list *cur = template->calls; cur; cur = cur->next) {
+		put_str(w, cur->call->name);
+		count = 0;
+		for (const struct string_list *arg = cur->call->args; arg; arg = arg->next) {
+			count++;
+		}
+		serial_put_varint(w, count);
+		for (const struct string_list *arg = cur->call->args; arg; arg = arg->next) {
+			put_str(w, arg->string);
+			serial_put_varint(w, (uint64_t)(arg->has_incorrect_space != 0) | (uint64_t)(arg->arg_start != 0) << 1);
+		}
+	}
+}
+
+static void put_maps(struct serial_writer *w)
+{
+	uint64_t count = 0;
+	visit_all_in_mod_layers_map(count_pair, &count);
+	serial_put_varint(w, count);
+	visit_all_in_mod_layers_map(put_pair, w);
+
+	for (int flavor = DECL_TYPE; flavor <= DECL_BOOL; flavor++) {
+		count = 0;
+		visit_all_in_decl_map((enum decl_flavor)flavor, count_pair, &count);
+		serial_put_varint(w, count);
+		visit_all_in_decl_map((enum decl_flavor)flavor, put_pair, w);
+	}
+
+	count = 0;
+	visit_all_in_ifs_map(count_if, &count);
+	serial_put_varint(w, count);
+	visit_all_in_ifs_map(put_if, w);
+
+	count = 0;
+	visit_all_in_template_map(count_template, &count);
+	serial_put_varint(w, count);
+	visit_all_in_template_map(put_template, w);
+}
+
+enum selint_error build_context_snapshot(const char *path, const char *devel_dir)
+{
+	struct policy_file_list *files = xcalloc(1, sizeof(struct policy_file_list));
+	uint64_t count;
+	const uint64_t fingerprint = fingerprint_headers(devel_dir, &count, files);
+
+	set_symbols_only(1);
+	enum selint_error res = parse_all_files_in_list(files, NODE_IF_FILE);
+	set_symbols_only(0);
+	if (res == SELINT_SUCCESS) {
+		mark_transform_interfaces(files);
+
+		struct serial_writer w;
+		memset(&w, 0, sizeof(struct serial_writer));
+
+		serial_put_bytes(&w, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN);
+		serial_put_varint(&w, CONTEXT_SNAPSHOT_FORMAT);
+		put_str(&w, VERSION);
+		put_str(&w, devel_dir);
+		serial_put_varint(&w, count);
+		serial_put_varint(&w, fingerprint);
+		put_maps(&w);
+
+		serial_put_checksum(&w);
+
+		res = serial_write_file(path, w.buf, w.len);
+		if (res == SELINT_SUCCESS) {
+			print_if_verbose("Wrote context snapshot of %" PRIu64 " headers (%zu bytes) to %s\n",
+			                 count, w.len, path);
+		}
+
+		free_serial_writer(&w);
+	}
+
+	free_file_list(files);
+	cleanup_parsing();
+
+	return res;
+}
+
+/*
+ * Deserializing
+ */
+
+// Return a string inside the snapshot, or NULL for a NULL string or on failure
+static const char *get_str(struct serial_reader *r)
+{
+	uint64_t len;
+	const unsigned char *data = serial_get_data(r, &len);
+
+	if (data && data[len - 1] != '\0') {
+		r->failed = 1;
+		return NULL;
+	}
+
+	return (const char *)data;
+}
+
+// Return a string which must not be NULL
+static const char *get_name(struct serial_reader *r)
+{
+	const char *str = get_str(r);
+
+	if (!str) {
+		r->failed = 1;
+	}
+
+	return str;
+}
+
+// Read a count of items, each taking at least min_size bytes
+static uint64_t get_count(struct serial_reader *r, uint64_t min_size)
+{
+	const uint64_t count = serial_get_varint(r);
+
+	if (count > (uint64_t)(r->end - r->pos) / min_size) {
+		r->failed = 1;
+		return 0;
+	}
+
+	return count;
+}
+
+static struct if_call_data *get_call(struct serial_reader *r)
+{
+	const char *name = get_name(r);
+	const uint64_t argc = get_count(r, 2);
+	if (r->failed) {
+		return NULL;
+	}
+
+	struct if_call_data *call = xmalloc(sizeof(struct if_call_data));
+	call->name = xstrdup(name);
+	call->args = NULL;
+
+	struct string_list *tail = NULL;
+	for (uint64_t i = 0; i < argc && !r->failed; i++) {
+		const char *arg = get_name(r);
+		const uint64_t flags = serial_get_varint(r);
+		if (r->failed) {
+			break;
+		}
+		struct string_list *item = sl_from_str(arg);
+		item->has_incorrect_space = (flags & 1) != 0;
+		item->arg_start = (flags & 2) != 0;
+		if (tail) {
+			tail->next = item;
+		} else {
+			call->args = item;
+		}
+		tail = item;
+	}
+
+	return call;
+}
+
+static void own_call(struct if_call_list **calls, struct if_call_data *call)
+{
+	struct if_call_list *item = xmalloc(sizeof(struct if_call_list));
+
+	item->call = call;
+	item->next = *calls;
+	*calls = item;
+}
+
+// Insert all map entries into the maps, which record them in the staged
+// changes.  Module layers are only collected into layers.
+static void get_maps(struct serial_reader *r, struct if_call_list **calls,
+                     const char ***layers, uint64_t *layer_count)
+{
+	*layer_count = get_count(r, 4);
+	*layers = xcalloc(*layer_count ? *layer_count * 2 : 1, sizeof(const char *));
+	for (uint64_t i = 0; i < *layer_count && !r->failed; i++) {
+		(*layers)[2 * i] = get_name(r);
+		(*layers)[2 * i + 1] = get_name(r);
+	}
+
+	for (int flavor = DECL_TYPE; flavor <= DECL_BOOL && !r->failed; flavor++) {
+		const uint64_t count = get_count(r, 4);
+		for (uint64_t i = 0; i < count && !r->failed; i++) {
+			const char *name = get_name(r);
+			const char *module_name = get_name(r);
+			if (!r->failed) {
+				insert_into_decl_map(name, module_name, (enum decl_flavor)flavor);
+			}
+		}
+	}
+
+	uint64_t count = get_count(r, 3);
+	for (uint64_t i = 0; i < count && !r->failed; i++) {
+		const char *name = get_name(r);
+		const char *module_name = get_str(r);
+		const uint64_t flags = serial_get_varint(r);
+		if (r->failed) {
+			break;
+		}
+		if (module_name) {
+			insert_into_ifs_map(name, module_name);
+		}
+		if (flags & TRANSFORM_IF) {
+			mark_transform_if(name);
+		}
+		if (flags & FILETRANS_IF) {
+			mark_filetrans_if(name);
+		}
+		if (flags & ROLE_IF) {
+			mark_role_if(name);
+		}
+		if (flags & USED_IF) {
+			mark_used_if(name);
+		}
+	}
+
+	count = get_count(r, 4);
+	for (uint64_t i = 0; i < count && !r->failed; i++) {
+		const char *name = get_name(r);
+		const uint64_t decl_count = get_count(r, 3);
+		if (r->failed) {
+			break;
+		}
+		insert_template_into_template_map(name);
+		for (uint64_t j = 0; j < decl_count && !r->failed; j++) {
+			const uint64_t flavor = serial_get_varint(r);
+			const char *decl_name = get_name(r);
+			if (flavor > DECL_BOOL) {
+				r->failed = 1;
+			}
+			if (!r->failed) {
+				insert_decl_into_template_map(name, (enum decl_flavor)flavor, decl_name);
+			}
+		}
+		const uint64_t call_count = get_count(r, 3);
+		for (uint64_t j = 0; j < call_count && !r->failed; j++) {
+			struct if_call_data *call = get_call(r);
+			if (call) {
+				own_call(calls, call);
+				insert_call_into_template_map(name, call);
+			}
+		}
+	}
+}
+
+static int check_header(struct serial_reader *r, const char *devel_dir)
+{
+	int corrupt;
+	if (!serial_check_frame(r, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN, &corrupt)) {
+		print_if_verbose(corrupt ? "Context snapshot is corrupt\n" :
+		                 "Context snapshot is not a snapshot\n");
+		return 0;
+	}
+
+	const uint64_t format = serial_get_varint(r);
+	const char *version = get_str(r);
+	if (format != CONTEXT_SNAPSHOT_FORMAT || !version || 0 != strcmp(version, VERSION)) {
+		print_if_verbose("Context snapshot was built by another version of SELint\n");
+		return 0;
+	}
+
+	const char *dir = get_str(r);
+	if (!dir || 0 != strcmp(dir, devel_dir)) {
+		print_if_verbose("Context snapshot was built from another directory\n");
+		return 0;
+	}
+
+	uint64_t count;
+	const uint64_t fingerprint = fingerprint_headers(devel_dir, &count, NULL);
+	if (serial_get_varint(r) != count || serial_get_varint(r) != fingerprint || r->failed) {
+		print_if_verbose("Context snapshot is out of date\n");
+		return 0;
+	}
+
+	return 1;
+}
+
+enum selint_error load_context_snapshot(const char *path, const char *devel_dir)
+{
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return SELINT_IO_ERROR;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return SELINT_IO_ERROR;
+	}
+
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return SELINT_IO_ERROR;
+	}
+
+	struct serial_reader r = {
+		.pos = data,
+		.end = (const unsigned char *)data + st.st_size,
+		.failed = 0,
+	};
+	struct if_call_list *calls = NULL;
+	const char **layers = NULL;
+	uint64_t layer_count = 0;
+
+	// Record the entries separately, to drop them if the snapshot turns
+	// out to be corrupt
+	struct map_changes *outer = get_staged_map_changes();
+	struct map_changes *loaded = alloc_map_changes();
+
+	if (check_header(&r, devel_dir)) {
+		stage_map_changes(loaded);
+		get_maps(&r, &calls, &layers, &layer_count);
+		stage_map_changes(outer);
+
+		if (r.pos != r.end) {
+			r.failed = 1;
+		}
+	} else {
+		r.failed = 1;
+	}
+
+	enum selint_error res;
+	if (r.failed) {
+		free_map_changes(loaded);
+		free_if_call_list_and_data(calls);
+		res = SELINT_PARSE_ERROR;
+	} else {
+		if (outer) {
+			move_map_changes(outer, loaded);
+		} else {
+			commit_map_changes(loaded);
+		}
+		for (uint64_t i = 0; i < layer_count; i++) {
+			insert_into_mod_layers_map(layers[2 * i], layers[2 * i + 1]);
+		}
+		// Keep the calls until free_context_snapshot()
+		if (calls) {
+			struct if_call_list *last = calls;
+			while (last->next) {
+				last = last->next;
+			}
+			last->next = selint_context_current()->snapshot_calls;
+			selint_context_current()->snapshot_calls = calls;
+		}
+		res = SELINT_SUCCESS;
+	}
+
+	free(layers);
+	munmap(data, (size_t)st.st_size);
+
+	return res;
+}
+
+void free_context_snapshot(void)
+{
+	free_if_call_list_and_data(selint_context_current()->snapshot_calls);
+	selint_context_current()->snapshot_calls = NULL;
+}
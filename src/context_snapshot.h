@@ -0,0 +1,60 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#ifndef CONTEXT_SNAPSHOT_H
+#define CONTEXT_SNAPSHOT_H
+
+#include "selint_error.h"
+
+/**********************************
+* A context snapshot holds the map entries parsing the development headers
+* (see load_devel_headers()) produces: the declarations, the interfaces and
+* their flags, the templates and the layers of the modules.  Loading it
+* takes time linear in its size, instead of parsing every header again.
+*
+* A snapshot records the names, sizes and modification times of the headers
+* it was built from, and is only loaded while they are unchanged.  Like parse
+* cache entries, snapshots end with a checksum and do not depend on the byte
+* order or word size of the host.
+**********************************/
+
+// Bump when the serialized format changes
+#define CONTEXT_SNAPSHOT_FORMAT 1
+
+/**********************************
+* Parse all .if files below devel_dir and write a snapshot of the resulting
+* maps to path.  Call before anything else is inserted into the maps.
+* Returns SELINT_SUCCESS, SELINT_PARSE_ERROR if a header fails to parse or
+* SELINT_IO_ERROR if the snapshot cannot be written
+**********************************/
+enum selint_error build_context_snapshot(const char *path, const char *devel_dir);
+
+/**********************************
+* Insert the entries of the snapshot at path into the maps, and the module
+* layers it records into the mod layers map
+* devel_dir - The directory the snapshot has to be built from
+* Returns SELINT_SUCCESS, SELINT_IO_ERROR if the snapshot cannot be read or
+* SELINT_PARSE_ERROR if it is corrupt or out of date.  On errors the maps
+* are left unchanged.
+**********************************/
+enum selint_error load_context_snapshot(const char *path, const char *devel_dir);
+
+// Free the interface calls loaded snapshots added to the template map of
+// the current context.  Call once the maps are freed.
+void free_context_snapshot(void);
+
+#endif
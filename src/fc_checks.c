@@ -49,12 +49,10 @@ struct check_result *check_file_context_types_in_mod(const struct check_data
 		if (0 == strcmp("base.fc", data->filename) ||
 		    0 == strcmp("all_mods.fc", data->filename) ||
 		    ends_with(data->filename, strlen(data->filename), ".mod.fc", strlen(".mod.fc"))) {
-			if (!notified) {
-				printf("%sNote%s: Check S-002 is not performed against generated filecontext files (e.g. %s).\n"\
-				       "      This can be disabled with the configuration setting \"skip_checking_generated_fcs\".\n",
-				    color_note(), color_reset(), data->filename);
-				notified = true;
-			}
+			display_note_once(&notified,
+			                  "%sNote%s: Check S-002 is not performed against generated filecontext files (e.g. %s).\n"\
+			                  "      This can be disabled with the configuration setting \"skip_checking_generated_fcs\".\n",
+			                  color_note(), color_reset(), data->filename);
 			return NULL;
 		}
 	}
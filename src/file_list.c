@@ -16,10 +16,61 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <uthash.h>
 
+#include "arena.h"
 #include "file_list.h"
+#include "maps.h"
+#include "util.h"
 #include "xalloc.h"
 
+struct path_index_entry {
+	char *path;
+	UT_hash_handle hh;
+};
+
+struct path_index {
+	struct path_index_entry *entries;
+};
+
+// The path of the file with symbolic links, "." and ".." resolved, or the
+// path itself if it can not be resolved, e.g. because the file is missing
+static char *canonical_path(const char *filename)
+{
+	char *resolved = realpath(filename, NULL);
+
+	return resolved ? resolved : xstrdup(filename);
+}
+
+no_sanitize_unsigned_integer_
+static void index_path(struct path_index *index, const char *filename)
+{
+	char *path = canonical_path(filename);
+	struct path_index_entry *entry;
+
+	HASH_FIND_STR(index->entries, path, entry);
+	if (entry) {
+		free(path);
+		return;
+	}
+
+	entry = xmalloc(sizeof(struct path_index_entry));
+	entry->path = path;
+	HASH_ADD_KEYPTR(hh, index->entries, entry->path, strlen(entry->path), entry);
+}
+
+no_sanitize_unsigned_integer_
+static int path_in_index(const struct path_index *index, const char *filename)
+{
+	char *path = canonical_path(filename);
+	struct path_index_entry *entry;
+
+	HASH_FIND_STR(index->entries, path, entry);
+	free(path);
+
+	return entry != NULL;
+}
+
 void file_list_push_back(struct policy_file_list *list,
                          struct policy_file *file)
 {
@@ -33,6 +84,20 @@ void file_list_push_back(struct policy_file_list *list,
 	}
 	list->tail->file = file;
 	list->tail->next = NULL;
+
+	if (list->index) {
+		index_path(list->index, file->filename);
+	}
+}
+
+size_t file_list_length(const struct policy_file_list *list)
+{
+	size_t count = 0;
+	for (const struct policy_file_node *cur = list->head; cur; cur = cur->next) {
+		count++;
+	}
+
+	return count;
 }
 
 struct policy_file *make_policy_file(const char *filename, struct policy_node *ast)
@@ -41,11 +106,17 @@ struct policy_file *make_policy_file(const char *filename, struct policy_node *a
 
 	ret->filename = xstrdup(filename);
 	ret->ast = ast;
+	ret->arena = NULL;
+	ret->changes = NULL;
 	return ret;
 }
 
 int file_name_in_file_list(const char *filename, const struct policy_file_list *list)
 {
+	if (list->index) {
+		return path_in_index(list->index, filename);
+	}
+
 	const struct policy_file_node *node = list->head;
 
 	while (node) {
@@ -57,13 +128,47 @@ int file_name_in_file_list(const char *filename, const struct policy_file_list *
 	return 0;
 }
 
+void index_file_list(struct policy_file_list *list)
+{
+	if (list->index) {
+		return;
+	}
+
+	list->index = xcalloc(1, sizeof(struct path_index));
+
+	for (const struct policy_file_node *node = list->head; node; node = node->next) {
+		index_path(list->index, node->file->filename);
+	}
+}
+
+void unindex_file_list(struct policy_file_list *list)
+{
+	if (!list->index) {
+		return;
+	}
+
+	struct path_index_entry *entry, *tmp;
+
+	HASH_ITER(hh, list->index->entries, entry, tmp) {
+		HASH_DELETE(hh, list->index->entries, entry);
+		free(entry->path);
+		free(entry);
+	}
+	free(list->index);
+	list->index = NULL;
+}
+
 void free_file_list(struct policy_file_list *to_free)
 {
+	unindex_file_list(to_free);
+
 	struct policy_file_node *cur = to_free->head;
 
 	while (cur) {
 		free(cur->file->filename);
+		free_map_changes(cur->file->changes);
 		free_policy_node(cur->file->ast);
+		free_arena(cur->file->arena);
 		free(cur->file);
 		struct policy_file_node *tmp = cur;
 		cur = cur->next;
@@ -71,3 +176,13 @@ void free_file_list(struct policy_file_list *to_free)
 	}
 	free(to_free);
 }
+
+void free_file_list_asts(struct policy_file_list *list)
+{
+	for (struct policy_file_node *cur = list->head; cur; cur = cur->next) {
+		free_policy_node(cur->file->ast);
+		cur->file->ast = NULL;
+		free_arena(cur->file->arena);
+		cur->file->arena = NULL;
+	}
+}
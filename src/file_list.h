@@ -19,9 +19,17 @@
 
 #include "tree.h"
 
+struct arena;
+struct map_changes;
+struct path_index;
+
 struct policy_file {
 	char *filename;
 	struct policy_node *ast;
+	struct arena *arena;    // owns the AST if not NULL
+	// The map insertions caused by parsing the file, if they are kept to
+	// rebuild the maps, see retain_map_changes in runner.h
+	struct map_changes *changes;
 };
 
 struct policy_file_node {
@@ -32,6 +40,7 @@ struct policy_file_node {
 struct policy_file_list {
 	struct policy_file_node *head;
 	struct policy_file_node *tail;
+	struct path_index *index;       // optional, see index_file_list()
 };
 
 void file_list_push_back(struct policy_file_list *list,
@@ -39,9 +48,24 @@ void file_list_push_back(struct policy_file_list *list,
 
 struct policy_file *make_policy_file(const char *filename, struct policy_node *ast);
 
-// Return 1 if filename matches the name of a file in list, and 0 otherwise
+// Return the number of files in the list
+size_t file_list_length(const struct policy_file_list *list);
+
+// Return 1 if filename matches the name of a file in list, and 0 otherwise.
+// In an indexed list filename also matches other paths of the same file.
 int file_name_in_file_list(const char *filename, const struct policy_file_list *list);
 
+// Index the canonical paths of the files in the list, to look them up in
+// constant time.  Files pushed with file_list_push_back() are indexed too,
+// but the index is not updated when nodes are unlinked by hand, so drop it
+// with unindex_file_list() before.
+void index_file_list(struct policy_file_list *list);
+
+void unindex_file_list(struct policy_file_list *list);
+
 void free_file_list(struct policy_file_list *to_free);
 
+// Free the ASTs of the files in the list, but keep the files
+void free_file_list_asts(struct policy_file_list *list);
+
 #endif
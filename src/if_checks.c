@@ -251,18 +251,132 @@ struct check_result *check_unquoted_gen_require_block(__attribute__((unused)) co
 	return NULL;
 }
 
+// The names required before the node checked by W-002, in the interface or
+// template definition around it.  It is built incrementally, as the nodes
+// are checked in depth first order, so each require block is only read
+// once per definition.  Per thread, since files are checked concurrently.
+struct require_index {
+	const struct policy_node *def;
+	const struct policy_node *next;         // the first node not yet indexed
+	struct name_set *required;
+};
+
+static _Thread_local struct require_index req_index;
+
+static void reset_require_index(const struct policy_node *def)
+{
+	free_name_set(req_index.required);
+	req_index.def = def;
+	req_index.next = def ? def->first_child : NULL;
+	req_index.required = def ? alloc_name_set() : NULL;
+}
+
+// Index the require blocks up to the node
+static int index_requires_before(const struct policy_node *node)
+{
+	const struct policy_node *cur = req_index.next;
+
+	// The normal case is that the gen_require block is at the top level,
+	// but it could be nested, for example in an ifdef
+	for (; cur && cur != node; cur = dfs_next(cur)) {
+		if (cur->flavor == NODE_GEN_REQ || cur->flavor == NODE_REQUIRE) {
+			for (const struct policy_node *child = cur->first_child; child; child = child->next) {
+				name_set_add_list(req_index.required, get_names_in_node(child));
+			}
+		}
+	}
+
+	req_index.next = cur;
+
+	return cur == node;
+}
+
+static const struct name_set *get_names_required_before(const struct policy_node *def,
+                                                        const struct policy_node *node)
+{
+	if (req_index.def != def) {
+		reset_require_index(def);
+	}
+
+	if (!index_requires_before(node)) {
+		// Not checked in depth first order, so start over
+		reset_require_index(def);
+		index_requires_before(node);
+	}
+
+	return req_index.required;
+}
+
+// The names used by the nodes following the require block of the
+// declarations checked by W-003, and their descendants.  Built once and
+// shared by all declarations of the block.  Per thread, since files are
+// checked concurrently.
+struct used_names {
+	const struct policy_node *req_block_node;
+	struct name_set *used;
+};
+
+static _Thread_local struct used_names used_after_req;
+
+static void reset_used_names(const struct policy_node *req_block_node)
+{
+	free_name_set(used_after_req.used);
+	used_after_req.req_block_node = req_block_node;
+	used_after_req.used = req_block_node ? alloc_name_set() : NULL;
+}
+
+static const struct name_set *get_names_used_after(const struct policy_node *req_block_node)
+{
+	if (used_after_req.req_block_node == req_block_node) {
+		return used_after_req.used;
+	}
+
+	reset_used_names(req_block_node);
+
+	const struct policy_node *cur = req_block_node->next;
+
+	int depth = 0;
+
+	while (cur) {
+		name_set_add_list(used_after_req.used, get_names_in_node(cur));
+
+		if (cur->first_child) {
+			cur = cur->first_child;
+			depth++;
+		} else if (cur->next) {
+			cur = cur->next;
+		} else {
+			while (cur->parent && depth > 0) {
+				cur = cur->parent;
+				depth--;
+				if (cur->next) {
+					break;
+				}
+			}
+			cur = cur->next;
+		}
+	}
+
+	return used_after_req.used;
+}
+
 struct check_result *check_name_used_but_not_required_in_if(const struct
                                                             check_data *data,
                                                             const struct
                                                             policy_node *node)
 {
+	if (node->flavor == NODE_CLEANUP) {
+		reset_require_index(NULL);
+		return NULL;
+	}
+
 	if (data->flavor != FILE_IF_FILE) {
 		return NULL;
 	}
 
 	const struct policy_node *cur = node;
 
-	struct name_list *names_in_current_node = get_names_in_node(node);
+	const struct name_list *names_in_current_node = get_names_in_node(node);
 
 	if (!names_in_current_node) {
 		return NULL;
@@ -276,34 +390,10 @@ struct check_result *check_name_used_but_not_required_in_if(const struct
 	}
 
 	if (!cur) {
-		free_name_list(names_in_current_node);
 		return NULL;
 	}
 	// In a template or interface, and cur is a pointer to the definition node
-
-	cur = cur->first_child;
-
-	struct name_list *names_required = NULL;
-	struct name_list *names_required_tail = NULL;
-
-	while (cur && cur != node) {
-	       if (cur->flavor == NODE_GEN_REQ
-	           || cur->flavor == NODE_REQUIRE) {
-			if (!names_required) {
-				names_required = get_names_required(cur);
-				names_required_tail = names_required;
-			} else {
-				names_required_tail->next = get_names_required(cur);
-			}
-			while (names_required_tail && names_required_tail->next) {
-				names_required_tail = names_required_tail->next;
-			}
-		}
-
-		cur = dfs_next(cur); // The normal case is that the gen_require block
-		                     // is at the top level, but it could be nested,
-		                     // for example in an ifdef
-	}
+	const struct name_set *names_required = get_names_required_before(cur, node);
 
 	const struct name_list *name_node = names_in_current_node;
 	/* In declarations skip the first name, which is the new declared type */
@@ -314,7 +404,7 @@ struct check_result *check_name_used_but_not_required_in_if(const struct
 
 	while (name_node) {
 		const struct name_data *ndata = name_node->data;
-		if (!name_list_contains_name(names_required, ndata)) {
+		if (!name_set_contains(names_required, ndata)) {
 			if (name_is_role(ndata) && 0 == strcmp(ndata->name, "system_r")) {
 				// system_r is required by default in all modules
 				// so that is an exception that shouldn't be warned
@@ -322,15 +412,15 @@ struct check_result *check_name_used_but_not_required_in_if(const struct
 				name_node = name_node->next;
 				continue;
 			}
-			if (name_is_type(ndata) && look_up_in_decl_map(ndata->name, DECL_TYPE)) {
+			if (name_is_type(ndata) && look_up_atom_in_decl_map(ndata->name, DECL_TYPE)) {
 				flavor = "Type";
-			} else if (name_is_typeattr(ndata) && look_up_in_decl_map(ndata->name, DECL_ATTRIBUTE)) {
+			} else if (name_is_typeattr(ndata) && look_up_atom_in_decl_map(ndata->name, DECL_ATTRIBUTE)) {
 				flavor = "Attribute";
-			} else if (name_is_roleattr(ndata) && look_up_in_decl_map(ndata->name, DECL_ATTRIBUTE_ROLE)) {
+			} else if (name_is_roleattr(ndata) && look_up_atom_in_decl_map(ndata->name, DECL_ATTRIBUTE_ROLE)) {
 				flavor = "Role Attribute";
-			} else if (name_is_role(ndata) && look_up_in_decl_map(ndata->name, DECL_ROLE)) {
+			} else if (name_is_role(ndata) && look_up_atom_in_decl_map(ndata->name, DECL_ROLE)) {
 				flavor = "Role";
-			} else if (name_is_class(ndata) && look_up_in_decl_map(ndata->name, DECL_CLASS) &&
+			} else if (name_is_class(ndata) && look_up_atom_in_decl_map(ndata->name, DECL_CLASS) &&
 			           userspace_class_support && is_userspace_class(ndata->name, ndata->traits)) {
 				flavor = "Class";
 			} else {
@@ -343,16 +433,11 @@ struct check_result *check_name_used_but_not_required_in_if(const struct
 			struct check_result *res =
 				make_check_result('W', W_ID_NO_REQ, NOT_REQ_MESSAGE,
 				                  flavor, ndata->name);
-			free_name_list(names_in_current_node);
-			free_name_list(names_required);
 			return res;
 		}
 		name_node = name_node->next;
 	}
 
-	free_name_list(names_in_current_node);
-	free_name_list(names_required);
-
 	return NULL;
 }
 
@@ -361,6 +446,11 @@ struct check_result *check_name_required_but_not_used_in_if(const struct
                                                             const struct
                                                             policy_node *node)
 {
+	if (node->flavor == NODE_CLEANUP) {
+		reset_used_names(NULL);
+		return NULL;
+	}
+
 	if (data->flavor != FILE_IF_FILE) {
 		return NULL;
 	}
@@ -411,69 +501,26 @@ struct check_result *check_name_required_but_not_used_in_if(const struct
 		return NULL;
 	}
 
-	struct name_list *names_to_check = get_names_in_node(node);
+	const struct name_list *names_to_check = get_names_in_node(node);
 	if (!names_to_check) {
 		// This should never happen
 		return alloc_internal_error(
 			"Declaration with no declared items");
 	}
 
-	cur = req_block_node;
-
-	cur = cur->next;
-
-	struct name_list *nl_end = NULL;
-	struct name_list *nl_head = NULL;
-
-	int depth = 0;
-
-	while (cur) {
-		struct name_list *names_used = get_names_in_node(cur);
-		if (names_used) {
-			if (!nl_head) {
-				nl_head = nl_end = names_used;
-			} else {
-				nl_end->next = names_used;
-			}
-
-			while (nl_end->next) {
-				nl_end = nl_end->next;
-			}
-		}
-
-		if (cur->first_child) {
-			cur = cur->first_child;
-			depth++;
-		} else if (cur->next) {
-			cur = cur->next;
-		} else {
-			while (cur->parent && depth > 0) {
-				cur = cur->parent;
-				depth--;
-				if (cur->next) {
-					break;
-				}
-			}
-			cur = cur->next;
-		}
-	}
-
-	struct check_result *res = NULL;
+	const struct name_set *names_used = get_names_used_after(req_block_node);
 
 	for (const struct name_list *name_node = names_to_check; name_node; name_node = name_node->next) {
-		if (!name_list_contains_name(nl_head, name_node->data)) {
-			res = make_check_result('W',
-			                        W_ID_UNUSED_REQ,
-			                        "%s %s is listed in require block but not used in interface",
-			                        flavor,
-			                        name_node->data->name);
-			break;
+		if (!name_set_contains(names_used, name_node->data)) {
+			return make_check_result('W',
+			                         W_ID_UNUSED_REQ,
+			                         "%s %s is listed in require block but not used in interface",
+			                         flavor,
+			                         name_node->data->name);
 		}
 	}
 
-	free_name_list(nl_head);
-	free_name_list(names_to_check);
-	return res;
+	return NULL;
 }
 
 struct check_result *check_required_declaration_own(const struct
@@ -97,7 +97,8 @@ struct check_result *check_unquoted_gen_require_block(const struct
 /*********************************************
 * Check that all names referenced in interface are listed in its require block
 * (or declared in that template)
-* Called on NODE_AV_RULE, NODE_TT_RULE and NODE_IF_CALL nodes.
+* Called on NODE_AV_RULE, NODE_TT_RULE and NODE_IF_CALL nodes, and on
+* NODE_CLEANUP to free the index of the required names.
 * data - metadata about the file
 * node - the node to check
 * returns NULL if passed or check_result for issue W-002
@@ -109,7 +110,8 @@ struct check_result *check_name_used_but_not_required_in_if(const struct
 
 /*********************************************
 * Check that all types listed in require block are actually used in the interface
-* Called on NODE_DECL nodes
+* Called on NODE_DECL nodes, and on NODE_CLEANUP to free the set of the
+* used names
 * data - metadata about the file
 * node - the node to check
 * returns NULL if passed or check_result for issue W-003
@@ -0,0 +1,225 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "intern.h"
+#include "xalloc.h"
+
+// Atoms are spread over shards with a lock each, so threads interning
+// different strings rarely contend.  Looking up atoms takes no lock: atoms
+// are published by storing their slot pointer last, and grown tables replace
+// the old ones atomically.  Replaced tables are kept until exit, as readers
+// may still probe them, which costs less memory than the current table.
+#define ATOM_SHARD_BITS 6
+#define ATOM_SHARDS (1u << ATOM_SHARD_BITS)
+#define ATOM_MIN_CAPACITY 256
+
+struct atom_slot {
+	const char *atom;       // accessed atomically, set after hash
+	uint64_t hash;
+};
+
+// Open addressing table with linear probing, at most half full
+struct atom_table {
+	size_t capacity;
+	struct atom_table *replaced;
+	struct atom_slot slots[];
+};
+
+struct atom_shard {
+	pthread_mutex_t lock;
+	struct atom_table *table;       // accessed atomically, replaced under lock
+	size_t count;
+	struct arena *strings;
+	size_t atom_bytes;
+	size_t requests;        // accessed atomically
+	size_t request_bytes;   // accessed atomically
+};
+
+static struct atom_shard shards[ATOM_SHARDS] = {
+	[0 ... ATOM_SHARDS - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+
+static pthread_once_t free_atoms_once = PTHREAD_ONCE_INIT;
+
+// FNV-1a
+static uint64_t hash_string(const char *str, size_t len)
+{
+	uint64_t hash = 0xcbf29ce484222325u;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (unsigned char)str[i];
+		hash *= 0x100000001b3u;
+	}
+
+	return hash;
+}
+
+static struct atom_shard *shard_of(uint64_t hash)
+{
+	return &shards[hash >> (64 - ATOM_SHARD_BITS)];
+}
+
+// Return the atom equal to the first len characters of str, or NULL if
+// table has none.  Set index to the slot the probe ended at.
+static const char *probe_table(const struct atom_table *table, const char *str,
+                               size_t len, uint64_t hash, size_t *index)
+{
+	const size_t mask = table->capacity - 1;
+
+	for (size_t i = hash & mask;; i = (i + 1) & mask) {
+		const char *atom = __atomic_load_n(&table->slots[i].atom, __ATOMIC_ACQUIRE);
+		if (!atom ||
+		    (table->slots[i].hash == hash &&
+		     0 == strncmp(atom, str, len) &&
+		     atom[len] == '\0')) {
+			*index = i;
+			return atom;
+		}
+	}
+}
+
+// Called with the lock of the shard held
+static void grow_shard(struct atom_shard *shard)
+{
+	struct atom_table *old_table = shard->table;
+	const size_t old_capacity = old_table ? old_table->capacity : 0;
+	const size_t capacity = old_capacity ? old_capacity * 2 : ATOM_MIN_CAPACITY;
+
+	struct atom_table *table = xcalloc(1, sizeof(struct atom_table) + capacity * sizeof(struct atom_slot));
+	table->capacity = capacity;
+	table->replaced = old_table;
+
+	const size_t mask = capacity - 1;
+	for (size_t i = 0; i < old_capacity; i++) {
+		if (!old_table->slots[i].atom) {
+			continue;
+		}
+		size_t j = old_table->slots[i].hash & mask;
+		while (table->slots[j].atom) {
+			j = (j + 1) & mask;
+		}
+		table->slots[j] = old_table->slots[i];
+	}
+
+	__atomic_store_n(&shard->table, table, __ATOMIC_RELEASE);
+}
+
+static void free_atoms(void)
+{
+	for (unsigned int i = 0; i < ATOM_SHARDS; i++) {
+		struct atom_shard *shard = &shards[i];
+		struct atom_table *table = shard->table;
+		while (table) {
+			struct atom_table *replaced = table->replaced;
+			free(table);
+			table = replaced;
+		}
+		free_arena(shard->strings);
+		shard->table = NULL;
+		shard->strings = NULL;
+		shard->count = 0;
+	}
+}
+
+static void register_free_atoms(void)
+{
+	// Keeps leak checkers quiet
+	atexit(free_atoms);
+}
+
+const char *intern_n(const char *str, size_t len)
+{
+	const char *nul = memchr(str, '\0', len);
+	if (nul) {
+		len = (size_t)(nul - str);
+	}
+
+	const uint64_t hash = hash_string(str, len);
+	struct atom_shard *shard = shard_of(hash);
+	size_t index;
+
+	__atomic_fetch_add(&shard->requests, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&shard->request_bytes, len + 1, __ATOMIC_RELAXED);
+
+	// Most strings were interned before, which needs no lock
+	const struct atom_table *table = __atomic_load_n(&shard->table, __ATOMIC_ACQUIRE);
+	const char *atom = table ? probe_table(table, str, len, hash, &index) : NULL;
+	if (atom) {
+		return atom;
+	}
+
+	pthread_mutex_lock(&shard->lock);
+
+	if (!shard->table || 2 * (shard->count + 1) > shard->table->capacity) {
+		if (!shard->table) {
+			pthread_once(&free_atoms_once, register_free_atoms);
+			shard->strings = alloc_arena();
+		}
+		grow_shard(shard);
+	}
+
+	// Another thread might have added it meanwhile
+	struct atom_table *locked_table = shard->table;
+	atom = probe_table(locked_table, str, len, hash, &index);
+	if (!atom) {
+		atom = arena_strndup(shard->strings, str, len);
+		locked_table->slots[index].hash = hash;
+		__atomic_store_n(&locked_table->slots[index].atom, atom, __ATOMIC_RELEASE);
+		shard->count++;
+		shard->atom_bytes += len + 1;
+	}
+
+	pthread_mutex_unlock(&shard->lock);
+
+	return atom;
+}
+
+const char *intern(const char *str)
+{
+	return intern_n(str, strlen(str));
+}
+
+const char *find_atom(const char *str)
+{
+	const size_t len = strlen(str);
+	const uint64_t hash = hash_string(str, len);
+	const struct atom_table *table = __atomic_load_n(&shard_of(hash)->table, __ATOMIC_ACQUIRE);
+	size_t index;
+
+	return table ? probe_table(table, str, len, hash, &index) : NULL;
+}
+
+void get_atom_stats(struct atom_stats *stats)
+{
+	memset(stats, 0, sizeof(struct atom_stats));
+
+	for (unsigned int i = 0; i < ATOM_SHARDS; i++) {
+		struct atom_shard *shard = &shards[i];
+		pthread_mutex_lock(&shard->lock);
+		stats->atoms += shard->count;
+		stats->atom_bytes += shard->atom_bytes;
+		pthread_mutex_unlock(&shard->lock);
+		stats->requests += __atomic_load_n(&shard->requests, __ATOMIC_RELAXED);
+		stats->request_bytes += __atomic_load_n(&shard->request_bytes, __ATOMIC_RELAXED);
+	}
+}
@@ -0,0 +1,49 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+
+/**********************************
+* Interned strings ("atoms") are canonical, read-only copies of strings.
+* Two atoms are equal if and only if they are the same pointer, so atoms
+* can be compared and hashed by address.
+* Atoms stay valid until the program exits.  All functions are thread safe,
+* and find_atom() and interning strings interned before take no lock.
+**********************************/
+
+// Return the atom equal to str, creating it if needed
+const char *intern(const char *str);
+
+// Return the atom equal to the first len characters of str
+const char *intern_n(const char *str, size_t len);
+
+// Return the atom equal to str, or NULL if str was never interned
+const char *find_atom(const char *str);
+
+struct atom_stats {
+	size_t atoms;           // number of distinct atoms
+	size_t atom_bytes;      // bytes used by the strings of all atoms
+	size_t requests;        // number of intern calls
+	size_t request_bytes;   // bytes the interned strings would have used as copies
+};
+
+void get_atom_stats(struct atom_stats *stats);
+
+#endif
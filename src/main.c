@@ -14,6 +14,7 @@
 * limitations under the License.
 */
 
+#include <errno.h>
 #include <stdio.h>
 #include <getopt.h>
 #include <sys/types.h>
@@ -30,6 +31,10 @@
 #include "selint_config.h"
 #include "startup.h"
 #include "color.h"
+#include "parse_cache.h"
+#include "context_snapshot.h"
+#include "trace.h"
+#include "watch.h"
 #include "xalloc.h"
 
 // ASCII characters go up to 127
@@ -39,6 +44,12 @@
 #define SCAN_HIDDEN_DIRS_ID 131
 #define DEBUG_PARSER_ID     132
 #define FULL_PATH_ID        133
+#define CACHE_DIR_ID        134
+#define WATCH_ID            135
+#define BUILD_SNAPSHOT_ID   136
+#define SNAPSHOT_ID         137
+#define PROFILE_CHECKS_ID   138
+#define TRACE_OUT_ID        139
 
 extern int yydebug;
 
@@ -53,12 +64,19 @@ static void usage(void)
 	printf("  -c, --config=CONFIGFILE\tOverride default config with config\n"\
 		"\t\t\t\tspecified on command line.  See\n"\
 		"\t\t\t\tCONFIGURATION section for config file syntax.\n"\
+		"      --build-context-snapshot=OUT\n"\
+		"\t\t\t\tParse the installed development headers, store the\n"\
+		"\t\t\t\tsymbols they define in OUT and exit.\n"\
+		"      --cache-dir=DIR\t\tCache parsed te and if files in DIR and reuse them\n"\
+		"\t\t\t\twhile the files are unchanged.\n"\
 		"      --color=COLOR_OPTION\tConfigure color output.\n"\
 		"\t\t\t\tOptions are on, off and auto (the default).\n"\
 		"      --context=CONTEXT_PATH\tRecursively scan CONTEXT_PATH to find additional te and if\n"\
 		"\t\t\t\tfiles to parse, but not scan.  SELint will assume the scanned policy files\n"\
 		"\t\t\t\tare intended to be compiled together with the context files.\n"\
 		"\t\t\t\tare intended to be compiled together with the context files.  Implies -s.\n"\
+		"      --context-snapshot=FILE\tLoad the symbols of the development headers from\n"\
+		"\t\t\t\ta snapshot, unless the headers changed since it was built.\n"\
 		"      --debug-parser\t\tEnable debug output for the internal policy parser.\n"\
 		"\t\t\t\tVery noisy, useful to debug parsing failures.\n"\
 		"  -d, --disable=CHECKID\t\tDisable check with the given ID.\n"\
@@ -68,9 +86,13 @@ static void usage(void)
 		"      --full-path\t\tPrint full path for files.\n"\
 		"  -F, --fail\t\t\tExit with a non-zero value if any issue was found.\n"\
 		"  -h, --help\t\t\tDisplay this menu.\n"\
+		"  -j, --jobs=N\t\t\tParse and check files using N threads (default: 1).\n"\
 		"  -l, --level=LEVEL\t\tOnly list errors with a severity level at or\n"\
 		"\t\t\t\tgreater than LEVEL.  Options are C (convention), S (style),\n"\
 		"\t\t\t\tW (warning), E (error), F (fatal error).\n"\
+		"      --profile-checks[=FILE]\tDisplay the calls, run time, findings and allocations\n"\
+		"\t\t\t\tof each check after the run.  Also write them as JSON\n"\
+		"\t\t\t\tto FILE if given.\n"\
 		"      --scan-hidden-dirs\tScan hidden directories.\n"\
 		"\t\t\t\tBy default hidden directories (like '.git') are skipped in recursive mode.\n"\
 		"  -s, --source\t\t\tRun in \"source mode\" to scan a policy source repository\n"\
@@ -79,8 +101,12 @@ static void usage(void)
 		"      --summary-only\t\tOnly display a summary of issues found after running the analysis.\n"\
 		"\t\t\t\tDo not show the individual findings.  Implies -S.\n"\
 		"  -r, --recursive\t\tScan recursively and check all SELinux policy files found.\n"\
+		"      --trace-out=FILE\t\tWrite the time spent in each phase of the run and on\n"\
+		"\t\t\t\teach file to FILE, in the Chrome trace event format.\n"\
 		"  -v, --verbose\t\t\tEnable verbose output.\n"\
-		"  -V, --version\t\t\tShow version information and exit.\n"
+		"  -V, --version\t\t\tShow version information and exit.\n"\
+		"      --watch\t\t\tKeep running and check changed files again whenever\n"\
+		"\t\t\t\tte, if or fc files are written, until interrupted.\n"
 );
 	/* *INDENT-ON* */
 
@@ -96,6 +122,9 @@ int main(int argc, char **argv)
 
 	char severity = '\0';
 	const char *config_filename = NULL;
+	const char *cache_dir = NULL;
+	const char *snapshot_out = NULL;
+	const char *context_snapshot = NULL;
 	int source_flag = 0;
 	int recursive_scan = 0;
 	int only_enabled = 0;
@@ -103,6 +132,10 @@ int main(int argc, char **argv)
 	int summary_flag = 0;
 	int fail_on_finding = 0;
 	int scan_hidden_dirs = 0;
+	int watch_flag = 0;
+	int profile_checks = 0;
+	const char *profile_out = NULL;
+	const char *trace_out = NULL;
 	struct string_list *context_paths = NULL;
 	char color = 0;  // 0 auto, 1 off, 2 on
 
@@ -121,8 +154,11 @@ int main(int argc, char **argv)
 	while (1) {
 
 		static const struct option long_options[] = {
+			{ "build-context-snapshot", required_argument, NULL,    BUILD_SNAPSHOT_ID },
+			{ "cache-dir",        required_argument, NULL,          CACHE_DIR_ID },
 			{ "config",           required_argument, NULL,          'c' },
 			{ "context",          required_argument, NULL,          CONTEXT_ID },
+			{ "context-snapshot", required_argument, NULL,          SNAPSHOT_ID },
 			{ "debug-parser",     no_argument,       NULL,          DEBUG_PARSER_ID },
 			{ "disable",          required_argument, NULL,          'd' },
 			{ "enable",           required_argument, NULL,          'e' },
@@ -130,16 +166,20 @@ int main(int argc, char **argv)
 			{ "full-path",        no_argument,       NULL,          FULL_PATH_ID },
 			{ "only-enabled",     no_argument,       NULL,          'E' },
 			{ "help",             no_argument,       NULL,          'h' },
+			{ "jobs",             required_argument, NULL,          'j' },
 			{ "level",            required_argument, NULL,          'l' },
 			{ "modules-conf",     required_argument, NULL,          'm' },
+			{ "profile-checks",   optional_argument, NULL,          PROFILE_CHECKS_ID },
 			{ "recursive",        no_argument,       NULL,          'r' },
 			{ "source",           no_argument,       NULL,          's' },
 			{ "summary",          no_argument,       NULL,          'S' },
 			{ "color",            required_argument, NULL,          COLOR_ID },
 			{ "scan-hidden-dirs", no_argument,       NULL,          SCAN_HIDDEN_DIRS_ID },
 			{ "summary-only",     no_argument,       NULL,          SUMMARY_ONLY_ID },
+			{ "trace-out",        required_argument, NULL,          TRACE_OUT_ID },
 			{ "version",          no_argument,       NULL,          'V' },
 			{ "verbose",          no_argument,       &verbose_flag, 1   },
+			{ "watch",            no_argument,       NULL,          WATCH_ID },
 			{ 0,                  0,                 0,             0   }
 		};
 
@@ -147,7 +187,7 @@ int main(int argc, char **argv)
 
 		int c = getopt_long(argc,
 		                    argv,
-		                    "c:d:e:EFhl:mrsSVv",
+		                    "c:d:e:EFhj:l:mrsSVv",
 		                    long_options,
 		                    &option_index);
 
@@ -165,6 +205,16 @@ int main(int argc, char **argv)
 			config_filename = optarg;
 			break;
 
+		case BUILD_SNAPSHOT_ID:
+			// Write a snapshot of the development headers and exit
+			snapshot_out = optarg;
+			break;
+
+		case CACHE_DIR_ID:
+			// Specify a directory for the parse cache
+			cache_dir = optarg;
+			break;
+
 		case CONTEXT_ID:
 			// Specify a path for context files
 			if (!context_paths) {
@@ -176,6 +226,11 @@ int main(int argc, char **argv)
 			source_flag = 1;
 			break;
 
+		case SNAPSHOT_ID:
+			// Load the development headers from a snapshot
+			context_snapshot = optarg;
+			break;
+
 		case COLOR_ID:
 			if (0 == strcmp(optarg, "on")) {
 				color = 2;
@@ -243,6 +298,20 @@ int main(int argc, char **argv)
 			usage();
 			exit(0);
 
+		case 'j': {
+			// Set the number of worker threads
+			char *end;
+			errno = 0;
+			const unsigned long jobs = strtoul(optarg, &end, 10);
+			if (errno != 0 || *end != '\0' || jobs == 0 || jobs > 1024 || optarg[0] == '-') {
+				printf("Invalid argument '%s' given for option --jobs\n", optarg);
+				usage();
+				exit(EX_USAGE);
+			}
+			parallel_jobs = (unsigned int)jobs;
+			break;
+		}
+
 		case 'l':
 			// Set the severity level
 			severity = optarg[0];
@@ -258,6 +327,12 @@ int main(int argc, char **argv)
 			// TODO
 			break;
 
+		case PROFILE_CHECKS_ID:
+			// Profile the checks, and optionally write the profiles as JSON
+			profile_checks = 1;
+			profile_out = optarg;
+			break;
+
 		case 'r':
 			// Scan recursively for files to parse
 			recursive_scan = 1;
@@ -282,6 +357,11 @@ int main(int argc, char **argv)
 			summary_flag = 1;
 			break;
 
+		case TRACE_OUT_ID:
+			// Write the spans of the phases of the run
+			trace_out = optarg;
+			break;
+
 		case 'V':
 			// Output version info and exit
 			printf("SELint %s\n", VERSION);
@@ -292,6 +372,11 @@ int main(int argc, char **argv)
 			verbose_flag = 1;
 			break;
 
+		case WATCH_ID:
+			// Check changed files again until interrupted
+			watch_flag = 1;
+			break;
+
 		case '?':
 			usage();
 			exit(EX_USAGE);
@@ -301,6 +386,17 @@ int main(int argc, char **argv)
 
 	print_if_verbose("Verbose mode enabled\n");
 
+	if (trace_out) {
+		if (SELINT_SUCCESS != trace_open(trace_out)) {
+			printf("%sError%s: Failed to write trace to '%s': %s\n", color_error(), color_reset(), trace_out, strerror(errno));
+			exit(EX_CANTCREAT);
+		}
+		// Also finish the trace of runs exiting early
+		atexit(trace_close);
+	}
+
+	struct trace_span span;
+
 	if (color == 2 || (color == 0 && isatty(STDOUT_FILENO))) {
 		color_enable();
 		print_if_verbose("Color output enabled\n");
@@ -312,6 +408,11 @@ int main(int argc, char **argv)
 		if (!recursive_scan) {
 			printf("%sNote%s: Source mode enabled without recursive flag (only explicit specified files will be checked).\n", color_note(), color_reset());
 		}
+
+		if (context_snapshot) {
+			// The development headers are not used in source mode
+			print_if_verbose("Ignoring context snapshot in source mode\n");
+		}
 	}
 
 	for (const struct string_list * cur = cl_disabled_checks; cur; cur = cur->next) {
@@ -321,6 +422,33 @@ int main(int argc, char **argv)
 		WARN_ON_INVALID_CHECK_ID(cur->string, "enabled on command line");
 	}
 
+	if (cache_dir) {
+		if (yydebug) {
+			// Cache hits would not show any parser debug output
+			print_if_verbose("Parse cache disabled by --debug-parser\n");
+		} else if (SELINT_SUCCESS != enable_parse_cache(cache_dir)) {
+			printf("%sError%s: Failed to use cache directory '%s': %s\n", color_error(), color_reset(), cache_dir, strerror(errno));
+			exit(EX_CANTCREAT);
+		} else {
+			print_if_verbose("Parse cache directory set to %s\n", cache_dir);
+			if (SELINT_SUCCESS != prune_parse_cache(PARSE_CACHE_MAX_ENTRIES)) {
+				print_if_verbose("Failed to prune cache directory %s\n", cache_dir);
+			}
+		}
+	}
+
+	if (snapshot_out) {
+		enum selint_error res = build_context_snapshot(snapshot_out, DEVEL_HEADERS_DIR);
+		if (res == SELINT_PARSE_ERROR) {
+			printf("%sError%s: Failed to parse development headers in %s\n", color_error(), color_reset(), DEVEL_HEADERS_DIR);
+			exit(EX_SOFTWARE);
+		} else if (res != SELINT_SUCCESS) {
+			printf("%sError%s: Failed to write context snapshot '%s': %s\n", color_error(), color_reset(), snapshot_out, strerror(errno));
+			exit(EX_CANTCREAT);
+		}
+		exit(EX_OK);
+	}
+
 	if (config_filename && 0 != access(config_filename, R_OK)) {
 		printf("%sError%s: No configuration file found at '%s'!\n", color_error(), color_reset(), config_filename);
 		exit(EX_USAGE);
@@ -339,12 +467,14 @@ int main(int argc, char **argv)
 
 	if (config_filename) {
 		char cfg_severity;
+		trace_begin(&span, "load config");
 		if (SELINT_SUCCESS != parse_config(config_filename, source_flag,
 		                                   &cfg_severity, &config_disabled_checks,
 		                                   &config_enabled_checks, &custom_fc_macros, &ccd)) {
 			// Error message printed by parse_config()
 			exit(EX_CONFIG);
 		}
+		trace_end(&span, config_filename, NULL, 0);
 		if (severity == '\0') {
 			severity = cfg_severity;
 		}
@@ -403,6 +533,8 @@ int main(int argc, char **argv)
 
 	paths[i] = NULL;
 
+	trace_begin(&span, "scan files");
+
 	FTS *ftsp = fts_open(paths, FTS_PHYSICAL | FTS_NOSTAT, NULL);
 
 	FTSENT *file = fts_read(ftsp);
@@ -424,10 +556,7 @@ int main(int argc, char **argv)
 			file_list_push_back(if_files,
 			                    make_policy_file(file->fts_path,
 			                                     NULL));
-			char *mod_name = xstrdup(file->fts_name);
-			mod_name[file->fts_namelen - 3] = '\0';
-			insert_into_mod_layers_map(mod_name, file->fts_parent->fts_name);
-			free(mod_name);
+			insert_mod_layer_of_if_file(file->fts_path);
 		} else if (suffix && !strcmp(suffix, ".fc")) {
 			file_list_push_back(fc_files,
 			                    make_policy_file(file->fts_path,
@@ -499,10 +628,23 @@ int main(int argc, char **argv)
 
 	fts_close(ftsp);
 
+	trace_end(&span, NULL, "files",
+	          file_list_length(te_files) + file_list_length(if_files) + file_list_length(fc_files));
+
+	// Context paths usually overlap the checked files, so look them up by
+	// canonical path
+	index_file_list(te_files);
+	index_file_list(if_files);
+
+	trace_begin(&span, "scan context");
+
 	struct string_list *context_path_node = context_paths;
 
 	while (context_path_node) {
+		// fts_open() does not modify the paths
+IGNORE_CONST_DISCARD_BEGIN
 		paths[0] = context_path_node->string;
+IGNORE_CONST_DISCARD_END
 		paths[1] = NULL;
 
 		ftsp = fts_open(paths, FTS_PHYSICAL | FTS_NOSTAT, NULL);
@@ -535,8 +677,8 @@ int main(int argc, char **argv)
                                    && 0 == strcmp(file->fts_name, "access_vectors")) {
 				access_vector_path = xstrdup(file->fts_path);
 			} else if (source_flag
-			           && !str_in_sl(file->fts_path, global_cond_files)
-			           && (0 == strcmp(file->fts_name, "global_booleans") || 0 == strcmp(file->fts_name, "global_tunables"))) {
+			           && (0 == strcmp(file->fts_name, "global_booleans") || 0 == strcmp(file->fts_name, "global_tunables"))
+			           && !str_in_sl(file->fts_path, global_cond_files)) {
 				global_cond_files = concat_string_lists(global_cond_files, sl_from_str(file->fts_path));
 			} else if (source_flag
 			           && !security_classes_path
@@ -550,13 +692,21 @@ int main(int argc, char **argv)
 		context_path_node = context_path_node->next;
 	}
 
+	unindex_file_list(te_files);
+	unindex_file_list(if_files);
+
+	trace_end(&span, NULL, "files",
+	          file_list_length(context_te_files) + file_list_length(context_if_files));
+
 	free_string_list(context_paths);
 	free(paths);
 
 	// Load object classes and permissions
 	if (source_flag) {
 		if (access_vector_path) {
+			trace_begin(&span, "load access vectors");
 			enum selint_error res = load_access_vectors_source(access_vector_path);
+			trace_end(&span, access_vector_path, NULL, 0);
 			if (res != SELINT_SUCCESS) {
 				printf("%sWarning%s: Failed to parse access_vectors from %s: %d\n", color_warning(), color_reset(), access_vector_path, res);
 			} else {
@@ -567,7 +717,9 @@ int main(int argc, char **argv)
 		}
 
 		if (security_classes_path) {
+			trace_begin(&span, "load security classes");
 			enum selint_error res = load_security_classes_source(security_classes_path);
+			trace_end(&span, security_classes_path, NULL, 0);
 			if (res != SELINT_SUCCESS) {
 				printf("%sWarning%s: Failed to parse security_classes from %s: %d\n", color_warning(), color_reset(), security_classes_path, res);
 			} else {
@@ -579,8 +731,10 @@ int main(int argc, char **argv)
 		}
 
 		if (modules_conf_path) {
+			trace_begin(&span, "load modules.conf");
 			enum selint_error res =
 				load_modules_source(modules_conf_path);
+			trace_end(&span, modules_conf_path, NULL, 0);
 			if (res != SELINT_SUCCESS) {
 				printf("%sWarning%s: Failed to load modules from %s: %d\n", color_warning(), color_reset(), modules_conf_path, res);
 			} else {
@@ -592,8 +746,10 @@ int main(int argc, char **argv)
 		}
 
 		if (obj_perm_sets_path) {
+			trace_begin(&span, "load obj_perm_sets");
 			enum selint_error res =
 				load_obj_perm_sets_source(obj_perm_sets_path);
+			trace_end(&span, obj_perm_sets_path, NULL, 0);
 			if (res != SELINT_SUCCESS) {
 				printf("%sWarning%s: Failed to permission and class set macros from %s: %d\n", color_warning(), color_reset(), obj_perm_sets_path, res);
 			} else {
@@ -605,7 +761,9 @@ int main(int argc, char **argv)
 		}
 
 		if (global_cond_files) {
+			trace_begin(&span, "load global conditions");
 			enum selint_error res = load_global_conditions(global_cond_files);
+			trace_end(&span, NULL, NULL, 0);
 			if (res != SELINT_SUCCESS) {
 				printf("%sWarning%s: Failed to parse global conditions: %d\n", color_warning(), color_reset(), res);
 			} else {
@@ -616,7 +774,9 @@ int main(int argc, char **argv)
 		}
 
 	} else {
+		trace_begin(&span, "load access vectors");
 		enum selint_error r = load_access_vectors_kernel("/sys/fs/selinux/class");
+		trace_end(&span, "/sys/fs/selinux/class", NULL, 0);
 		if (r != SELINT_SUCCESS) {
 			if (r == SELINT_IO_ERROR) {
 				printf("%sNote%s: Failed to load classes and perms probably due to running on a SELinux disabled system.\n",
@@ -627,20 +787,40 @@ int main(int argc, char **argv)
 			}
 		}
 
+		trace_begin(&span, "load modules");
 		load_modules_normal();
-		enum selint_error res = load_devel_headers(context_if_files);
+		trace_end(&span, NULL, NULL, 0);
+		enum selint_error res = SELINT_IO_ERROR;
+		if (context_snapshot) {
+			trace_begin(&span, "load context snapshot");
+			res = load_context_snapshot(context_snapshot, DEVEL_HEADERS_DIR);
+			trace_end(&span, context_snapshot, NULL, 0);
+			if (res != SELINT_SUCCESS) {
+				printf("%sNote%s: Context snapshot %s is unreadable or out of date, parsing development header files instead.\n",
+				       color_note(), color_reset(), context_snapshot);
+			} else {
+				print_if_verbose("Loaded development headers from context snapshot %s\n", context_snapshot);
+			}
+		}
 		if (res != SELINT_SUCCESS) {
-			printf("%sWarning%s: Failed to load SELinux development header files.\n", color_warning(), color_reset());
+			trace_begin(&span, "load devel headers");
+			res = load_devel_headers(context_if_files);
+			trace_end(&span, DEVEL_HEADERS_DIR, "files", file_list_length(context_if_files));
+			if (res != SELINT_SUCCESS) {
+				printf("%sWarning%s: Failed to load SELinux development header files.\n", color_warning(), color_reset());
+			}
 		}
 	}
 
 	/* Delay until support files have been parsed for check conditions. */
+	trace_begin(&span, "register checks");
 	struct checks *ck = register_checks(severity,
 	                                    config_enabled_checks,
 	                                    config_disabled_checks,
 	                                    cl_enabled_checks,
 	                                    cl_disabled_checks,
 	                                    only_enabled);
+	trace_end(&span, NULL, "checks", ck ? ck->check_node_count : 0);
 
 	if (!ck) {
 		printf("%sError%s: Failed to register checks (bad configuration)\n", color_error(), color_reset());
@@ -655,6 +835,7 @@ int main(int argc, char **argv)
 		free(modules_conf_path);
 		free_string_list(global_cond_files);
 		free_string_list(custom_fc_macros);
+		free_context_snapshot();
 		return EX_CONFIG;
 	}
 
@@ -664,22 +845,54 @@ int main(int argc, char **argv)
 	free(modules_conf_path);
 	free_string_list(global_cond_files);
 
-	enum selint_error res = run_analysis(ck, te_files, if_files, fc_files, context_te_files, context_if_files, custom_fc_macros, &ccd);
+	if (profile_checks) {
+		enable_check_profiling(ck);
+	}
+
+	enum selint_error res;
+	if (watch_flag) {
+		res = watch_analysis(ck, te_files, if_files, fc_files, context_te_files, context_if_files, custom_fc_macros, &ccd, summary_flag);
+	} else {
+		res = run_analysis(ck, te_files, if_files, fc_files, context_te_files, context_if_files, custom_fc_macros, &ccd);
+	}
 	switch (res) {
 	case SELINT_SUCCESS:
-		if (summary_flag) {
+		// Watch mode displays a summary after every run
+		if (summary_flag && !watch_flag) {
 			display_run_summary(ck);
 		}
+		if (profile_checks) {
+			display_check_profiles(ck);
+		}
+		if (profile_out) {
+			FILE *out = fopen(profile_out, "w");
+			if (!out) {
+				printf("%sError%s: Failed to write check profiles to '%s': %s\n", color_error(), color_reset(), profile_out, strerror(errno));
+				exit_code = EX_CANTCREAT;
+				break;
+			}
+			write_check_profiles(ck, out);
+			fclose(out);
+		}
 		break;
 	case SELINT_PARSE_ERROR:
 		printf("%sError%s: Failed to parse files\n", color_error(), color_reset());
 		exit_code = EX_SOFTWARE;
 		break;
+	case SELINT_IO_ERROR:
+		if (watch_flag) {
+			// Error message printed by watch_analysis()
+			exit_code = EX_OSERR;
+			break;
+		}
+		// FALLTHRU
 	default:
 		printf("%sError%s: Internal error: %d\n", color_error(), color_reset(), res);
 		exit_code = EX_SOFTWARE;
 	}
 
+	trace_begin(&span, "cleanup");
+
 	if (config_enabled_checks) {
 		free_string_list(config_enabled_checks);
 	}
@@ -700,8 +913,11 @@ int main(int argc, char **argv)
 	free_file_list(context_te_files);
 	free_file_list(context_if_files);
 	free_string_list(custom_fc_macros);
+	free_context_snapshot();
 	free_selint_config(&ccd);
 
+	trace_end(&span, NULL, NULL, 0);
+
 	if (fail_on_finding && found_issue && exit_code == EX_OK) {
 		return EX_DATAERR;
 	}
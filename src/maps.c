@@ -14,143 +14,305 @@
 * limitations under the License.
 */
 
+#include <stdint.h>
+#include <string.h>
+
+#include "intern.h"
 #include "maps.h"
+#include "util.h"
 #include "xalloc.h"
 
-#if defined(__clang__) && defined(__clang_major__) && (__clang_major__ >= 4)
-#if (__clang_major__ >= 12)
-#define no_sanitize_unsigned_integer_       __attribute__((no_sanitize("unsigned-integer-overflow", "unsigned-shift-base")))
-#else
-#define no_sanitize_unsigned_integer_       __attribute__((no_sanitize("unsigned-integer-overflow")))
-#endif
-#else
-#define no_sanitize_unsigned_integer_
-#endif
-
 int userspace_class_support = 0;
 
-static struct hash_elem *type_map = NULL;
-static struct hash_elem *role_map = NULL;
-static struct hash_elem *user_map = NULL;
-static struct hash_elem *attr_type_map = NULL;
-static struct hash_elem *attr_role_map = NULL;
-static struct hash_elem *bool_map = NULL;
-static struct hash_elem *class_map = NULL;
-static struct hash_elem *perm_map = NULL;
-static struct hash_elem *mods_map = NULL;
-static struct hash_elem *mod_layers_map = NULL;
-static struct if_hash_elem *interfaces_map = NULL;
-static struct bool_hash_elem *userspace_class_map = NULL;
-static struct sl_hash_elem *permmacros_map = NULL;
-static struct template_hash_elem *template_map = NULL;
+#define DECL_FLAVORS (DECL_BOOL + 1)
+#define DECL_TABLE_MIN_CAPACITY 1024
+
+struct decl_entry {
+	const char *name;       // atom
+	const char *module;     // atom
+	uint32_t hash;
+	uint32_t flavor;
+	uint32_t id;            // ordinal among the declarations of its flavor
+	uint32_t insertions;    // 0 once all insertions are removed again
+};
+
+// The permissions of a class, a bit for each permission id
+struct perm_set {
+	uint64_t *words;
+	uint32_t word_count;
+};
+
+// Declarations of all flavors, stored in insertion order.  The index is an
+// open addressing table with linear probing, at most half full, holding
+// one plus the position of each entry, or 0 for an empty slot.  Removed
+// entries keep their position and id, until they are declared again.
+struct decl_table {
+	struct decl_entry *entries;
+	uint32_t count;
+	uint32_t entries_capacity;
+	uint32_t *index;
+	uint32_t index_capacity;
+	unsigned int flavor_counts[DECL_FLAVORS];      // declared entries
+	uint32_t flavor_ids[DECL_FLAVORS];             // all entries
+	struct perm_set *class_perms;   // indexed by class id
+	uint32_t class_perms_capacity;
+};
+
+struct template_expansion_elem {
+	char *key;
+	size_t key_len;
+	struct template_expansion expansion;
+	UT_hash_handle hh;
+};
+
+struct maps {
+	struct decl_table decls;
+	struct hash_elem *mods_map;
+	struct hash_elem *mod_layers_map;
+	struct if_hash_elem *interfaces_map;
+	struct bool_hash_elem *userspace_class_map;
+	struct sl_hash_elem *permmacros_map;
+	struct template_hash_elem *template_map;
+	struct template_expansion_elem *template_expansions;
+};
+
+// The maps of the current context, see selint_context.h.  Shared by all
+// threads, like the maps themselves.
+static struct maps default_maps;
+static struct maps *maps = &default_maps;
+
+struct map_changes {
+	struct map_change *head;
+	struct map_change *tail;
+};
+
+static _Thread_local struct map_changes *staged_changes = NULL;
+
+static struct map_change *stage_change(enum map_change_flavor flavor,
+                                       const char *name, const char *value)
+{
+	struct map_change *change = xcalloc(1, sizeof(struct map_change));
+
+	change->flavor = flavor;
+	change->name = name ? intern(name) : NULL;
+	change->value = value ? intern(value) : NULL;
 
+	if (staged_changes->tail) {
+		staged_changes->tail->next = change;
+	} else {
+		staged_changes->head = change;
+	}
+	staged_changes->tail = change;
+
+	return change;
+}
+
+// Atoms are distinct pointers, so hash the address, mixed with the flavor
+// (the finalizer of splitmix64)
 no_sanitize_unsigned_integer_
-static struct hash_elem *look_up_hash_elem(const char *name, enum decl_flavor flavor)
+static uint32_t hash_decl(const char *atom, enum decl_flavor flavor)
+{
+	uint64_t x = (uint64_t)(uintptr_t)atom ^ ((uint64_t)flavor << 56);
+
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9u;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebu;
+	x ^= x >> 31;
+
+	return (uint32_t)x;
+}
+
+// Return the index slot of the declaration, or the empty slot it belongs in
+static uint32_t *find_decl_slot(const char *atom, enum decl_flavor flavor, uint32_t hash)
+{
+	const uint32_t mask = maps->decls.index_capacity - 1;
+
+	for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+		uint32_t *slot = &maps->decls.index[i];
+		if (*slot == 0) {
+			return slot;
+		}
+		const struct decl_entry *entry = &maps->decls.entries[*slot - 1];
+		if (entry->hash == hash && entry->name == atom && entry->flavor == flavor) {
+			return slot;
+		}
+	}
+}
+
+static void grow_decl_index(void)
 {
+	free(maps->decls.index);
 
-	if (!name) {
+	maps->decls.index_capacity = maps->decls.index_capacity ? maps->decls.index_capacity * 2 : DECL_TABLE_MIN_CAPACITY;
+	maps->decls.index = xcalloc(maps->decls.index_capacity, sizeof(uint32_t));
+
+	const uint32_t mask = maps->decls.index_capacity - 1;
+	for (uint32_t pos = 0; pos < maps->decls.count; pos++) {
+		uint32_t i = maps->decls.entries[pos].hash & mask;
+		while (maps->decls.index[i]) {
+			i = (i + 1) & mask;
+		}
+		maps->decls.index[i] = pos + 1;
+	}
+}
+
+static const struct decl_entry *look_up_decl_entry(const char *atom, enum decl_flavor flavor)
+{
+	if (!atom || maps->decls.count == 0 || (unsigned int)flavor >= DECL_FLAVORS) {
 		return NULL;
 	}
 
-	struct hash_elem *decl;
+	const uint32_t *slot = find_decl_slot(atom, flavor, hash_decl(atom, flavor));
 
-	switch (flavor) {
-	case DECL_TYPE:
-		HASH_FIND(hh_type, type_map, name, strlen(name), decl);
-		break;
-	case DECL_ROLE:
-		HASH_FIND(hh_role, role_map, name, strlen(name), decl);
-		break;
-	case DECL_USER:
-		HASH_FIND(hh_user, user_map, name, strlen(name), decl);
-		break;
-	case DECL_ATTRIBUTE:
-		HASH_FIND(hh_attr_type, attr_type_map, name, strlen(name), decl);
-		break;
-	case DECL_ATTRIBUTE_ROLE:
-		HASH_FIND(hh_attr_role, attr_role_map, name, strlen(name), decl);
-		break;
-	case DECL_BOOL:
-		HASH_FIND(hh_bool, bool_map, name, strlen(name), decl);
-		break;
-	case DECL_CLASS:
-		HASH_FIND(hh_class, class_map, name, strlen(name), decl);
-		break;
-	case DECL_PERM:
-		HASH_FIND(hh_perm, perm_map, name, strlen(name), decl);
-		break;
-	default:
-		decl = NULL;
+	if (*slot == 0 || maps->decls.entries[*slot - 1].insertions == 0) {
+		return NULL;
 	}
 
-	return decl;
+	return &maps->decls.entries[*slot - 1];
 }
 
-no_sanitize_unsigned_integer_
 void insert_into_decl_map(const char *name, const char *module_name,
                           enum decl_flavor flavor)
 {
 
-	struct hash_elem *decl = look_up_hash_elem(name, flavor);
-
-	if (decl == NULL) {     // Item not in hash table already
-
-		decl = xmalloc(sizeof(struct hash_elem));
-		decl->key = xstrdup(name);
-		decl->val = xstrdup(module_name);
-
-		switch (flavor) {
-		case DECL_TYPE:
-			HASH_ADD_KEYPTR(hh_type, type_map, decl->key,
-			                strlen(decl->key), decl);
-			break;
-		case DECL_ROLE:
-			HASH_ADD_KEYPTR(hh_role, role_map, decl->key,
-			                strlen(decl->key), decl);
-			break;
-		case DECL_USER:
-			HASH_ADD_KEYPTR(hh_user, user_map, decl->key,
-			                strlen(decl->key), decl);
-			break;
-		case DECL_ATTRIBUTE:
-			HASH_ADD_KEYPTR(hh_attr_type, attr_type_map, decl->key,
-			                strlen(decl->key), decl);
-			break;
-		case DECL_ATTRIBUTE_ROLE:
-			HASH_ADD_KEYPTR(hh_attr_role, attr_role_map, decl->key,
-			                strlen(decl->key), decl);
-			break;
-		case DECL_BOOL:
-			HASH_ADD_KEYPTR(hh_bool, bool_map, decl->key,
-			                strlen(decl->key), decl);
-			break;
-		case DECL_CLASS:
-			HASH_ADD_KEYPTR(hh_class, class_map, decl->key,
-			                strlen(decl->key), decl);
-			break;
-		case DECL_PERM:
-			HASH_ADD_KEYPTR(hh_perm, perm_map, decl->key,
-			                strlen(decl->key), decl);
-			break;
-		default:
-			free(decl->key);
-			free(decl->val);
-			free(decl);
-			return;
+	if (staged_changes) {
+		stage_change(CHANGE_DECL, name, module_name)->data.decl_flavor = flavor;
+		return;
+	}
+
+	if ((unsigned int)flavor >= DECL_FLAVORS) {
+		return;
+	}
+
+	if (2 * (maps->decls.count + 1) > maps->decls.index_capacity) {
+		grow_decl_index();
+	}
+
+	const char *atom = intern(name);
+	const uint32_t hash = hash_decl(atom, flavor);
+	uint32_t *slot = find_decl_slot(atom, flavor, hash);
+
+	if (*slot == 0) {       // Item not in hash table already
+
+		if (maps->decls.count == maps->decls.entries_capacity) {
+			maps->decls.entries_capacity = maps->decls.entries_capacity ? maps->decls.entries_capacity * 2 : DECL_TABLE_MIN_CAPACITY / 2;
+			maps->decls.entries = xrealloc(maps->decls.entries, maps->decls.entries_capacity * sizeof(struct decl_entry));
 		}
-	}       //TODO: else report error?
+
+		struct decl_entry *entry = &maps->decls.entries[maps->decls.count];
+		entry->name = atom;
+		entry->module = intern(module_name);
+		entry->hash = hash;
+		entry->flavor = flavor;
+		entry->id = maps->decls.flavor_ids[flavor]++;
+		entry->insertions = 1;
+		maps->decls.flavor_counts[flavor]++;
+
+		*slot = ++maps->decls.count;
+	} else {
+		struct decl_entry *entry = &maps->decls.entries[*slot - 1];
+
+		if (entry->insertions++ == 0) {
+			// Declared again after all declarations got removed
+			entry->module = intern(module_name);
+			maps->decls.flavor_counts[flavor]++;
+		}       //TODO: else report error?
+	}
+}
+
+void remove_from_decl_map(const char *name, enum decl_flavor flavor)
+{
+	const char *atom = find_atom(name);
+
+	if (!atom || maps->decls.count == 0 || (unsigned int)flavor >= DECL_FLAVORS) {
+		return;
+	}
+
+	const uint32_t *slot = find_decl_slot(atom, flavor, hash_decl(atom, flavor));
+	if (*slot == 0) {
+		return;
+	}
+
+	struct decl_entry *entry = &maps->decls.entries[*slot - 1];
+
+	if (entry->insertions > 0 && --entry->insertions == 0) {
+		maps->decls.flavor_counts[flavor]--;
+	}
 }
 
 const char *look_up_in_decl_map(const char *name, enum decl_flavor flavor)
+{
+	// A string that was never interned was never declared
+	return look_up_atom_in_decl_map(name ? find_atom(name) : NULL, flavor);
+}
+
+const char *look_up_atom_in_decl_map(const char *atom, enum decl_flavor flavor)
 {
 
-	struct hash_elem *decl = look_up_hash_elem(name, flavor);
+	const struct decl_entry *decl = look_up_decl_entry(atom, flavor);
 
 	if (decl == NULL) {
 		return NULL;
 	} else {
-		return decl->val;
+		return decl->module;
+	}
+}
+
+void insert_into_class_perms(const char *class_name, const char *perm)
+{
+	if (staged_changes) {
+		stage_change(CHANGE_CLASS_PERM, class_name, perm);
+		return;
+	}
+
+	const struct decl_entry *class = look_up_decl_entry(find_atom(class_name), DECL_CLASS);
+	const struct decl_entry *perm_decl = look_up_decl_entry(find_atom(perm), DECL_PERM);
+
+	if (!class || !perm_decl) {
+		return;
+	}
+
+	if (class->id >= maps->decls.class_perms_capacity) {
+		uint32_t capacity = maps->decls.class_perms_capacity ? maps->decls.class_perms_capacity : 64;
+		while (capacity <= class->id) {
+			capacity *= 2;
+		}
+		maps->decls.class_perms = xrealloc(maps->decls.class_perms, capacity * sizeof(struct perm_set));
+		memset(maps->decls.class_perms + maps->decls.class_perms_capacity, 0,
+		       (capacity - maps->decls.class_perms_capacity) * sizeof(struct perm_set));
+		maps->decls.class_perms_capacity = capacity;
+	}
+
+	struct perm_set *set = &maps->decls.class_perms[class->id];
+	const uint32_t word = perm_decl->id / 64;
+
+	if (word >= set->word_count) {
+		set->words = xrealloc(set->words, (word + 1) * sizeof(uint64_t));
+		memset(set->words + set->word_count, 0, (word + 1 - set->word_count) * sizeof(uint64_t));
+		set->word_count = word + 1;
+	}
+
+	set->words[word] |= UINT64_C(1) << (perm_decl->id % 64);
+}
+
+int class_has_perm(const char *class_atom, const char *perm_atom)
+{
+	const struct decl_entry *class = look_up_decl_entry(class_atom, DECL_CLASS);
+	const struct decl_entry *perm = look_up_decl_entry(perm_atom, DECL_PERM);
+
+	if (!class || !perm || class->id >= maps->decls.class_perms_capacity) {
+		return -1;
+	}
+
+	const struct perm_set *set = &maps->decls.class_perms[class->id];
+	const uint32_t word = perm->id / 64;
+
+	if (set->word_count == 0) {
+		return -1;
 	}
+
+	return word < set->word_count && (set->words[word] >> (perm->id % 64)) & 1;
 }
 
 no_sanitize_unsigned_integer_
@@ -159,13 +321,13 @@ void insert_into_mods_map(const char *mod_name, const char *status)
 
 	struct hash_elem *mod;
 
-	HASH_FIND(hh_mods, mods_map, mod_name, strlen(mod_name), mod);
+	HASH_FIND(hh_mods, maps->mods_map, mod_name, strlen(mod_name), mod);
 
 	if (!mod) {
 		mod = xmalloc(sizeof(struct hash_elem));
-		mod->key = xstrdup(mod_name);
-		mod->val = xstrdup(status);
-		HASH_ADD_KEYPTR(hh_mods, mods_map, mod->key, strlen(mod->key),
+		mod->key = intern(mod_name);
+		mod->val = intern(status);
+		HASH_ADD_KEYPTR(hh_mods, maps->mods_map, mod->key, strlen(mod->key),
 		                mod);
 	}
 }
@@ -176,7 +338,7 @@ const char *look_up_in_mods_map(const char *mod_name)
 
 	struct hash_elem *mod;
 
-	HASH_FIND(hh_mods, mods_map, mod_name, strlen(mod_name), mod);
+	HASH_FIND(hh_mods, maps->mods_map, mod_name, strlen(mod_name), mod);
 
 	if (mod == NULL) {
 		return NULL;
@@ -190,13 +352,13 @@ void insert_into_mod_layers_map(const char *mod_name, const char *layer)
 {
 	struct hash_elem *mod;
 
-	HASH_FIND(hh_mod_layers, mod_layers_map, mod_name, strlen(mod_name), mod);
+	HASH_FIND(hh_mod_layers, maps->mod_layers_map, mod_name, strlen(mod_name), mod);
 
 	if (!mod) {
 		mod = xmalloc(sizeof(struct hash_elem));
-		mod->key = xstrdup(mod_name);
-		mod->val = xstrdup(layer);
-		HASH_ADD_KEYPTR(hh_mod_layers, mod_layers_map, mod->key, strlen(mod->key),
+		mod->key = intern(mod_name);
+		mod->val = intern(layer);
+		HASH_ADD_KEYPTR(hh_mod_layers, maps->mod_layers_map, mod->key, strlen(mod->key),
 		                mod);
 	}
 
@@ -207,7 +369,7 @@ const char *look_up_in_mod_layers_map(const char *mod_name)
 {
 	struct hash_elem *mod;
 
-	HASH_FIND(hh_mod_layers, mod_layers_map, mod_name, strlen(mod_name), mod);
+	HASH_FIND(hh_mod_layers, maps->mod_layers_map, mod_name, strlen(mod_name), mod);
 
 	if (mod == NULL) {
 		return NULL;
@@ -216,24 +378,85 @@ const char *look_up_in_mod_layers_map(const char *mod_name)
 	}
 }
 
+no_sanitize_unsigned_integer_
+static struct if_hash_elem *find_or_add_if(const char *if_name)
+{
+	struct if_hash_elem *elem;
+
+	HASH_FIND(hh_interfaces, maps->interfaces_map, if_name, strlen(if_name), elem);
+
+	if (!elem) {
+		elem = xcalloc(1, sizeof(struct if_hash_elem));
+		elem->name = intern(if_name);
+		HASH_ADD_KEYPTR(hh_interfaces, maps->interfaces_map, elem->name,
+				strlen(elem->name), elem);
+	}
+
+	return elem;
+}
+
+static void update_if_flags(struct if_hash_elem *elem)
+{
+	elem->flags = elem->derived_flags;
+
+	for (unsigned int i = 0; i < IF_FLAG_COUNT; i++) {
+		if (elem->flag_counts[i] > 0) {
+			elem->flags |= (uint8_t)(1u << i);
+		}
+	}
+}
+
+static void mark_if(const char *if_name, uint8_t flag)
+{
+	if (staged_changes) {
+		stage_change(CHANGE_IF_FLAG, if_name, NULL)->data.if_flag = flag;
+		return;
+	}
+
+	struct if_hash_elem *elem = find_or_add_if(if_name);
+
+	elem->flag_counts[__builtin_ctz(flag)]++;
+	elem->flags |= flag;
+}
+
+no_sanitize_unsigned_integer_
+static void unmark_if(const char *if_name, uint8_t flag)
+{
+	struct if_hash_elem *elem;
+
+	HASH_FIND(hh_interfaces, maps->interfaces_map, if_name, strlen(if_name), elem);
+
+	if (elem && elem->flag_counts[__builtin_ctz(flag)] > 0 &&
+	    --elem->flag_counts[__builtin_ctz(flag)] == 0) {
+		update_if_flags(elem);
+	}
+}
+
 no_sanitize_unsigned_integer_
 void insert_into_ifs_map(const char *if_name, const char *mod_name)
 {
 
+	if (staged_changes) {
+		stage_change(CHANGE_IF, if_name, mod_name);
+		return;
+	}
+
+	struct if_hash_elem *if_call = find_or_add_if(if_name);
+
+	if_call->module = intern(mod_name);
+	if_call->definitions++;
+}
+
+no_sanitize_unsigned_integer_
+static void remove_from_ifs_map(const char *if_name)
+{
 	struct if_hash_elem *if_call;
 
-	HASH_FIND(hh_interfaces, interfaces_map, if_name, strlen(if_name), if_call);
+	HASH_FIND(hh_interfaces, maps->interfaces_map, if_name, strlen(if_name), if_call);
 
-	if (!if_call) {
-		if_call = xmalloc(sizeof(struct if_hash_elem));
-		if_call->name = xstrdup(if_name);
-		if_call->module = xstrdup(mod_name);
-		if_call->flags = 0;
-		HASH_ADD_KEYPTR(hh_interfaces, interfaces_map, if_call->name,
-				strlen(if_call->name), if_call);
-	} else {
-		free(if_call->module);
-		if_call->module = xstrdup(mod_name);
+	// Another definition keeps the module of the last one inserted
+	if (if_call && if_call->definitions > 0 && --if_call->definitions == 0) {
+		if_call->module = NULL;
 	}
 }
 
@@ -243,7 +466,7 @@ const char *look_up_in_ifs_map(const char *if_name)
 
 	struct if_hash_elem *if_call;
 
-	HASH_FIND(hh_interfaces, interfaces_map, if_name, strlen(if_name), if_call);
+	HASH_FIND(hh_interfaces, maps->interfaces_map, if_name, strlen(if_name), if_call);
 
 	if (if_call == NULL) {
 		return NULL;
@@ -254,26 +477,11 @@ const char *look_up_in_ifs_map(const char *if_name)
 
 unsigned int decl_map_count(enum decl_flavor flavor)
 {
-	switch (flavor) {
-	case DECL_TYPE:
-		return HASH_CNT(hh_type, type_map);
-	case DECL_ATTRIBUTE:
-		return HASH_CNT(hh_attr_type, attr_type_map);
-	case DECL_ATTRIBUTE_ROLE:
-		return HASH_CNT(hh_attr_role, attr_role_map);
-	case DECL_ROLE:
-		return HASH_CNT(hh_role, role_map);
-	case DECL_USER:
-		return HASH_CNT(hh_user, user_map);
-	case DECL_BOOL:
-		return HASH_CNT(hh_bool, bool_map);
-	case DECL_CLASS:
-		return HASH_CNT(hh_class, class_map);
-	case DECL_PERM:
-		return HASH_CNT(hh_perm, perm_map);
-	default:
+	if ((unsigned int)flavor >= DECL_FLAVORS) {
 		return 0;
 	}
+
+	return maps->decls.flavor_counts[flavor];
 }
 
 no_sanitize_unsigned_integer_
@@ -281,13 +489,13 @@ void mark_userspace_class(const char *class_name)
 {
 	struct bool_hash_elem *userspace_class;
 
-	HASH_FIND(hh_userspace_class, userspace_class_map, class_name, strlen(class_name), userspace_class);
+	HASH_FIND(hh_userspace_class, maps->userspace_class_map, class_name, strlen(class_name), userspace_class);
 
 	if (!userspace_class) {
 		userspace_class = xmalloc(sizeof(struct bool_hash_elem));
 		userspace_class->key = xstrdup(class_name);
 		userspace_class->val = 1;
-		HASH_ADD_KEYPTR(hh_userspace_class, userspace_class_map, userspace_class->key,
+		HASH_ADD_KEYPTR(hh_userspace_class, maps->userspace_class_map, userspace_class->key,
 				strlen(userspace_class->key), userspace_class);
 	} else {
 		userspace_class->val = 1;
@@ -298,7 +506,7 @@ no_sanitize_unsigned_integer_
 int is_userspace_class(const char *class_name, const struct string_list *permissions)
 {
 	struct bool_hash_elem *userspace_class;
-	HASH_FIND(hh_userspace_class, userspace_class_map, class_name, strlen(class_name), userspace_class);
+	HASH_FIND(hh_userspace_class, maps->userspace_class_map, class_name, strlen(class_name), userspace_class);
 	if (userspace_class && userspace_class->val == 1) {
 		return 1;
 	}
@@ -331,22 +539,31 @@ int is_userspace_class(const char *class_name, const struct string_list *permiss
 	return 0;
 }
 
-no_sanitize_unsigned_integer_
 void mark_transform_if(const char *if_name)
 {
-	struct if_hash_elem *transform_if;
+	mark_if(if_name, TRANSFORM_IF);
+}
+
+void mark_derived_transform_if(const char *if_name)
+{
+	if (staged_changes) {
+		mark_transform_if(if_name);
+		return;
+	}
 
-	HASH_FIND(hh_interfaces, interfaces_map, if_name, strlen(if_name), transform_if);
+	struct if_hash_elem *elem = find_or_add_if(if_name);
 
-	if (!transform_if) {
-		transform_if = xmalloc(sizeof(struct if_hash_elem));
-		transform_if->name = xstrdup(if_name);
-		transform_if->module = NULL;
-		transform_if->flags = TRANSFORM_IF;
-		HASH_ADD_KEYPTR(hh_interfaces, interfaces_map, transform_if->name,
-				strlen(transform_if->name), transform_if);
-	} else {
-		transform_if->flags |= TRANSFORM_IF;
+	elem->derived_flags |= TRANSFORM_IF;
+	elem->flags |= TRANSFORM_IF;
+}
+
+void clear_derived_transform_ifs(void)
+{
+	struct if_hash_elem *cur_if, *tmp_if;
+
+	HASH_ITER(hh_interfaces, maps->interfaces_map, cur_if, tmp_if) {
+		cur_if->derived_flags = 0;
+		update_if_flags(cur_if);
 	}
 }
 
@@ -354,7 +571,7 @@ no_sanitize_unsigned_integer_
 int is_transform_if(const char *if_name)
 {
 	struct if_hash_elem *transform_if;
-	HASH_FIND(hh_interfaces, interfaces_map, if_name, strlen(if_name), transform_if);
+	HASH_FIND(hh_interfaces, maps->interfaces_map, if_name, strlen(if_name), transform_if);
 	if (transform_if && (transform_if->flags & TRANSFORM_IF)) {
 		return 1;
 	} else {
@@ -362,30 +579,16 @@ int is_transform_if(const char *if_name)
 	}
 }
 
-no_sanitize_unsigned_integer_
 void mark_filetrans_if(const char *if_name)
 {
-	struct if_hash_elem *filetrans_if;
-
-	HASH_FIND(hh_interfaces, interfaces_map, if_name, strlen(if_name), filetrans_if);
-
-	if (!filetrans_if) {
-		filetrans_if = xmalloc(sizeof(struct if_hash_elem));
-		filetrans_if->name = xstrdup(if_name);
-		filetrans_if->module = NULL;
-		filetrans_if->flags = FILETRANS_IF;
-		HASH_ADD_KEYPTR(hh_interfaces, interfaces_map, filetrans_if->name,
-				strlen(filetrans_if->name), filetrans_if);
-	} else {
-		filetrans_if->flags |= FILETRANS_IF;
-	}
+	mark_if(if_name, FILETRANS_IF);
 }
 
 no_sanitize_unsigned_integer_
 int is_filetrans_if(const char *if_name)
 {
 	struct if_hash_elem *filetrans_if;
-	HASH_FIND(hh_interfaces, interfaces_map, if_name, strlen(if_name), filetrans_if);
+	HASH_FIND(hh_interfaces, maps->interfaces_map, if_name, strlen(if_name), filetrans_if);
 	if (filetrans_if && (filetrans_if->flags & FILETRANS_IF)) {
 		return 1;
 	} else {
@@ -393,30 +596,16 @@ int is_filetrans_if(const char *if_name)
 	}
 }
 
-no_sanitize_unsigned_integer_
 void mark_role_if(const char *if_name)
 {
-	struct if_hash_elem *role_if;
-
-	HASH_FIND(hh_interfaces, interfaces_map, if_name, strlen(if_name), role_if);
-
-	if (!role_if) {
-		role_if = xmalloc(sizeof(struct if_hash_elem));
-		role_if->name = xstrdup(if_name);
-		role_if->module = NULL;
-		role_if->flags = ROLE_IF;
-		HASH_ADD_KEYPTR(hh_interfaces, interfaces_map, role_if->name,
-				strlen(role_if->name), role_if);
-	} else {
-		role_if->flags |= ROLE_IF;
-	}
+	mark_if(if_name, ROLE_IF);
 }
 
 no_sanitize_unsigned_integer_
 int is_role_if(const char *if_name)
 {
 	struct if_hash_elem *role_if;
-	HASH_FIND(hh_interfaces, interfaces_map, if_name, strlen(if_name), role_if);
+	HASH_FIND(hh_interfaces, maps->interfaces_map, if_name, strlen(if_name), role_if);
 	if (role_if && (role_if->flags & ROLE_IF)) {
 		return 1;
 	} else {
@@ -424,30 +613,21 @@ int is_role_if(const char *if_name)
 	}
 }
 
-no_sanitize_unsigned_integer_
 void mark_used_if(const char *if_name)
 {
-	struct if_hash_elem *used_if;
-
-	HASH_FIND(hh_interfaces, interfaces_map, if_name, strlen(if_name), used_if);
+	mark_if(if_name, USED_IF);
+}
 
-	if (!used_if) {
-		used_if = xmalloc(sizeof(struct if_hash_elem));
-		used_if->name = xstrdup(if_name);
-		used_if->module = NULL;
-		used_if->flags = USED_IF;
-		HASH_ADD_KEYPTR(hh_interfaces, interfaces_map, used_if->name,
-				strlen(used_if->name), used_if);
-	} else {
-		used_if->flags |= USED_IF;
-	}
+void unmark_used_if(const char *if_name)
+{
+	unmark_if(if_name, USED_IF);
 }
 
 no_sanitize_unsigned_integer_
 int is_used_if(const char *if_name)
 {
 	struct if_hash_elem *used_if;
-	HASH_FIND(hh_interfaces, interfaces_map, if_name, strlen(if_name), used_if);
+	HASH_FIND(hh_interfaces, maps->interfaces_map, if_name, strlen(if_name), used_if);
 	if (used_if && (used_if->flags & USED_IF)) {
 		return 1;
 	} else {
@@ -455,6 +635,19 @@ int is_used_if(const char *if_name)
 	}
 }
 
+static void free_template_expansions(void)
+{
+	struct template_expansion_elem *cur, *tmp;
+
+	HASH_ITER(hh, maps->template_expansions, cur, tmp) {
+		HASH_DELETE(hh, maps->template_expansions, cur);
+		free(cur->key);
+		free(cur->expansion.names);
+		free(cur->expansion.flavors);
+		free(cur);
+	}
+}
+
 static void insert_decl(struct template_hash_elem *template, void *new_node)
 {
 	if (template->declarations) {
@@ -495,24 +688,109 @@ static void insert_into_template_map(const char *name, void *new_node,
 
 	struct template_hash_elem *template;
 
-	HASH_FIND(hh, template_map, name, strlen(name), template);
+	// Expansions of calls to this template, or to templates calling it,
+	// might change
+	free_template_expansions();
+
+	HASH_FIND(hh, maps->template_map, name, strlen(name), template);
 
 	if (template == NULL) {
-		template = xmalloc(sizeof(struct template_hash_elem));
+		template = xcalloc(1, sizeof(struct template_hash_elem));
 		template->name = xstrdup(name);
-		template->declarations = NULL;
-		template->calls = NULL;
 
-		HASH_ADD_KEYPTR(hh, template_map, template->name,
+		HASH_ADD_KEYPTR(hh, maps->template_map, template->name,
 		                strlen(template->name), template);
 
 	}
 
 	insertion_func(template, new_node);
+	template->insertions++;
+}
+
+static void free_template(struct template_hash_elem *template)
+{
+	free(template->name);
+	free_decl_list(template->declarations);
+	free_if_call_list(template->calls);
+	free(template);
+}
+
+// Undo an insertion recorded as change into the template map.  The template
+// is removed once all its insertions are.
+no_sanitize_unsigned_integer_
+static void remove_from_template_map(const struct map_change *change)
+{
+	struct template_hash_elem *template;
+
+	free_template_expansions();
+
+	HASH_FIND(hh, maps->template_map, change->name, strlen(change->name), template);
+	if (!template) {
+		return;
+	}
+
+	if (change->flavor == CHANGE_TEMPLATE_DECL) {
+		for (struct decl_list **cur = &template->declarations; *cur; cur = &(*cur)->next) {
+			const struct declaration_data *decl = (*cur)->decl;
+			if (decl->flavor == change->data.decl_flavor && 0 == strcmp(decl->name, change->value)) {
+				struct decl_list *removed = *cur;
+				*cur = removed->next;
+				removed->next = NULL;
+				free_decl_list(removed);
+				break;
+			}
+		}
+	} else if (change->flavor == CHANGE_TEMPLATE_CALL) {
+		for (struct if_call_list **cur = &template->calls; *cur; cur = &(*cur)->next) {
+			if ((*cur)->call == change->data.call) {
+				struct if_call_list *removed = *cur;
+				*cur = removed->next;
+				removed->next = NULL;
+				free_if_call_list(removed);
+				break;
+			}
+		}
+	}
+
+	if (--template->insertions == 0) {
+		HASH_DELETE(hh, maps->template_map, template);
+		free_template(template);
+	}
+}
+
+no_sanitize_unsigned_integer_
+const struct template_expansion *look_up_template_expansion(const char *key, size_t key_len)
+{
+	struct template_expansion_elem *elem;
+
+	HASH_FIND(hh, maps->template_expansions, key, key_len, elem);
+
+	return elem ? &elem->expansion : NULL;
+}
+
+no_sanitize_unsigned_integer_
+const struct template_expansion *insert_template_expansion(const char *key, size_t key_len,
+                                                           const struct template_expansion *expansion)
+{
+	struct template_expansion_elem *elem = xmalloc(sizeof(struct template_expansion_elem));
+
+	elem->key = xmalloc(key_len);
+	memcpy(elem->key, key, key_len);
+	elem->key_len = key_len;
+	elem->expansion = *expansion;
+
+	HASH_ADD_KEYPTR(hh, maps->template_expansions, elem->key, elem->key_len, elem);
+
+	return &elem->expansion;
 }
 
 void insert_template_into_template_map(const char *name)
 {
+	if (staged_changes) {
+		stage_change(CHANGE_TEMPLATE, name, NULL);
+		return;
+	}
+
 	insert_into_template_map(name, NULL, insert_noop);
 }
 
@@ -520,6 +798,11 @@ void insert_decl_into_template_map(const char *name, enum decl_flavor flavor,
                                    const char *declaration)
 {
 
+	if (staged_changes) {
+		stage_change(CHANGE_TEMPLATE_DECL, name, declaration)->data.decl_flavor = flavor;
+		return;
+	}
+
 	struct declaration_data *new_data =
 		xmalloc(sizeof(struct declaration_data));
 
@@ -537,6 +820,11 @@ void insert_decl_into_template_map(const char *name, enum decl_flavor flavor,
 void insert_call_into_template_map(const char *name, struct if_call_data *call)
 {
 
+	if (staged_changes) {
+		stage_change(CHANGE_TEMPLATE_CALL, name, NULL)->data.call = call;
+		return;
+	}
+
 	struct if_call_list *new_node = xmalloc(sizeof(struct if_call_list));
 
 	new_node->call = call;
@@ -551,7 +839,7 @@ const struct template_hash_elem *look_up_in_template_map(const char *name)
 
 	struct template_hash_elem *template;
 
-	HASH_FIND(hh, template_map, name, strlen(name), template);
+	HASH_FIND(hh, maps->template_map, name, strlen(name), template);
 
 	return template;
 }
@@ -584,13 +872,13 @@ void insert_into_permmacros_map(const char *name, struct string_list *permission
 
 	struct sl_hash_elem *perm_macro;
 
-	HASH_FIND(hh_permmacros, permmacros_map, name, strlen(name), perm_macro);
+	HASH_FIND(hh_permmacros, maps->permmacros_map, name, strlen(name), perm_macro);
 
 	if (!perm_macro) {
 		perm_macro = xmalloc(sizeof(struct sl_hash_elem));
 		perm_macro->key = xstrdup(name);
 		perm_macro->val = permissions;
-		HASH_ADD_KEYPTR(hh_permmacros, permmacros_map, perm_macro->key, strlen(perm_macro->key),
+		HASH_ADD_KEYPTR(hh_permmacros, maps->permmacros_map, perm_macro->key, strlen(perm_macro->key),
 		                perm_macro);
 	}
 }
@@ -601,7 +889,7 @@ const struct string_list *look_up_in_permmacros_map(const char *name)
 
 	struct sl_hash_elem *perm_macro;
 
-	HASH_FIND(hh_permmacros, permmacros_map, name, strlen(name), perm_macro);
+	HASH_FIND(hh_permmacros, maps->permmacros_map, name, strlen(name), perm_macro);
 
 	if (perm_macro == NULL) {
 		return NULL;
@@ -614,85 +902,342 @@ void visit_all_in_permmacros_map(void (*visitor)(const char *name, const struct
 {
 	const struct sl_hash_elem *cur_sl, *tmp_sl;
 
-	HASH_ITER(hh_permmacros, permmacros_map, cur_sl, tmp_sl) {
+	HASH_ITER(hh_permmacros, maps->permmacros_map, cur_sl, tmp_sl) {
 		visitor(cur_sl->key, cur_sl->val);
 	}
 }
 
 unsigned int permmacros_map_count(void)
 {
-	return HASH_CNT(hh_permmacros, permmacros_map);
+	return HASH_CNT(hh_permmacros, maps->permmacros_map);
+}
+
+#define VISIT_MAP(mn) HASH_ITER(hh_ ## mn, maps->mn ## _map, cur_decl, tmp_decl) { \
+		visitor(cur_decl->key, cur_decl->val, ctx); \
+} \
+
+void visit_all_in_decl_map(enum decl_flavor flavor,
+                           void (*visitor)(const char *name, const char *module_name, void *ctx),
+                           void *ctx)
+{
+	for (uint32_t pos = 0; pos < maps->decls.count; pos++) {
+		const struct decl_entry *entry = &maps->decls.entries[pos];
+		if (entry->flavor == (uint32_t)flavor && entry->insertions > 0) {
+			visitor(entry->name, entry->module, ctx);
+		}
+	}
+}
+
+void visit_all_in_mod_layers_map(void (*visitor)(const char *mod_name, const char *layer, void *ctx),
+                                 void *ctx)
+{
+	const struct hash_elem *cur_decl, *tmp_decl;
+
+	VISIT_MAP(mod_layers);
+}
+
+void visit_all_in_ifs_map(void (*visitor)(const struct if_hash_elem *elem, void *ctx),
+                          void *ctx)
+{
+	const struct if_hash_elem *cur_if, *tmp_if;
+
+	HASH_ITER(hh_interfaces, maps->interfaces_map, cur_if, tmp_if) {
+		visitor(cur_if, ctx);
+	}
+}
+
+void visit_all_in_template_map(void (*visitor)(const struct template_hash_elem *template, void *ctx),
+                               void *ctx)
+{
+	const struct template_hash_elem *cur_template, *tmp_template;
+
+	HASH_ITER(hh, maps->template_map, cur_template, tmp_template) {
+		visitor(cur_template, ctx);
+	}
 }
 
-#define FREE_MAP(mn) HASH_ITER(hh_ ## mn, mn ## _map, cur_decl, tmp_decl) { \
-		HASH_DELETE(hh_ ## mn, mn ## _map, cur_decl); \
-		free(cur_decl->key); \
-		free(cur_decl->val); \
+#define FREE_MAP(mn) HASH_ITER(hh_ ## mn, maps->mn ## _map, cur_decl, tmp_decl) { \
+		HASH_DELETE(hh_ ## mn, maps->mn ## _map, cur_decl); \
 		free(cur_decl); \
 } \
 
-#define FREE_BOOL_MAP(mn) HASH_ITER(hh_ ## mn, mn ## _map, cur_bool, tmp_bool) { \
-		HASH_DELETE(hh_ ## mn, mn ## _map, cur_bool); \
+#define FREE_BOOL_MAP(mn) HASH_ITER(hh_ ## mn, maps->mn ## _map, cur_bool, tmp_bool) { \
+		HASH_DELETE(hh_ ## mn, maps->mn ## _map, cur_bool); \
 		free(cur_bool->key); \
 		free(cur_bool); \
 } \
 
-#define FREE_IF_MAP(mn) HASH_ITER(hh_ ## mn, mn ## _map, cur_if, tmp_if) { \
-		HASH_DELETE(hh_ ## mn, mn ## _map, cur_if); \
-		free(cur_if->name); \
-		free(cur_if->module); \
+#define FREE_IF_MAP(mn) HASH_ITER(hh_ ## mn, maps->mn ## _map, cur_if, tmp_if) { \
+		HASH_DELETE(hh_ ## mn, maps->mn ## _map, cur_if); \
 		free(cur_if); \
 } \
 
-void free_all_maps(void)
+void reset_policy_maps(void)
 {
 
-	struct hash_elem *cur_decl, *tmp_decl;
+	free(maps->decls.entries);
+	free(maps->decls.index);
+	for (uint32_t i = 0; i < maps->decls.class_perms_capacity; i++) {
+		free(maps->decls.class_perms[i].words);
+	}
+	free(maps->decls.class_perms);
+	memset(&maps->decls, 0, sizeof(struct decl_table));
 
-	FREE_MAP(type);
+	struct if_hash_elem *cur_if, *tmp_if;
 
-	FREE_MAP(role);
+	FREE_IF_MAP(interfaces);
 
-	FREE_MAP(user);
+	struct template_hash_elem *cur_template, *tmp_template;
 
-	FREE_MAP(attr_type);
+	HASH_ITER(hh, maps->template_map, cur_template, tmp_template) {
+		HASH_DELETE(hh, maps->template_map, cur_template);
+		free_template(cur_template);
+	}
 
-	FREE_MAP(attr_role);
+	free_template_expansions();
+}
 
-	FREE_MAP(bool);
+void free_all_maps(void)
+{
 
-	FREE_MAP(class);
+	reset_policy_maps();
 
-	FREE_MAP(perm);
+	struct hash_elem *cur_decl, *tmp_decl;
 
 	FREE_MAP(mods);
 
 	FREE_MAP(mod_layers);
 
-	struct if_hash_elem *cur_if, *tmp_if;
-
-	FREE_IF_MAP(interfaces);
-
 	struct bool_hash_elem *cur_bool, *tmp_bool;
 
 	FREE_BOOL_MAP(userspace_class);
 
 	struct sl_hash_elem *cur_sl, *tmp_sl;
 
-	HASH_ITER(hh_permmacros, permmacros_map, cur_sl, tmp_sl) {
-		HASH_DELETE(hh_permmacros, permmacros_map, cur_sl);
+	HASH_ITER(hh_permmacros, maps->permmacros_map, cur_sl, tmp_sl) {
+		HASH_DELETE(hh_permmacros, maps->permmacros_map, cur_sl);
 		free(cur_sl->key);
 		free_string_list(cur_sl->val);
 		free(cur_sl);
 	}
+}
+
+struct maps *alloc_maps(void)
+{
+	return xcalloc(1, sizeof(struct maps));
+}
+
+struct maps *switch_maps(struct maps *new_maps)
+{
+	struct maps *prev = maps;
+
+	maps = new_maps;
+
+	return prev;
+}
+
+void free_maps(struct maps *to_free)
+{
+	struct maps *prev = switch_maps(to_free);
+
+	free_all_maps();
+	switch_maps(prev);
+
+	if (to_free != &default_maps) {
+		free(to_free);
+	}
+}
 
-	struct template_hash_elem *cur_template, *tmp_template;
+struct map_changes *alloc_map_changes(void)
+{
+	return xcalloc(1, sizeof(struct map_changes));
+}
+
+void stage_map_changes(struct map_changes *changes)
+{
+	staged_changes = changes;
+}
+
+struct map_changes *get_staged_map_changes(void)
+{
+	return staged_changes;
+}
+
+int is_staging_map_changes(void)
+{
+	return staged_changes != NULL;
+}
+
+void defer_map_change(void (*apply)(void *ctx), void (*retract)(void *ctx),
+                      void *ctx, void (*free_ctx)(void *ctx))
+{
+	if (!staged_changes) {
+		apply(ctx);
+		free_ctx(ctx);
+		return;
+	}
+
+	struct map_change *change = stage_change(CHANGE_DEFERRED, NULL, NULL);
+
+	change->data.deferred.apply = apply;
+	change->data.deferred.retract = retract;
+	change->data.deferred.free_ctx = free_ctx;
+	change->data.deferred.ctx = ctx;
+}
+
+static void apply_change(const struct map_change *change)
+{
+	switch (change->flavor) {
+	case CHANGE_DECL:
+		insert_into_decl_map(change->name, change->value, change->data.decl_flavor);
+		break;
+	case CHANGE_IF:
+		insert_into_ifs_map(change->name, change->value);
+		break;
+	case CHANGE_IF_FLAG:
+		mark_if(change->name, change->data.if_flag);
+		break;
+	case CHANGE_TEMPLATE:
+		insert_template_into_template_map(change->name);
+		break;
+	case CHANGE_TEMPLATE_DECL:
+		insert_decl_into_template_map(change->name, change->data.decl_flavor, change->value);
+		break;
+	case CHANGE_TEMPLATE_CALL:
+		insert_call_into_template_map(change->name, change->data.call);
+		break;
+	case CHANGE_DEFERRED:
+		change->data.deferred.apply(change->data.deferred.ctx);
+		break;
+	case CHANGE_CLASS_PERM:
+		insert_into_class_perms(change->name, change->value);
+		break;
+	}
+}
+
+void replay_map_changes(const struct map_changes *changes)
+{
+	if (!changes) {
+		return;
+	}
+
+	for (const struct map_change *change = changes->head; change; change = change->next) {
+		apply_change(change);
+	}
+}
+
+static void retract_change(const struct map_change *change)
+{
+	switch (change->flavor) {
+	case CHANGE_DECL:
+		remove_from_decl_map(change->name, change->data.decl_flavor);
+		break;
+	case CHANGE_IF:
+		remove_from_ifs_map(change->name);
+		break;
+	case CHANGE_IF_FLAG:
+		unmark_if(change->name, change->data.if_flag);
+		break;
+	case CHANGE_TEMPLATE:
+	case CHANGE_TEMPLATE_DECL:
+	case CHANGE_TEMPLATE_CALL:
+		remove_from_template_map(change);
+		break;
+	case CHANGE_DEFERRED:
+		change->data.deferred.retract(change->data.deferred.ctx);
+		break;
+	case CHANGE_CLASS_PERM:
+		break;
+	}
+}
+
+void retract_map_changes(const struct map_changes *changes)
+{
+	if (!changes) {
+		return;
+	}
 
-	HASH_ITER(hh, template_map, cur_template, tmp_template) {
-		HASH_DELETE(hh, template_map, cur_template);
-		free(cur_template->name);
-		free_decl_list(cur_template->declarations);
-		free_if_call_list(cur_template->calls);
-		free(cur_template);
+	for (const struct map_change *change = changes->head; change; change = change->next) {
+		retract_change(change);
 	}
 }
+
+void reapply_deferred_map_changes(const struct map_changes *changes)
+{
+	if (!changes) {
+		return;
+	}
+
+	for (const struct map_change *change = changes->head; change; change = change->next) {
+		if (change->flavor == CHANGE_DEFERRED) {
+			change->data.deferred.retract(change->data.deferred.ctx);
+			change->data.deferred.apply(change->data.deferred.ctx);
+		}
+	}
+}
+
+int changes_template_map(const struct map_changes *changes)
+{
+	if (!changes) {
+		return 0;
+	}
+
+	for (const struct map_change *change = changes->head; change; change = change->next) {
+		if (change->flavor == CHANGE_TEMPLATE ||
+		    change->flavor == CHANGE_TEMPLATE_DECL ||
+		    change->flavor == CHANGE_TEMPLATE_CALL) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void commit_map_changes(struct map_changes *changes)
+{
+	replay_map_changes(changes);
+
+	free_map_changes(changes);
+}
+
+const struct map_change *first_map_change(const struct map_changes *changes)
+{
+	return changes ? changes->head : NULL;
+}
+
+void move_map_changes(struct map_changes *dest, struct map_changes *src)
+{
+	if (!src->head) {
+		free(src);
+		return;
+	}
+
+	if (dest->tail) {
+		dest->tail->next = src->head;
+	} else {
+		dest->head = src->head;
+	}
+	dest->tail = src->tail;
+
+	free(src);
+}
+
+void free_map_changes(struct map_changes *changes)
+{
+	if (!changes) {
+		return;
+	}
+
+	struct map_change *change = changes->head;
+
+	while (change) {
+		struct map_change *tmp = change;
+		change = change->next;
+		if (tmp->flavor == CHANGE_DEFERRED) {
+			tmp->data.deferred.free_ctx(tmp->data.deferred.ctx);
+		}
+		free(tmp);
+	}
+
+	free(changes);
+}
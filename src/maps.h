@@ -22,11 +22,13 @@
 #include "tree.h"
 #include "selint_error.h"
 
+// Keys and values are atoms, see intern.h.  The maps are keyed by the
+// string of the atom.  Declarations are kept in a separate table, keyed by
+// the flavor and the address of the atom.
 struct hash_elem {
-	char *key;
-	char *val;
-	UT_hash_handle hh_type, hh_role, hh_user, hh_attr_type, hh_attr_role, hh_bool,
-	               hh_class, hh_perm, hh_mods, hh_mod_layers;
+	const char *key;
+	const char *val;
+	UT_hash_handle hh_mods, hh_mod_layers;
 };
 
 struct bool_hash_elem {
@@ -45,11 +47,18 @@ struct sl_hash_elem {
 #define FILETRANS_IF (1u << 1)
 #define ROLE_IF      (1u << 2)
 #define USED_IF      (1u << 3)
+#define IF_FLAG_COUNT 4
 
+// The counts record how often an interface was defined or marked, so
+// retracting the changes of one file keeps what other files inserted, see
+// retract_map_changes()
 struct if_hash_elem {
-	char *name;
-	char *module;
+	const char *name;       // an atom
+	const char *module;     // an atom
 	uint8_t flags;
+	uint8_t derived_flags;  // marked by mark_derived_transform_if()
+	unsigned int definitions;
+	unsigned int flag_counts[IF_FLAG_COUNT];
 	UT_hash_handle hh_interfaces;
 };
 
@@ -57,6 +66,7 @@ struct template_hash_elem {
 	char *name;
 	struct decl_list *declarations;
 	struct if_call_list *calls;
+	unsigned int insertions;
 	UT_hash_handle hh;
 };
 
@@ -65,6 +75,23 @@ void insert_into_decl_map(const char *name, const char *module_name,
 
 const char *look_up_in_decl_map(const char *name, enum decl_flavor flavor);
 
+// Undo one insert_into_decl_map() of the name.  The name stays declared
+// until every insertion is undone, with the module of the first one.
+void remove_from_decl_map(const char *name, enum decl_flavor flavor);
+
+// Like look_up_in_decl_map(), for an atom (see intern.h)
+const char *look_up_atom_in_decl_map(const char *atom, enum decl_flavor flavor);
+
+// Record that the class defines the permission.  Both have to be inserted
+// into the decl map first, as DECL_CLASS and DECL_PERM.
+void insert_into_class_perms(const char *class_name, const char *perm);
+
+// Return 1 if the class defines the permission, and 0 if it does not.
+// Return -1 if that is unknown, because the class or the permission is not
+// declared, or no permissions were recorded for the class.
+// Both arguments are atoms (see intern.h).
+int class_has_perm(const char *class_atom, const char *perm_atom);
+
 void insert_into_mods_map(const char *mod_name, const char *status);
 
 const char *look_up_in_mods_map(const char *mod_name);
@@ -85,6 +112,14 @@ extern int userspace_class_support;
 
 void mark_transform_if(const char *if_name);
 
+// Mark an interface as transform interface because it calls one first, see
+// mark_transform_interfaces().  Unlike other marks these are not recorded
+// as map changes, and clear_derived_transform_ifs() drops all of them, to
+// propagate the marks again once interfaces changed.
+void mark_derived_transform_if(const char *if_name);
+
+void clear_derived_transform_ifs(void);
+
 int is_transform_if(const char *if_name);
 
 void mark_filetrans_if(const char *if_name);
@@ -97,6 +132,9 @@ int is_role_if(const char *if_name);
 
 void mark_used_if(const char *if_name);
 
+// Undo one mark_used_if() of the interface
+void unmark_used_if(const char *if_name);
+
 int is_used_if(const char *if_name);
 
 // Just generate a template entry in the map, but don't save any calls
@@ -115,6 +153,25 @@ const struct decl_list *look_up_decl_in_template_map(const char *name);
 
 const struct if_call_list *look_up_call_in_template_map(const char *name);
 
+// The declarations added by a template call, with the arguments of the call
+// substituted.  The names are atoms (see intern.h)
+struct template_expansion {
+	const char **names;
+	enum decl_flavor *flavors;
+	size_t count;
+};
+
+// Look up the cached expansion of a template call.  The key identifies the
+// template and the arguments of the call, see add_template_declarations().
+// The cache is emptied whenever the template map changes, since the
+// expansion depends on all templates called.
+const struct template_expansion *look_up_template_expansion(const char *key, size_t key_len);
+
+// Cache the expansion of a template call.  The map takes ownership of the
+// arrays of the expansion.
+const struct template_expansion *insert_template_expansion(const char *key, size_t key_len,
+                                                           const struct template_expansion *expansion);
+
 void insert_into_permmacros_map(const char *name, struct string_list *permissions);
 
 const struct string_list *look_up_in_permmacros_map(const char *name);
@@ -123,8 +180,125 @@ void visit_all_in_permmacros_map(void (*visitor)(const char *name, const struct
 
 unsigned int permmacros_map_count(void);
 
+// Call visitor on every entry of a map, in no particular order
+void visit_all_in_decl_map(enum decl_flavor flavor,
+                           void (*visitor)(const char *name, const char *module_name, void *ctx),
+                           void *ctx);
+
+void visit_all_in_mod_layers_map(void (*visitor)(const char *mod_name, const char *layer, void *ctx),
+                                 void *ctx);
+
+void visit_all_in_ifs_map(void (*visitor)(const struct if_hash_elem *elem, void *ctx),
+                          void *ctx);
+
+void visit_all_in_template_map(void (*visitor)(const struct template_hash_elem *template, void *ctx),
+                               void *ctx);
+
 unsigned int decl_map_count(enum decl_flavor flavor);
 
 void free_all_maps(void);
 
+// The maps of a context, see selint_context.h.  switch_maps() makes
+// new_maps the current maps, and returns the previous ones.  free_maps()
+// frees maps which are not current.
+struct maps;
+
+struct maps *alloc_maps(void);
+
+struct maps *switch_maps(struct maps *new_maps);
+
+void free_maps(struct maps *to_free);
+
+// Empty the declaration, interface and template maps, which are filled by
+// parsing te and if files.  The maps filled at startup from modules.conf,
+// the layer directories, security_classes and obj_perm_sets.spt are kept.
+void reset_policy_maps(void);
+
+// Map insertions recorded while parsing files concurrently.  Each worker
+// records the insertions caused by one file, and the main thread replays
+// them in file order, so the resulting maps are identical to a serial run.
+struct map_changes;
+
+struct map_changes *alloc_map_changes(void);
+
+// Record all map insertions made by the calling thread in changes instead
+// of applying them.  Pass NULL to apply insertions directly again.
+void stage_map_changes(struct map_changes *changes);
+
+// Return the changes insertions of the calling thread are recorded in,
+// or NULL if they are applied directly
+struct map_changes *get_staged_map_changes(void);
+
+// Return 1 if map insertions of the calling thread are currently recorded
+// and 0 otherwise
+int is_staging_map_changes(void);
+
+// Record a change that has to be applied in order with the recorded
+// insertions, because it depends on the content of the maps.  If no
+// changes are being recorded, apply is called immediately.
+// retract undoes what apply inserted, see retract_map_changes().
+// free_ctx is called on ctx once the change got applied or discarded.
+void defer_map_change(void (*apply)(void *ctx), void (*retract)(void *ctx),
+                      void *ctx, void (*free_ctx)(void *ctx));
+
+// Apply all recorded changes in the order they were recorded, and free them
+void commit_map_changes(struct map_changes *changes);
+
+// Apply all recorded changes in the order they were recorded, and keep them,
+// so they can be applied again after reset_policy_maps()
+void replay_map_changes(const struct map_changes *changes);
+
+// Undo the insertions of changes which were applied before, e.g. of the
+// previous version of a file changed in watch mode.  What other changes
+// inserted too is kept.  Changes to the class permissions are only made
+// at startup, and are never retracted.
+void retract_map_changes(const struct map_changes *changes);
+
+// Retract and apply again the deferred changes only, whose result depends
+// on the templates, e.g. after the template map changed
+void reapply_deferred_map_changes(const struct map_changes *changes);
+
+// Return 1 if changes insert into the template map, and 0 otherwise
+int changes_template_map(const struct map_changes *changes);
+
+// Free recorded changes without applying them
+void free_map_changes(struct map_changes *changes);
+
+// Append all changes recorded in src to dest, and free src
+void move_map_changes(struct map_changes *dest, struct map_changes *src);
+
+enum map_change_flavor {
+	CHANGE_DECL,
+	CHANGE_IF,
+	CHANGE_IF_FLAG,
+	CHANGE_TEMPLATE,
+	CHANGE_TEMPLATE_DECL,
+	CHANGE_TEMPLATE_CALL,
+	CHANGE_DEFERRED,
+	CHANGE_CLASS_PERM,
+};
+
+// A recorded change.  Only exposed to be stored in the parse cache, see
+// parse_cache.h, so treat it as read only.
+struct map_change {
+	enum map_change_flavor flavor;
+	const char *name;       // an atom
+	const char *value;      // an atom
+	union {
+		enum decl_flavor decl_flavor;
+		uint8_t if_flag;
+		struct if_call_data *call;
+		struct {
+			void (*apply)(void *ctx);
+			void (*retract)(void *ctx);
+			void (*free_ctx)(void *ctx);
+			void *ctx;
+		} deferred;
+	} data;
+	struct map_change *next;
+};
+
+// Return the first recorded change, in the order they are applied
+const struct map_change *first_map_change(const struct map_changes *changes);
+
 #endif
@@ -16,9 +16,11 @@
 
 #include "name_list.h"
 
+#include <stdint.h>
 #include <stdlib.h>
-#include <string.h>
+#include <uthash.h>
 
+#include "intern.h"
 #include "tree.h"
 #include "xalloc.h"
 
@@ -89,7 +91,7 @@ bool name_list_contains_name(const struct name_list *nl, const struct name_data
 			continue;
 		}
 
-		if (0 == strcmp(nl->data->name, name->name)) {
+		if (nl->data->name == name->name) {
 			return true;
 		}
 	}
@@ -108,7 +110,7 @@ struct name_list *name_list_from_sl_with_traits(const struct string_list *sl,
 
 	while (sl) {
 		struct name_data *data = xmalloc(sizeof(struct name_data));
-		data->name = xstrdup(sl->string);
+		data->name = sl->interned ? sl->string : intern(sl->string);
 		data->flavor = flavor;
 		data->traits = copy_string_list(traits);
 		cur->data = data;
@@ -127,7 +129,7 @@ struct name_list *name_list_from_sl_with_traits(const struct string_list *sl,
 struct name_list *name_list_create(const char *name, enum name_flavor flavor)
 {
 	struct name_data *data = xmalloc(sizeof(struct name_data));
-	data->name = xstrdup(name);
+	data->name = intern(name);
 	data->flavor = flavor;
 	data->traits = NULL;
 	struct name_list *ret = xmalloc(sizeof(struct name_list));
@@ -140,7 +142,7 @@ struct name_list *name_list_create(const char *name, enum name_flavor flavor)
 struct name_list *name_list_from_decl(const struct declaration_data *decl)
 {
 	struct name_data *data = xmalloc(sizeof(struct name_data));
-	data->name = xstrdup(decl->name);
+	data->name = intern(decl->name);
 	data->traits = NULL;
 
 	struct name_list *extra = NULL;
@@ -214,9 +216,82 @@ void free_name_list(struct name_list *nl)
 	while (cur) {
 		struct name_list *to_free = cur;
 		cur = cur->next;
-		free(to_free->data->name);
 		free_string_list(to_free->data->traits);
 		free(to_free->data);
 		free(to_free);
 	}
 }
+
+struct name_set_entry {
+	const char *name;       // an atom, the key
+	uint32_t flavors;       // a bit for each flavor the name was added with
+	UT_hash_handle hh;
+};
+
+struct name_set {
+	struct name_set_entry *entries;
+};
+
+struct name_set *alloc_name_set(void)
+{
+	return xcalloc(1, sizeof(struct name_set));
+}
+
+void name_set_add(struct name_set *set, const struct name_data *name)
+{
+	struct name_set_entry *entry;
+
+	HASH_FIND_PTR(set->entries, &name->name, entry);
+
+	if (!entry) {
+		entry = xmalloc(sizeof(struct name_set_entry));
+		entry->name = name->name;
+		entry->flavors = 0;
+		HASH_ADD_PTR(set->entries, name, entry);
+	}
+
+	entry->flavors |= UINT32_C(1) << name->flavor;
+}
+
+void name_set_add_list(struct name_set *set, const struct name_list *nl)
+{
+	for (; nl; nl = nl->next) {
+		name_set_add(set, nl->data);
+	}
+}
+
+bool name_set_contains(const struct name_set *set, const struct name_data *name)
+{
+	const struct name_set_entry *entry;
+
+	HASH_FIND_PTR(set->entries, &name->name, entry);
+
+	if (!entry) {
+		return false;
+	}
+
+	for (unsigned int flavor = NAME_UNKNOWN; flavor <= NAME_BOOL; flavor++) {
+		if ((entry->flavors >> flavor) & 1 &&
+		    is_compatible((enum name_flavor)flavor, name->flavor)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void free_name_set(struct name_set *set)
+{
+	if (!set) {
+		return;
+	}
+
+	struct name_set_entry *cur, *tmp;
+
+	HASH_ITER(hh, set->entries, cur, tmp) {
+		HASH_DEL(set->entries, cur);
+		free(cur);
+	}
+
+	free(set);
+}
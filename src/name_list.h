@@ -40,7 +40,7 @@ enum name_flavor {
 
 struct name_data {
 	enum name_flavor flavor;
-	char *name;
+	const char *name;       // an atom, see intern.h
 	// flavor == NAME_CLASS: list of associated permissions
 	struct string_list *traits;
 };
@@ -76,8 +76,24 @@ struct name_list *concat_name_lists(struct name_list *head, struct name_list *ta
 // Create a name list with a single entry from a declaration
 struct name_list *name_list_from_decl(const struct declaration_data *decl);
 
+// Names are atoms, so this compares them by address
 bool name_list_contains_name(const struct name_list *nl, const struct name_data *name);
 
 void free_name_list(struct name_list *nl);
 
+// A set of names, to test membership in constant time.  Names match like
+// in name_list_contains_name().
+struct name_set;
+
+struct name_set *alloc_name_set(void);
+
+void name_set_add(struct name_set *set, const struct name_data *name);
+
+// Add all names of the list
+void name_set_add_list(struct name_set *set, const struct name_list *nl);
+
+bool name_set_contains(const struct name_set *set, const struct name_data *name);
+
+void free_name_set(struct name_set *set);
+
 #endif
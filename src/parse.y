@@ -25,6 +25,7 @@
 }
 
 %{
+	#include <errno.h>
 	#include <stdio.h>
 	#include <string.h>
 	#include <libgen.h>
@@ -34,6 +35,7 @@
 	#include "check_hooks.h"
 	#include "util.h"
 	#include "color.h"
+	#include "intern.h"
 	#include "xalloc.h"
 
 	#define YYDEBUG 1
@@ -51,7 +53,7 @@
 %}
 
 %union {
-	char *string;
+	const char *string;
 	char symbol;
 	struct string_list *sl;
 	enum av_rule_flavor av_flavor;
@@ -60,25 +62,28 @@
 
 %{
 	// local variables and functions
-	static const char *parsing_filename;
-	static struct policy_node *cur;
-	static enum node_flavor expected_node_flavor;
+	// parser state is kept per thread, to parse multiple files concurrently
+	static _Thread_local const char *parsing_filename;
+	static _Thread_local struct policy_node *cur;
+	static _Thread_local enum node_flavor expected_node_flavor;
 	static void yyerror(const YYLTYPE *locp, yyscan_t yyscanner, char const *msg);
+	static const char *intern_join(const char *left, char separator, const char *right);
 
 	// lexer
-	extern void yyrestart(FILE *input_file , yyscan_t yyscanner);
 	extern int yylex(YYSTYPE *yylval_param, YYLTYPE *yylloc_param, yyscan_t yyscanner);
-	extern int yylex_init(yyscan_t* scanner);
-	extern int yylex_destroy(yyscan_t scanner);
-	extern char *current_lines[LINES_TO_CACHE];
-	extern unsigned line_cache_index;
-	extern void reset_current_lines(void);
 %}
 
 %code provides {
-	// number of lines stored, printed on parse errors for multiline statements
+	// maximum number of lines printed on parse errors for multiline statements
 	#define LINES_TO_CACHE 5
 
+	// scanner over the complete content of file, which is read at once
+	// returns NULL if file can not be read
+	yyscan_t scanner_open(FILE *file);
+	void scanner_close(yyscan_t scanner);
+	// returns line lineno of the input scanned, needs to be freed
+	char *scanner_get_line(yyscan_t scanner, unsigned lineno);
+
 	// global prototype
 	struct policy_node *yyparse_wrapper(FILE *filefd, const char *filename, enum node_flavor expected_flavor);
 }
@@ -180,6 +185,9 @@
 %type<sl> xperm_items
 %type<sl> spt_contents
 %type<sl> spt_content
+%type<sl> av_permission_list
+%type<sl> av_permissions
+%type<sl> av_permission
 %type<string> string_or_quoted_string
 %type<string> sl_item
 %type<string> xperm_item
@@ -198,7 +206,6 @@
 %type<av_flavor> xperm_av_type
 %type<node_flavor> if_keyword
 
-%destructor { free($$); } <string>
 %destructor { free_string_list($$); } <sl>
 
 %%
@@ -237,7 +244,7 @@ selinux_file:
 	// TE File parsing
 
 te_policy:
-	header body
+	header maybe_selint_disable { save_file_command(cur, $2); } body
 	;
 
 comments:
@@ -260,25 +267,23 @@ maybe_selint_disable:
 header:
 	POLICY_MODULE OPEN_PAREN STRING maybe_header_version CLOSE_PAREN {
 			if (expected_node_flavor != NODE_TE_FILE) {
-				free($3);
 				const struct location loc = { @1.first_line, @1.first_column, @5.last_line, @5.last_column };
-				yyerror(&loc, NULL, "Error: Unexpected te-file parsed"); YYERROR;
+				yyerror(&loc, scanner, "Error: Unexpected te-file parsed"); YYERROR;
 			}
-			insert_header(&cur, $3, HEADER_MACRO, @$.first_line); free($3); } // Version number isn't needed
+			insert_header(&cur, $3, HEADER_MACRO, @$.first_line); } // Version number isn't needed
 	|
 	MODULE STRING header_version SEMICOLON {
 			if (expected_node_flavor != NODE_TE_FILE) {
-				free($2);
 				const struct location loc = { @1.first_line, @1.first_column, @4.last_line, @4.last_column };
-				yyerror(&loc, NULL, "Error: Unexpected te-file parsed"); YYERROR;
+				yyerror(&loc, scanner, "Error: Unexpected te-file parsed"); YYERROR;
 			}
-			insert_header(&cur, $2, HEADER_BARE, @$.first_line); free($2); }
+			insert_header(&cur, $2, HEADER_BARE, @$.first_line); }
 	;
 
 header_version:
-	VERSION_NO { free($1); }
+	VERSION_NO
 	|
-	NUMBER { free($1); }
+	NUMBER
 	;
 
 maybe_header_version:
@@ -300,7 +305,7 @@ lines:
 	;
 
 line:
-	bare_line maybe_selint_disable { save_command(cur, $2); free($2); }
+	bare_line maybe_selint_disable { save_command(cur, $2); }
 	;
 
 bare_line:
@@ -367,7 +372,7 @@ bare_line:
 	|
 	error {
 		const struct location loc = { @1.first_line, @1.first_column, @1.last_line, @1.last_column };
-		yyerror(&loc, NULL, "Error: Invalid statement");
+		yyerror(&loc, scanner, "Error: Invalid statement");
 		YYABORT;
 		}
 	;
@@ -375,50 +380,49 @@ bare_line:
 declaration:
 	type_declaration
 	|
-	ATTRIBUTE STRING SEMICOLON { insert_declaration(&cur, DECL_ATTRIBUTE, $2, NULL, @$.first_line); free($2); }
+	ATTRIBUTE STRING SEMICOLON { insert_declaration(&cur, DECL_ATTRIBUTE, $2, NULL, @$.first_line); }
 	|
-	CLASS STRING string_list SEMICOLON { insert_declaration(&cur, DECL_CLASS, $2, $3, @$.first_line); free($2); }
+	CLASS STRING string_list SEMICOLON { insert_declaration(&cur, DECL_CLASS, $2, $3, @$.first_line); }
 	|
-	ROLE STRING SEMICOLON { insert_declaration(&cur, DECL_ROLE, $2, NULL, @$.first_line); free($2); }
+	ROLE STRING SEMICOLON { insert_declaration(&cur, DECL_ROLE, $2, NULL, @$.first_line); }
 	|
-	ATTRIBUTE_ROLE STRING SEMICOLON { insert_declaration(&cur, DECL_ATTRIBUTE_ROLE, $2, NULL, @$.first_line); free($2); }
+	ATTRIBUTE_ROLE STRING SEMICOLON { insert_declaration(&cur, DECL_ATTRIBUTE_ROLE, $2, NULL, @$.first_line); }
 	|
 	bool_declaration
 	;
 
 type_declaration:
-	TYPE STRING SEMICOLON { insert_declaration(&cur, DECL_TYPE, $2, NULL, @$.first_line); free($2); }
+	TYPE STRING SEMICOLON { insert_declaration(&cur, DECL_TYPE, $2, NULL, @$.first_line); }
 	|
-	TYPE STRING COMMA comma_string_list SEMICOLON { insert_declaration(&cur, DECL_TYPE, $2, $4, @$.first_line); free($2); }
+	TYPE STRING COMMA comma_string_list SEMICOLON { insert_declaration(&cur, DECL_TYPE, $2, $4, @$.first_line); }
 	|
-	TYPE STRING ALIAS string_list SEMICOLON { insert_declaration(&cur, DECL_TYPE, $2, NULL, @$.first_line); free($2); insert_aliases(&cur, $4, DECL_TYPE, @$.first_line); }
+	TYPE STRING ALIAS string_list SEMICOLON { insert_declaration(&cur, DECL_TYPE, $2, NULL, @$.first_line); insert_aliases(&cur, $4, DECL_TYPE, @$.first_line); }
 	|
 	TYPE STRING ALIAS string_list COMMA comma_string_list SEMICOLON {
 				insert_declaration(&cur, DECL_TYPE, $2, $6, @$.first_line);
-				free($2);
 				insert_aliases(&cur, $4, DECL_TYPE, @$.first_line); }
 	;
 
 bool_declaration:
-	BOOL STRING SEMICOLON { insert_declaration(&cur, DECL_BOOL, $2, NULL, @$.first_line); free($2); }
+	BOOL STRING SEMICOLON { insert_declaration(&cur, DECL_BOOL, $2, NULL, @$.first_line); }
 	|
-	GEN_BOOL OPEN_PAREN STRING COMMA STRING CLOSE_PAREN { insert_declaration(&cur, DECL_BOOL, $3, NULL, @$.first_line); free($3); free($5); }
+	GEN_BOOL OPEN_PAREN STRING COMMA STRING CLOSE_PAREN { insert_declaration(&cur, DECL_BOOL, $3, NULL, @$.first_line); }
 	|
-	GEN_TUNABLE OPEN_PAREN BACKTICK STRING SINGLE_QUOTE COMMA STRING CLOSE_PAREN { insert_declaration(&cur, DECL_BOOL, $4, NULL, @$.first_line); free($4); free($7); }
+	GEN_TUNABLE OPEN_PAREN BACKTICK STRING SINGLE_QUOTE COMMA STRING CLOSE_PAREN { insert_declaration(&cur, DECL_BOOL, $4, NULL, @$.first_line); }
 	|
-	GEN_TUNABLE OPEN_PAREN STRING COMMA STRING CLOSE_PAREN { insert_declaration(&cur, DECL_BOOL, $3, NULL, @$.first_line); free($3); free($5); }
+	GEN_TUNABLE OPEN_PAREN STRING COMMA STRING CLOSE_PAREN { insert_declaration(&cur, DECL_BOOL, $3, NULL, @$.first_line); }
 	;
 
 type_alias:
-	TYPEALIAS STRING ALIAS string_list SEMICOLON { insert_type_alias(&cur, $2, @$.first_line); insert_aliases(&cur, $4, DECL_TYPE, @$.first_line); free($2); }
+	TYPEALIAS STRING ALIAS string_list SEMICOLON { insert_type_alias(&cur, $2, @$.first_line); insert_aliases(&cur, $4, DECL_TYPE, @$.first_line); }
 	;
 
 type_attribute:
-	TYPE_ATTRIBUTE STRING comma_string_list SEMICOLON { insert_type_attribute(&cur, $2, $3, @$.first_line); free($2); }
+	TYPE_ATTRIBUTE STRING comma_string_list SEMICOLON { insert_type_attribute(&cur, $2, $3, @$.first_line); }
 	;
 
 role_attribute:
-	ROLE_ATTRIBUTE STRING comma_string_list SEMICOLON { insert_role_attribute(&cur, $2, $3, @$.first_line); free($2); }
+	ROLE_ATTRIBUTE STRING comma_string_list SEMICOLON { insert_role_attribute(&cur, $2, $3, @$.first_line); }
 
 rule:
 	av_type string_list string_list COLON string_list string_list SEMICOLON { insert_av_rule(&cur, $1, $2, $3, $5, $6, @$.first_line); }
@@ -435,7 +439,7 @@ av_type:
 	;
 
 xperm_rule:
-	xperm_av_type string_list string_list COLON string_list STRING xperm_list SEMICOLON { insert_xperm_av_rule(&cur, $1, $2, $3, $5, $6, $7, @$.first_line); free($6); }
+	xperm_av_type string_list string_list COLON string_list STRING xperm_list SEMICOLON { insert_xperm_av_rule(&cur, $1, $2, $3, $5, $6, $7, @$.first_line); }
 	;
 
 xperm_av_type:
@@ -453,15 +457,15 @@ xperm_list:
 	|
 	TILDE xperm_list { $$ = sl_from_str("~"); $$->next = $2; }
 	|
-	xperm_item { $$ = sl_from_str_consume($1); }
+	xperm_item { $$ = sl_from_atom($1); }
 	;
 
 xperm_items:
-	xperm_items xperm_item { $$ = concat_string_lists($1, sl_from_str_consume($2)); }
+	xperm_items xperm_item { $$ = concat_string_lists($1, sl_from_atom($2)); }
 	|
-	xperm_item { $$ = sl_from_str_consume($1); }
+	xperm_item { $$ = sl_from_atom($1); }
 	|
-	xperm_item DASH xperm_item { $$ = concat_string_lists(sl_from_str_consume($1), concat_string_lists(sl_from_str("-"), sl_from_str_consume($3))); } // TODO: validate usage: enforce two surrounding increasing elements
+	xperm_item DASH xperm_item { $$ = concat_string_lists(sl_from_atom($1), concat_string_lists(sl_from_str("-"), sl_from_atom($3))); } // TODO: validate usage: enforce two surrounding increasing elements
 	;
 
 xperm_item:
@@ -477,15 +481,15 @@ string_list:
 	|
 	TILDE string_list { $$ = sl_from_str("~"); $$->next = $2; }
 	|
-	sl_item { $$ = sl_from_str_consume($1); }
+	sl_item { $$ = sl_from_atom($1); }
 	|
 	STAR { $$ = sl_from_str("*"); }
 	;
 
 strings:
-	strings sl_item { $$ = concat_string_lists($1, sl_from_str_consume($2)); }
+	strings sl_item { $$ = concat_string_lists($1, sl_from_atom($2)); }
 	|
-	sl_item { $$ = sl_from_str_consume($1); }
+	sl_item { $$ = sl_from_atom($1); }
 	;
 
 string_or_quoted_string:
@@ -497,17 +501,13 @@ string_or_quoted_string:
 sl_item:
 	string_or_quoted_string
 	|
-	DASH STRING { $$ = xmalloc(sizeof(char) * (strlen($2) + 2));
-			$$[0] = '-';
-			$$[1] = '\0';
-			strcat($$, $2);
-			free($2);}
+	DASH STRING { $$ = intern_join("", '-', $2); }
 	;
 
 comma_string_list:
-	comma_string_list COMMA STRING { $$ = concat_string_lists($1, sl_from_str_consume($3)); }
+	comma_string_list COMMA STRING { $$ = concat_string_lists($1, sl_from_atom($3)); }
 	|
-	STRING { $$ = sl_from_str_consume($1); }
+	STRING { $$ = sl_from_atom($1); }
 	;
 
 role_allow:
@@ -517,44 +517,44 @@ role_allow:
                                                                 free_string_list($2);
                                                                 free_string_list($3);
 								const struct location loc = { @1.first_line, @1.first_column, @4.last_line, @4.last_column };
-								yyerror(&loc, NULL, "Incomplete AV rule");
+								yyerror(&loc, scanner, "Incomplete AV rule");
 								YYERROR; }
 	                                            insert_role_allow(&cur, $2, $3, @$.first_line);
 	                                          }
 	;
 
 role_types:
-        ROLE STRING TYPES string_list SEMICOLON { insert_role_types(&cur, $2, $4, @$.first_line); free($2); }
+        ROLE STRING TYPES string_list SEMICOLON { insert_role_types(&cur, $2, $4, @$.first_line); }
         ;
 
 type_transition:
 	TYPE_TRANSITION string_list string_list COLON string_list STRING SEMICOLON
-	{ insert_type_transition(&cur, TT_TT, $2, $3, $5, $6, NULL, @$.first_line); free($6); }
+	{ insert_type_transition(&cur, TT_TT, $2, $3, $5, $6, NULL, @$.first_line); }
 	|
 	TYPE_TRANSITION string_list string_list COLON string_list STRING QUOTED_STRING SEMICOLON
-	{ insert_type_transition(&cur, TT_TT, $2, $3, $5, $6, $7, @$.first_line); free($6); free($7); }
+	{ insert_type_transition(&cur, TT_TT, $2, $3, $5, $6, $7, @$.first_line); }
 	|
-	TYPE_MEMBER string_list string_list COLON string_list STRING SEMICOLON { insert_type_transition(&cur, TT_TM, $2, $3, $5, $6, NULL, @$.first_line); free($6); }
+	TYPE_MEMBER string_list string_list COLON string_list STRING SEMICOLON { insert_type_transition(&cur, TT_TM, $2, $3, $5, $6, NULL, @$.first_line); }
 	|
-	TYPE_CHANGE string_list string_list COLON string_list STRING SEMICOLON { insert_type_transition(&cur, TT_TC, $2, $3, $5, $6, NULL, @$.first_line); free($6); }
+	TYPE_CHANGE string_list string_list COLON string_list STRING SEMICOLON { insert_type_transition(&cur, TT_TC, $2, $3, $5, $6, NULL, @$.first_line); }
 	;
 
 range_transition:
-	RANGE_TRANSITION string_list string_list COLON string_list mls_range SEMICOLON { insert_type_transition(&cur, TT_RT, $2, $3, $5, $6, NULL, @$.first_line); free($6); }
+	RANGE_TRANSITION string_list string_list COLON string_list mls_range SEMICOLON { insert_type_transition(&cur, TT_RT, $2, $3, $5, $6, NULL, @$.first_line); }
 	;
 
 role_transition:
-	ROLE_TRANSITION string_list string_list STRING SEMICOLON { insert_role_transition(&cur, $2, $3, NULL, $4, @$.first_line); free($4); }
+	ROLE_TRANSITION string_list string_list STRING SEMICOLON { insert_role_transition(&cur, $2, $3, NULL, $4, @$.first_line); }
 	|
-	ROLE_TRANSITION string_list string_list COLON string_list STRING SEMICOLON { insert_role_transition(&cur, $2, $3, $5, $6, @$.first_line); free($6); }
+	ROLE_TRANSITION string_list string_list COLON string_list STRING SEMICOLON { insert_role_transition(&cur, $2, $3, $5, $6, @$.first_line); }
 	;
 
 interface_call:
 	STRING OPEN_PAREN args CLOSE_PAREN
-	{ insert_interface_call(&cur, $1, $3, @$.first_line); free($1); }
+	{ insert_interface_call(&cur, $1, $3, @$.first_line); }
 	|
 	STRING OPEN_PAREN CLOSE_PAREN
-	{ insert_interface_call(&cur, $1, NULL, @$.first_line); free($1); }
+	{ insert_interface_call(&cur, $1, NULL, @$.first_line); }
 	;
 
 optional_block:
@@ -571,22 +571,22 @@ optional_block:
 	;
 
 optional_open:
-	OPTIONAL_POLICY OPEN_PAREN BACKTICK maybe_selint_disable { begin_optional_policy(&cur, @$.first_line); save_command(cur->parent, $4); free($4); }
+	OPTIONAL_POLICY OPEN_PAREN BACKTICK maybe_selint_disable { begin_optional_policy(&cur, @$.first_line); save_command(cur->parent, $4); }
 	;
 
 require:
 	gen_require_begin
-	BACKTICK maybe_selint_disable require_lines SINGLE_QUOTE CLOSE_PAREN { end_gen_require(&cur, 0); save_command(cur, $3); free($3); }
+	BACKTICK maybe_selint_disable require_lines SINGLE_QUOTE CLOSE_PAREN { end_gen_require(&cur, 0); save_command(cur, $3); }
 	|
 	gen_require_begin
 	require_lines CLOSE_PAREN { end_gen_require(&cur, 1); }
 	|
-	REQUIRE OPEN_CURLY maybe_selint_disable { begin_require(&cur, @$.first_line); save_command(cur->parent, $3); free($3); }
+	REQUIRE OPEN_CURLY maybe_selint_disable { begin_require(&cur, @$.first_line); save_command(cur->parent, $3); }
 	require_lines CLOSE_CURLY { end_require(&cur); }
 	;
 
 gen_require_begin:
-	GEN_REQUIRE OPEN_PAREN maybe_selint_disable { begin_gen_require(&cur, @$.first_line); save_command(cur->parent, $3); free($3); }
+	GEN_REQUIRE OPEN_PAREN maybe_selint_disable { begin_gen_require(&cur, @$.first_line); save_command(cur->parent, $3); }
 	;
 
 require_lines:
@@ -602,7 +602,6 @@ require_line:
 			save_command(cur, $4);
 		}
 		free_string_list($2);
-		free($4);
 		}
 	|
 	ATTRIBUTE comma_string_list SEMICOLON maybe_selint_disable {
@@ -611,7 +610,6 @@ require_line:
 			save_command(cur, $4);
 		}
 		free_string_list($2);
-		free($4);
 		}
 	|
 	ROLE comma_string_list SEMICOLON maybe_selint_disable {
@@ -620,7 +618,6 @@ require_line:
 			save_command(cur, $4);
 		}
 		free_string_list($2);
-		free($4);
 		}
 	|
 	ATTRIBUTE_ROLE comma_string_list SEMICOLON maybe_selint_disable {
@@ -629,7 +626,6 @@ require_line:
 			save_command(cur, $4);
 		}
 		free_string_list($2);
-		free($4);
 		}
 	|
 	BOOL comma_string_list SEMICOLON maybe_selint_disable {
@@ -638,14 +634,11 @@ require_line:
 			save_command(cur, $4);
 		}
 		free_string_list($2);
-		free($4);
 		}
 	|
 	CLASS STRING string_list SEMICOLON maybe_selint_disable {
 		insert_declaration(&cur, DECL_CLASS, $2, $3, @$.first_line);
 		save_command(cur, $5);
-		free($2);
-		free($5);
 		}
 	|
 	ifdef_opener
@@ -674,7 +667,7 @@ m4_call:
 	;
 
 ifdef_opener:
-	if_or_ifn OPEN_PAREN BACKTICK STRING SINGLE_QUOTE COMMA { begin_ifdef(&cur, @$.first_line); free($4); }
+	if_or_ifn OPEN_PAREN BACKTICK STRING SINGLE_QUOTE COMMA { begin_ifdef(&cur, @$.first_line); }
 	;
 
 ifdef:
@@ -707,7 +700,7 @@ arbitrary_m4_string:
 	;
 
 m4_string_elem:
-	STRING { free($1); }
+	STRING
 	|
 	OPEN_PAREN
 	|
@@ -771,7 +764,7 @@ m4_argument:
 	|
 	BACKTICK lines SINGLE_QUOTE
 	|
-	STRING { free($1); }
+	STRING
 	;
 
 arg_list:
@@ -779,21 +772,17 @@ arg_list:
 	|
 	TILDE arg_list { $$ = sl_from_str("~"); $$->next = $2; }
 	|
-	arg_list_item { $$ = sl_from_str_consume($1); }
+	arg_list_item { $$ = sl_from_atom($1); }
 	;
 
 arg_list_items:
-	arg_list_items arg_list_item { $$ = concat_string_lists($1, sl_from_str_consume($2)); }
+	arg_list_items arg_list_item { $$ = concat_string_lists($1, sl_from_atom($2)); }
 	|
-	arg_list_item { $$ = sl_from_str_consume($1); }
+	arg_list_item { $$ = sl_from_atom($1); }
 	;
 
 arg_list_item:
-	DASH arg_list_item { $$ = xmalloc(sizeof(char) * (strlen($2) + 2));
-			$$[0] = '-';
-			$$[1] = '\0';
-			strcat($$, $2);
-			free($2); }
+	DASH arg_list_item { $$ = intern_join("", '-', $2); }
 	|
 	STRING
 	|
@@ -803,9 +792,9 @@ arg_list_item:
 	;
 
 arg_m4_quoted:
-	QUOTED_STRING { $$ = sl_from_str_consume($1); }
+	QUOTED_STRING { $$ = sl_from_atom($1); }
 	|
-	mls_range { $$ = sl_from_str_consume($1); }
+	mls_range { $$ = sl_from_atom($1); }
 	|
 	%empty { $$ = sl_from_str(""); }
 	|
@@ -815,7 +804,7 @@ arg_m4_quoted:
 arg:
 	arg_list
 	|
-	QUOTED_STRING { $$ = sl_from_str_consume($1); }
+	QUOTED_STRING { $$ = sl_from_atom($1); }
 	|
 	BACKTICK arg_m4_quoted SINGLE_QUOTE { $$ = $2; }
 	;
@@ -825,18 +814,14 @@ args:
 	|
 	args COMMA arg { $3->arg_start = 1; $$ = concat_string_lists($1, $3); }
 	|
-	args sl_item { struct string_list *sl = xcalloc(1, sizeof(struct string_list));
-			sl->string = $2;
+	args sl_item { struct string_list *sl = sl_from_atom($2);
 			sl->has_incorrect_space = 1;
 			$1->arg_start = 1;
 			$$ = concat_string_lists($1, sl); }
 	;
 
 mls_range:
-	mls_level DASH mls_level { size_t len = strlen($1) + strlen($3) + 1 /* DASH */ + 1 /* NT */;
-				$$ = xmalloc(len);
-				snprintf($$, len, "%s-%s", $1, $3);
-				free($1); free($3); }
+	mls_level DASH mls_level { $$ = intern_join($1, '-', $3); }
 	|
 	mls_level
 	;
@@ -844,19 +829,13 @@ mls_range:
 mls_level:
 	mls_component
 	|
-	mls_component COLON mls_component { size_t len = strlen($1) + strlen($3) + 1 /* COLON */ + 1 /* NT */;
-				$$ = xmalloc(len);
-				snprintf($$, len, "%s:%s", $1, $3);
-				free($1); free($3); }
+	mls_component COLON mls_component { $$ = intern_join($1, ':', $3); }
 	;
 
 mls_component:
 	STRING
 	|
-	STRING PERIOD STRING { size_t len = strlen($1) + strlen($3) + 1 /* PERIOD */ + 1 /* NT */;
-				$$ = xmalloc(len);
-				snprintf($$, len, "%s.%s", $1, $3);
-				free($1); free($3); }
+	STRING PERIOD STRING { $$ = intern_join($1, '.', $3); }
 	;
 
 cond_expr:
@@ -866,28 +845,28 @@ cond_expr:
 	;
 
 boolean_block:
-	boolean_open condition CLOSE_PAREN maybe_selint_disable OPEN_CURLY lines CLOSE_CURLY { end_boolean_policy(&cur); save_command(cur, $4); free($4); }
+	boolean_open condition CLOSE_PAREN maybe_selint_disable OPEN_CURLY lines CLOSE_CURLY { end_boolean_policy(&cur); save_command(cur, $4); }
 	|
 	boolean_open condition CLOSE_PAREN maybe_selint_disable OPEN_CURLY lines CLOSE_CURLY
-	ELSE OPEN_CURLY lines CLOSE_CURLY { end_boolean_policy(&cur); save_command(cur, $4); free($4); }
+	ELSE OPEN_CURLY lines CLOSE_CURLY { end_boolean_policy(&cur); save_command(cur, $4); }
 	;
 
 boolean_open:
-	IF OPEN_PAREN maybe_selint_disable { begin_boolean_policy(&cur, @$.first_line); save_command(cur->parent, $3); free($3); }
+	IF OPEN_PAREN maybe_selint_disable { begin_boolean_policy(&cur, @$.first_line); save_command(cur->parent, $3); }
 	;
 
 tunable_block:
 	TUNABLE_POLICY OPEN_PAREN BACKTICK { begin_tunable_policy(&cur, @$.first_line); }
-	condition SINGLE_QUOTE maybe_selint_disable COMMA m4_args CLOSE_PAREN { end_tunable_policy(&cur); save_command(cur, $7); free($7); }
+	condition SINGLE_QUOTE maybe_selint_disable COMMA m4_args CLOSE_PAREN { end_tunable_policy(&cur); save_command(cur, $7); }
 	|
 	TUNABLE_POLICY OPEN_PAREN { begin_tunable_policy(&cur, @$.first_line); }
-	condition maybe_selint_disable COMMA m4_args CLOSE_PAREN { end_tunable_policy(&cur); save_command(cur, $5); free($5); }
+	condition maybe_selint_disable COMMA m4_args CLOSE_PAREN { end_tunable_policy(&cur); save_command(cur, $5); }
 	;
 
 genfscon:
-	GENFSCON STRING string_or_quoted_string genfscon_context { free($2); free($3); }
+	GENFSCON STRING string_or_quoted_string genfscon_context
 	|
-	GENFSCON NUM_STRING string_or_quoted_string genfscon_context { free($2); free($3); }
+	GENFSCON NUM_STRING string_or_quoted_string genfscon_context
 	;
 
 genfscon_context:
@@ -897,25 +876,25 @@ genfscon_context:
 	;
 
 sid:
-	SID STRING context { free($2); }
+	SID STRING context
 	;
 
 portcon:
-	PORTCON STRING port_range context { free($2); }
+	PORTCON STRING port_range context
 	;
 
 port_range:
-	NUM_STRING { free($1); }
+	NUM_STRING
 	|
-	NUMBER { free($1); }
+	NUMBER
 	|
 	// TODO: This only happens with whitespace around the dash.  NUM_STRING catches "1000-1001" type
 	// names.  Is that actually a valid scenario?
-	NUMBER DASH NUMBER { free($1); free($3); }
+	NUMBER DASH NUMBER
 	;
 
 netifcon:
-	NETIFCON STRING context context { free($2); }
+	NETIFCON STRING context context
 	;
 
 nodecon:
@@ -925,23 +904,23 @@ nodecon:
 	;
 
 two_ip_addrs:
-	IPV4 IPV4 { free($1); free($2); }
+	IPV4 IPV4
 	|
-	IPV6 IPV6 { free($1); free($2); }
+	IPV6 IPV6
 	;
 
 cidr_addr:
-	IPV4_CIDR { free($1); }
+	IPV4_CIDR
 	|
-	IPV6_CIDR { free($1); }
+	IPV6_CIDR
 	;
 
 fs_use:
-	FS_USE_TRANS STRING context SEMICOLON { free($2); }
+	FS_USE_TRANS STRING context SEMICOLON
 	|
-	FS_USE_XATTR STRING context SEMICOLON { free($2); }
+	FS_USE_XATTR STRING context SEMICOLON
 	|
-	FS_USE_TASK STRING context SEMICOLON { free($2); }
+	FS_USE_TASK STRING context SEMICOLON
 	;
 
 define:
@@ -950,9 +929,9 @@ define:
 	;
 
 define_name:
-	BACKTICK STRING SINGLE_QUOTE { free($2); }
+	BACKTICK STRING SINGLE_QUOTE
 	|
-	STRING { free($1); }
+	STRING
 	;
 
 define_content:
@@ -966,7 +945,7 @@ define_expansion:
 	|
 	BACKTICK arbitrary_m4_string SINGLE_QUOTE
 	|
-	STRING { free($1); }
+	STRING
 	|
 	BACKTICK SINGLE_QUOTE
 	;
@@ -974,13 +953,13 @@ define_expansion:
 maybe_string_comma:
 	STRING COMMA
 	|
-	COMMA { $$ = xstrdup(""); }
+	COMMA { $$ = ""; }
 	;
 
 gen_user:
-	GEN_USER OPEN_PAREN maybe_string_comma maybe_string_comma strings COMMA mls_range COMMA mls_range CLOSE_PAREN { free($3); free($4); free_string_list($5); free($7); free($9); }
+	GEN_USER OPEN_PAREN maybe_string_comma maybe_string_comma strings COMMA mls_range COMMA mls_range CLOSE_PAREN { free_string_list($5); }
 	|
-	GEN_USER OPEN_PAREN maybe_string_comma maybe_string_comma strings COMMA mls_range COMMA mls_range COMMA mls_range CLOSE_PAREN { free($3); free($4); free_string_list($5); free($7); free($9); free($11); }
+	GEN_USER OPEN_PAREN maybe_string_comma maybe_string_comma strings COMMA mls_range COMMA mls_range COMMA mls_range CLOSE_PAREN { free_string_list($5); }
 	;
 
 context:
@@ -988,25 +967,25 @@ context:
 	|
 	GEN_CONTEXT OPEN_PAREN raw_context CLOSE_PAREN
 	|
-	GEN_CONTEXT OPEN_PAREN raw_context COMMA mls_range CLOSE_PAREN { free($5); }
+	GEN_CONTEXT OPEN_PAREN raw_context COMMA mls_range CLOSE_PAREN
 	|
-	GEN_CONTEXT OPEN_PAREN raw_context COMMA mls_range COMMA mls_range CLOSE_PAREN { free($5); free($7); }
+	GEN_CONTEXT OPEN_PAREN raw_context COMMA mls_range COMMA mls_range CLOSE_PAREN
 	|
-	GEN_CONTEXT OPEN_PAREN raw_context COMMA mls_range COMMA CLOSE_PAREN { free($5); }
+	GEN_CONTEXT OPEN_PAREN raw_context COMMA mls_range COMMA CLOSE_PAREN
 	;
 
 raw_context:
-	STRING COLON STRING COLON STRING { free($1); free($3); free($5); }
+	STRING COLON STRING COLON STRING
 	|
-	STRING COLON STRING COLON STRING COLON mls_range { free($1); free($3); free($5); free($7); }
+	STRING COLON STRING COLON STRING COLON mls_range
 	;
 
 permissive:
-	PERMISSIVE STRING SEMICOLON { insert_permissive_statement(&cur, $2, @$.first_line); free($2);}
+	PERMISSIVE STRING SEMICOLON { insert_permissive_statement(&cur, $2, @$.first_line);}
 	;
 
 typebounds:
-	TYPEBOUNDS STRING STRING SEMICOLON { free($2); free($3); }
+	TYPEBOUNDS STRING STRING SEMICOLON
 	;
 
 	// IF File parsing
@@ -1046,19 +1025,19 @@ if_file_ifdef:
 	;
 
 interface_def:
-	start_interface maybe_selint_disable lines end_interface { save_command(cur, $2); free($2); }
+	start_interface maybe_selint_disable lines end_interface { save_command(cur, $2); }
 	|
-	start_interface maybe_selint_disable end_interface  { save_command(cur, $2); free($2); }
+	start_interface maybe_selint_disable end_interface  { save_command(cur, $2); }
 	;
 
 start_interface:
 	if_keyword OPEN_PAREN BACKTICK STRING SINGLE_QUOTE COMMA BACKTICK {
 				if (expected_node_flavor != NODE_IF_FILE) {
 					const struct location loc = { @1.first_line, @1.first_column, @7.last_line, @7.last_column };
-					yyerror(&loc, NULL, "Error: Unexpected if-file parsed");
+					yyerror(&loc, scanner, "Error: Unexpected if-file parsed");
 					YYERROR;
 				}
-				begin_interface_def(&cur, $1, $4, @$.first_line); free($4); }
+				begin_interface_def(&cur, $1, $4, @$.first_line); }
 	;
 
 end_interface:
@@ -1093,16 +1072,15 @@ spt_line:
 support_def:
 	DEFINE OPEN_PAREN BACKTICK STRING SINGLE_QUOTE COMMA BACKTICK spt_contents SINGLE_QUOTE CLOSE_PAREN {
 			if (expected_node_flavor != NODE_SPT_FILE) {
-				free($4); free_string_list($8);
+				free_string_list($8);
 				const struct location loc = { @1.first_line, @1.first_column, @10.last_line, @10.last_column };
-				yyerror(&loc, NULL, "Error: Unexpected spt-file parsed"); YYERROR;
+				yyerror(&loc, scanner, "Error: Unexpected spt-file parsed"); YYERROR;
 			}
 			if (ends_with($4, strlen($4), "_perms", strlen("_perms"))) {
 				insert_into_permmacros_map($4, $8);
 			} else {
 				free_string_list($8);
-			}
-			free($4); }
+			} }
 	;
 
 spt_contents:
@@ -1148,47 +1126,46 @@ av_definition:
 av_class_definition:
 	CLASS STRING av_permission_list {
 			if (expected_node_flavor != NODE_AV_FILE) {
-				free($2);
+				free_string_list($3);
 				const struct location loc = { @1.first_line, @1.first_column, @3.last_line, @3.last_column };
-				yyerror(&loc, NULL, "Error: Unexpected av-file parsed"); YYERROR;
+				yyerror(&loc, scanner, "Error: Unexpected av-file parsed"); YYERROR;
 			}
-			insert_into_decl_map($2, "__av_file__", DECL_CLASS); free($2); }
+			insert_av_class($2, NULL, $3); }
 	|
 	CLASS STRING INHERITS STRING {
 			if (expected_node_flavor != NODE_AV_FILE) {
-				free($2); free($4);
 				const struct location loc = { @1.first_line, @1.first_column, @4.last_line, @4.last_column };
-				yyerror(&loc, NULL, "Error: Unexpected av-file parsed"); YYERROR;
+				yyerror(&loc, scanner, "Error: Unexpected av-file parsed"); YYERROR;
 			}
-			insert_into_decl_map($2, "__av_file__", DECL_CLASS); free($2); free($4); }
+			insert_av_class($2, $4, NULL); }
 	|
 	CLASS STRING INHERITS STRING av_permission_list {
 			if (expected_node_flavor != NODE_AV_FILE) {
-				free($2); free($4);
+				free_string_list($5);
 				const struct location loc = { @1.first_line, @1.first_column, @5.last_line, @5.last_column };
-				yyerror(&loc, NULL, "Error: Unexpected av-file parsed"); YYERROR;
+				yyerror(&loc, scanner, "Error: Unexpected av-file parsed"); YYERROR;
 			}
-			insert_into_decl_map($2, "__av_file__", DECL_CLASS); free($2); free($4); }
+			insert_av_class($2, $4, $5); }
 	;
 
 av_common_definition:
-	COMMON STRING av_permission_list { free($2); }
+	COMMON STRING av_permission_list { insert_av_common($2, $3); }
 	;
 
 av_permission_list:
-	OPEN_CURLY av_permissions CLOSE_CURLY
+	OPEN_CURLY av_permissions CLOSE_CURLY { $$ = $2; }
 	;
 
 av_permissions:
-	av_permissions av_permission
+	av_permissions av_permission { $$ = concat_string_lists($1, $2); }
 	|
 	av_permission
 	;
 
 av_permission:
-	STRING { insert_into_decl_map($1, "__av_file__", DECL_PERM); free($1); }
+	STRING { $$ = sl_from_atom($1); }
 	|
-	COMMENT
+	COMMENT { $$ = NULL; }
 	;
 
 // policy/global_booleans and policy/global_tunables files
@@ -1215,11 +1192,24 @@ gcf_definition:
 	bool_declaration {
 		if (expected_node_flavor != NODE_COND_FILE) {
 				const struct location loc = { @1.first_line, @1.first_column, @1.last_line, @1.last_column };
-				yyerror(&loc, NULL, "Error: Unexpected global conditionals file parsed"); YYERROR;
+				yyerror(&loc, scanner, "Error: Unexpected global conditionals file parsed"); YYERROR;
 		} }
 	;
 
 %%
+// Return the atom of left and right joined by separator, e.g. for MLS levels
+static const char *intern_join(const char *left, char separator, const char *right) {
+	const size_t left_len = strlen(left);
+	const size_t right_len = strlen(right);
+	char *joined = xmalloc(left_len + 1 + right_len);
+	memcpy(joined, left, left_len);
+	joined[left_len] = separator;
+	memcpy(joined + left_len + 1, right, right_len);
+	const char *ret = intern_n(joined, left_len + 1 + right_len);
+	free(joined);
+	return ret;
+}
+
 static unsigned leading_spaces(const char *str) {
 	unsigned result = 0;
 	while (str[result] == ' ' || str[result] == '\t')
@@ -1227,7 +1217,9 @@ static unsigned leading_spaces(const char *str) {
 	return result;
 }
 
-static void yyerror(const YYLTYPE *locp, __attribute__((unused)) yyscan_t scanner, char const *msg) {
+static void yyerror(const YYLTYPE *locp, yyscan_t scanner, char const *msg) {
+
+	FILE *out = get_result_stream();
 
 	// Print error tag: """test7.if:             1: (F): Error: Unexpected te-file parsed (F-001)"""
 	{
@@ -1253,21 +1245,22 @@ IGNORE_CONST_DISCARD_END
 	if (lines_to_print > LINES_TO_CACHE) {
 		lines_to_print = LINES_TO_CACHE;
 		shortened = true;
-		printf("%5u |  ...  [truncated]\n", locp->last_line - LINES_TO_CACHE);
+		fprintf(out, "%5u |  ...  [truncated]\n", locp->last_line - LINES_TO_CACHE);
 	}
 
 	for (unsigned k = lines_to_print; k > 0; --k) {
 
-		const char *current_line = trim_right(current_lines[(LINES_TO_CACHE + line_cache_index - k + 1) % LINES_TO_CACHE]);
+		char *line = scanner_get_line(scanner, locp->last_line - (k - 1));
+		const char *current_line = trim_right(line);
 		const unsigned current_first_column = (k == lines_to_print && !shortened) ? locp->first_column : (1 + leading_spaces(current_line));
 		const unsigned current_last_column = (k == 1) ? locp->last_column : (unsigned)strlen(current_line);
 
-		printf("%5u |", locp->last_line - (k - 1));
+		fprintf(out, "%5u |", locp->last_line - (k - 1));
 
 		// print line, replace tabs
 		unsigned tabs_before_hinter = 0, tabs_inside_hinter = 0;
 		if (*current_line != '\0') {
-			printf(" ");
+			fprintf(out, " ");
 		}
 		for (const char *c = current_line; *c != '\0'; ++c) {
 			if (*c == '\t') {
@@ -1276,63 +1269,68 @@ IGNORE_CONST_DISCARD_END
 				} else if ((size_t)(c - current_line) < current_last_column) {
 					tabs_inside_hinter++;
 				}
-				printf("    ");
+				fprintf(out, "    ");
 				continue;
 			}
 
 			if (!isprint((unsigned char)*c) && !isspace((unsigned char)*c)) {
-				printf("%s!%s\n%sWarning%s: Line in question contains unprintable character at position %zu: 0x%.2x\n",
-				       color_error(), color_reset(),
-				       color_warning(), color_reset(),
-				       (size_t)(c - current_line + 1),
-				       *c);
+				fprintf(out, "%s!%s\n%sWarning%s: Line in question contains unprintable character at position %zu: 0x%.2x\n",
+				        color_error(), color_reset(),
+				        color_warning(), color_reset(),
+				        (size_t)(c - current_line + 1),
+				        *c);
+				free(line);
 				return;
 			}
 
-			printf("%c", *c);
+			fprintf(out, "%c", *c);
 		}
 
-		printf("\n      | ");
+		fprintf(out, "\n      | ");
 
 		// print hinter
 		for (unsigned i = 0; i < tabs_before_hinter; ++i) {
-			printf("    ");
+			fprintf(out, "    ");
 		}
 		for (unsigned i = tabs_before_hinter + 1; i < current_first_column; ++i) {
-			printf(" ");
+			fprintf(out, " ");
 		}
 
 		if (k == lines_to_print) {
-			printf("%s^", color_error());
+			fprintf(out, "%s^", color_error());
 		} else {
-			printf("%s~", color_error());
+			fprintf(out, "%s~", color_error());
 		}
 
 		if (current_last_column > current_first_column) {
 			for (unsigned i = 0; i < (current_last_column - current_first_column); ++i) {
-				printf("~");
+				fprintf(out, "~");
 			}
 			for (unsigned i = 0; i < tabs_inside_hinter; ++i) {
-				printf("~~~");
+				fprintf(out, "~~~");
 			}
 		}
-		printf("%s\n", color_reset());
+		fprintf(out, "%s\n", color_reset());
+
+		free(line);
 	}
 }
 
 struct policy_node *yyparse_wrapper(FILE *filefd, const char *filename, enum node_flavor expected_flavor) {
-	struct policy_node *ast = xcalloc(1, sizeof(struct policy_node));
+	yyscan_t scanner = scanner_open(filefd);
+	if (!scanner) {
+		fprintf(get_result_stream(), "%sError%s: Failed to read %s: %s\n", color_error(), color_reset(), filename, strerror(errno));
+		return NULL;
+	}
+
+	struct policy_node *ast = alloc_policy_node();
 	ast->flavor = expected_node_flavor = expected_flavor;
-	yyscan_t scanner;
-	yylex_init(&scanner);
-	yyrestart(filefd, scanner);
 	parsing_filename = filename;
 	cur = ast;
 
 	const int ret = yyparse(scanner);
 
-	reset_current_lines();
-	yylex_destroy(scanner);
+	scanner_close(scanner);
 
 	if (ret != 0) {
 		// parser will have printed an error message
@@ -1340,5 +1338,7 @@ struct policy_node *yyparse_wrapper(FILE *filefd, const char *filename, enum nod
 		return NULL;
 	}
 
+	inherit_disabled_checks(ast);
+
 	return ast;
 }
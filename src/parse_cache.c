@@ -0,0 +1,1103 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <libgen.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <uthash.h>
+
+#include "config.h"
+
+#include "check_hooks.h"
+#include "intern.h"
+#include "parse_cache.h"
+#include "parse_functions.h"
+#include "serialize.h"
+#include "util.h"
+#include "xalloc.h"
+
+// Entries are framed by the magic and a checksum, see serialize.h
+#define ENTRY_MAGIC "SELINTPC"
+#define ENTRY_MAGIC_LEN 8
+
+// Entry names are two 64 bit hashes in hex followed by the suffix
+#define ENTRY_SUFFIX ".ast"
+#define ENTRY_HASH_LEN 32
+
+// Temporary files not renamed for that long were abandoned by runs which
+// were interrupted
+#define ABANDONED_TMP_SECONDS 3600
+
+// Deeper nesting than any real policy, to bound recursion on corrupt entries
+#define MAX_NODE_DEPTH 1024
+
+// String references: 0 is NULL, 1 introduces a new string, and n > 1
+// refers to the (n - 2)th string introduced before
+#define STR_NULL 0
+#define STR_NEW 1
+#define STR_FIRST_REF 2
+
+static char *cache_dir = NULL;
+
+static size_t cache_hits = 0;   // accessed atomically
+static size_t cache_misses = 0; // accessed atomically
+static size_t cache_stores = 0; // accessed atomically
+
+static void free_cache_dir(void)
+{
+	free(cache_dir);
+	cache_dir = NULL;
+}
+
+enum selint_error enable_parse_cache(const char *dir)
+{
+	if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+		return SELINT_IO_ERROR;
+	}
+
+	struct stat st;
+	if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+		return SELINT_IO_ERROR;
+	}
+
+	if (!cache_dir) {
+		atexit(free_cache_dir);
+	}
+	free(cache_dir);
+	cache_dir = xstrdup(dir);
+
+	return SELINT_SUCCESS;
+}
+
+int is_parse_cache_enabled(void)
+{
+	return cache_dir != NULL;
+}
+
+static char *module_name_of(const char *filename)
+{
+	char *copy = xstrdup(filename);
+	char *mod_name = xstrdup(basename(copy));
+	free(copy);
+
+	const size_t len = strlen(mod_name);
+	mod_name[len > 3 ? len - 3 : 0] = '\0'; // Remove suffix
+
+	return mod_name;
+}
+
+// Hash the content of the file along with everything else parsing it
+// depends on.  Returns 0 if the file cannot be read.
+static int compute_key(const char *filename, enum node_flavor flavor,
+                       struct parse_cache_key *key)
+{
+	const int fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return 0;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return 0;
+	}
+
+	serial_hash_init(key->hash);
+	key->size = (uint64_t)st.st_size;
+	key->flavor = flavor;
+	key->mod_name = module_name_of(filename);
+
+	const unsigned int format = PARSE_CACHE_FORMAT;
+	serial_hash_bytes(key->hash, &format, sizeof(format));
+	serial_hash_bytes(key->hash, VERSION, sizeof(VERSION));
+	serial_hash_bytes(key->hash, &key->flavor, sizeof(key->flavor));
+	serial_hash_bytes(key->hash, key->mod_name, strlen(key->mod_name) + 1);
+
+	if (st.st_size > 0) {
+		void *content = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (content == MAP_FAILED) {
+			close(fd);
+			free_parse_cache_key(key);
+			return 0;
+		}
+		serial_hash_bytes(key->hash, content, (size_t)st.st_size);
+		munmap(content, (size_t)st.st_size);
+	}
+
+	close(fd);
+
+	return 1;
+}
+
+static char *entry_path(const struct parse_cache_key *key)
+{
+	const size_t len = strlen(cache_dir) + 1 + ENTRY_HASH_LEN + sizeof(ENTRY_SUFFIX);
+	char *path = xmalloc(len);
+
+	snprintf(path, len, "%s/%016" PRIx64 "%016" PRIx64 ENTRY_SUFFIX,
+	         cache_dir, key->hash[0], key->hash[1]);
+
+	return path;
+}
+
+void free_parse_cache_key(struct parse_cache_key *key)
+{
+	free(key->mod_name);
+	key->mod_name = NULL;
+}
+
+void get_parse_cache_stats(struct parse_cache_stats *stats)
+{
+	stats->hits = __atomic_load_n(&cache_hits, __ATOMIC_RELAXED);
+	stats->misses = __atomic_load_n(&cache_misses, __ATOMIC_RELAXED);
+	stats->stores = __atomic_load_n(&cache_stores, __ATOMIC_RELAXED);
+}
+
+struct cache_entry {
+	char *name;
+	struct timespec mtime;
+};
+
+static int is_entry_name(const char *name)
+{
+	return strlen(name) == ENTRY_HASH_LEN + strlen(ENTRY_SUFFIX) &&
+	       strspn(name, "0123456789abcdef") == ENTRY_HASH_LEN &&
+	       0 == strcmp(name + ENTRY_HASH_LEN, ENTRY_SUFFIX);
+}
+
+// Order entries from the least to the most recently used
+static int compare_entry_ages(const void *a, const void *b)
+{
+	const struct cache_entry *x = a;
+	const struct cache_entry *y = b;
+
+	if (x->mtime.tv_sec != y->mtime.tv_sec) {
+		return x->mtime.tv_sec < y->mtime.tv_sec ? -1 : 1;
+	}
+	if (x->mtime.tv_nsec != y->mtime.tv_nsec) {
+		return x->mtime.tv_nsec < y->mtime.tv_nsec ? -1 : 1;
+	}
+
+	return strcmp(x->name, y->name);
+}
+
+enum selint_error prune_parse_cache(size_t max_entries)
+{
+	if (!cache_dir) {
+		return SELINT_SUCCESS;
+	}
+
+	DIR *dir = opendir(cache_dir);
+	if (!dir) {
+		return SELINT_IO_ERROR;
+	}
+
+	const int fd = dirfd(dir);
+	const time_t now = time(NULL);
+	struct cache_entry *entries = NULL;
+	size_t count = 0;
+	size_t cap = 0;
+
+	const struct dirent *dent;
+	while ((dent = readdir(dir))) {
+		const int is_tmp = 0 == strncmp(dent->d_name, SERIAL_TMP_PREFIX, strlen(SERIAL_TMP_PREFIX));
+		struct stat st;
+
+		if ((!is_tmp && !is_entry_name(dent->d_name)) ||
+		    fstatat(fd, dent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 ||
+		    !S_ISREG(st.st_mode)) {
+			continue;
+		}
+
+		if (is_tmp) {
+			if (now - st.st_mtime > ABANDONED_TMP_SECONDS) {
+				unlinkat(fd, dent->d_name, 0);
+			}
+			continue;
+		}
+
+		if (count == cap) {
+			cap = cap ? cap * 2 : 256;
+			entries = xrealloc(entries, cap * sizeof(struct cache_entry));
+		}
+		entries[count].name = xstrdup(dent->d_name);
+		entries[count].mtime = st.st_mtim;
+		count++;
+	}
+
+	if (count > max_entries) {
+		qsort(entries, count, sizeof(struct cache_entry), compare_entry_ages);
+		// Concurrent runs might have removed some already
+		for (size_t i = 0; i < count - max_entries; i++) {
+			unlinkat(fd, entries[i].name, 0);
+		}
+		print_if_verbose("Pruned %zu least recently used parse cache entries\n",
+		                 count - max_entries);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		free(entries[i].name);
+	}
+	free(entries);
+	closedir(dir);
+
+	return SELINT_SUCCESS;
+}
+
+/*
+ * Serializing
+ */
+
+struct written_string {
+	const char *str;
+	uint64_t index;
+	UT_hash_handle hh;
+};
+
+struct written_call {
+	const struct if_call_data *call;
+	uint64_t index;
+	UT_hash_handle hh;
+};
+
+struct writer {
+	struct serial_writer out;
+	struct written_string *strings;
+	uint64_t string_count;
+	struct written_call *calls;
+	uint64_t call_count;
+	int failed;     // the content cannot be stored
+};
+
+no_sanitize_unsigned_integer_
+static void put_str(struct writer *w, const char *str)
+{
+	if (!str) {
+		serial_put_varint(&w->out, STR_NULL);
+		return;
+	}
+
+	struct written_string *ws;
+	const size_t len = strlen(str);
+
+	HASH_FIND(hh, w->strings, str, len, ws);
+	if (ws) {
+		serial_put_varint(&w->out, STR_FIRST_REF + ws->index);
+		return;
+	}
+
+	ws = xmalloc(sizeof(struct written_string));
+	ws->str = str;
+	ws->index = w->string_count++;
+	HASH_ADD_KEYPTR(hh, w->strings, ws->str, len, ws);
+
+	serial_put_varint(&w->out, STR_NEW);
+	serial_put_data(&w->out, str, len);
+}
+
+static void put_sl(struct writer *w, const struct string_list *sl)
+{
+	uint64_t count = 0;
+	for (const struct string_list *cur = sl; cur; cur = cur->next) {
+		count++;
+	}
+
+	serial_put_varint(&w->out, count);
+	for (const struct string_list *cur = sl; cur; cur = cur->next) {
+		put_str(w, cur->string);
+		serial_put_varint(&w->out, (uint64_t)(cur->has_incorrect_space != 0) | (uint64_t)(cur->arg_start != 0) << 1);
+	}
+}
+
+// Struct members of node data are preceded by a flag telling whether they are set
+static int put_presence(struct writer *w, const void *ptr)
+{
+	serial_put_varint(&w->out, ptr != NULL);
+
+	return ptr != NULL;
+}
+
+no_sanitize_unsigned_integer_
+static void put_call(struct writer *w, const struct if_call_data *call)
+{
+	const uint64_t index = w->call_count++;
+
+	if (!call) {
+		return;
+	}
+
+	struct written_call *wc = xmalloc(sizeof(struct written_call));
+	wc->call = call;
+	wc->index = index;
+	HASH_ADD_PTR(w->calls, call, wc);
+}
+
+no_sanitize_unsigned_integer_
+static int find_call(const struct writer *w, const struct if_call_data *call, uint64_t *index)
+{
+	struct written_call *wc;
+
+	HASH_FIND_PTR(w->calls, &call, wc);
+	if (!wc) {
+		return 0;
+	}
+
+	*index = wc->index;
+
+	return 1;
+}
+
+static void put_node_data(struct writer *w, const struct policy_node *node)
+{
+	const union node_data data = node->data;
+
+	switch (node->flavor) {
+	case NODE_HEADER:
+		if (put_presence(w, data.h_data)) {
+			serial_put_varint(&w->out, data.h_data->flavor);
+			put_str(w, data.h_data->module_name);
+		}
+		break;
+	case NODE_AV_RULE:
+	case NODE_XAV_RULE:
+		if (put_presence(w, data.av_data)) {
+			serial_put_varint(&w->out, data.av_data->flavor);
+			put_sl(w, data.av_data->sources);
+			put_sl(w, data.av_data->targets);
+			put_sl(w, data.av_data->object_classes);
+			put_sl(w, data.av_data->perms);
+			if (node->flavor == NODE_XAV_RULE) {
+				put_str(w, data.xav_data->operation);
+			}
+		}
+		break;
+	case NODE_ROLE_ALLOW:
+		if (put_presence(w, data.ra_data)) {
+			put_sl(w, data.ra_data->from);
+			put_sl(w, data.ra_data->to);
+		}
+		break;
+	case NODE_ROLE_TYPES:
+		if (put_presence(w, data.rtyp_data)) {
+			put_str(w, data.rtyp_data->role);
+			put_sl(w, data.rtyp_data->types);
+		}
+		break;
+	case NODE_TT_RULE:
+		if (put_presence(w, data.tt_data)) {
+			put_sl(w, data.tt_data->sources);
+			put_sl(w, data.tt_data->targets);
+			put_sl(w, data.tt_data->object_classes);
+			put_str(w, data.tt_data->default_type);
+			put_str(w, data.tt_data->name);
+			serial_put_varint(&w->out, data.tt_data->flavor);
+		}
+		break;
+	case NODE_RT_RULE:
+		if (put_presence(w, data.rt_data)) {
+			put_sl(w, data.rt_data->sources);
+			put_sl(w, data.rt_data->targets);
+			put_sl(w, data.rt_data->object_classes);
+			put_str(w, data.rt_data->default_role);
+		}
+		break;
+	case NODE_IF_CALL:
+		put_call(w, data.ic_data);
+		if (put_presence(w, data.ic_data)) {
+			put_str(w, data.ic_data->name);
+			put_sl(w, data.ic_data->args);
+		}
+		break;
+	case NODE_DECL:
+		if (put_presence(w, data.d_data)) {
+			serial_put_varint(&w->out, data.d_data->flavor);
+			put_str(w, data.d_data->name);
+			put_sl(w, data.d_data->attrs);
+		}
+		break;
+	case NODE_TYPE_ATTRIBUTE:
+	case NODE_ROLE_ATTRIBUTE:
+		if (put_presence(w, data.at_data)) {
+			put_str(w, data.at_data->type);
+			put_sl(w, data.at_data->attrs);
+			serial_put_varint(&w->out, data.at_data->flavor);
+		}
+		break;
+	case NODE_GEN_REQ:
+		if (put_presence(w, data.gr_data)) {
+			serial_put_varint(&w->out, data.gr_data->unquoted);
+		}
+		break;
+	case NODE_BOOLEAN_POLICY:
+	case NODE_TUNABLE_POLICY:
+		if (put_presence(w, data.cd_data)) {
+			put_sl(w, data.cd_data->identifiers);
+		}
+		break;
+	case NODE_FC_ENTRY:
+		// fc files are not cached
+		w->failed = 1;
+		break;
+	default:
+		put_str(w, data.str);
+		break;
+	}
+}
+
+// A node is written as its flavor, line, exceptions and data, followed by
+// its children.  A zero flavor ends each list of siblings.  The disabled
+// checks are parsed from the exceptions again when loading.
+static void put_nodes(struct writer *w, const struct policy_node *node)
+{
+	for (; node; node = node->next) {
+		serial_put_varint(&w->out, (uint64_t)node->flavor + 1);
+		serial_put_varint(&w->out, node->lineno);
+		put_str(w, node->exceptions);
+		put_node_data(w, node);
+		put_nodes(w, node->first_child);
+	}
+
+	serial_put_varint(&w->out, 0);
+}
+
+static void put_changes(struct writer *w, const struct map_changes *changes)
+{
+	for (const struct map_change *change = first_map_change(changes); change; change = change->next) {
+		serial_put_varint(&w->out, (uint64_t)change->flavor + 1);
+
+		uint64_t index;
+		const char *mod_name;
+		const struct policy_node *node;
+
+		switch (change->flavor) {
+		case CHANGE_DECL:
+		case CHANGE_TEMPLATE_DECL:
+			put_str(w, change->name);
+			put_str(w, change->value);
+			serial_put_varint(&w->out, change->data.decl_flavor);
+			break;
+		case CHANGE_IF:
+			put_str(w, change->name);
+			put_str(w, change->value);
+			break;
+		case CHANGE_IF_FLAG:
+			put_str(w, change->name);
+			serial_put_varint(&w->out, change->data.if_flag);
+			break;
+		case CHANGE_TEMPLATE:
+			put_str(w, change->name);
+			break;
+		case CHANGE_TEMPLATE_CALL:
+			put_str(w, change->name);
+			if (!find_call(w, change->data.call, &index)) {
+				w->failed = 1;
+				return;
+			}
+			serial_put_varint(&w->out, index);
+			break;
+		case CHANGE_DEFERRED:
+			node = get_deferred_expansion(change, &mod_name);
+			if (!node || !find_call(w, node->data.ic_data, &index)) {
+				// Unknown deferred changes cannot be replayed
+				w->failed = 1;
+				return;
+			}
+			serial_put_varint(&w->out, index);
+			put_str(w, mod_name);
+			break;
+		case CHANGE_CLASS_PERM:
+			// Only recorded while loading the access vectors, which are
+			// never cached
+			w->failed = 1;
+			return;
+		}
+	}
+
+	serial_put_varint(&w->out, 0);
+}
+
+static void put_header(struct writer *w, const struct parse_cache_key *key)
+{
+	serial_put_bytes(&w->out, ENTRY_MAGIC, ENTRY_MAGIC_LEN);
+	serial_put_varint(&w->out, PARSE_CACHE_FORMAT);
+	put_str(w, VERSION);
+	serial_put_varint(&w->out, key->flavor);
+	put_str(w, key->mod_name);
+	serial_put_varint(&w->out, key->size);
+	serial_put_varint(&w->out, key->hash[0]);
+	serial_put_varint(&w->out, key->hash[1]);
+}
+
+static void free_writer(struct writer *w)
+{
+	struct written_string *cur_str, *tmp_str;
+	HASH_ITER(hh, w->strings, cur_str, tmp_str) {
+		HASH_DEL(w->strings, cur_str);
+		free(cur_str);
+	}
+
+	struct written_call *cur_call, *tmp_call;
+	HASH_ITER(hh, w->calls, cur_call, tmp_call) {
+		HASH_DEL(w->calls, cur_call);
+		free(cur_call);
+	}
+
+	free_serial_writer(&w->out);
+}
+
+static void write_entry(const struct parse_cache_key *key, const unsigned char *data, size_t len)
+{
+	char *path = entry_path(key);
+
+	if (serial_write_file(path, data, len) == SELINT_SUCCESS) {
+		__atomic_fetch_add(&cache_stores, 1, __ATOMIC_RELAXED);
+	}
+
+	free(path);
+}
+
+void store_cached_parse(const struct parse_cache_key *key,
+                        const struct policy_node *ast,
+                        const struct map_changes *changes)
+{
+	if (!cache_dir || !key->mod_name || !ast) {
+		return;
+	}
+
+	struct writer w;
+	memset(&w, 0, sizeof(struct writer));
+
+	put_header(&w, key);
+	put_nodes(&w, ast);
+	put_changes(&w, changes);
+
+	if (!w.failed) {
+		serial_put_checksum(&w.out);
+		write_entry(key, w.out.buf, w.out.len);
+	}
+
+	free_writer(&w);
+}
+
+/*
+ * Deserializing
+ */
+
+struct reader {
+	struct serial_reader in;
+	const char **strings;   // atoms
+	size_t string_count;
+	size_t string_cap;
+	struct policy_node **calls;
+	size_t call_count;
+	size_t call_cap;
+};
+
+// Return an atom, or NULL for a NULL string or on failure
+static const char *get_str(struct reader *r)
+{
+	const uint64_t ref = serial_get_varint(&r->in);
+
+	if (ref == STR_NULL || r->in.failed) {
+		return NULL;
+	}
+
+	if (ref >= STR_FIRST_REF) {
+		if (ref - STR_FIRST_REF >= r->string_count) {
+			r->in.failed = 1;
+			return NULL;
+		}
+		return r->strings[ref - STR_FIRST_REF];
+	}
+
+	uint64_t len;
+	const unsigned char *data = serial_get_data(&r->in, &len);
+	if (r->in.failed) {
+		return NULL;
+	}
+
+	const char *atom = intern_n(data ? (const char *)data : "", (size_t)len);
+
+	if (r->string_count == r->string_cap) {
+		r->string_cap = r->string_cap ? r->string_cap * 2 : 256;
+		r->strings = xrealloc(r->strings, r->string_cap * sizeof(const char *));
+	}
+	r->strings[r->string_count++] = atom;
+
+	return atom;
+}
+
+// Return a copy of a string, to be owned by the node it is stored in
+static char *get_node_str(struct reader *r)
+{
+	const char *atom = get_str(r);
+
+	return atom ? node_xstrdup(atom) : NULL;
+}
+
+static struct string_list *get_sl(struct reader *r)
+{
+	struct string_list *head = NULL;
+	struct string_list *tail = NULL;
+
+	// Every cell takes at least two bytes
+	const uint64_t count = serial_get_bounded(&r->in, (uint64_t)(r->in.end - r->in.pos) / 2);
+
+	for (uint64_t i = 0; i < count && !r->in.failed; i++) {
+		const char *atom = get_str(r);
+		const uint64_t flags = serial_get_bounded(&r->in, 3);
+		if (!atom) {
+			r->in.failed = 1;
+			break;
+		}
+
+		struct string_list *cell = sl_from_str(atom);
+		cell->has_incorrect_space = flags & 1;
+		cell->arg_start = (flags >> 1) & 1;
+
+		if (tail) {
+			tail->next = cell;
+		} else {
+			head = cell;
+		}
+		tail = cell;
+	}
+
+	return head;
+}
+
+static int get_presence(struct reader *r)
+{
+	return serial_get_bounded(&r->in, 1) == 1;
+}
+
+static void add_call(struct reader *r, struct policy_node *node)
+{
+	if (r->call_count == r->call_cap) {
+		r->call_cap = r->call_cap ? r->call_cap * 2 : 64;
+		r->calls = xrealloc(r->calls, r->call_cap * sizeof(struct policy_node *));
+	}
+	r->calls[r->call_count++] = node;
+}
+
+static struct policy_node *get_call(struct reader *r)
+{
+	const uint64_t index = serial_get_varint(&r->in);
+
+	if (r->in.failed || index >= r->call_count || !r->calls[index]->data.ic_data) {
+		r->in.failed = 1;
+		return NULL;
+	}
+
+	return r->calls[index];
+}
+
+// The data is attached to the node before it is filled, so a partially
+// read node can be freed with free_policy_node()
+static void get_node_data(struct reader *r, struct policy_node *node)
+{
+	switch (node->flavor) {
+	case NODE_HEADER:
+		if (get_presence(r)) {
+			struct header_data *data = node_xcalloc(1, sizeof(struct header_data));
+			node->data.h_data = data;
+			data->flavor = (enum header_flavor)serial_get_bounded(&r->in, HEADER_MACRO);
+			data->module_name = get_node_str(r);
+		}
+		break;
+	case NODE_AV_RULE:
+	case NODE_XAV_RULE:
+		if (get_presence(r)) {
+			struct av_rule_data *data;
+			if (node->flavor == NODE_XAV_RULE) {
+				node->data.xav_data = node_xcalloc(1, sizeof(struct xav_rule_data));
+				data = (struct av_rule_data *)node->data.xav_data;
+			} else {
+				data = node->data.av_data = node_xcalloc(1, sizeof(struct av_rule_data));
+			}
+			data->flavor = (enum av_rule_flavor)serial_get_bounded(&r->in, AV_RULE_NEVERALLOW);
+			data->sources = get_sl(r);
+			data->targets = get_sl(r);
+			data->object_classes = get_sl(r);
+			data->perms = get_sl(r);
+			if (node->flavor == NODE_XAV_RULE) {
+				node->data.xav_data->operation = get_node_str(r);
+			}
+		}
+		break;
+	case NODE_ROLE_ALLOW:
+		if (get_presence(r)) {
+			struct role_allow_data *data = node_xcalloc(1, sizeof(struct role_allow_data));
+			node->data.ra_data = data;
+			data->from = get_sl(r);
+			data->to = get_sl(r);
+		}
+		break;
+	case NODE_ROLE_TYPES:
+		if (get_presence(r)) {
+			struct role_types_data *data = node_xcalloc(1, sizeof(struct role_types_data));
+			node->data.rtyp_data = data;
+			data->role = get_node_str(r);
+			data->types = get_sl(r);
+		}
+		break;
+	case NODE_TT_RULE:
+		if (get_presence(r)) {
+			struct type_transition_data *data = node_xcalloc(1, sizeof(struct type_transition_data));
+			node->data.tt_data = data;
+			data->sources = get_sl(r);
+			data->targets = get_sl(r);
+			data->object_classes = get_sl(r);
+			data->default_type = get_node_str(r);
+			data->name = get_node_str(r);
+			data->flavor = (enum tt_flavor)serial_get_bounded(&r->in, TT_RT);
+		}
+		break;
+	case NODE_RT_RULE:
+		if (get_presence(r)) {
+			struct role_transition_data *data = node_xcalloc(1, sizeof(struct role_transition_data));
+			node->data.rt_data = data;
+			data->sources = get_sl(r);
+			data->targets = get_sl(r);
+			data->object_classes = get_sl(r);
+			data->default_role = get_node_str(r);
+		}
+		break;
+	case NODE_IF_CALL:
+		add_call(r, node);
+		if (get_presence(r)) {
+			struct if_call_data *data = node_xcalloc(1, sizeof(struct if_call_data));
+			node->data.ic_data = data;
+			data->name = get_node_str(r);
+			data->args = get_sl(r);
+		}
+		break;
+	case NODE_DECL:
+		if (get_presence(r)) {
+			struct declaration_data *data = node_xcalloc(1, sizeof(struct declaration_data));
+			node->data.d_data = data;
+			data->flavor = (enum decl_flavor)serial_get_bounded(&r->in, DECL_BOOL);
+			data->name = get_node_str(r);
+			data->attrs = get_sl(r);
+		}
+		break;
+	case NODE_TYPE_ATTRIBUTE:
+	case NODE_ROLE_ATTRIBUTE:
+		if (get_presence(r)) {
+			struct attribute_data *data = node_xcalloc(1, sizeof(struct attribute_data));
+			node->data.at_data = data;
+			data->type = get_node_str(r);
+			data->attrs = get_sl(r);
+			data->flavor = (enum attr_flavor)serial_get_bounded(&r->in, ATTR_ROLE);
+		}
+		break;
+	case NODE_GEN_REQ:
+		if (get_presence(r)) {
+			struct gen_require_data *data = node_xcalloc(1, sizeof(struct gen_require_data));
+			node->data.gr_data = data;
+			data->unquoted = (unsigned char)serial_get_bounded(&r->in, UCHAR_MAX);
+		}
+		break;
+	case NODE_BOOLEAN_POLICY:
+	case NODE_TUNABLE_POLICY:
+		if (get_presence(r)) {
+			struct cond_declaration_data *data = node_xcalloc(1, sizeof(struct cond_declaration_data));
+			node->data.cd_data = data;
+			data->identifiers = get_sl(r);
+		}
+		break;
+	case NODE_FC_ENTRY:
+		r->in.failed = 1;
+		break;
+	default:
+		node->data.str = get_node_str(r);
+		break;
+	}
+}
+
+// Read a list of siblings and their children, linking every node into
+// the tree as soon as it is allocated
+static struct policy_node *get_nodes(struct reader *r, struct policy_node *parent,
+                                     unsigned int depth)
+{
+	struct policy_node *first = NULL;
+	struct policy_node *prev = NULL;
+
+	if (depth > MAX_NODE_DEPTH) {
+		r->in.failed = 1;
+		return NULL;
+	}
+
+	while (!r->in.failed) {
+		const uint64_t tag = serial_get_bounded(&r->in, (uint64_t)NODE_ERROR + 1);
+		if (tag == 0) {
+			break;
+		}
+
+		struct policy_node *node = alloc_policy_node();
+		node->flavor = (enum node_flavor)(tag - 1);
+		node->parent = parent;
+		node->prev = prev;
+		if (prev) {
+			prev->next = node;
+		} else {
+			first = node;
+			if (parent) {
+				parent->first_child = node;
+			}
+		}
+		prev = node;
+
+		node->lineno = (unsigned int)serial_get_bounded(&r->in, UINT_MAX);
+		node->exceptions = get_node_str(r);
+		node->disabled_checks = parse_disabled_checks(node->exceptions);
+		get_node_data(r, node);
+		get_nodes(r, node, depth + 1);
+	}
+
+	return first;
+}
+
+// Replay the changes by calling the map functions while recording
+static void get_changes(struct reader *r)
+{
+	while (!r->in.failed) {
+		const uint64_t tag = serial_get_bounded(&r->in, (uint64_t)CHANGE_DEFERRED + 1);
+		if (tag == 0) {
+			break;
+		}
+
+		const char *name;
+		const char *value;
+		enum decl_flavor decl_flavor;
+		uint8_t if_flag;
+		struct policy_node *node;
+
+		switch ((enum map_change_flavor)(tag - 1)) {
+		case CHANGE_DECL:
+		case CHANGE_TEMPLATE_DECL:
+			name = get_str(r);
+			value = get_str(r);
+			decl_flavor = (enum decl_flavor)serial_get_bounded(&r->in, DECL_BOOL);
+			if (!name || !value) {
+				r->in.failed = 1;
+			} else if (tag - 1 == CHANGE_DECL) {
+				insert_into_decl_map(name, value, decl_flavor);
+			} else {
+				insert_decl_into_template_map(name, decl_flavor, value);
+			}
+			break;
+		case CHANGE_IF:
+			name = get_str(r);
+			value = get_str(r);
+			if (!name || !value) {
+				r->in.failed = 1;
+			} else {
+				insert_into_ifs_map(name, value);
+			}
+			break;
+		case CHANGE_IF_FLAG:
+			name = get_str(r);
+			if_flag = (uint8_t)serial_get_bounded(&r->in, UINT8_MAX);
+			if (!name) {
+				r->in.failed = 1;
+			} else if (if_flag == TRANSFORM_IF) {
+				mark_transform_if(name);
+			} else if (if_flag == FILETRANS_IF) {
+				mark_filetrans_if(name);
+			} else if (if_flag == ROLE_IF) {
+				mark_role_if(name);
+			} else if (if_flag == USED_IF) {
+				mark_used_if(name);
+			} else {
+				r->in.failed = 1;
+			}
+			break;
+		case CHANGE_TEMPLATE:
+			name = get_str(r);
+			if (!name) {
+				r->in.failed = 1;
+			} else {
+				insert_template_into_template_map(name);
+			}
+			break;
+		case CHANGE_TEMPLATE_CALL:
+			name = get_str(r);
+			node = get_call(r);
+			if (!name || !node) {
+				r->in.failed = 1;
+			} else {
+				insert_call_into_template_map(name, node->data.ic_data);
+			}
+			break;
+		case CHANGE_DEFERRED:
+			node = get_call(r);
+			value = get_str(r);
+			if (!node || !value) {
+				r->in.failed = 1;
+			} else {
+				defer_template_expansion(node, value);
+			}
+			break;
+		case CHANGE_CLASS_PERM:
+			r->in.failed = 1;
+			break;
+		}
+	}
+}
+
+static int check_header(struct reader *r, const struct parse_cache_key *key)
+{
+	if (!serial_check_frame(&r->in, ENTRY_MAGIC, ENTRY_MAGIC_LEN, NULL)) {
+		return 0;
+	}
+
+	if (serial_get_varint(&r->in) != PARSE_CACHE_FORMAT) {
+		return 0;
+	}
+	const char *version = get_str(r);
+	if (!version || 0 != strcmp(version, VERSION)) {
+		return 0;
+	}
+	if (serial_get_varint(&r->in) != (uint64_t)key->flavor) {
+		return 0;
+	}
+	const char *mod_name = get_str(r);
+	if (!mod_name || 0 != strcmp(mod_name, key->mod_name)) {
+		return 0;
+	}
+
+	return serial_get_varint(&r->in) == key->size &&
+	       serial_get_varint(&r->in) == key->hash[0] &&
+	       serial_get_varint(&r->in) == key->hash[1] &&
+	       !r->in.failed;
+}
+
+static unsigned char *read_entry(const struct parse_cache_key *key, size_t *len)
+{
+	char *path = entry_path(key);
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	free(path);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return NULL;
+	}
+
+	unsigned char *buf = xmalloc((size_t)st.st_size);
+	size_t done = 0;
+	while (done < (size_t)st.st_size) {
+		const ssize_t got = read(fd, buf + done, (size_t)st.st_size - done);
+		if (got < 0 && errno == EINTR) {
+			continue;
+		}
+		if (got <= 0) {
+			free(buf);
+			close(fd);
+			return NULL;
+		}
+		done += (size_t)got;
+	}
+
+	// Mark the entry as recently used for prune_parse_cache().  This fails
+	// harmlessly on entries of other users in shared caches.
+	futimens(fd, NULL);
+
+	close(fd);
+	*len = done;
+
+	return buf;
+}
+
+struct policy_node *load_cached_parse(const char *filename, enum node_flavor flavor,
+                                      struct parse_cache_key *key,
+                                      struct map_changes *changes)
+{
+	memset(key, 0, sizeof(struct parse_cache_key));
+
+	if (!cache_dir || !compute_key(filename, flavor, key)) {
+		return NULL;
+	}
+
+	size_t len;
+	unsigned char *buf = read_entry(key, &len);
+	if (!buf) {
+		__atomic_fetch_add(&cache_misses, 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+
+	struct reader r;
+	memset(&r, 0, sizeof(struct reader));
+	r.in.pos = buf;
+	r.in.end = buf + len;
+
+	struct policy_node *ast = NULL;
+	struct map_changes *replayed = NULL;
+
+	if (check_header(&r, key)) {
+		ast = get_nodes(&r, NULL, 0);
+
+		// Record the replayed changes separately, to drop them if the
+		// entry turns out to be corrupt
+		struct map_changes *outer = get_staged_map_changes();
+		replayed = alloc_map_changes();
+		stage_map_changes(replayed);
+		get_changes(&r);
+		stage_map_changes(outer);
+
+		if (r.in.pos != r.in.end) {
+			r.in.failed = 1;
+		}
+	} else {
+		r.in.failed = 1;
+	}
+
+	if (r.in.failed || !ast) {
+		free_map_changes(replayed);
+		if (ast) {
+			free_policy_node(ast);
+			ast = NULL;
+		}
+		__atomic_fetch_add(&cache_misses, 1, __ATOMIC_RELAXED);
+	} else {
+		inherit_disabled_checks(ast);
+		update_names_in_tree(ast);
+		move_map_changes(changes, replayed);
+		__atomic_fetch_add(&cache_hits, 1, __ATOMIC_RELAXED);
+	}
+
+	free(r.strings);
+	free(r.calls);
+	free(buf);
+
+	return ast;
+}
@@ -0,0 +1,104 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#ifndef PARSE_CACHE_H
+#define PARSE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "maps.h"
+#include "selint_error.h"
+#include "tree.h"
+
+/**********************************
+* A persistent cache of parsed te and if files.  Each entry holds the AST
+* of a file together with the map changes parsing it recorded (see
+* stage_map_changes()), so a hit replays exactly what parsing would have
+* done.  Entries are keyed by a hash of the file content, the module name,
+* the file flavor and the SELint version, and stale entries are never read
+* again.  Only successful parses are stored, which never print anything.
+* Hits refresh the modification time of their entry, so the least recently
+* used entries can be pruned (see prune_parse_cache()).
+**********************************/
+
+// Bump when the serialized format changes
+#define PARSE_CACHE_FORMAT 1
+
+// Entries kept by default, several times the files of a full refpolicy
+#define PARSE_CACHE_MAX_ENTRIES 10000
+
+struct parse_cache_key {
+	uint64_t hash[2];
+	uint64_t size;
+	enum node_flavor flavor;
+	char *mod_name;
+};
+
+/**********************************
+* Store cache entries in dir, which is created if it does not exist yet
+* Returns SELINT_SUCCESS or SELINT_IO_ERROR
+**********************************/
+enum selint_error enable_parse_cache(const char *dir);
+
+// Return 1 if a cache directory was set, and 0 otherwise
+int is_parse_cache_enabled(void);
+
+/**********************************
+* Remove the least recently used entries of the cache directory until at
+* most max_entries are left, along with temporary files abandoned by
+* interrupted runs
+* Returns SELINT_SUCCESS or SELINT_IO_ERROR if the directory cannot be read
+**********************************/
+enum selint_error prune_parse_cache(size_t max_entries);
+
+/**********************************
+* Look up the parse of a file in the cache
+* filename (in) - The file to look up
+* flavor (in) - The node type corresponding to the type of file (TE or IF)
+* key (out) - The key of the file, to store it after a miss.  Free it with
+*	free_parse_cache_key().  It is left empty if the file cannot be read.
+* changes (in, out) - The map changes the file recorded are appended
+* Returns the AST on a hit, allocated like node_xmalloc(),
+* and NULL on a miss
+**********************************/
+struct policy_node *load_cached_parse(const char *filename, enum node_flavor flavor,
+                                      struct parse_cache_key *key,
+                                      struct map_changes *changes);
+
+/**********************************
+* Store the result of parsing a file after a miss.  Files whose map changes
+* cannot be serialized are silently skipped.
+* key (in) - The key load_cached_parse() returned for the file
+* ast (in) - The AST of the file
+* changes (in) - The map changes recorded while parsing the file
+**********************************/
+void store_cached_parse(const struct parse_cache_key *key,
+                        const struct policy_node *ast,
+                        const struct map_changes *changes);
+
+void free_parse_cache_key(struct parse_cache_key *key);
+
+struct parse_cache_stats {
+	size_t hits;
+	size_t misses;
+	size_t stores;
+};
+
+void get_parse_cache_stats(struct parse_cache_stats *stats);
+
+#endif
@@ -21,7 +21,6 @@
 
 #include "parse_fc.h"
 #include "tree.h"
-#include "xalloc.h"
 
 // "gen_context("
 #define GEN_CONTEXT_LEN 12
@@ -30,53 +29,53 @@ struct fc_entry *parse_fc_line(char *line)
 {
 	const char *whitespace = " \t";
 
-	struct fc_entry *out = xmalloc(sizeof(struct fc_entry));
+	struct fc_entry *out = node_xcalloc(1, sizeof(struct fc_entry));
 
-	memset(out, 0, sizeof(struct fc_entry));
+	// Fields are sliced out without writing to the line, since the context
+	// may contain whitespace
+	char *pos = line + strspn(line, whitespace);
+	size_t len = strcspn(pos, whitespace);
 
-	char *orig_line = xstrdup(line); // If the object class is omitted, we need to revert
-
-	char *pos = strtok(line, whitespace);
-
-	if (pos == NULL) {
+	if (len == 0) {
 		goto cleanup;
 	}
 
-	out->path = xstrdup(pos);
+	out->path = node_xstrndup(pos, len);
 
-	pos = strtok(NULL, whitespace);
+	pos += len;
+	pos += strspn(pos, whitespace);
+	len = strcspn(pos, whitespace);
 
-	if (pos == NULL) {
+	if (len == 0) {
 		goto cleanup;
 	}
 
 	if (pos[0] == '-') {
-		if (pos[2] != '\0') {
+		if (len != 2) {
 			goto cleanup;
 		}
 		out->obj = pos[1];
-		pos = strtok(NULL, whitespace);
-		if (pos == NULL) {
+		pos += len;
+		pos += strspn(pos, whitespace);
+		if (pos[0] == '\0') {
 			goto cleanup;
 		}
 	}
-	// pos points to the start of the context, but spaces in the context may have been
-	// overwritten by strtok
-	strcpy(line, orig_line);
 
 	if (strncmp("gen_context(", pos, GEN_CONTEXT_LEN) == 0) {
 		pos += GEN_CONTEXT_LEN; // Next character
-		char *context_part = strtok(pos, ",");
+		char *context_save = NULL;
+		char *context_part = strtok_r(pos, ",", &context_save);
 		if (context_part == NULL) {
 			goto cleanup;
 		}
 
-		char *maybe_s = strtok(NULL, ",");
+		char *maybe_s = strtok_r(NULL, ",", &context_save);
 		char *maybe_c = NULL;
 		int i = 0;
 
 		if (maybe_s) {
-			maybe_c = strtok(NULL, ",");
+			maybe_c = strtok_r(NULL, ",", &context_save);
 			while (maybe_s[i] != '\0' && maybe_s[i] != ')') {
 				i++;
 			}
@@ -127,12 +126,12 @@ struct fc_entry *parse_fc_line(char *line)
 		out->context->has_gen_context = 1;
 		if (maybe_c) {
 			out->context->range =
-				xmalloc(strlen(maybe_s) + 1 + strlen(maybe_c) + 1);
+				node_xmalloc(strlen(maybe_s) + 1 + strlen(maybe_c) + 1);
 			strcpy(out->context->range, maybe_s);
 			strcat(out->context->range, ":");
 			strcat(out->context->range, maybe_c);
 		} else if (maybe_s) {
-			out->context->range = xstrdup(maybe_s);
+			out->context->range = node_xstrdup(maybe_s);
 		} else {
 			out->context->range = NULL;
 		}
@@ -147,11 +146,9 @@ struct fc_entry *parse_fc_line(char *line)
 
 	}
 
-	free(orig_line);
 	return out;
 
 cleanup:
-	free(orig_line);
 	free_fc_entry(out);
 	return NULL;
 }
@@ -163,40 +160,40 @@ struct sel_context *parse_context(char *context_str)
 		return NULL;
 	}
 
-	struct sel_context *context = xmalloc(sizeof(struct sel_context));
-	memset(context, 0, sizeof(struct sel_context));
+	struct sel_context *context = node_xcalloc(1, sizeof(struct sel_context));
 	// User
-	const char *pos = strtok(context_str, ":");
+	char *save = NULL;
+	const char *pos = strtok_r(context_str, ":", &save);
 
 	if (pos == NULL) {
 		goto cleanup;
 	}
 
-	context->user = xstrdup(pos);
+	context->user = node_xstrdup(pos);
 
 	// Role
-	pos = strtok(NULL, ":");
+	pos = strtok_r(NULL, ":", &save);
 
 	if (pos == NULL) {
 		goto cleanup;
 	}
 
-	context->role = xstrdup(pos);
+	context->role = node_xstrdup(pos);
 
 	// Type
-	pos = strtok(NULL, ":");
+	pos = strtok_r(NULL, ":", &save);
 
 	if (pos == NULL) {
 		goto cleanup;
 	}
 
-	context->type = xstrdup(pos);
+	context->type = node_xstrdup(pos);
 
-	pos = strtok(NULL, ":");
+	pos = strtok_r(NULL, ":", &save);
 
 	if (pos) {
-		context->range = xstrdup(pos);
-		if (strtok(NULL, ":")) {
+		context->range = node_xstrdup(pos);
+		if (strtok_r(NULL, ":", &save)) {
 			goto cleanup;
 		}
 	}
@@ -243,12 +240,12 @@ struct policy_node *parse_fc_file(const char *filename, const struct string_list
 		return NULL;
 	}
 
-	struct policy_node *head = xmalloc(sizeof(struct policy_node));
-	memset(head, 0, sizeof(struct policy_node));
+	struct policy_node *head = alloc_policy_node();
 	head->flavor = NODE_FC_FILE;
 
 	struct policy_node *cur = head;
 
+	// One line buffer, grown by getline() as needed, serves the whole file
 	char *line = NULL;
 
 	ssize_t len_read = 0;
@@ -298,9 +295,6 @@ struct policy_node *parse_fc_file(const char *filename, const struct string_list
 			return NULL;
 		}
 		cur = cur->next;
-		free(line);
-		line = NULL;
-		buf_len = 0;
 	}
 	free(line);             // getline alloc must be freed even if getline failed
 	fclose(fd);
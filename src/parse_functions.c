@@ -17,20 +17,24 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
+#include "check_hooks.h"
 #include "parse_functions.h"
 #include "selint_error.h"
 #include "tree.h"
 #include "template.h"
 #include "util.h"
 #include "perm_macro.h"
+#include "selint_context.h"
 #include "xalloc.h"
 
-static char *module_name = NULL;
+static _Thread_local char *module_name = NULL;
+
 
 enum selint_error insert_header(struct policy_node **cur, const char *mn,
                                 enum header_flavor flavor, unsigned int lineno)
 {
-	struct header_data *data = (struct header_data *)xmalloc(sizeof(struct header_data));
+	struct header_data *data = (struct header_data *)node_xmalloc(sizeof(struct header_data));
 	if (!data) {
 		return SELINT_OUT_OF_MEM;
 	}
@@ -38,9 +42,9 @@ enum selint_error insert_header(struct policy_node **cur, const char *mn,
 	memset(data, 0, sizeof(struct header_data));
 
 	data->flavor = flavor;
-	data->module_name = xstrdup(mn);
+	data->module_name = node_xstrdup(mn);
 	if (!data->module_name) {
-		free(data);
+		node_free(data);
 		return SELINT_OUT_OF_MEM;
 	}
 
@@ -69,6 +73,39 @@ char *get_current_module_name(void)
 	return module_name;
 }
 
+void reset_current_module_name(void)
+{
+	free(module_name);
+	module_name = NULL;
+}
+
+void set_symbols_only(int enable)
+{
+	selint_context_current()->symbols_only = enable;
+}
+
+int is_symbols_only(void)
+{
+	return selint_context_current()->symbols_only;
+}
+
+// Insert a rule without data, for files parsed for their symbols only
+static enum selint_error insert_bare_rule(struct policy_node **cur,
+                                          enum node_flavor flavor,
+                                          unsigned int lineno)
+{
+	union node_data nd;
+
+	nd.str = NULL;
+	enum selint_error ret = insert_policy_node_next(*cur, flavor, nd, lineno);
+	if (ret != SELINT_SUCCESS) {
+		return ret;
+	}
+
+	*cur = (*cur)->next;
+	return SELINT_SUCCESS;
+}
+
 enum selint_error insert_comment(struct policy_node **cur, unsigned int lineno)
 {
 	union node_data data;
@@ -115,7 +152,7 @@ enum selint_error insert_declaration(struct policy_node **cur,
 		}
 	}
 
-	struct declaration_data *data = (struct declaration_data *)xmalloc(sizeof(struct declaration_data));
+	struct declaration_data *data = (struct declaration_data *)node_xmalloc(sizeof(struct declaration_data));
 	if (!data) {
 		return SELINT_OUT_OF_MEM;
 	}
@@ -123,7 +160,7 @@ enum selint_error insert_declaration(struct policy_node **cur,
 	memset(data, 0, sizeof(struct declaration_data));
 
 	data->flavor = flavor;
-	data->name = xstrdup(name);
+	data->name = node_xstrdup(name);
 	data->attrs = attrs;
 
 	union node_data nd;
@@ -133,7 +170,7 @@ enum selint_error insert_declaration(struct policy_node **cur,
 		insert_policy_node_next(*cur, NODE_DECL, nd, lineno);
 
 	if (ret != SELINT_SUCCESS) {
-		free(data);
+		node_free(data);
 		return ret;
 	}
 
@@ -164,7 +201,7 @@ enum selint_error insert_aliases(struct policy_node **cur,
 			insert_into_decl_map(alias->string, mn, flavor);
 		}
 		union node_data nd;
-		nd.str = xstrdup(alias->string);
+		nd.str = node_xstrdup(alias->string);
 		enum selint_error ret = insert_policy_node_child(*cur,
 		                                                 NODE_ALIAS,
 		                                                 nd,
@@ -186,7 +223,7 @@ enum selint_error insert_type_alias(struct policy_node **cur, const char *type,
 
 	union node_data nd;
 
-	nd.str = xstrdup(type);
+	nd.str = node_xstrdup(type);
 	enum selint_error ret = insert_policy_node_next(*cur,
 	                                                NODE_TYPE_ALIAS,
 	                                                nd,
@@ -206,8 +243,20 @@ enum selint_error insert_av_rule(struct policy_node **cur,
                                  struct string_list *object_classes,
                                  struct string_list *perms, unsigned int lineno)
 {
+	if ((*cur)->parent && (*cur)->parent->flavor == NODE_INTERFACE_DEF &&
+	    str_in_sl("associate", perms)) {
+		mark_transform_if((*cur)->parent->data.str);
+	}
+
+	if (is_symbols_only()) {
+		free_string_list(sources);
+		free_string_list(targets);
+		free_string_list(object_classes);
+		free_string_list(perms);
+		return insert_bare_rule(cur, NODE_AV_RULE, lineno);
+	}
 
-	struct av_rule_data *av_data = xmalloc(sizeof(struct av_rule_data));
+	struct av_rule_data *av_data = node_xmalloc(sizeof(struct av_rule_data));
 
 	av_data->flavor = flavor;
 	av_data->sources = sources;
@@ -218,11 +267,6 @@ enum selint_error insert_av_rule(struct policy_node **cur,
 	union node_data nd;
 	nd.av_data = av_data;
 
-	if ((*cur)->parent && (*cur)->parent->flavor == NODE_INTERFACE_DEF &&
-	    str_in_sl("associate", perms)) {
-		mark_transform_if((*cur)->parent->data.str);
-	}
-
 	enum selint_error ret = insert_policy_node_next(*cur,
 	                                                NODE_AV_RULE,
 	                                                nd,
@@ -246,14 +290,21 @@ enum selint_error insert_xperm_av_rule(struct policy_node **cur,
                                        struct string_list *perms,
                                        unsigned int lineno)
 {
+	if (is_symbols_only()) {
+		free_string_list(sources);
+		free_string_list(targets);
+		free_string_list(object_classes);
+		free_string_list(perms);
+		return insert_bare_rule(cur, NODE_XAV_RULE, lineno);
+	}
 
-	struct xav_rule_data *xav_data = xmalloc(sizeof(struct xav_rule_data));
+	struct xav_rule_data *xav_data = node_xmalloc(sizeof(struct xav_rule_data));
 
 	xav_data->flavor = flavor;
 	xav_data->sources = sources;
 	xav_data->targets = targets;
 	xav_data->object_classes = object_classes;
-	xav_data->operation = xstrdup(operation);
+	xav_data->operation = node_xstrdup(operation);
 	xav_data->perms = perms;
 
 	union node_data nd;
@@ -278,7 +329,13 @@ enum selint_error insert_role_allow(struct policy_node **cur,
                                     struct string_list *from_roles,
                                     struct string_list *to_roles, unsigned int lineno)
 {
-	struct role_allow_data *ra_data = xmalloc(sizeof(struct role_allow_data));
+	if (is_symbols_only()) {
+		free_string_list(from_roles);
+		free_string_list(to_roles);
+		return insert_bare_rule(cur, NODE_ROLE_ALLOW, lineno);
+	}
+
+	struct role_allow_data *ra_data = node_xmalloc(sizeof(struct role_allow_data));
 
 	ra_data->from = from_roles;
 	ra_data->to = to_roles;
@@ -313,9 +370,14 @@ enum selint_error insert_role_types(struct policy_node **cur, const char *role,
 		}
 	}
 
-	struct role_types_data *rtyp_data = (struct role_types_data *)xmalloc(sizeof(struct role_types_data));
+	if (is_symbols_only()) {
+		free_string_list(types);
+		return insert_bare_rule(cur, NODE_ROLE_TYPES, lineno);
+	}
+
+	struct role_types_data *rtyp_data = (struct role_types_data *)node_xmalloc(sizeof(struct role_types_data));
 
-	rtyp_data->role = xstrdup(role);
+	rtyp_data->role = node_xstrdup(role);
 	rtyp_data->types = types;
 
 	union node_data nd;
@@ -340,27 +402,33 @@ enum selint_error insert_type_transition(struct policy_node **cur,
                                          const char *default_type, const char *name,
                                          unsigned int lineno)
 {
+	if (!str_in_sl("process", object_classes) &&
+	    (*cur)->parent &&
+	    (*cur)->parent->flavor == NODE_INTERFACE_DEF) {
+		mark_filetrans_if((*cur)->parent->data.str);
+	}
+
+	if (is_symbols_only()) {
+		free_string_list(sources);
+		free_string_list(targets);
+		free_string_list(object_classes);
+		return insert_bare_rule(cur, NODE_TT_RULE, lineno);
+	}
 
 	struct type_transition_data *tt_data =
-		xmalloc(sizeof(struct type_transition_data));
+		node_xmalloc(sizeof(struct type_transition_data));
 
 	tt_data->sources = sources;
 	tt_data->targets = targets;
 	tt_data->object_classes = object_classes;
-	tt_data->default_type = xstrdup(default_type);
+	tt_data->default_type = node_xstrdup(default_type);
 	if (name) {
-		tt_data->name = xstrdup(name);
+		tt_data->name = node_xstrdup(name);
 	} else {
 		tt_data->name = NULL;
 	}
 	tt_data->flavor = flavor;
 
-	if (!str_in_sl("process", object_classes) &&
-	    (*cur)->parent &&
-	    (*cur)->parent->flavor == NODE_INTERFACE_DEF) {
-		mark_filetrans_if((*cur)->parent->data.str);
-	}
-
 	union node_data nd;
 	nd.tt_data = tt_data;
 
@@ -385,13 +453,20 @@ enum selint_error insert_role_transition(struct policy_node **cur,
                                          const char *default_role,
                                          unsigned int lineno)
 {
+	if (is_symbols_only()) {
+		free_string_list(sources);
+		free_string_list(targets);
+		free_string_list(object_classes);
+		return insert_bare_rule(cur, NODE_RT_RULE, lineno);
+	}
+
 	struct role_transition_data *rt_data =
-	        xmalloc(sizeof(struct role_transition_data));
+	        node_xmalloc(sizeof(struct role_transition_data));
 
 	rt_data->sources = sources;
 	rt_data->targets = targets;
 	rt_data->object_classes = object_classes;
-	rt_data->default_role = xstrdup(default_role);
+	rt_data->default_role = node_xstrdup(default_role);
 
 	union node_data nd;
 	nd.rt_data = rt_data;
@@ -430,21 +505,151 @@ static int is_filetrans_if_name(const char *if_name)
 	return 0;
 }
 
+// Interface call outside of an interface definition, whose template
+// declarations are added once the maps contain all previously parsed
+// templates.  See insert_interface_call().  A call failing to expand is
+// unlinked from the tree, like an immediate expansion failure would have
+// dropped it, and linked again if expanding it succeeds once the changes
+// are applied again, e.g. after the templates changed in watch mode.
+struct deferred_if_call {
+	struct policy_node *node;
+	struct policy_node *anchor;     // the node preceding the call when parsed
+	char *mod_name;
+	struct template_expansion added;
+	int expanded;
+	int detached;
+};
+
+// A detached call keeps the anchor as previous node
+static int is_detached(const struct policy_node *node)
+{
+	return node->prev && node->prev->next != node;
+}
+
+static void detach_deferred_call(struct deferred_if_call *deferred)
+{
+	struct policy_node *node = deferred->node;
+
+	node->prev->next = node->next;
+	if (node->next) {
+		node->next->prev = node->prev;
+	}
+	node->prev = deferred->anchor;
+	node->next = NULL;
+	deferred->detached = 1;
+}
+
+// Link the call again after the nearest node preceding it in the tree,
+// skipping detached calls in between
+static void attach_deferred_call(struct deferred_if_call *deferred)
+{
+	struct policy_node *node = deferred->node;
+	struct policy_node *prev = deferred->anchor;
+
+	while (is_detached(prev)) {
+		prev = prev->prev;
+	}
+
+	node->prev = prev;
+	node->next = prev->next;
+	if (prev->next) {
+		prev->next->prev = node;
+	}
+	prev->next = node;
+	deferred->detached = 0;
+}
+
+static void add_deferred_template_declarations(void *ctx)
+{
+	struct deferred_if_call *deferred = ctx;
+	const struct if_call_data *if_data = deferred->node->data.ic_data;
+
+	enum selint_error r = add_template_declarations(if_data->name, if_data->args,
+	                                                deferred->mod_name, &deferred->added);
+	if (r != SELINT_SUCCESS) {
+		if (!deferred->detached) {
+			detach_deferred_call(deferred);
+		}
+		return;
+	}
+
+	if (deferred->detached) {
+		attach_deferred_call(deferred);
+	}
+	deferred->expanded = 1;
+
+	mark_used_if(if_data->name);
+}
+
+static void remove_deferred_template_declarations(void *ctx)
+{
+	struct deferred_if_call *deferred = ctx;
+
+	if (!deferred->expanded) {
+		return;
+	}
+
+	remove_template_declarations(&deferred->added);
+	unmark_used_if(deferred->node->data.ic_data->name);
+	deferred->expanded = 0;
+}
+
+static void free_deferred_if_call(void *ctx)
+{
+	struct deferred_if_call *deferred = ctx;
+
+	if (deferred->detached) {
+		free_policy_node(deferred->node);
+	}
+	free(deferred->added.names);
+	free(deferred->added.flavors);
+	free(deferred->mod_name);
+	free(deferred);
+}
+
+void defer_template_expansion(struct policy_node *node, const char *mod_name)
+{
+	struct deferred_if_call *deferred = xcalloc(1, sizeof(struct deferred_if_call));
+
+	deferred->node = node;
+	deferred->anchor = node->prev;
+	deferred->mod_name = xstrdup(mod_name);
+	defer_map_change(add_deferred_template_declarations, remove_deferred_template_declarations,
+	                 deferred, free_deferred_if_call);
+}
+
+const struct policy_node *get_deferred_expansion(const struct map_change *change,
+                                                 const char **mod_name)
+{
+	if (change->flavor != CHANGE_DEFERRED ||
+	    change->data.deferred.apply != add_deferred_template_declarations) {
+		return NULL;
+	}
+
+	const struct deferred_if_call *deferred = change->data.deferred.ctx;
+	*mod_name = deferred->mod_name;
+
+	return deferred->node;
+}
+
 enum selint_error insert_interface_call(struct policy_node **cur, const char *if_name,
                                         struct string_list *args,
                                         unsigned int lineno)
 {
-	struct if_call_data *if_data = xmalloc(sizeof(struct if_call_data));
+	struct if_call_data *if_data = node_xmalloc(sizeof(struct if_call_data));
 
-	if_data->name = xstrdup(if_name);
+	if_data->name = node_xstrdup(if_name);
 	if_data->args = args;
 
 	const char *template_name = get_name_if_in_template(*cur);
+	// While files are parsed concurrently the template map might not yet
+	// contain all templates parsed before, so expand the call later
+	const int defer_expansion = !template_name && !is_in_if_define(*cur) && is_staging_map_changes();
 
 	if (template_name) {
 		insert_call_into_template_map(template_name, if_data);
-	} else if (!is_in_if_define(*cur)) {
-		enum selint_error r = add_template_declarations(if_name, args, NULL, module_name);
+	} else if (!is_in_if_define(*cur) && !defer_expansion) {
+		enum selint_error r = add_template_declarations(if_name, args, module_name, NULL);
 		if (r != SELINT_SUCCESS) {
 			free_if_call_data(if_data);
 			return r;
@@ -457,7 +662,9 @@ enum selint_error insert_interface_call(struct policy_node **cur, const char *if
 		mark_filetrans_if((*cur)->parent->data.str);
 	}
 
-	mark_used_if(if_name);
+	if (!defer_expansion) {
+		mark_used_if(if_name);
+	}
 
 	union node_data nd;
 	nd.ic_data = if_data;
@@ -472,6 +679,10 @@ enum selint_error insert_interface_call(struct policy_node **cur, const char *if
 
 	*cur = (*cur)->next;
 
+	if (defer_expansion) {
+		defer_template_expansion(*cur, module_name);
+	}
+
 	return SELINT_SUCCESS;
 }
 
@@ -480,7 +691,7 @@ enum selint_error insert_permissive_statement(struct policy_node **cur,
 {
 	union node_data nd;
 
-	nd.str = xstrdup(domain);
+	nd.str = node_xstrdup(domain);
 	enum selint_error ret = insert_policy_node_next(*cur,
 	                                                NODE_PERMISSIVE,
 	                                                nd,
@@ -511,11 +722,11 @@ enum selint_error insert_semicolon(struct policy_node **cur, unsigned int lineno
 	return SELINT_SUCCESS;
 }
 
-enum selint_error insert_m4simplemacro(struct policy_node **cur, char *name, unsigned int lineno)
+enum selint_error insert_m4simplemacro(struct policy_node **cur, const char *name, unsigned int lineno)
 {
 
 	union node_data nd;
-	nd.str = name;
+	nd.str = node_xstrdup(name);
 
 	enum selint_error ret = insert_policy_node_next(*cur,
 	                                                NODE_M4_SIMPLE_MACRO,
@@ -612,7 +823,7 @@ enum selint_error end_optional_else(struct policy_node **cur)
 enum selint_error begin_boolean_policy(struct policy_node **cur,
                                        unsigned int lineno)
 {
-	struct cond_declaration_data *cd_data = xmalloc(sizeof(struct cond_declaration_data));
+	struct cond_declaration_data *cd_data = node_xmalloc(sizeof(struct cond_declaration_data));
 	cd_data->identifiers = NULL;
 
 	union node_data nd;
@@ -630,7 +841,7 @@ enum selint_error end_boolean_policy(struct policy_node **cur)
 enum selint_error begin_tunable_policy(struct policy_node **cur,
                                        unsigned int lineno)
 {
-	struct cond_declaration_data *cd_data = xmalloc(sizeof(struct cond_declaration_data));
+	struct cond_declaration_data *cd_data = node_xmalloc(sizeof(struct cond_declaration_data));
 	cd_data->identifiers = NULL;
 
 	union node_data nd;
@@ -663,7 +874,7 @@ enum selint_error begin_interface_def(struct policy_node **cur,
 	insert_into_ifs_map(name, get_current_module_name());
 
 	union node_data nd;
-	nd.str = xstrdup(name);
+	nd.str = node_xstrdup(name);
 
 	return begin_block(cur, flavor, nd, lineno);
 }
@@ -681,7 +892,7 @@ enum selint_error end_interface_def(struct policy_node **cur)
 enum selint_error begin_gen_require(struct policy_node **cur,
                                     unsigned int lineno)
 {
-	struct gen_require_data *data = (struct gen_require_data *)xmalloc(sizeof(struct gen_require_data));
+	struct gen_require_data *data = (struct gen_require_data *)node_xmalloc(sizeof(struct gen_require_data));
 	union node_data nd;
 	nd.gr_data = data;
 	return begin_block(cur, NODE_GEN_REQ, nd, lineno);
@@ -762,7 +973,8 @@ enum selint_error save_command(struct policy_node *cur, const char *comm)
 	}
 	comm += strlen("selint-");
 	if (0 == strncmp("disable:", comm, 8)) {
-		cur->exceptions = xstrdup(comm + strlen("disable:"));
+		cur->exceptions = node_xstrdup(comm + strlen("disable:"));
+		cur->disabled_checks |= parse_disabled_checks(cur->exceptions);
 	} else {
 		return SELINT_PARSE_ERROR;
 	}
@@ -770,19 +982,29 @@ enum selint_error save_command(struct policy_node *cur, const char *comm)
 	return SELINT_SUCCESS;
 }
 
-enum selint_error save_identifier(struct policy_node *cur, char *identifier)
+enum selint_error save_file_command(struct policy_node *cur, const char *comm)
+{
+	if (cur == NULL) {
+		return SELINT_BAD_ARG;
+	}
+	while (cur->prev) {
+		cur = cur->prev;
+	}
+
+	return save_command(cur, comm);
+}
+
+enum selint_error save_identifier(struct policy_node *cur, const char *identifier)
 {
 	if (cur == NULL || identifier == NULL) {
-		free(identifier);
 		return SELINT_BAD_ARG;
 	}
 
 	if (cur->flavor != NODE_TUNABLE_POLICY && cur->flavor != NODE_BOOLEAN_POLICY) {
-		free(identifier);
 		return SELINT_BAD_ARG;
 	}
 
-	cur->data.cd_data->identifiers = concat_string_lists(cur->data.cd_data->identifiers, sl_from_str_consume(identifier));
+	cur->data.cd_data->identifiers = concat_string_lists(cur->data.cd_data->identifiers, sl_from_str(identifier));
 
 	return SELINT_SUCCESS;
 }
@@ -802,17 +1024,17 @@ static enum node_flavor attr_to_node_flavor(enum attr_flavor flavor)
 
 static enum selint_error insert_attribute(struct policy_node **cur, enum attr_flavor flavor, const char *type, struct string_list *attrs, unsigned int lineno)
 {
-	struct attribute_data *data = xcalloc(1, sizeof(struct attribute_data));
+	struct attribute_data *data = node_xcalloc(1, sizeof(struct attribute_data));
 	union node_data nd;
 	nd.at_data = data;
 
-	data->type = xstrdup(type);
+	data->type = node_xstrdup(type);
 	data->attrs = attrs;
 	data->flavor = flavor;
 
 	enum selint_error ret = insert_policy_node_next(*cur, attr_to_node_flavor(flavor), nd, lineno);
 	if (ret != SELINT_SUCCESS) {
-		free(data);
+		node_free(data);
 		return ret;
 	}
 
@@ -839,13 +1061,66 @@ enum selint_error insert_role_attribute(struct policy_node **cur, const char *ro
 	return insert_attribute(cur, ATTR_ROLE, role, attrs, lineno);
 }
 
-void cleanup_parsing(void)
+struct av_common {
+	char *name;
+	struct string_list *perms;
+	struct av_common *next;
+};
+
+void insert_av_common(const char *name, struct string_list *perms)
 {
-	if (module_name) {
-		free(module_name);
-		module_name = NULL;
+	for (const struct string_list *cur = perms; cur; cur = cur->next) {
+		insert_into_decl_map(cur->string, "__av_file__", DECL_PERM);
 	}
 
+	struct av_common *common = xmalloc(sizeof(struct av_common));
+	common->name = xstrdup(name);
+	common->perms = perms;
+	common->next = selint_context_current()->av_commons;
+	selint_context_current()->av_commons = common;
+}
+
+void insert_av_class(const char *name, const char *common_name, struct string_list *perms)
+{
+	insert_into_decl_map(name, "__av_file__", DECL_CLASS);
+
+	for (const struct string_list *cur = perms; cur; cur = cur->next) {
+		insert_into_decl_map(cur->string, "__av_file__", DECL_PERM);
+		insert_into_class_perms(name, cur->string);
+	}
+	free_string_list(perms);
+
+	if (!common_name) {
+		return;
+	}
+
+	for (const struct av_common *common = selint_context_current()->av_commons; common; common = common->next) {
+		if (0 == strcmp(common->name, common_name)) {
+			for (const struct string_list *cur = common->perms; cur; cur = cur->next) {
+				insert_into_class_perms(name, cur->string);
+			}
+			return;
+		}
+	}
+}
+
+void free_av_commons(struct selint_context *ctx)
+{
+	while (ctx->av_commons) {
+		struct av_common *next = ctx->av_commons->next;
+		free(ctx->av_commons->name);
+		free_string_list(ctx->av_commons->perms);
+		free(ctx->av_commons);
+		ctx->av_commons = next;
+	}
+}
+
+void cleanup_parsing(void)
+{
+	reset_current_module_name();
+
+	free_av_commons(selint_context_current());
+
 	free_permmacros();
 
 	free_all_maps();
@@ -20,6 +20,7 @@
 #include "selint_error.h"
 #include "tree.h"
 #include "maps.h"
+#include "selint_context.h"
 
 /**********************************
 * insert_header
@@ -36,6 +37,7 @@ enum selint_error insert_header(struct policy_node **cur, const char *mn,
 
 /**********************************
 * Set the name of the current module to mn
+* The module name is tracked per thread, so files can be parsed concurrently
 **********************************/
 void set_current_module_name(const char *mn);
 
@@ -45,6 +47,23 @@ void set_current_module_name(const char *mn);
 **********************************/
 char *get_current_module_name(void);
 
+/**********************************
+* Free the name of the current module of the calling thread
+**********************************/
+void reset_current_module_name(void);
+
+/**********************************
+* Parse only for the symbols files define, as for context files, which are
+* never checked.  Rules still update the maps and are inserted into the
+* tree, so its structure is unchanged, but without their data.
+* Set it before parsing starts, it applies to the current context, and so
+* to the threads parsing files for it.
+**********************************/
+void set_symbols_only(int enable);
+
+// Return 1 if files are parsed for their symbols only, and 0 otherwise
+int is_symbols_only(void);
+
 /**********************************
 * insert_comment
 * Add a comment node at the next node in the tree, allocating all memory for it.
@@ -223,6 +242,22 @@ enum selint_error insert_interface_call(struct policy_node **cur, const char *if
                                         struct string_list *args,
                                         unsigned int lineno);
 
+/**********************************
+* Add the declarations of the templates called by node, an interface call
+* outside of an interface definition, once all map changes recorded before
+* are applied.  See defer_map_change().
+* mod_name (in) - The module the call is in
+**********************************/
+void defer_template_expansion(struct policy_node *node, const char *mod_name);
+
+/**********************************
+* Return the interface call node of a change recorded by
+* defer_template_expansion() and store its module in mod_name,
+* or return NULL if the change is of another kind
+**********************************/
+const struct policy_node *get_deferred_expansion(const struct map_change *change,
+                                                 const char **mod_name);
+
 enum selint_error insert_permissive_statement(struct policy_node **cur,
                                               const char *domain,
                                               unsigned int lineno);
@@ -231,7 +266,7 @@ enum selint_error insert_semicolon(struct policy_node **cur,
                                    unsigned int lineno);
 
 enum selint_error insert_m4simplemacro(struct policy_node **cur,
-                                       char *name,
+                                       const char *name,
                                        unsigned int lineno);
 
 /**********************************
@@ -346,7 +381,8 @@ enum selint_error end_m4_argument(struct policy_node **cur);
 /**********************************
 * save_command
 * Save an selint control command in the tree.  These go at the end of lines
-* and modify selint behavior while checking that line.
+* and modify selint behavior while checking that line, or the block or file
+* opened on that line.
 * Current commands are:
 * - selint-disable:[check-id]
 * cur (in) - The current spot in the tree.  Will be modified with information
@@ -357,16 +393,28 @@ enum selint_error end_m4_argument(struct policy_node **cur);
 **********************************/
 enum selint_error save_command(struct policy_node *cur, const char *comm);
 
+/**********************************
+* save_file_command
+* Save an selint control command for the whole file, as given on the line
+* of the module header.
+* cur (in) - The current spot in the tree.  The command is saved in the file
+* node at the head of the tree.
+* comm (in) - What command string was in the comment
+*
+* Returns - SELint error code
+**********************************/
+enum selint_error save_file_command(struct policy_node *cur, const char *comm);
+
 /**********************************
 * save_identifier
 * Save an identifier name in the tree.
 * cur (in) - The current spot in the tree.  Will be modified with information
 * about the identifier
-* comm (in, sink) - The name of the identifier
+* identifier (in) - The name of the identifier
 *
 * Returns - SELint error code
 **********************************/
-enum selint_error save_identifier(struct policy_node *cur, char *identifier);
+enum selint_error save_identifier(struct policy_node *cur, const char *identifier);
 
 /**********************************
 * insert_type_attribute
@@ -394,6 +442,33 @@ enum selint_error insert_type_attribute(struct policy_node **cur, const char *ty
 **********************************/
 enum selint_error insert_role_attribute(struct policy_node **cur, const char *role, struct string_list *attrs, unsigned int lineno);
 
+/**********************************
+* insert_av_common
+* Declare the permissions of a common of an access vector file, and save
+* them for the classes inheriting the common.
+* name - The name of the common
+* perms - The permissions of the common.  This function takes ownership
+* of the list.
+**********************************/
+void insert_av_common(const char *name, struct string_list *perms);
+
+/**********************************
+* insert_av_class
+* Declare a class of an access vector file and record its permissions,
+* including the ones of the inherited common.
+* name - The name of the class
+* common_name - The name of the inherited common, or NULL
+* perms - The permissions defined by the class itself.  This function
+* takes ownership of the list.
+**********************************/
+void insert_av_class(const char *name, const char *common_name, struct string_list *perms);
+
+/**********************************
+* free_av_commons
+* Free the commons saved by insert_av_common() in ctx
+**********************************/
+void free_av_commons(struct selint_context *ctx);
+
 /**********************************
 * cleanup_parsing
 * Call after all parsing is done to free up memory
@@ -14,6 +14,7 @@
 * limitations under the License.
 */
 
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -34,15 +35,23 @@ struct perm_macro {
 	mask_t mask_raw;
 };
 
-static bool initialized = false;
+// The permission macros by class, built from the permmacros map on first use
+struct perm_macros {
+	bool initialized;
+	struct perm_macro *dir_macros;
+	struct perm_macro *file_macros;
+	struct perm_macro *lnk_file_macros;
+	struct perm_macro *chr_file_macros;
+	struct perm_macro *blk_file_macros;
+	struct perm_macro *sock_file_macros;
+	struct perm_macro *fifo_file_macros;
+};
+
+static pthread_mutex_t initialize_lock = PTHREAD_MUTEX_INITIALIZER;
 
-static struct perm_macro *dir_macros = NULL;
-static struct perm_macro *file_macros = NULL;
-static struct perm_macro *lnk_file_macros = NULL;
-static struct perm_macro *chr_file_macros = NULL;
-static struct perm_macro *blk_file_macros = NULL;
-static struct perm_macro *sock_file_macros = NULL;
-static struct perm_macro *fifo_file_macros = NULL;
+// The macros of the current context, see selint_context.h
+static struct perm_macros default_perm_macros;
+static struct perm_macros *pm = &default_perm_macros;
 
 enum pm_common_file {
 	PM_CF__EMPTY		=         0u,
@@ -333,21 +342,21 @@ static void load_permission_macro(const char *name, const struct string_list *pe
 
 	struct perm_macro **category;
 	if (ends_with(name, strlen(name), "_dir_perms", strlen("_dir_perms"))) {
-		category = &dir_macros;
+		category = &pm->dir_macros;
 	} else if (ends_with(name, strlen(name), "_lnk_file_perms", strlen("_lnk_file_perms"))) {
-		category = &lnk_file_macros;
+		category = &pm->lnk_file_macros;
 	} else if (ends_with(name, strlen(name), "_chr_file_perms", strlen("_chr_file_perms"))) {
-		category = &chr_file_macros;
+		category = &pm->chr_file_macros;
 	} else if (ends_with(name, strlen(name), "_term_perms", strlen("_term_perms"))) {
-		category = &chr_file_macros;
+		category = &pm->chr_file_macros;
 	} else if (ends_with(name, strlen(name), "_blk_file_perms", strlen("_blk_file_perms"))) {
-		category = &blk_file_macros;
+		category = &pm->blk_file_macros;
 	} else if (ends_with(name, strlen(name), "_sock_file_perms", strlen("_sock_file_perms"))) {
-		category = &sock_file_macros;
+		category = &pm->sock_file_macros;
 	} else if (ends_with(name, strlen(name), "_fifo_file_perms", strlen("_fifo_file_perms"))) {
-		category = &fifo_file_macros;
+		category = &pm->fifo_file_macros;
 	} else if (ends_with(name, strlen(name), "_file_perms", strlen("_file_perms"))) {
-		category = &file_macros;
+		category = &pm->file_macros;
 	} else {
 		// macro for unsupported class
 		return;
@@ -392,27 +401,32 @@ static void load_permission_macro(const char *name, const struct string_list *pe
 
 char *permmacro_check(const char *class, const struct string_list *permissions)
 {
-	if (!initialized) {
-		visit_all_in_permmacros_map(load_permission_macro);
+	// checks might run concurrently
+	if (!__atomic_load_n(&pm->initialized, __ATOMIC_ACQUIRE)) {
+		pthread_mutex_lock(&initialize_lock);
+		if (!pm->initialized) {
+			visit_all_in_permmacros_map(load_permission_macro);
 
-		initialized = true;
+			__atomic_store_n(&pm->initialized, true, __ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock(&initialize_lock);
 	}
 
 	const struct perm_macro *category;
 	if (0 == strcmp(class, "dir")) {
-		category = dir_macros;
+		category = pm->dir_macros;
 	} else if (0 == strcmp(class, "file")) {
-		category = file_macros;
+		category = pm->file_macros;
 	} else if (0 == strcmp(class, "lnk_file")) {
-		category = lnk_file_macros;
+		category = pm->lnk_file_macros;
 	} else if (0 == strcmp(class, "chr_file")) {
-		category = chr_file_macros;
+		category = pm->chr_file_macros;
 	} else if (0 == strcmp(class, "blk_file")) {
-		category = blk_file_macros;
+		category = pm->blk_file_macros;
 	} else if (0 == strcmp(class, "sock_file")) {
-		category = sock_file_macros;
+		category = pm->sock_file_macros;
 	} else if (0 == strcmp(class, "fifo_file")) {
-		category = fifo_file_macros;
+		category = pm->fifo_file_macros;
 	} else {
 		// unsupported class
 		return NULL;
@@ -519,21 +533,47 @@ static void free_perm_macro(struct perm_macro *to_free)
 
 void free_permmacros(void)
 {
-	initialized = false;
-
-	free_perm_macro(dir_macros);
-	free_perm_macro(file_macros);
-	free_perm_macro(lnk_file_macros);
-	free_perm_macro(chr_file_macros);
-	free_perm_macro(blk_file_macros);
-	free_perm_macro(sock_file_macros);
-	free_perm_macro(fifo_file_macros);
-
-	dir_macros = NULL;
-	file_macros = NULL;
-	lnk_file_macros = NULL;
-	chr_file_macros = NULL;
-	blk_file_macros = NULL;
-	sock_file_macros = NULL;
-	fifo_file_macros = NULL;
+	pm->initialized = false;
+
+	free_perm_macro(pm->dir_macros);
+	free_perm_macro(pm->file_macros);
+	free_perm_macro(pm->lnk_file_macros);
+	free_perm_macro(pm->chr_file_macros);
+	free_perm_macro(pm->blk_file_macros);
+	free_perm_macro(pm->sock_file_macros);
+	free_perm_macro(pm->fifo_file_macros);
+
+	pm->dir_macros = NULL;
+	pm->file_macros = NULL;
+	pm->lnk_file_macros = NULL;
+	pm->chr_file_macros = NULL;
+	pm->blk_file_macros = NULL;
+	pm->sock_file_macros = NULL;
+	pm->fifo_file_macros = NULL;
+}
+
+struct perm_macros *alloc_perm_macros(void)
+{
+	return xcalloc(1, sizeof(struct perm_macros));
+}
+
+struct perm_macros *switch_perm_macros(struct perm_macros *macros)
+{
+	struct perm_macros *prev = pm;
+
+	pm = macros;
+
+	return prev;
+}
+
+void free_perm_macros(struct perm_macros *macros)
+{
+	struct perm_macros *prev = switch_perm_macros(macros);
+
+	free_permmacros();
+	switch_perm_macros(prev);
+
+	if (macros != &default_perm_macros) {
+		free(macros);
+	}
 }
@@ -35,4 +35,17 @@ char *permmacro_check(const char *class, const struct string_list *permissions);
 *********************************************/
 void free_permmacros(void);
 
+/*********************************************
+* The permission macro tables of a context, see selint_context.h.
+* switch_perm_macros() makes macros the current tables, and returns the
+* previous ones.  free_perm_macros() frees tables which are not current.
+*********************************************/
+struct perm_macros;
+
+struct perm_macros *alloc_perm_macros(void);
+
+struct perm_macros *switch_perm_macros(struct perm_macros *macros);
+
+void free_perm_macros(struct perm_macros *macros);
+
 #endif
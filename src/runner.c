@@ -15,12 +15,19 @@
 */
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <libgen.h>
 
+#include "config.h"
+
+#include "arena.h"
 #include "color.h"
+#include "intern.h"
+#include "parse_cache.h"
 #include "runner.h"
+#include "selint_context.h"
 #include "fc_checks.h"
 #include "if_checks.h"
 #include "te_checks.h"
@@ -28,9 +35,98 @@
 #include "parse.h"
 #include "util.h"
 #include "startup.h"
+#include "trace.h"
 #include "xalloc.h"
 
-#define CHECK_ENABLED(cid) is_check_enabled(cid, config_enabled_checks, config_disabled_checks, cl_enabled_checks, cl_disabled_checks, only_enabled)
+unsigned int parallel_jobs = 1;
+int retain_map_changes = 0;
+
+// A list of items processed by up to parallel_jobs threads.  Items are
+// handed out in order, and no further items are handed out once processing
+// an item failed.  Thus all items before a failed one are always processed.
+struct work_queue {
+	void *items;
+	size_t item_size;
+	size_t count;
+	size_t next;    // accessed atomically
+	int stop;       // accessed atomically
+	// returns 0 if processing failed
+	int (*process)(void *item);
+	struct selint_context *context;         // of the thread running the queue
+};
+
+static void *work_queue_worker(void *arg)
+{
+	struct work_queue *queue = arg;
+
+	selint_context_use(queue->context);
+
+	while (!__atomic_load_n(&queue->stop, __ATOMIC_ACQUIRE)) {
+		const size_t index = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED);
+		if (index >= queue->count) {
+			break;
+		}
+
+		if (!queue->process((char *)queue->items + index * queue->item_size)) {
+			__atomic_store_n(&queue->stop, 1, __ATOMIC_RELEASE);
+		}
+	}
+
+	return NULL;
+}
+
+static void run_work_queue(struct work_queue *queue)
+{
+	unsigned int threads = parallel_jobs;
+
+	if (threads > queue->count) {
+		threads = (unsigned int)queue->count;
+	}
+
+	pthread_t *workers = xcalloc(threads, sizeof(pthread_t));
+	unsigned int started = 0;
+
+	queue->context = selint_context_current();
+
+	// The calling thread is the first worker
+	for (unsigned int i = 1; i < threads; i++) {
+		if (pthread_create(&workers[started], NULL, work_queue_worker, queue) == 0) {
+			started++;
+		}
+	}
+
+	work_queue_worker(queue);
+
+	for (unsigned int i = 0; i < started; i++) {
+		pthread_join(workers[i], NULL);
+	}
+
+	free(workers);
+}
+
+// End the span of a phase working on a list of files
+static void trace_list_end(const struct trace_span *span, const struct policy_file_list *files)
+{
+	if (is_tracing()) {
+		trace_end(span, NULL, "files", file_list_length(files));
+	}
+}
+
+// End the span of parsing a file, with the number of nodes of its AST
+static void trace_parse_end(const struct trace_span *span, const char *filename,
+                            const struct policy_node *ast)
+{
+	if (!is_tracing()) {
+		return;
+	}
+
+	size_t nodes = 0;
+	for (const struct policy_node *cur = ast; cur; cur = dfs_next(cur)) {
+		nodes++;
+	}
+
+	trace_end(span, filename, "nodes", nodes);
+}
 
 struct policy_node *parse_one_file(const char *filename, enum node_flavor flavor)
 {
@@ -43,309 +139,479 @@ struct policy_node *parse_one_file(const char *filename, enum node_flavor flavor
 
 	FILE *f = fopen(filename, "re");
 	if (!f) {
-		printf("%sError%s: Failed to open %s: %s\n", color_error(), color_reset(), filename, strerror(errno));
+		fprintf(get_result_stream(), "%sError%s: Failed to open %s: %s\n", color_error(), color_reset(), filename, strerror(errno));
 		return NULL;
 	}
 
 	struct policy_node *ast = yyparse_wrapper(f, filename, flavor);
 	fclose(f);
 
+	if (ast) {
+		update_names_in_tree(ast);
+	}
+
 	// dont run cleanup_parsing until everything is done because it frees the maps
 	return ast;
 }
 
-int is_check_enabled(const char *check_name,
-                     const struct string_list *config_enabled_checks,
-                     const struct string_list *config_disabled_checks,
-                     const struct string_list *cl_enabled_checks,
-                     const struct string_list *cl_disabled_checks,
-                     int only_enabled)
+// Load a te or if file from the parse cache, or parse it and store it.
+// The map changes of the file are recorded even in a serial run, so they
+// can be stored along with the AST.
+static struct policy_node *parse_or_load_cached(const char *filename,
+                                                enum node_flavor flavor)
 {
-
-	int is_enabled = check_name[0] == 'X' ? 0 : 1;     // default to enabled, except for extra checks
-
-	if (only_enabled) {
-		// if only_enabled is true, we only want to enable checks that are
-		// explicitly enabled in the cl_enabled_checks. So change the default
-		// enabled state to disabled, and skip all other checks except for the
-		// enabled checks.
-		is_enabled = 0;
-	} else {
-		if (str_in_sl(check_name, config_disabled_checks)) {
-			is_enabled = 0;
+	struct map_changes *outer = get_staged_map_changes();
+	struct map_changes *changes = outer ? outer : alloc_map_changes();
+	struct parse_cache_key key;
+
+	struct policy_node *ast = load_cached_parse(filename, flavor, &key, changes);
+	if (!ast) {
+		stage_map_changes(changes);
+		ast = parse_one_file(filename, flavor);
+		stage_map_changes(outer);
+		if (ast && !is_symbols_only()) {
+			// The rules of a symbols-only parse lack their data
+			store_cached_parse(&key, ast, changes);
 		}
+	}
+	free_parse_cache_key(&key);
 
-		if (str_in_sl(check_name, config_enabled_checks)) {
-			is_enabled = 1;
+	if (!outer) {
+		if (ast) {
+			commit_map_changes(changes);
+		} else {
+			free_map_changes(changes);
 		}
+	}
 
-		if (str_in_sl(check_name, cl_disabled_checks)) {
-			is_enabled = 0;
-		}
+	return ast;
+}
+
+// Parse a te or if file.  With arenas enabled the AST of each file is
+// allocated from an arena of its own, so freeing it does not walk the tree.
+static struct policy_node *parse_policy_file(struct policy_file *file,
+                                             enum node_flavor flavor)
+{
+	struct trace_span span;
+	trace_begin(&span, flavor == NODE_IF_FILE ? "parse if file" : "parse te file");
+
+#ifdef ENABLE_ARENA
+	file->arena = alloc_arena();
+	set_active_arena(file->arena);
+#endif
+
+	// Concurrent parses record the changes of each file already
+	struct map_changes *changes = NULL;
+	if (retain_map_changes && !is_staging_map_changes()) {
+		changes = alloc_map_changes();
+		stage_map_changes(changes);
+	}
+
+	struct policy_node *ast;
+	if (is_parse_cache_enabled()) {
+		ast = parse_or_load_cached(file->filename, flavor);
+	} else {
+		ast = parse_one_file(file->filename, flavor);
 	}
 
-	if (str_in_sl(check_name, cl_enabled_checks)) {
-		is_enabled = 1;
+	if (changes) {
+		stage_map_changes(NULL);
+		if (ast) {
+			replay_map_changes(changes);
+			file->changes = changes;
+		} else {
+			free_map_changes(changes);
+		}
 	}
 
-	return is_enabled;
+#ifdef ENABLE_ARENA
+	set_active_arena(NULL);
+#endif
+
+	trace_parse_end(&span, file->filename, ast);
+
+	return ast;
 }
 
-struct checks *register_checks(char level,
-                               const struct string_list *config_enabled_checks,
-                               const struct string_list *config_disabled_checks,
-                               const struct string_list *cl_enabled_checks,
-                               const struct string_list *cl_disabled_checks,
-                               int only_enabled)
+// Parse an fc file, with its AST allocated like the one of a te or if file
+static struct policy_node *parse_fc_policy_file(struct policy_file *file,
+                                                const struct string_list *custom_fc_macros)
 {
+	struct trace_span span;
+	trace_begin(&span, "parse fc file");
+
+#ifdef ENABLE_ARENA
+	file->arena = alloc_arena();
+	set_active_arena(file->arena);
+#endif
+
+	struct policy_node *ast = parse_fc_file(file->filename, custom_fc_macros);
+
+#ifdef ENABLE_ARENA
+	set_active_arena(NULL);
+#endif
+
+	trace_parse_end(&span, file->filename, ast);
 
-	struct checks *ck = xmalloc(sizeof(struct checks));
+	return ast;
+}
 
-	memset(ck, 0, sizeof(struct checks));
+// A check, called for nodes of the flavors in node_flavors in files of the
+// flavors in file_flavors
+struct check_definition {
+	const char *check_id;
+	uint64_t node_flavors;
+	unsigned int file_flavors;
+	struct check_result *(*check_function)(const struct check_data *data,
+	                                       const struct policy_node *node);
+	// Whether the check can run in this analysis, or NULL if it always can
+	bool (*precondition)(void);
+};
+
+#define FLAVOR(flavor) (UINT64_C(1) << (flavor))
+#define TE_FILES FILE_FLAVOR_BIT(FILE_TE_FILE)
+#define IF_FILES FILE_FLAVOR_BIT(FILE_IF_FILE)
+#define FC_FILES FILE_FLAVOR_BIT(FILE_FC_FILE)
+#define TE_IF_FILES (TE_FILES | IF_FILES)
+
+_Static_assert(NODE_ERROR < 64, "node flavors do not fit into node_flavors");
+
+// Nodes naming types, roles or attributes that need a declaration or require
+#define NAME_USE_FLAVORS (FLAVOR(NODE_AV_RULE) | FLAVOR(NODE_XAV_RULE) | \
+	FLAVOR(NODE_IF_CALL) | FLAVOR(NODE_TT_RULE) | FLAVOR(NODE_RT_RULE) | \
+	FLAVOR(NODE_ROLE_ALLOW) | FLAVOR(NODE_ROLE_TYPES) | FLAVOR(NODE_ALIAS) | \
+	FLAVOR(NODE_TYPE_ALIAS) | FLAVOR(NODE_TYPE_ATTRIBUTE) | \
+	FLAVOR(NODE_ROLE_ATTRIBUTE) | FLAVOR(NODE_PERMISSIVE) | FLAVOR(NODE_DECL) | \
+	FLAVOR(NODE_CLEANUP))
+
+// All checks, in the order they are called for a node
+static const struct check_definition check_definitions[] = {
+	{ "X-001", FLAVOR(NODE_INTERFACE_DEF) | FLAVOR(NODE_TEMP_DEF),
+	  TE_IF_FILES, check_unused_interface, NULL },
+	{ "X-002", FLAVOR(NODE_AV_RULE) | FLAVOR(NODE_IF_CALL),
+	  TE_IF_FILES, check_excluding_av_rule, NULL },
+
+	{ "C-001", FLAVOR(NODE_TE_FILE) | FLAVOR(NODE_DECL) | FLAVOR(NODE_AV_RULE) |
+	  FLAVOR(NODE_XAV_RULE) | FLAVOR(NODE_IF_CALL) | FLAVOR(NODE_TT_RULE) |
+	  FLAVOR(NODE_CLEANUP),
+	  TE_FILES, check_te_order, NULL },
+	{ "C-004", FLAVOR(NODE_INTERFACE_DEF) | FLAVOR(NODE_TEMP_DEF),
+	  TE_IF_FILES, check_interface_definitions_have_comment, NULL },
+	{ "C-005", FLAVOR(NODE_AV_RULE) | FLAVOR(NODE_XAV_RULE) | FLAVOR(NODE_DECL),
+	  TE_IF_FILES, check_unordered_perms, NULL },
+	{ "C-006", FLAVOR(NODE_REQUIRE) | FLAVOR(NODE_GEN_REQ),
+	  TE_IF_FILES, check_unordered_declaration_in_require, NULL },
+	{ "C-007", FLAVOR(NODE_AV_RULE) | FLAVOR(NODE_XAV_RULE),
+	  TE_IF_FILES, check_no_self, NULL },
+	{ "C-008", FLAVOR(NODE_BOOLEAN_POLICY) | FLAVOR(NODE_TUNABLE_POLICY),
+	  TE_IF_FILES, check_foreign_cond_id, NULL },
+
+	{ "S-001", FLAVOR(NODE_REQUIRE) | FLAVOR(NODE_GEN_REQ),
+	  TE_FILES, check_require_block, NULL },
+	{ "S-002", FLAVOR(NODE_FC_ENTRY),
+	  FC_FILES, check_file_context_types_in_mod, NULL },
+	{ "S-003", FLAVOR(NODE_SEMICOLON),
+	  TE_IF_FILES, check_useless_semicolon, NULL },
+	{ "S-004", FLAVOR(NODE_IF_CALL),
+	  IF_FILES, check_if_calls_template, NULL },
+	{ "S-005", FLAVOR(NODE_DECL),
+	  IF_FILES, check_decl_in_if, NULL },
+	{ "S-006", FLAVOR(NODE_HEADER),
+	  TE_IF_FILES, check_bare_module_statement, NULL },
+	{ "S-007", FLAVOR(NODE_FC_ENTRY),
+	  FC_FILES, check_gen_context_no_range, NULL },
+	{ "S-008", FLAVOR(NODE_GEN_REQ),
+	  TE_IF_FILES, check_unquoted_gen_require_block, NULL },
+	{ "S-009", FLAVOR(NODE_AV_RULE),
+	  TE_IF_FILES, check_perm_macro_class_mismatch, NULL },
+	{ "S-010", FLAVOR(NODE_AV_RULE),
+	  TE_IF_FILES, check_perm_macro_available, NULL },
+	{ "S-011", FLAVOR(NODE_EMPTY),
+	  FC_FILES, check_file_context_error_nodes, NULL },
+
+	{ "W-001", NAME_USE_FLAVORS,
+	  TE_FILES, check_no_explicit_declaration, NULL },
+	{ "W-002", NAME_USE_FLAVORS,
+	  IF_FILES, check_name_used_but_not_required_in_if, NULL },
+	{ "W-003", FLAVOR(NODE_DECL) | FLAVOR(NODE_CLEANUP),
+	  IF_FILES, check_name_required_but_not_used_in_if, NULL },
+	{ "W-004", FLAVOR(NODE_FC_ENTRY),
+	  FC_FILES, check_file_context_regex, NULL },
+	{ "W-005", FLAVOR(NODE_IF_CALL),
+	  TE_IF_FILES, check_module_if_call_in_optional, NULL },
+	{ "W-006", FLAVOR(NODE_IF_CALL),
+	  TE_IF_FILES, check_empty_if_call_arg, NULL },
+	{ "W-007", FLAVOR(NODE_IF_CALL),
+	  TE_IF_FILES, check_space_if_call_arg, NULL },
+	{ "W-008", FLAVOR(NODE_AV_RULE),
+	  TE_IF_FILES, check_risky_allow_perm, NULL },
+	{ "W-009", FLAVOR(NODE_HEADER),
+	  TE_IF_FILES, check_module_file_name_mismatch, NULL },
+	{ "W-010", FLAVOR(NODE_IF_CALL),
+	  TE_IF_FILES, check_unknown_interface_call, NULL },
+	{ "W-011", FLAVOR(NODE_DECL),
+	  IF_FILES, check_required_declaration_own, NULL },
+	{ "W-012", FLAVOR(NODE_BOOLEAN_POLICY) | FLAVOR(NODE_TUNABLE_POLICY),
+	  TE_IF_FILES, check_unknown_cond_id, NULL },
+	{ "W-013", FLAVOR(NODE_AV_RULE),
+	  TE_IF_FILES, check_audit_access_perm, NULL },
+
+	{ "E-002", FLAVOR(NODE_ERROR),
+	  FC_FILES, check_file_context_error_nodes, NULL },
+	{ "E-003", FLAVOR(NODE_FC_ENTRY),
+	  FC_FILES, check_file_context_users, NULL },
+	{ "E-004", FLAVOR(NODE_FC_ENTRY),
+	  FC_FILES, check_file_context_roles, NULL },
+	{ "E-005", FLAVOR(NODE_FC_ENTRY),
+	  FC_FILES, check_file_context_types_exist, NULL },
+	{ "E-006", FLAVOR(NODE_DECL),
+	  TE_IF_FILES, check_declaration_interface_nameclash, NULL },
+	{ "E-007", FLAVOR(NODE_AV_RULE),
+	  TE_IF_FILES, check_unknown_permission, check_unknown_permission_condition },
+	{ "E-008", FLAVOR(NODE_AV_RULE) | FLAVOR(NODE_RT_RULE) | FLAVOR(NODE_TT_RULE),
+	  TE_IF_FILES, check_unknown_class, check_unknown_class_condition },
+	{ "E-009", FLAVOR(NODE_OPTIONAL_POLICY) | FLAVOR(NODE_GEN_REQ) | FLAVOR(NODE_REQUIRE),
+	  TE_IF_FILES, check_empty_block, NULL },
+	{ "E-010", FLAVOR(NODE_M4_SIMPLE_MACRO),
+	  TE_IF_FILES, check_stray_word, NULL },
+};
+
+// Return the bits of the checks listed
+static uint64_t check_list_bits(const struct string_list *list)
+{
+	uint64_t bits = 0;
 
-	if (CHECK_ENABLED("X-001")) {
-		add_check(NODE_INTERFACE_DEF, ck, "X-001",
-			  check_unused_interface);
-		add_check(NODE_TEMP_DEF, ck, "X-001",
-			  check_unused_interface);
+	for (; list; list = list->next) {
+		bits |= check_id_bit(list->string);
 	}
-	if (CHECK_ENABLED("X-002")) {
-		add_check(NODE_AV_RULE, ck, "X-002",
-			  check_excluding_av_rule);
-		add_check(NODE_IF_CALL, ck, "X-002",
-			  check_excluding_av_rule);
+
+	return bits;
+}
+
+uint64_t enabled_check_bits(const struct string_list *config_enabled_checks,
+                            const struct string_list *config_disabled_checks,
+                            const struct string_list *cl_enabled_checks,
+                            const struct string_list *cl_disabled_checks,
+                            int only_enabled)
+{
+	// default to enabled, except for extra checks
+	uint64_t bits = severity_check_bits('C') | severity_check_bits('S') |
+	                severity_check_bits('W') | severity_check_bits('E') |
+	                severity_check_bits('F');
+
+	if (only_enabled) {
+		// if only_enabled is true, we only want to enable checks that are
+		// explicitly enabled in the cl_enabled_checks. So change the default
+		// enabled state to disabled, and skip all other checks except for the
+		// enabled checks.
+		bits = 0;
+	} else {
+		bits &= ~check_list_bits(config_disabled_checks);
+		bits |= check_list_bits(config_enabled_checks);
+		bits &= ~check_list_bits(cl_disabled_checks);
 	}
 
+	bits |= check_list_bits(cl_enabled_checks);
+
+	return bits;
+}
+
+int is_check_enabled(const char *check_name,
+                     const struct string_list *config_enabled_checks,
+                     const struct string_list *config_disabled_checks,
+                     const struct string_list *cl_enabled_checks,
+                     const struct string_list *cl_disabled_checks,
+                     int only_enabled)
+{
+	const uint64_t bits = enabled_check_bits(config_enabled_checks,
+	                                         config_disabled_checks,
+	                                         cl_enabled_checks,
+	                                         cl_disabled_checks,
+	                                         only_enabled);
+
+	return (bits & check_id_bit(check_name)) != 0;
+}
+
+// Return the bits of the checks run at a severity level, or 0 if the level
+// is not valid.  Extra checks run at any level once enabled.
+static uint64_t level_check_bits(char level)
+{
+	uint64_t bits = severity_check_bits('X');
+
 	switch (level) {
 	case 'C':
-		if (CHECK_ENABLED("C-001")) {
-			add_check(NODE_TE_FILE, ck, "C-001",
-			          check_te_order);
-			add_check(NODE_DECL, ck, "C-001",
-			          check_te_order);
-			add_check(NODE_AV_RULE, ck, "C-001",
-			          check_te_order);
-			add_check(NODE_XAV_RULE, ck, "C-001",
-			          check_te_order);
-			add_check(NODE_IF_CALL, ck, "C-001",
-			          check_te_order);
-			add_check(NODE_TT_RULE, ck, "C-001",
-			          check_te_order);
-			add_check(NODE_CLEANUP, ck, "C-001",
-			          check_te_order);
-		}
-		if (CHECK_ENABLED("C-004")) {
-			add_check(NODE_INTERFACE_DEF, ck, "C-004",
-			          check_interface_definitions_have_comment);
-			add_check(NODE_TEMP_DEF, ck, "C-004",
-			          check_interface_definitions_have_comment);
-		}
-		if (CHECK_ENABLED("C-005")) {
-			add_check(NODE_AV_RULE, ck, "C-005",
-			          check_unordered_perms);
-			add_check(NODE_XAV_RULE, ck, "C-005",
-			          check_unordered_perms);
-			add_check(NODE_DECL, ck, "C-005",
-			          check_unordered_perms);
-		}
-		if (CHECK_ENABLED("C-006")) {
-			add_check(NODE_REQUIRE, ck, "C-006",
-			          check_unordered_declaration_in_require);
-			add_check(NODE_GEN_REQ, ck, "C-006",
-			          check_unordered_declaration_in_require);
-		}
-		if (CHECK_ENABLED("C-007")) {
-			add_check(NODE_AV_RULE, ck, "C-007",
-			          check_no_self);
-			add_check(NODE_XAV_RULE, ck, "C-007",
-			          check_no_self);
-		}
-		if (CHECK_ENABLED("C-008")) {
-			add_check(NODE_BOOLEAN_POLICY, ck, "C-008",
-			          check_foreign_cond_id);
-			add_check(NODE_TUNABLE_POLICY, ck, "C-008",
-			          check_foreign_cond_id);
-		}
+		bits |= severity_check_bits('C');
 		// FALLTHRU
 	case 'S':
-		if (CHECK_ENABLED("S-001")) {
-			add_check(NODE_REQUIRE, ck, "S-001", check_require_block);
-			add_check(NODE_GEN_REQ, ck, "S-001", check_require_block);
-		}
-		if (CHECK_ENABLED("S-002")) {
-			add_check(NODE_FC_ENTRY, ck, "S-002",
-			          check_file_context_types_in_mod);
-		}
-		if (CHECK_ENABLED("S-003")) {
-			add_check(NODE_SEMICOLON, ck, "S-003",
-			          check_useless_semicolon);
-		}
-		if (CHECK_ENABLED("S-004")) {
-			add_check(NODE_IF_CALL, ck, "S-004",
-			          check_if_calls_template);
-		}
-		if (CHECK_ENABLED("S-005")) {
-			add_check(NODE_DECL, ck, "S-005",
-			          check_decl_in_if);
-		}
-		if (CHECK_ENABLED("S-006")) {
-			add_check(NODE_HEADER, ck, "S-006",
-			          check_bare_module_statement);
-		}
-		if (CHECK_ENABLED("S-007")) {
-			add_check(NODE_FC_ENTRY, ck, "S-007",
-			          check_gen_context_no_range);
-		}
-		if (CHECK_ENABLED("S-008")) {
-			add_check(NODE_GEN_REQ, ck, "S-008",
-			          check_unquoted_gen_require_block);
-		}
-		if (CHECK_ENABLED("S-009")) {
-			add_check(NODE_AV_RULE, ck, "S-009",
-			          check_perm_macro_class_mismatch);
-		}
-		if (CHECK_ENABLED("S-010")) {
-			add_check(NODE_AV_RULE, ck, "S-010",
-			          check_perm_macro_available);
-		}
-		if (CHECK_ENABLED("S-011")) {
-			add_check(NODE_EMPTY, ck, "S-011",
-			          check_file_context_error_nodes);
-		}
+		bits |= severity_check_bits('S');
 		// FALLTHRU
 	case 'W':
-		if (CHECK_ENABLED("W-001")) {
-			add_check(NODE_AV_RULE, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_XAV_RULE, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_IF_CALL, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_TT_RULE, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_RT_RULE, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_ROLE_ALLOW, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_ROLE_TYPES, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_ALIAS, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_TYPE_ALIAS, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_TYPE_ATTRIBUTE, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_ROLE_ATTRIBUTE, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_PERMISSIVE, ck, "W-001", check_no_explicit_declaration);
-			add_check(NODE_DECL, ck, "W-001", check_no_explicit_declaration);
-		}
-		if (CHECK_ENABLED("W-002")) {
-			add_check(NODE_AV_RULE, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_XAV_RULE, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_IF_CALL, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_TT_RULE, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_RT_RULE, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_ROLE_ALLOW, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_ROLE_TYPES, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_ALIAS, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_TYPE_ALIAS, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_TYPE_ATTRIBUTE, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_ROLE_ATTRIBUTE, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_PERMISSIVE, ck, "W-002", check_name_used_but_not_required_in_if);
-			add_check(NODE_DECL, ck, "W-002", check_name_used_but_not_required_in_if);
-		}
-		if (CHECK_ENABLED("W-003")) {
-			add_check(NODE_DECL, ck, "W-003",
-			          check_name_required_but_not_used_in_if);
-		}
-		if (CHECK_ENABLED("W-004")) {
-			add_check(NODE_FC_ENTRY, ck, "W-004", check_file_context_regex);
-		}
-		if (CHECK_ENABLED("W-005")) {
-			add_check(NODE_IF_CALL, ck, "W-005",
-			          check_module_if_call_in_optional);
-		}
-		if (CHECK_ENABLED("W-006")) {
-			add_check(NODE_IF_CALL, ck, "W-006",
-			          check_empty_if_call_arg);
-		}
-		if (CHECK_ENABLED("W-007")) {
-			add_check(NODE_IF_CALL, ck, "W-007",
-			          check_space_if_call_arg);
-		}
-		if (CHECK_ENABLED("W-008")) {
-			add_check(NODE_AV_RULE, ck, "W-008",
-			          check_risky_allow_perm);
-		}
-		if (CHECK_ENABLED("W-009")) {
-			add_check(NODE_HEADER, ck, "W-009",
-			          check_module_file_name_mismatch);
-		}
-		if (CHECK_ENABLED("W-010")) {
-			add_check(NODE_IF_CALL, ck, "W-010",
-				  check_unknown_interface_call);
-		}
-		if (CHECK_ENABLED("W-011")) {
-			add_check(NODE_DECL, ck, "W-011",
-				  check_required_declaration_own);
-		}
-		if (CHECK_ENABLED("W-012")) {
-			add_check(NODE_BOOLEAN_POLICY, ck, "W-012",
-				  check_unknown_cond_id);
-			add_check(NODE_TUNABLE_POLICY, ck, "W-012",
-				  check_unknown_cond_id);
-		}
-		if (CHECK_ENABLED("W-013")) {
-			add_check(NODE_AV_RULE, ck, "W-013",
-				  check_audit_access_perm);
-		}
+		bits |= severity_check_bits('W');
 		// FALLTHRU
 	case 'E':
-		if (CHECK_ENABLED("E-002")) {
-			add_check(NODE_ERROR, ck, "E-002",
-			          check_file_context_error_nodes);
-		}
-		if (CHECK_ENABLED("E-003")) {
-			add_check(NODE_FC_ENTRY, ck, "E-003", check_file_context_users);
-		}
-		if (CHECK_ENABLED("E-004")) {
-			add_check(NODE_FC_ENTRY, ck, "E-004", check_file_context_roles);
-		}
-		if (CHECK_ENABLED("E-005")) {
-			add_check(NODE_FC_ENTRY, ck, "E-005",
-			          check_file_context_types_exist);
-		}
-		if (CHECK_ENABLED("E-006")) {
-			add_check(NODE_DECL, ck, "E-006",
-				check_declaration_interface_nameclash);
-		}
-		if (CHECK_ENABLED("E-007") && check_unknown_permission_condition()) {
-			add_check(NODE_AV_RULE, ck, "E-007",
-				  check_unknown_permission);
-		}
-		if (CHECK_ENABLED("E-008") && check_unknown_class_condition()) {
-			add_check(NODE_AV_RULE, ck, "E-008", check_unknown_class);
-			add_check(NODE_RT_RULE, ck, "E-008", check_unknown_class);
-			add_check(NODE_TT_RULE, ck, "E-008", check_unknown_class);
-		}
-		if (CHECK_ENABLED("E-009")) {
-			add_check(NODE_OPTIONAL_POLICY, ck, "E-009", check_empty_block);
-			add_check(NODE_GEN_REQ, ck, "E-009", check_empty_block);
-			add_check(NODE_REQUIRE, ck, "E-009", check_empty_block);
-		}
-		if (CHECK_ENABLED("E-010")) {
-			add_check(NODE_M4_SIMPLE_MACRO, ck, "E-010",
-				  check_stray_word);
-		}
+		bits |= severity_check_bits('E');
 		// FALLTHRU
 	case 'F':
 		break;
 	default:
-		free(ck);
+		return 0;
+	}
+
+	return bits;
+}
+
+struct checks *register_checks(char level,
+                               const struct string_list *config_enabled_checks,
+                               const struct string_list *config_disabled_checks,
+                               const struct string_list *cl_enabled_checks,
+                               const struct string_list *cl_disabled_checks,
+                               int only_enabled)
+{
+	const uint64_t level_bits = level_check_bits(level);
+	if (!level_bits) {
 		return NULL;
 	}
 
+	const uint64_t enabled = level_bits & enabled_check_bits(config_enabled_checks,
+	                                                         config_disabled_checks,
+	                                                         cl_enabled_checks,
+	                                                         cl_disabled_checks,
+	                                                         only_enabled);
+
+	struct checks *ck = xcalloc(1, sizeof(struct checks));
+
+	for (size_t i = 0; i < sizeof(check_definitions) / sizeof(check_definitions[0]); i++) {
+		const struct check_definition *def = &check_definitions[i];
+
+		if (!(enabled & check_id_bit(def->check_id))) {
+			continue;
+		}
+		if (def->precondition && !def->precondition()) {
+			continue;
+		}
+
+		for (int flavor = 0; flavor <= NODE_ERROR; flavor++) {
+			if (def->node_flavors & FLAVOR(flavor)) {
+				add_file_check((enum node_flavor)flavor, def->file_flavors, ck,
+				               def->check_id, def->check_function);
+			}
+		}
+	}
+
 	return ck;
 }
 
+struct parse_job {
+	struct policy_file *file;
+	enum node_flavor flavor;
+	const struct string_list *custom_fc_macros;
+	struct map_changes *changes;
+	char *output;
+	size_t output_len;
+};
+
+static int parse_job_run(void *item)
+{
+	struct parse_job *job = item;
+
+	// Buffer all output and map insertions, to replay them in file order
+	FILE *out = open_memstream(&job->output, &job->output_len);
+	set_result_stream(out);
+	job->changes = alloc_map_changes();
+	stage_map_changes(job->changes);
+
+	if (job->flavor == NODE_FC_FILE) {
+		job->file->ast = parse_fc_policy_file(job->file, job->custom_fc_macros);
+	} else {
+		job->file->ast = parse_policy_file(job->file, job->flavor);
+	}
+
+	stage_map_changes(NULL);
+	reset_current_module_name();
+	set_result_stream(NULL);
+	if (out) {
+		fclose(out);
+	}
+
+	return job->file->ast != NULL;
+}
+
+static enum selint_error parse_files_concurrently(struct policy_file_list *files,
+                                                  enum node_flavor flavor,
+                                                  const struct string_list *custom_fc_macros)
+{
+	if (!files->head) {
+		return SELINT_SUCCESS;
+	}
+
+	const size_t count = file_list_length(files);
+
+	struct parse_job *jobs = xcalloc(count, sizeof(struct parse_job));
+	size_t i = 0;
+	for (struct policy_file_node *cur = files->head; cur; cur = cur->next) {
+		jobs[i].file = cur->file;
+		jobs[i].flavor = flavor;
+		jobs[i].custom_fc_macros = custom_fc_macros;
+		i++;
+	}
+
+	struct work_queue queue = {
+		.items = jobs,
+		.item_size = sizeof(struct parse_job),
+		.count = count,
+		.process = parse_job_run,
+	};
+	run_work_queue(&queue);
+
+	enum selint_error ret = SELINT_SUCCESS;
+	for (i = 0; i < count; i++) {
+		struct parse_job *job = &jobs[i];
+
+		if (ret != SELINT_SUCCESS) {
+			// A serial run stops at the first file failing to parse
+			free_map_changes(job->changes);
+			if (job->file->ast) {
+				free_policy_node(job->file->ast);
+				job->file->ast = NULL;
+			}
+		} else {
+			print_if_verbose("Parsing %s%s\n", flavor == NODE_FC_FILE ? "fc file " : "", job->file->filename);
+			if (job->output_len > 0) {
+				fwrite(job->output, 1, job->output_len, stdout);
+			}
+			if (job->file->ast && retain_map_changes) {
+				replay_map_changes(job->changes);
+				job->file->changes = job->changes;
+			} else if (job->file->ast) {
+				commit_map_changes(job->changes);
+			} else {
+				// The changes might refer to the freed AST, and nothing
+				// but cleanup happens after a parse error
+				free_map_changes(job->changes);
+				ret = SELINT_PARSE_ERROR;
+			}
+		}
+
+		free(job->output);
+	}
+
+	free(jobs);
+
+	return ret;
+}
+
 enum selint_error parse_all_files_in_list(struct policy_file_list *files, enum node_flavor flavor)
 {
 
+	if (parallel_jobs > 1) {
+		return parse_files_concurrently(files, flavor, NULL);
+	}
+
 	struct policy_file_node *current = files->head;
 
 	while (current) {
 		print_if_verbose("Parsing %s\n", current->file->filename);
-		current->file->ast = parse_one_file(current->file->filename, flavor);
+		current->file->ast = parse_policy_file(current->file, flavor);
 		if (!current->file->ast) {
 			return SELINT_PARSE_ERROR;
 		}
@@ -360,11 +626,15 @@ enum selint_error parse_all_fc_files_in_list(struct policy_file_list *files,
                                              const struct string_list *custom_fc_macros)
 {
 
+	if (parallel_jobs > 1) {
+		return parse_files_concurrently(files, NODE_FC_FILE, custom_fc_macros);
+	}
+
 	struct policy_file_node *current = files->head;
 
 	while (current) {
 		print_if_verbose("Parsing fc file %s\n", current->file->filename);
-		current->file->ast = parse_fc_file(current->file->filename, custom_fc_macros);
+		current->file->ast = parse_fc_policy_file(current->file, custom_fc_macros);
 		if (!current->file->ast) {
 			return SELINT_PARSE_ERROR;
 		}
@@ -379,35 +649,177 @@ enum selint_error run_checks_on_one_file(struct checks *ck,
                                          const struct policy_node *head)
 {
 	const struct policy_node *current = head;
+	size_t nodes = 0;
+	struct trace_span span;
+
+	enum selint_error res = SELINT_SUCCESS;
+
+	trace_begin(&span, "check file");
 
 	while (current) {
-		enum selint_error res = call_checks(ck, data, current);
+		res = call_checks(ck, data, current);
 		if (res != SELINT_SUCCESS) {
-			return res;
+			break;
 		}
 
+		nodes++;
 		current = dfs_next(current);
 	}
 
-	// Give checks a change to clean up state
-	struct policy_node cleanup;
-	memset(&cleanup, 0, sizeof(struct policy_node));
-	cleanup.flavor = NODE_CLEANUP;
+	if (res == SELINT_SUCCESS) {
+		// Give checks a change to clean up state
+		struct policy_node cleanup;
+		memset(&cleanup, 0, sizeof(struct policy_node));
+		cleanup.flavor = NODE_CLEANUP;
 
-	return call_checks(ck, data, &cleanup);
+		res = call_checks(ck, data, &cleanup);
+	}
+
+	// Failing files are traced too, with the nodes checked before
+	trace_end(&span, data->filepath, "nodes", nodes);
+
+	return res;
 }
 
-enum selint_error run_all_checks(struct checks *ck, enum file_flavor flavor,
-                                 struct policy_file_list *files,
-                                 const struct config_check_data *ccd)
+struct check_job {
+	struct checks *ck;
+	const struct policy_file *file;
+	enum file_flavor flavor;
+	const struct config_check_data *ccd;
+	unsigned int *issue_counts;
+	// Profiles of the checks, if profiling is enabled
+	struct check_profile *profiles;
+	char *output;
+	size_t output_len;
+	struct pending_note *notes;
+	enum selint_error res;
+};
+
+static int check_job_run(void *item)
+{
+	struct check_job *job = item;
+
+	struct check_data data;
+
+	data.flavor = job->flavor;
+	{
+		char *copy = xstrdup(job->file->filename);
+		data.filename = xstrdup(basename(copy));
+		free(copy);
+	}
+	data.mod_name = xstrdup(data.filename);
+	data.filepath = job->file->filename;
+	data.config_check_data = job->ccd;
+
+	char *suffix_ptr = strrchr(data.mod_name, '.');
+
+	*suffix_ptr = '\0';
+
+	// Buffer findings and counts, to report them in file order
+	FILE *out = open_memstream(&job->output, &job->output_len);
+	set_result_stream(out);
+	if (job->ck->check_node_count > 0) {
+		job->issue_counts = xcalloc(job->ck->check_node_count, sizeof(unsigned int));
+	}
+	set_issue_counters(job->issue_counts);
+	set_check_profiles(job->profiles);
+
+	job->res = run_checks_on_one_file(job->ck, &data, job->file->ast);
+
+	set_check_profiles(NULL);
+	set_issue_counters(NULL);
+	job->notes = take_pending_notes();
+	set_result_stream(NULL);
+	if (out) {
+		fclose(out);
+	}
+
+	free(data.filename);
+	free(data.mod_name);
+
+	return job->res == SELINT_SUCCESS;
+}
+
+// Check files concurrently, dispatching their nodes to the selected checks
+// and adding the issues found to the checks they were selected from
+static enum selint_error check_files_concurrently(struct checks *ck, struct checks *selected,
+                                                  enum file_flavor flavor,
+                                                  const struct policy_file_list *files,
+                                                  const struct config_check_data *ccd)
 {
+	if (!files->head) {
+		return SELINT_SUCCESS;
+	}
+
+	const size_t count = file_list_length(files);
+
+	struct check_job *jobs = xcalloc(count, sizeof(struct check_job));
+	size_t i = 0;
+	for (const struct policy_file_node *cur = files->head; cur; cur = cur->next) {
+		jobs[i].ck = selected;
+		jobs[i].file = cur->file;
+		jobs[i].flavor = flavor;
+		jobs[i].ccd = ccd;
+		if (ck->profiles) {
+			jobs[i].profiles = xcalloc(ck->check_node_count, sizeof(struct check_profile));
+		}
+		jobs[i].res = SELINT_SUCCESS;
+		i++;
+	}
+
+	struct work_queue queue = {
+		.items = jobs,
+		.item_size = sizeof(struct check_job),
+		.count = count,
+		.process = check_job_run,
+	};
+	run_work_queue(&queue);
+
+	enum selint_error ret = SELINT_SUCCESS;
+	for (i = 0; i < count; i++) {
+		struct check_job *job = &jobs[i];
+
+		if (ret == SELINT_SUCCESS) {
+			write_result_buffer(job->output, job->output_len, job->notes);
+			if (job->issue_counts) {
+				add_issue_counts(ck, job->issue_counts);
+			}
+			ret = job->res;
+		} else {
+			// A serial run stops at the first file failing
+			free_pending_notes(job->notes);
+		}
+
+		if (job->profiles) {
+			// Unlike issues, profile the files checked after a failure too
+			add_check_profiles(ck, job->profiles);
+		}
+
+		free(job->output);
+		free(job->issue_counts);
+		free(job->profiles);
+	}
 
-	struct policy_file_node *file = files->head;
+	free(jobs);
+
+	return ret;
+}
+
+// Check files one after the other, dispatching their nodes to the selected
+// checks and counting the issues found in counts
+static enum selint_error check_files_serially(struct checks *selected, enum file_flavor flavor,
+                                              const struct policy_file_list *files,
+                                              const struct config_check_data *ccd,
+                                              unsigned int *counts)
+{
+	const struct policy_file_node *file = files->head;
 
 	struct check_data data;
 
 	data.flavor = flavor;
 
+	set_issue_counters(counts);
+
 	while (file) {
 		{
 			char *copy = xstrdup(file->file->filename);
@@ -423,8 +835,9 @@ enum selint_error run_all_checks(struct checks *ck, enum file_flavor flavor,
 		*suffix_ptr = '\0';
 
 		enum selint_error res =
-			run_checks_on_one_file(ck, &data, file->file->ast);
+			run_checks_on_one_file(selected, &data, file->file->ast);
 		if (res != SELINT_SUCCESS) {
+			set_issue_counters(NULL);
 			return res;
 		}
 
@@ -435,34 +848,57 @@ enum selint_error run_all_checks(struct checks *ck, enum file_flavor flavor,
 
 	}
 
+	set_issue_counters(NULL);
+
 	return SELINT_SUCCESS;
 }
 
-enum selint_error run_analysis(struct checks *ck,
-                               struct policy_file_list *te_files,
-                               struct policy_file_list *if_files,
-                               struct policy_file_list *fc_files,
-                               struct policy_file_list *context_te_files,
-                               struct policy_file_list *context_if_files,
-                               const struct string_list *custom_fc_macros,
-                               const struct config_check_data *ccd)
+enum selint_error run_all_checks(struct checks *ck, enum file_flavor flavor,
+                                 struct policy_file_list *files,
+                                 const struct config_check_data *ccd)
 {
-
+	static const char *const span_names[] = {
+		[FILE_TE_FILE] = "check te files",
+		[FILE_IF_FILE] = "check if files",
+		[FILE_FC_FILE] = "check fc files",
+	};
+	struct trace_span span;
+	trace_begin(&span, span_names[flavor]);
+
+	// Leave out the checks not applying to this flavor of files, so they
+	// are not even called
+	struct checks *selected = select_file_checks(ck, flavor);
 	enum selint_error res;
 
-	res = parse_all_files_in_list(if_files, NODE_IF_FILE);
-	if (res != SELINT_SUCCESS) {
-		goto out;
-	}
+	if (parallel_jobs > 1) {
+		res = check_files_concurrently(ck, selected, flavor, files, ccd);
+	} else {
+		unsigned int *counts = NULL;
+		if (ck->check_node_count > 0) {
+			counts = xcalloc(ck->check_node_count, sizeof(unsigned int));
+		}
 
-	// We parse all the context files for the side effects of parsing (populating
-	// the hash tables), and to mark the transform interfaces.  Then we only
-	// run checks on the non-context files
-	res = parse_all_files_in_list(context_if_files, NODE_IF_FILE);
-	if (res != SELINT_SUCCESS) {
-		goto out;
+		set_check_profiles(ck->profiles);
+		res = check_files_serially(selected, flavor, files, ccd, counts);
+		set_check_profiles(NULL);
+
+		if (counts) {
+			add_issue_counts(ck, counts);
+		}
+		free(counts);
 	}
 
+	free_checks(selected);
+
+	trace_list_end(&span, files);
+
+	return res;
+}
+
+// Mark the transform interfaces defined in any of the if files
+static void mark_all_transform_interfaces(struct policy_file_list *if_files,
+                                          struct policy_file_list *context_if_files)
+{
 	// Make temporary joined list to mark ALL transform interfaces
 	struct policy_file_list *all_if_files = xcalloc(1, sizeof(struct policy_file_list));
 	if (if_files->tail) {
@@ -476,46 +912,154 @@ enum selint_error run_analysis(struct checks *ck,
 
 	all_if_files->tail = context_if_files->tail;
 
+	struct trace_span span;
+	trace_begin(&span, "mark transform interfaces");
 	mark_transform_interfaces(all_if_files);
+	trace_list_end(&span, all_if_files);
 
 	// Restore
 	if (if_files->tail) {
 		if_files->tail->next = NULL;
 	}
 	free(all_if_files);
+}
+
+// Parse a list of te or if files, traced as a phase of its own
+static enum selint_error parse_list_phase(const char *phase,
+                                          struct policy_file_list *files,
+                                          enum node_flavor flavor)
+{
+	struct trace_span span;
+	trace_begin(&span, phase);
+
+	enum selint_error res = parse_all_files_in_list(files, flavor);
+
+	trace_list_end(&span, files);
 
-	res = parse_all_files_in_list(context_te_files, NODE_TE_FILE);
+	return res;
+}
+
+enum selint_error parse_analysis_files(struct policy_file_list *te_files,
+                                       struct policy_file_list *if_files,
+                                       struct policy_file_list *fc_files,
+                                       struct policy_file_list *context_te_files,
+                                       struct policy_file_list *context_if_files,
+                                       const struct string_list *custom_fc_macros)
+{
+
+	enum selint_error res;
+
+	res = parse_list_phase("parse if files", if_files, NODE_IF_FILE);
 	if (res != SELINT_SUCCESS) {
-		goto out;
+		return res;
 	}
 
-	res = parse_all_files_in_list(te_files, NODE_TE_FILE);
+	// We parse all the context files for the side effects of parsing (populating
+	// the hash tables), and to mark the transform interfaces.  Then we only
+	// run checks on the non-context files, so the rules of context files are
+	// not kept.  The template map refers to the calls in the templates of
+	// context if files, which are expanded when te files are parsed, so
+	// only the ASTs of context te files are freed once the maps are filled,
+	// unless the retained map changes still refer to them.
+	set_symbols_only(1);
+	res = parse_list_phase("parse context if files", context_if_files, NODE_IF_FILE);
+	set_symbols_only(0);
 	if (res != SELINT_SUCCESS) {
-		goto out;
+		return res;
 	}
 
-	res = parse_all_fc_files_in_list(fc_files, custom_fc_macros);
+	mark_all_transform_interfaces(if_files, context_if_files);
+
+	set_symbols_only(1);
+	res = parse_list_phase("parse context te files", context_te_files, NODE_TE_FILE);
+	set_symbols_only(0);
 	if (res != SELINT_SUCCESS) {
-		goto out;
+		return res;
+	}
+
+	if (!retain_map_changes) {
+		free_file_list_asts(context_te_files);
 	}
 
+	res = parse_list_phase("parse te files", te_files, NODE_TE_FILE);
+	if (res != SELINT_SUCCESS) {
+		return res;
+	}
+
+	struct trace_span span;
+	trace_begin(&span, "parse fc files");
+	res = parse_all_fc_files_in_list(fc_files, custom_fc_macros);
+	trace_list_end(&span, fc_files);
+
+	return res;
+}
+
+enum selint_error check_analysis_files(struct checks *ck,
+                                       struct policy_file_list *te_files,
+                                       struct policy_file_list *if_files,
+                                       struct policy_file_list *fc_files,
+                                       const struct config_check_data *ccd)
+{
+
+	enum selint_error res;
+
 	res = run_all_checks(ck, FILE_TE_FILE, te_files, ccd);
 	if (res != SELINT_SUCCESS) {
-		goto out;
+		return res;
 	}
 
 	res = run_all_checks(ck, FILE_IF_FILE, if_files, ccd);
+	if (res != SELINT_SUCCESS) {
+		return res;
+	}
+
+	return run_all_checks(ck, FILE_FC_FILE, fc_files, ccd);
+}
+
+enum selint_error run_analysis(struct checks *ck,
+                               struct policy_file_list *te_files,
+                               struct policy_file_list *if_files,
+                               struct policy_file_list *fc_files,
+                               struct policy_file_list *context_te_files,
+                               struct policy_file_list *context_if_files,
+                               const struct string_list *custom_fc_macros,
+                               const struct config_check_data *ccd)
+{
+
+	enum selint_error res;
+	struct trace_span span;
+
+	trace_begin(&span, "parse files");
+	res = parse_analysis_files(te_files, if_files, fc_files, context_te_files,
+	                           context_if_files, custom_fc_macros);
+	trace_end(&span, NULL, NULL, 0);
 	if (res != SELINT_SUCCESS) {
 		goto out;
 	}
 
-	res = run_all_checks(ck, FILE_FC_FILE, fc_files, ccd);
+	trace_begin(&span, "check files");
+	res = check_analysis_files(ck, te_files, if_files, fc_files, ccd);
+	trace_end(&span, NULL, NULL, 0);
 	if (res != SELINT_SUCCESS) {
 		goto out;
 	}
 
+	struct atom_stats atoms;
+	get_atom_stats(&atoms);
+	print_if_verbose("Interned %zu identifiers (%zu bytes) for %zu requests (%zu bytes)\n",
+	                 atoms.atoms, atoms.atom_bytes, atoms.requests, atoms.request_bytes);
+
+	if (is_parse_cache_enabled()) {
+		struct parse_cache_stats cache;
+		get_parse_cache_stats(&cache);
+		print_if_verbose("Parse cache: %zu hits, %zu misses, %zu stored\n",
+		                 cache.hits, cache.misses, cache.stores);
+	}
+
 out:
+	trace_begin(&span, "cleanup parsing");
 	cleanup_parsing();
+	trace_end(&span, NULL, NULL, 0);
 
 	return res;
 }
@@ -22,6 +22,12 @@
 #include "parse_functions.h"
 #include "file_list.h"
 
+// Number of threads used to parse and check files
+extern unsigned int parallel_jobs;
+// Keep the map changes caused by parsing each te and if file in its
+// policy_file, so the maps can be rebuilt after a file changed
+extern int retain_map_changes;
+
 /****************************************************
 * Parse a policy file
 * filename - The name of the files to parse.
@@ -30,6 +36,17 @@
 ****************************************************/
 struct policy_node *parse_one_file(const char *filename, enum node_flavor flavor);
 
+/****************************************************
+* Determine which checks are enabled based on the config file and the
+* command line arguments
+* Returns the bits of the enabled checks, see check_bit()
+****************************************************/
+uint64_t enabled_check_bits(const struct string_list *config_enabled_checks,
+                            const struct string_list *config_disabled_checks,
+                            const struct string_list *cl_enabled_checks,
+                            const struct string_list *cl_disabled_checks,
+                            int only_enabled);
+
 /****************************************************
 * Determine whether a specific check is enabled based on the
 * config file and the command line arguments
@@ -94,6 +111,29 @@ enum selint_error run_all_checks(struct checks *ck, enum file_flavor flavor,
                                  struct policy_file_list *files,
                                  const struct config_check_data *ccd);
 
+/****************************************************
+* Parse all files of an analysis, filling the maps.  See run_analysis()
+* for the parameters.
+* Returns SELINT_SUCCESS on success or an error code
+****************************************************/
+enum selint_error parse_analysis_files(struct policy_file_list *te_files,
+                                       struct policy_file_list *if_files,
+                                       struct policy_file_list *fc_files,
+                                       struct policy_file_list *context_te_files,
+                                       struct policy_file_list *context_if_files,
+                                       const struct string_list *custom_fc_macros);
+
+/****************************************************
+* Run all checks on the parsed te, if and fc files of an analysis.  See
+* run_analysis() for the parameters.
+* Returns SELINT_SUCCESS on success or an error code
+****************************************************/
+enum selint_error check_analysis_files(struct checks *ck,
+                                       struct policy_file_list *te_files,
+                                       struct policy_file_list *if_files,
+                                       struct policy_file_list *fc_files,
+                                       const struct config_check_data *ccd);
+
 /****************************************************
 * Run the complete analysis, checking all files and reporting results
 * ck - The checks structure
@@ -0,0 +1,89 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "selint_context.h"
+
+#include <stdlib.h>
+
+#include "check_hooks.h"
+#include "maps.h"
+#include "parse_functions.h"
+#include "perm_macro.h"
+#include "xalloc.h"
+
+static struct selint_context default_context;
+static _Thread_local struct selint_context *current = &default_context;
+
+struct selint_context *selint_context_create(void)
+{
+	struct selint_context *ctx = xcalloc(1, sizeof(struct selint_context));
+
+	ctx->maps = alloc_maps();
+	ctx->perm_macros = alloc_perm_macros();
+
+	return ctx;
+}
+
+struct selint_context *selint_context_switch(struct selint_context *ctx)
+{
+	struct selint_context *prev = current;
+
+	if (ctx == prev) {
+		return prev;
+	}
+
+	prev->maps = switch_maps(ctx->maps);
+	prev->perm_macros = switch_perm_macros(ctx->perm_macros);
+	prev->found_issue = found_issue;
+	prev->suppress_output = suppress_output;
+
+	found_issue = ctx->found_issue;
+	suppress_output = ctx->suppress_output;
+	ctx->maps = NULL;
+	ctx->perm_macros = NULL;
+
+	current = ctx;
+
+	return prev;
+}
+
+void selint_context_use(struct selint_context *ctx)
+{
+	current = ctx;
+}
+
+struct selint_context *selint_context_current(void)
+{
+	return current;
+}
+
+void selint_context_free(struct selint_context *ctx)
+{
+	if (!ctx || ctx == current) {
+		return;
+	}
+
+	// The state of the default context is emptied, but stays usable
+	free_maps(ctx->maps);
+	free_perm_macros(ctx->perm_macros);
+	free_av_commons(ctx);
+	free_if_call_list_and_data(ctx->snapshot_calls);
+	ctx->snapshot_calls = NULL;
+
+	if (ctx != &default_context) {
+		free(ctx);
+	}
+}
@@ -0,0 +1,71 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#ifndef SELINT_CONTEXT_H
+#define SELINT_CONTEXT_H
+
+/**********************************
+* The state built while loading a policy and checking it: the declaration,
+* interface and template maps, the permission macro tables, and whether an
+* issue was found or output is suppressed.  The parse, startup and check
+* functions work on the current context, which is shared by all threads.
+*
+* Each thread starts with a default context.  Tools linking libselint can
+* keep a context per policy, or load the context files of a policy once and
+* check many inputs against it, by switching contexts between runs.
+* Switching while files are parsed or checked is not supported.  The worker
+* threads parsing or checking files use the context of the thread starting
+* them, see selint_context_use().
+* Interned strings (see intern.h) are shared by all contexts.
+**********************************/
+struct av_common;
+struct if_call_list;
+struct maps;
+struct perm_macros;
+
+struct selint_context {
+	// While a context is current, the state of these fields lives in the
+	// modules owning it, and the fields are only valid for other contexts
+	struct maps *maps;
+	struct perm_macros *perm_macros;
+	int found_issue;
+	int suppress_output;
+
+	// These fields are always used through the context
+	struct av_common *av_commons;           // see insert_av_common()
+	struct if_call_list *snapshot_calls;    // see load_context_snapshot()
+	int symbols_only;                       // see set_symbols_only()
+};
+
+// Create an empty context
+struct selint_context *selint_context_create(void);
+
+// Make ctx the current context of the calling thread, and return the
+// previous one
+struct selint_context *selint_context_switch(struct selint_context *ctx);
+
+// Make ctx, the current context of another thread, the current context of
+// the calling thread too, e.g. in a worker thread started by the other one
+void selint_context_use(struct selint_context *ctx);
+
+// Return the current context
+struct selint_context *selint_context_current(void);
+
+// Free the state of a context, which must not be current
+void selint_context_free(struct selint_context *ctx);
+
+#endif
@@ -0,0 +1,252 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "serialize.h"
+#include "util.h"
+#include "xalloc.h"
+
+#define TMP_NAME SERIAL_TMP_PREFIX "XXXXXX"
+
+void serial_hash_init(uint64_t hash[2])
+{
+	hash[0] = 0xcbf29ce484222325u;
+	hash[1] = 0;
+}
+
+no_sanitize_unsigned_integer_
+void serial_hash_bytes(uint64_t hash[2], const void *data, size_t len)
+{
+	const unsigned char *bytes = data;
+
+	for (size_t i = 0; i < len; i++) {
+		hash[0] ^= bytes[i];
+		hash[0] *= 0x100000001b3u;
+		hash[1] = (hash[1] ^ bytes[i]) * 0x9e3779b97f4a7c15u;
+		hash[1] = (hash[1] << 29) | (hash[1] >> 35);
+	}
+}
+
+static uint64_t checksum(const unsigned char *data, size_t len)
+{
+	uint64_t hash[2];
+
+	serial_hash_init(hash);
+	serial_hash_bytes(hash, data, len);
+
+	return hash[0];
+}
+
+/*
+ * Writing
+ */
+
+void serial_put_bytes(struct serial_writer *w, const void *data, size_t len)
+{
+	if (w->len + len > w->cap) {
+		while (w->len + len > w->cap) {
+			w->cap = w->cap ? w->cap * 2 : 4096;
+		}
+		w->buf = xrealloc(w->buf, w->cap);
+	}
+
+	if (len > 0) {
+		memcpy(w->buf + w->len, data, len);
+		w->len += len;
+	}
+}
+
+void serial_put_varint(struct serial_writer *w, uint64_t value)
+{
+	unsigned char bytes[10];
+	size_t len = 0;
+
+	do {
+		bytes[len] = value & 0x7f;
+		value >>= 7;
+		if (value) {
+			bytes[len] |= 0x80;
+		}
+		len++;
+	} while (value);
+
+	serial_put_bytes(w, bytes, len);
+}
+
+void serial_put_data(struct serial_writer *w, const void *data, size_t len)
+{
+	serial_put_varint(w, len);
+	serial_put_bytes(w, data, len);
+}
+
+void serial_put_checksum(struct serial_writer *w)
+{
+	const uint64_t sum = checksum(w->buf, w->len);
+	unsigned char sum_bytes[SERIAL_CHECKSUM_LEN];
+
+	for (unsigned int i = 0; i < SERIAL_CHECKSUM_LEN; i++) {
+		sum_bytes[i] = (unsigned char)(sum >> (8 * i));
+	}
+
+	serial_put_bytes(w, sum_bytes, SERIAL_CHECKSUM_LEN);
+}
+
+void free_serial_writer(struct serial_writer *w)
+{
+	free(w->buf);
+	w->buf = NULL;
+	w->len = 0;
+	w->cap = 0;
+}
+
+static int write_all(int fd, const unsigned char *data, size_t len)
+{
+	while (len > 0) {
+		const ssize_t written = write(fd, data, len);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return 0;
+		}
+		data += written;
+		len -= (size_t)written;
+	}
+
+	return 1;
+}
+
+enum selint_error serial_write_file(const char *path, const unsigned char *data, size_t len)
+{
+	// The temporary file is hidden in the directory of path
+	const char *slash = strrchr(path, '/');
+	const size_t dir_len = slash ? (size_t)(slash - path) + 1 : 0;
+	char *tmp_path = xmalloc(dir_len + sizeof(TMP_NAME));
+	memcpy(tmp_path, path, dir_len);
+	memcpy(tmp_path + dir_len, TMP_NAME, sizeof(TMP_NAME));
+
+	const int fd = mkstemp(tmp_path);
+	if (fd < 0) {
+		free(tmp_path);
+		return SELINT_IO_ERROR;
+	}
+
+	// mkstemp() creates files only readable by the owner, but the files
+	// might be shared
+	const int written = fchmod(fd, 0644) == 0 && write_all(fd, data, len);
+	if (close(fd) != 0 || !written || rename(tmp_path, path) != 0) {
+		const int saved_errno = errno;
+		unlink(tmp_path);
+		free(tmp_path);
+		errno = saved_errno;
+		return SELINT_IO_ERROR;
+	}
+
+	free(tmp_path);
+
+	return SELINT_SUCCESS;
+}
+
+/*
+ * Reading
+ */
+
+int serial_check_frame(struct serial_reader *r, const char *magic, size_t magic_len, int *corrupt)
+{
+	if (corrupt) {
+		*corrupt = 0;
+	}
+
+	if ((size_t)(r->end - r->pos) < magic_len + SERIAL_CHECKSUM_LEN ||
+	    memcmp(r->pos, magic, magic_len) != 0) {
+		return 0;
+	}
+
+	uint64_t sum = 0;
+	for (unsigned int i = 0; i < SERIAL_CHECKSUM_LEN; i++) {
+		sum |= (uint64_t)r->end[(int)i - SERIAL_CHECKSUM_LEN] << (8 * i);
+	}
+	if (sum != checksum(r->pos, (size_t)(r->end - r->pos) - SERIAL_CHECKSUM_LEN)) {
+		if (corrupt) {
+			*corrupt = 1;
+		}
+		return 0;
+	}
+
+	r->end -= SERIAL_CHECKSUM_LEN;
+	r->pos += magic_len;
+
+	return 1;
+}
+
+uint64_t serial_get_varint(struct serial_reader *r)
+{
+	uint64_t value = 0;
+
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		if (r->pos == r->end) {
+			break;
+		}
+		const unsigned char byte = *r->pos++;
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			return value;
+		}
+	}
+
+	r->failed = 1;
+	return 0;
+}
+
+uint64_t serial_get_bounded(struct serial_reader *r, uint64_t max)
+{
+	const uint64_t value = serial_get_varint(r);
+
+	if (value > max) {
+		r->failed = 1;
+		return 0;
+	}
+
+	return value;
+}
+
+const unsigned char *serial_get_data(struct serial_reader *r, uint64_t *len)
+{
+	*len = serial_get_varint(r);
+
+	if (*len == 0 || r->failed) {
+		*len = 0;
+		return NULL;
+	}
+
+	if (*len > (uint64_t)(r->end - r->pos)) {
+		r->failed = 1;
+		*len = 0;
+		return NULL;
+	}
+
+	const unsigned char *data = r->pos;
+	r->pos += *len;
+
+	return data;
+}
@@ -0,0 +1,98 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "selint_error.h"
+
+/**********************************
+* Building blocks of the files SELint stores between runs, the parse cache
+* entries and the context snapshots.  Files start with a magic, followed by
+* varints and data, and end with a checksum of everything before it.
+* Varints are LEB128, so the files do not depend on the byte order or word
+* size of the host.
+**********************************/
+
+#define SERIAL_CHECKSUM_LEN 8
+
+// Names of the temporary files serial_write_file() creates start with it
+#define SERIAL_TMP_PREFIX ".tmp-"
+
+struct serial_writer {
+	unsigned char *buf;
+	size_t len;
+	size_t cap;
+};
+
+struct serial_reader {
+	const unsigned char *pos;
+	const unsigned char *end;
+	int failed;     // the data is corrupt
+};
+
+/**********************************
+* Two independent 64 bit hashes, FNV-1a in hash[0] and a multiply-rotate
+* one in hash[1], updated with len bytes of data.  Start from
+* serial_hash_init().
+**********************************/
+void serial_hash_init(uint64_t hash[2]);
+void serial_hash_bytes(uint64_t hash[2], const void *data, size_t len);
+
+void serial_put_bytes(struct serial_writer *w, const void *data, size_t len);
+void serial_put_varint(struct serial_writer *w, uint64_t value);
+
+// Put len as varint followed by len bytes of data
+void serial_put_data(struct serial_writer *w, const void *data, size_t len);
+
+// Append the checksum of everything put so far
+void serial_put_checksum(struct serial_writer *w);
+
+void free_serial_writer(struct serial_writer *w);
+
+/**********************************
+* Write data to path, through a temporary file in the same directory which
+* is renamed, so concurrent readers never see partial files
+* Returns SELINT_IO_ERROR with errno set on failure
+**********************************/
+enum selint_error serial_write_file(const char *path, const unsigned char *data, size_t len);
+
+/**********************************
+* Check that the data of the reader starts with magic and ends with a
+* valid checksum.  On success, the checksum is excluded from the data and
+* the reader is positioned after the magic.
+* Returns 1 on success, or 0 and sets *corrupt, unless corrupt is NULL, if
+* the data starts with magic but its checksum is wrong
+**********************************/
+int serial_check_frame(struct serial_reader *r, const char *magic, size_t magic_len, int *corrupt);
+
+// All getters mark the reader failed and return 0 or NULL on corrupt data
+uint64_t serial_get_varint(struct serial_reader *r);
+
+// Read a varint which must not exceed max
+uint64_t serial_get_bounded(struct serial_reader *r, uint64_t max);
+
+/**********************************
+* Read data put with serial_put_data() and store its length in len
+* Returns a pointer into the data of the reader, or NULL if len is 0
+**********************************/
+const unsigned char *serial_get_data(struct serial_reader *r, uint64_t *len);
+
+#endif
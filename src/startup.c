@@ -25,6 +25,7 @@
 #include "maps.h"
 #include "parse.h"
 #include "parse_functions.h"
+#include "selint_context.h"
 #include "tree.h"
 #include "util.h"
 #include "xalloc.h"
@@ -61,6 +62,12 @@ enum selint_error load_access_vectors_kernel(const char *av_path)
 
 			insert_into_decl_map(file->fts_name, "perm", DECL_PERM);
 
+			// <class>/perms/<perm>
+			if (file->fts_level == 3 && 0 == strcmp(file->fts_parent->fts_name, "perms")) {
+				insert_into_class_perms(file->fts_parent->fts_parent->fts_name,
+				                        file->fts_name);
+			}
+
 			r = SELINT_SUCCESS;
 		}
 		file = fts_read(ftsp);
@@ -85,6 +92,7 @@ enum selint_error load_access_vectors_source(const char *av_path)
 
 	struct policy_node *ast = yyparse_wrapper(f, av_path, NODE_AV_FILE);
 	fclose(f);
+	free_av_commons(selint_context_current());
 
 	if (!ast) {
 		return SELINT_PARSE_ERROR;
@@ -258,40 +266,33 @@ enum selint_error load_obj_perm_sets_source(const char *obj_perm_sets_path)
 	return SELINT_SUCCESS;
 }
 
-static int mark_transform_interfaces_one_file(const struct policy_node *ast) {
-	int marked_transform = 0;
-	const struct policy_node *cur = ast;
-	while (cur) {
-		if (cur->flavor == NODE_INTERFACE_DEF &&
-		    cur->first_child &&
-		    !is_transform_if(cur->data.str)) {
-			const struct policy_node *child = cur->first_child;
-			while (child &&
-			       (child->flavor == NODE_START_BLOCK ||
-			        child->flavor == NODE_REQUIRE ||
-			        child->flavor == NODE_GEN_REQ)) {
-				child = child->next;
-			}
-			if (!child) {
-				// Nothing in interface besides possibly require
-				cur = dfs_next(cur);
-				continue;
-			}
-			if (child->flavor == NODE_IF_CALL) {
-				if (is_transform_if(child->data.ic_data->name)) {
-					mark_transform_if(cur->data.str);
-					marked_transform = 1;
-				}
-			}
-		}
-		cur = dfs_next(cur);
+void insert_mod_layer_of_if_file(const char *path)
+{
+	// The module is named like the file, and its layer like the directory
+	// the file is in
+	const char *slash = strrchr(path, '/');
+	const char *file_name = slash ? slash + 1 : path;
+	const size_t name_len = strlen(file_name);
+
+	if (name_len < 3) {
+		return;
 	}
-	return marked_transform;
+
+	char *mod_name = xstrdup(file_name);
+	mod_name[name_len - 3] = '\0';
+
+	char *layer = xstrndup(path, slash ? (size_t)(slash - path) : 0);
+	const char *layer_slash = strrchr(layer, '/');
+
+	insert_into_mod_layers_map(mod_name, layer_slash ? layer_slash + 1 : layer);
+
+	free(layer);
+	free(mod_name);
 }
 
 enum selint_error load_devel_headers(struct policy_file_list *context_files)
 {
-	char header_loc[] = "/usr/share/selinux/devel";
+	char header_loc[] = DEVEL_HEADERS_DIR;
 	char *const paths[2] = { header_loc, NULL };
 
 	FTS *ftsp = fts_open(paths, FTS_PHYSICAL | FTS_NOSTAT, NULL);
@@ -303,10 +304,7 @@ enum selint_error load_devel_headers(struct policy_file_list *context_files)
 			file_list_push_back(context_files,
 			                    make_policy_file(file->fts_path,
 			                                     NULL));
-			char *mod_name = xstrdup(file->fts_name);
-			mod_name[file->fts_namelen - 3] = '\0';
-			insert_into_mod_layers_map(mod_name, file->fts_parent->fts_name);
-			free(mod_name);
+			insert_mod_layer_of_if_file(file->fts_path);
 		}
 		file = fts_read(ftsp);
 	}
@@ -350,19 +348,20 @@ enum selint_error load_global_conditions(const struct string_list *paths)
 	return SELINT_SUCCESS;
 }
 
+void propagate_transform_interfaces(const struct call_graph *graph)
+{
+	// An interface calling a transform interface first is a transform
+	// interface too
+	propagate_to_callers(graph, is_transform_if, mark_derived_transform_if);
+}
+
 enum selint_error mark_transform_interfaces(const struct policy_file_list *files)
 {
-	const struct policy_file_node *cur;
-	int marked_transform;
-	do {
-		marked_transform = 0;
-		cur = files->head;
-		while (cur) {
-			marked_transform = marked_transform ||
-			                   mark_transform_interfaces_one_file(cur->file->ast);
-			cur = cur->next;
-		}
-	} while (marked_transform);
+	struct call_graph *graph = build_call_graph(files);
+
+	propagate_transform_interfaces(graph);
+
+	free_call_graph(graph);
 
 	return SELINT_SUCCESS;
 }
@@ -18,9 +18,13 @@
 #define STARTUP_H
 
 #include "selint_error.h"
+#include "call_graph.h"
 #include "file_list.h"
 #include "string_list.h"
 
+// Where the development headers of the installed policy are
+#define DEVEL_HEADERS_DIR "/usr/share/selinux/devel"
+
 enum selint_error load_access_vectors_kernel(const char *av_path);
 
 enum selint_error load_access_vectors_source(const char *av_path);
@@ -33,10 +37,21 @@ enum selint_error load_modules_source(const char *modules_conf_path);
 
 enum selint_error load_obj_perm_sets_source(const char *obj_perm_sets_path);
 
+/**********************************
+* Record the layer of the module defined by an if file, which is the
+* directory the file is in, e.g. kernel for policy/modules/kernel/files.if
+* path - The path of the if file
+**********************************/
+void insert_mod_layer_of_if_file(const char *path);
+
 enum selint_error load_devel_headers(struct policy_file_list *context_files);
 
 enum selint_error load_global_conditions(const struct string_list *paths);
 
 enum selint_error mark_transform_interfaces(const struct policy_file_list *files);
 
+// Like mark_transform_interfaces(), with the call graph of the files built
+// already, e.g. kept up to date across the rounds of watch mode
+void propagate_transform_interfaces(const struct call_graph *graph);
+
 #endif
@@ -15,12 +15,32 @@
 */
 
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
+#include "intern.h"
 #include "string_list.h"
+#include "util.h"
 #include "xalloc.h"
 
+// Lists built while parsing into an arena are owned by that arena
+static struct string_list *alloc_sl_cell(struct arena *arena)
+{
+	struct string_list *ret;
+
+	if (arena) {
+		ret = arena_alloc(arena, sizeof(struct string_list));
+		ret->arena_owned = 1;
+	} else {
+		ret = xmalloc(sizeof(struct string_list));
+		ret->arena_owned = 0;
+	}
+
+	return ret;
+}
+
 int str_in_sl(const char *str, const struct string_list *sl)
 {
 
@@ -28,8 +48,24 @@ int str_in_sl(const char *str, const struct string_list *sl)
 		return 0;
 	}
 
+	// Atoms are equal by address, so only strings not interned are compared.
+	// If str was never interned, no atom can match.
+	const char *atom = NULL;
+	int atom_known = 0;
+
 	while (sl) {
-		if (0 == strcmp(sl->string, str)) {
+		if (sl->string == str) {
+			return 1;
+		}
+		if (sl->interned) {
+			if (!atom_known) {
+				atom = find_atom(str);
+				atom_known = 1;
+			}
+			if (sl->string == atom) {
+				return 1;
+			}
+		} else if (0 == strcmp(sl->string, str)) {
 			return 1;
 		}
 		sl = sl->next;
@@ -37,21 +73,28 @@ int str_in_sl(const char *str, const struct string_list *sl)
 	return 0;
 }
 
+const char *sl_atom(const struct string_list *cell)
+{
+	return cell->interned ? cell->string : find_atom(cell->string);
+}
+
 struct string_list *copy_string_list(const struct string_list *sl)
 {
 	if (!sl) {
 		return NULL;
 	}
-	struct string_list *ret = xmalloc(sizeof(struct string_list));
+	struct arena *arena = get_active_arena();
+	struct string_list *ret = alloc_sl_cell(arena);
 	struct string_list *cur = ret;
 
 	while (sl) {
-		cur->string = xstrdup(sl->string);
+		cur->string = sl->interned ? sl->string : intern(sl->string);
+		cur->interned = 1;
 		cur->has_incorrect_space = sl->has_incorrect_space;
 		cur->arg_start = sl->arg_start;
 
 		if (sl->next) {
-			cur->next = xmalloc(sizeof(struct string_list));
+			cur->next = alloc_sl_cell(arena);
 		} else {
 			cur->next = NULL;
 		}
@@ -63,8 +106,9 @@ struct string_list *copy_string_list(const struct string_list *sl)
 
 struct string_list *sl_from_str(const char *string)
 {
-	struct string_list *ret = xmalloc(sizeof(struct string_list));
-	ret->string = xstrdup(string);
+	struct string_list *ret = alloc_sl_cell(get_active_arena());
+	ret->string = intern(string);
+	ret->interned = 1;
 	ret->next = NULL;
 	ret->has_incorrect_space = 0;
 	ret->arg_start = 0;
@@ -74,8 +118,21 @@ struct string_list *sl_from_str(const char *string)
 
 struct string_list *sl_from_strn(const char *string, size_t len)
 {
-	struct string_list *ret = xmalloc(sizeof(struct string_list));
-	ret->string = xstrndup(string, len);
+	struct string_list *ret = alloc_sl_cell(get_active_arena());
+	ret->string = intern_n(string, len);
+	ret->interned = 1;
+	ret->next = NULL;
+	ret->has_incorrect_space = 0;
+	ret->arg_start = 0;
+
+	return ret;
+}
+
+struct string_list *sl_from_atom(const char *atom)
+{
+	struct string_list *ret = alloc_sl_cell(get_active_arena());
+	ret->string = atom;
+	ret->interned = 1;
 	ret->next = NULL;
 	ret->has_incorrect_space = 0;
 	ret->arg_start = 0;
@@ -85,12 +142,15 @@ struct string_list *sl_from_strn(const char *string, size_t len)
 
 struct string_list *sl_from_str_consume(char *string)
 {
-	struct string_list *ret = xmalloc(sizeof(struct string_list));
-	ret->string = string;
+	struct string_list *ret = alloc_sl_cell(get_active_arena());
+	ret->string = intern(string);
+	ret->interned = 1;
 	ret->next = NULL;
 	ret->has_incorrect_space = 0;
 	ret->arg_start = 0;
 
+	free(string);
+
 	return ret;
 }
 
@@ -152,7 +212,13 @@ void free_string_list(struct string_list *list)
 	while (cur) {
 		struct string_list *to_free = cur;
 		cur = cur->next;
-		free(to_free->string);
-		free(to_free);
+		if (!to_free->interned) {
+IGNORE_CONST_DISCARD_BEGIN
+			free(to_free->string);
+IGNORE_CONST_DISCARD_END
+		}
+		if (!to_free->arena_owned) {
+			free(to_free);
+		}
 	}
 }
@@ -22,14 +22,23 @@
 #include "selint_error.h"
 
 struct string_list {
-	char *string;
+	const char *string;     // owned unless interned
 	struct string_list *next;
 	uint8_t has_incorrect_space;
 	uint8_t arg_start;
+	uint8_t arena_owned;    // cell is freed with an arena
+	uint8_t interned;       // string is an atom, see intern.h
 };
 
 int str_in_sl(const char *str, const struct string_list *sl);
 
+// Return the atom (see intern.h) of the string of cell, or NULL if the
+// string was never interned
+const char *sl_atom(const struct string_list *cell);
+
+// Lists created by the functions below hold atoms (see intern.h),
+// which are shared instead of copied
+
 // Return an identical copy of sl
 struct string_list *copy_string_list(const struct string_list *sl);
 
@@ -37,6 +46,10 @@ struct string_list *copy_string_list(const struct string_list *sl);
 struct string_list *sl_from_str(const char *string);
 struct string_list *sl_from_strn(const char *string, size_t len);
 
+// Return a string list with the given atom (see intern.h) as single item,
+// without looking it up again
+struct string_list *sl_from_atom(const char *atom);
+
 // Return a string list with the given string as single item
 // Takes ownership of the given string
 struct string_list *sl_from_str_consume(char *string);
@@ -53,6 +66,8 @@ struct string_list *concat_string_lists(struct string_list *head, struct string_
 // situations with multiple appends, you should save a pointer to the end of the list
 enum selint_error append_to_sl(struct string_list *sl, const char *string);
 
+// Cells allocated while an arena is active (see arena.h) are left to the arena
+// and atoms are never freed
 void free_string_list(struct string_list *list);
 
 #endif
@@ -16,9 +16,12 @@
 
 #include <ctype.h>
 #include <stdio.h>
+#include <string.h>
+#include <uthash.h>
 
 #include "color.h"
 #include "te_checks.h"
+#include "intern.h"
 #include "maps.h"
 #include "tree.h"
 #include "ordering.h"
@@ -59,7 +62,8 @@ struct check_result *check_excluding_av_rule(__attribute__((unused)) const struc
 		for (; args; args = args->next) {
 			// only check if the first section argument is a type or attribute
 			if (args->arg_start) {
-				check_current = look_up_in_decl_map(args->string, DECL_TYPE) || look_up_in_decl_map(args->string, DECL_ATTRIBUTE);
+				const char *atom = sl_atom(args);
+				check_current = look_up_atom_in_decl_map(atom, DECL_TYPE) || look_up_atom_in_decl_map(atom, DECL_ATTRIBUTE);
 				continue;
 			}
 
@@ -86,8 +90,9 @@ struct check_result *check_te_order(const struct check_data *data,
 		return NULL;
 	}
 
-	static struct ordering_metadata *order_data;
-	static unsigned int order_node_arr_index;
+	// per thread, since files are checked concurrently
+	static _Thread_local struct ordering_metadata *order_data;
+	static _Thread_local unsigned int order_node_arr_index;
 
 	switch (node->flavor) {
 	case NODE_TE_FILE:
@@ -211,7 +216,7 @@ struct check_result *check_no_self(__attribute__((unused)) const struct check_da
 		if (!ends_with(av_data->sources->string, strlen(av_data->sources->string), "_t", 2)) {
 			return NULL;
 		}
-	} else if (!look_up_in_decl_map(av_data->sources->string, DECL_TYPE)) {
+	} else if (!look_up_atom_in_decl_map(sl_atom(av_data->sources), DECL_TYPE)) {
 		// skip attributes
 		return NULL;
 	}
@@ -235,7 +240,7 @@ struct check_result *check_foreign_cond_id(const struct check_data
 	for (const struct string_list *ids = identifiers; ids; ids = ids->next) {
 		const char *id = ids->string;
 
-		const char *mod_name = look_up_in_decl_map(id, DECL_BOOL);
+		const char *mod_name = look_up_atom_in_decl_map(sl_atom(ids), DECL_BOOL);
 
 		/* Ignore non-existent identifiers, covered by W-012 */
 		if (mod_name == NULL) {
@@ -460,59 +465,190 @@ struct check_result *check_perm_macro_available(__attribute__((unused)) const st
 	return res;
 }
 
-// Helper for check_no_explicit_declaration.  Returns 1 is there is a require block
-// for name earlier in the file, and 0 otherwise
-static int has_require(const struct policy_node *node, const char *name, enum decl_flavor flavor)
+// The names required by the require blocks in scope of the node checked by
+// W-001: the blocks enclosing it and the blocks among the preceding siblings
+// of the node or of one of its ancestors.  It is built incrementally, as the
+// nodes are checked in depth first order: the names of a require block are
+// added when it is visited and dropped when the walk leaves the level of the
+// block.  Per thread, since files are checked concurrently.
+struct require_key {
+	const char *name;       // atom
+	enum decl_flavor flavor;
+};
+
+struct require_entry {
+	struct require_key key;
+	unsigned int count;     // the number of blocks in scope requiring it
+	UT_hash_handle hh;
+};
+
+struct require_scopes {
+	const struct policy_node *next;         // the first node not yet visited
+	struct require_entry *required;
+	struct require_entry **added;           // in the order the names were added
+	size_t added_count;
+	size_t added_capacity;
+	size_t *marks;                          // added_count when entering each level
+	size_t depth;
+	size_t marks_capacity;
+};
+
+static _Thread_local struct require_scopes req_scopes;
+
+static void reset_require_scopes(const struct policy_node *first)
 {
-	const struct policy_node *cur = node;
-	while (cur) {
-		if (cur->flavor == NODE_REQUIRE || cur->flavor == NODE_GEN_REQ) {
-			cur = cur->first_child;
-			while (1) {
-				if (cur->flavor == NODE_DECL && cur->data.d_data->flavor == flavor) {
-					if (0 == strcmp(name, cur->data.d_data->name)) {
-						return 1;
-					}
-					struct string_list *other_types = cur->data.d_data->attrs; // In requires these
-					                                                           // are types, not
-					                                                           // attributes
-					while (other_types) {
-						if (0 == strcmp(name, other_types->string)) {
-							return 1;
-						}
-						other_types = other_types->next;
-					}
-				}
-				if (cur->next) {
-					cur = cur->next;
-				} else {
-					break;
-				}
-			}
-			// Not found in this require block, keep going
-			cur = cur->parent;
-			if (!cur) {
-				break;
-			}
+	struct require_entry *entry, *tmp;
+	HASH_ITER(hh, req_scopes.required, entry, tmp) {
+		HASH_DEL(req_scopes.required, entry);
+		free(entry);
+	}
+	free(req_scopes.added);
+	free(req_scopes.marks);
+	memset(&req_scopes, 0, sizeof(req_scopes));
+	req_scopes.next = first;
+}
+
+static void add_required(const char *atom, enum decl_flavor flavor)
+{
+	struct require_key key;
+	memset(&key, 0, sizeof(key));
+	key.name = atom;
+	key.flavor = flavor;
+	if (!key.name) {
+		// Never used as a name, so it can not be looked up
+		return;
+	}
+
+	struct require_entry *entry;
+	HASH_FIND(hh, req_scopes.required, &key, sizeof(key), entry);
+	if (!entry) {
+		entry = xcalloc(1, sizeof(struct require_entry));
+		entry->key = key;
+		HASH_ADD(hh, req_scopes.required, key, sizeof(key), entry);
+	}
+	entry->count++;
+
+	if (req_scopes.added_count == req_scopes.added_capacity) {
+		req_scopes.added_capacity = req_scopes.added_capacity ? 2 * req_scopes.added_capacity : 32;
+		req_scopes.added = xrealloc(req_scopes.added, req_scopes.added_capacity * sizeof(struct require_entry *));
+	}
+	req_scopes.added[req_scopes.added_count++] = entry;
+}
+
+static void enter_level(void)
+{
+	if (req_scopes.depth == req_scopes.marks_capacity) {
+		req_scopes.marks_capacity = req_scopes.marks_capacity ? 2 * req_scopes.marks_capacity : 16;
+		req_scopes.marks = xrealloc(req_scopes.marks, req_scopes.marks_capacity * sizeof(size_t));
+	}
+	req_scopes.marks[req_scopes.depth++] = req_scopes.added_count;
+}
+
+static void leave_level(void)
+{
+	size_t mark = req_scopes.marks[--req_scopes.depth];
+	while (req_scopes.added_count > mark) {
+		struct require_entry *entry = req_scopes.added[--req_scopes.added_count];
+		if (--entry->count == 0) {
+			HASH_DEL(req_scopes.required, entry);
+			free(entry);
 		}
-		if (cur->prev) {
-			cur = cur->prev;
-		} else {
-			cur = cur->parent;
+	}
+}
+
+static void visit_require_scope(const struct policy_node *cur)
+{
+	if (cur->flavor != NODE_REQUIRE && cur->flavor != NODE_GEN_REQ) {
+		return;
+	}
+
+	for (const struct policy_node *child = cur->first_child; child; child = child->next) {
+		if (child->flavor != NODE_DECL) {
+			continue;
+		}
+		const struct declaration_data *d_data = child->data.d_data;
+		add_required(find_atom(d_data->name), d_data->flavor);
+		// In requires these are types, not attributes
+		for (const struct string_list *other = d_data->attrs; other; other = other->next) {
+			add_required(sl_atom(other), d_data->flavor);
 		}
 	}
-	return 0;
 }
 
+// Same order as dfs_next, keeping track of the levels entered and left
+static const struct policy_node *next_require_scope(const struct policy_node *cur)
+{
+	if (cur->first_child) {
+		enter_level();
+		return cur->first_child;
+	}
+	while (!cur->next) {
+		cur = cur->parent;
+		if (!cur) {
+			return NULL;
+		}
+		leave_level();
+	}
+	return cur->next;
+}
+
+static int visit_require_scopes_before(const struct policy_node *node)
+{
+	const struct policy_node *cur = req_scopes.next;
+
+	for (; cur && cur != node; cur = next_require_scope(cur)) {
+		visit_require_scope(cur);
+	}
+
+	req_scopes.next = cur;
+
+	return cur == node;
+}
+
+static const struct policy_node *first_node_in_file(const struct policy_node *node)
+{
+	while (node->parent) {
+		node = node->parent;
+	}
+	while (node->prev) {
+		node = node->prev;
+	}
+	return node;
+}
+
+// Helper for check_no_explicit_declaration.  Returns 1 is there is a require block
+// for name earlier in the file in scope of the node, and 0 otherwise
+static int has_require(const struct policy_node *node, const char *name, enum decl_flavor flavor)
+{
+	if (!visit_require_scopes_before(node)) {
+		// Not checked in depth first order, so start over
+		reset_require_scopes(first_node_in_file(node));
+		visit_require_scopes_before(node);
+	}
+
+	struct require_key key;
+	memset(&key, 0, sizeof(key));
+	key.name = name;
+	key.flavor = flavor;
+
+	const struct require_entry *entry;
+	HASH_FIND(hh, req_scopes.required, &key, sizeof(key), entry);
+	return entry != NULL;
+}
 
 struct check_result *check_no_explicit_declaration(const struct check_data *data,
                                                    const struct policy_node *node)
 {
+	if (node->flavor == NODE_CLEANUP) {
+		reset_require_scopes(NULL);
+		return NULL;
+	}
+
 	if (data->flavor != FILE_TE_FILE) {
 		return NULL;
 	}
 
-	struct name_list *names = get_names_in_node(node);
+	const struct name_list *names = get_names_in_node(node);
 
 	const struct name_list *name = names;
 	/* In declarations skip the first name, which is the new declared type */
@@ -525,13 +661,13 @@ struct check_result *check_no_explicit_declaration(const struct check_data *data
 		const char *mod_name;
 		enum decl_flavor flavor;
 
-		if (name_is_type(ndata) && (mod_name = look_up_in_decl_map(ndata->name, DECL_TYPE))) {
+		if (name_is_type(ndata) && (mod_name = look_up_atom_in_decl_map(ndata->name, DECL_TYPE))) {
 			flavor = DECL_TYPE;
-		} else if (name_is_typeattr(ndata) && (mod_name = look_up_in_decl_map(ndata->name, DECL_ATTRIBUTE))) {
+		} else if (name_is_typeattr(ndata) && (mod_name = look_up_atom_in_decl_map(ndata->name, DECL_ATTRIBUTE))) {
 			flavor = DECL_ATTRIBUTE;
-		} else if (name_is_roleattr(ndata) && (mod_name = look_up_in_decl_map(ndata->name, DECL_ATTRIBUTE_ROLE))) {
+		} else if (name_is_roleattr(ndata) && (mod_name = look_up_atom_in_decl_map(ndata->name, DECL_ATTRIBUTE_ROLE))) {
 			flavor = DECL_ATTRIBUTE_ROLE;
-		} else if (name_is_class(ndata) && look_up_in_decl_map(ndata->name, DECL_CLASS)) {
+		} else if (name_is_class(ndata) && look_up_atom_in_decl_map(ndata->name, DECL_CLASS)) {
 			// Ignore kernel classes
 			if (!userspace_class_support || !is_userspace_class(ndata->name, ndata->traits)) {
 				continue;
@@ -559,14 +695,12 @@ struct check_result *check_no_explicit_declaration(const struct check_data *data
 					                           "No explicit declaration for %s from module %s.  You should access it via interface call or use a require block.",
 					                           ndata->name, mod_name);
 				}
-				free_name_list(names);
 				return to_ret;
 			}
 			// Otherwise, keep checking other names in this node
 		}
 	}
 
-	free_name_list(names);
 	return NULL;
 }
 
@@ -645,13 +779,14 @@ struct check_result *check_space_if_call_arg(__attribute__((unused)) const struc
 	while (args) {
 		if (args->has_incorrect_space) {
 			// do not issue on mls ranges
+			const char *prev_atom = prev ? sl_atom(prev) : NULL;
 			if (prev &&
 			    (args->string[0] != '-' ||
-			    look_up_in_decl_map(prev->string, DECL_TYPE) ||
-			    look_up_in_decl_map(prev->string, DECL_ATTRIBUTE) ||
-			    look_up_in_decl_map(prev->string, DECL_ROLE) ||
-			    look_up_in_decl_map(prev->string, DECL_ATTRIBUTE_ROLE) ||
-			    look_up_in_decl_map(prev->string, DECL_USER))) {
+			    look_up_atom_in_decl_map(prev_atom, DECL_TYPE) ||
+			    look_up_atom_in_decl_map(prev_atom, DECL_ATTRIBUTE) ||
+			    look_up_atom_in_decl_map(prev_atom, DECL_ROLE) ||
+			    look_up_atom_in_decl_map(prev_atom, DECL_ATTRIBUTE_ROLE) ||
+			    look_up_atom_in_decl_map(prev_atom, DECL_USER))) {
 
 				return make_check_result('W',
 							 W_ID_SPACE_IF_CALL_ARG,
@@ -829,7 +964,7 @@ struct check_result *check_unknown_cond_id(__attribute__((unused)) const struct
 			continue;
 		}
 
-		if (look_up_in_decl_map(id, DECL_BOOL) != NULL) {
+		if (look_up_atom_in_decl_map(sl_atom(ids), DECL_BOOL) != NULL) {
 			continue;
 		}
 
@@ -916,8 +1051,19 @@ struct check_result *check_unknown_permission(__attribute__((unused)) const stru
 			continue;
 		}
 
-		if (look_up_in_decl_map(cur->string, DECL_PERM)) {
-			// TODO: check if class supports this permission
+		const char *perm_atom = sl_atom(cur);
+
+		if (look_up_atom_in_decl_map(perm_atom, DECL_PERM)) {
+			// Classes without recorded permissions, class sets and
+			// arguments are not known, and so not checked
+			for (const struct string_list *class = node->data.av_data->object_classes; class; class = class->next) {
+				const char *class_atom = sl_atom(class);
+				if (0 == class_has_perm(class_atom, perm_atom)) {
+					return make_check_result('E', E_ID_UNKNOWN_PERM,
+								 "Permission %s is not defined for class %s",
+								 cur->string, class->string);
+				}
+			}
 			continue;
 		}
 
@@ -976,7 +1122,7 @@ struct check_result *check_unknown_class(__attribute__((unused)) const struct ch
 			continue;
 		}
 
-		if (look_up_in_decl_map(cur->string, DECL_CLASS)) {
+		if (look_up_atom_in_decl_map(sl_atom(cur), DECL_CLASS)) {
 			continue;
 		}
 
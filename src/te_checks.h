@@ -137,7 +137,8 @@ struct check_result *check_perm_macro_available(const struct check_data *data,
 * handled by W-002 and E-005 respectively.
 * This situation typically results in a compilation error, but in the event
 * that an earlier interface call required the type it would not.
-* Called on allow rule and interface call nodes.
+* Called on allow rule and interface call nodes, and on NODE_CLEANUP to free
+* the index of the required names.
 * data - metadata about the file currently being scanned
 * node - the node to check
 * returns NULL if passed or check_result for issue W-001
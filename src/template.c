@@ -14,14 +14,18 @@
 * limitations under the License.
 */
 
+#include <assert.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <math.h>
+#include <uthash.h>
 
 #include "template.h"
+#include "intern.h"
 #include "maps.h"
+#include "util.h"
 #include "xalloc.h"
 
 char *replace_m4(const char *orig, const struct string_list *args)
@@ -93,58 +97,173 @@ struct string_list *replace_m4_list(const struct string_list *replace_with,
 	return ret;
 }
 
-enum selint_error add_template_declarations(const char *template_name,
-                                            const struct string_list *args,
-                                            struct string_list *parent_temp_names,
-                                            const char *mod_name)
+// Templates being expanded, to detect loops.  The entries live on the stack
+// of expand_template().
+struct expanding_template {
+	const char *name;
+	UT_hash_handle hh;
+};
+
+static _Thread_local struct expanding_template *expanding_templates = NULL;
+
+// The key of a template call in the expansion cache: the template name and
+// the arguments, each terminated by a NUL
+static char *expansion_key(const char *template_name, const struct string_list *args,
+                           size_t *key_len)
 {
-	struct string_list *cur = parent_temp_names;
+	size_t len = strlen(template_name) + 1;
 
-	while (cur) {
-		if (strcmp(cur->string, template_name) == 0) {
-			// Loop
-			free_string_list(parent_temp_names);
-			return SELINT_IF_CALL_LOOP;
-		}
-		cur = cur->next;
+	for (const struct string_list *cur = args; cur; cur = cur->next) {
+		len += (cur->string ? strlen(cur->string) : 0) + 1;
+	}
+
+	char *key = xmalloc(len);
+	size_t pos = strlen(template_name) + 1;
+
+	memcpy(key, template_name, pos);
+	for (const struct string_list *cur = args; cur; cur = cur->next) {
+		const char *arg = cur->string ? cur->string : "";
+		const size_t arg_len = strlen(arg) + 1;
+
+		memcpy(key + pos, arg, arg_len);
+		pos += arg_len;
+	}
+
+	*key_len = len;
+	return key;
+}
+
+static void append_expanded_decl(struct template_expansion *expansion, size_t *capacity,
+                                 const char *name, enum decl_flavor flavor)
+{
+	if (expansion->count == *capacity) {
+		*capacity = *capacity ? 2 * *capacity : 8;
+		expansion->names = xrealloc(expansion->names, *capacity * sizeof(const char *));
+		expansion->flavors = xrealloc(expansion->flavors, *capacity * sizeof(enum decl_flavor));
+	}
+
+	expansion->names[expansion->count] = name;
+	expansion->flavors[expansion->count] = flavor;
+	expansion->count++;
+}
+
+// Expand the declarations of a template call, including the ones of nested
+// calls.  Each expansion is cached, so a call with the same arguments is
+// only expanded once.
+no_sanitize_unsigned_integer_
+static enum selint_error expand_template(const char *template_name,
+                                         const struct string_list *args,
+                                         const struct template_expansion **out)
+{
+	size_t key_len;
+	char *key = expansion_key(template_name, args, &key_len);
+
+	const struct template_expansion *cached = look_up_template_expansion(key, key_len);
+	if (cached) {
+		free(key);
+		*out = cached;
+		return SELINT_SUCCESS;
+	}
+
+	struct expanding_template *loop;
+	HASH_FIND_STR(expanding_templates, template_name, loop);
+	if (loop) {
+		free(key);
+		return SELINT_IF_CALL_LOOP;
 	}
 
-	cur = xcalloc(1, sizeof(struct string_list));
-	cur->string = xstrdup(template_name);
-	cur->next = parent_temp_names;
+	struct expanding_template self = { .name = template_name };
+	HASH_ADD_KEYPTR(hh, expanding_templates, self.name, strlen(self.name), &self);
 
-	const struct if_call_list *calls =
-		look_up_call_in_template_map(template_name);
+	struct template_expansion expansion = { NULL, NULL, 0 };
+	size_t capacity = 0;
+	enum selint_error res = SELINT_SUCCESS;
 
-	while (calls) {
+	for (const struct if_call_list *calls = look_up_call_in_template_map(template_name);
+	     calls; calls = calls->next) {
 		struct string_list *new_args =
 			replace_m4_list(args, calls->call->args);
+		const struct template_expansion *called;
 
-		enum selint_error res =
-			add_template_declarations(calls->call->name, new_args, cur,
-			                          mod_name);
+		res = expand_template(calls->call->name, new_args, &called);
 		free_string_list(new_args);
 		if (res != SELINT_SUCCESS) {
-			return res;
+			goto cleanup;
 		}
 
-		calls = calls->next;
+		for (size_t i = 0; i < called->count; i++) {
+			append_expanded_decl(&expansion, &capacity, called->names[i], called->flavors[i]);
+		}
 	}
 
-	const struct decl_list *decls = look_up_decl_in_template_map(template_name);
-
-	while (decls) {
+	for (const struct decl_list *decls = look_up_decl_in_template_map(template_name);
+	     decls; decls = decls->next) {
 		char *new_decl = replace_m4(decls->decl->name, args);
 		if (!new_decl) {
-			free(cur->string);
-			free(cur);
-			return SELINT_M4_SUB_FAILURE;
+			res = SELINT_M4_SUB_FAILURE;
+			goto cleanup;
 		}
-		insert_into_decl_map(new_decl, mod_name, decls->decl->flavor);
+		append_expanded_decl(&expansion, &capacity, intern(new_decl), decls->decl->flavor);
 		free(new_decl);
-		decls = decls->next;
 	}
-	free(cur->string);
-	free(cur);
+
+cleanup:
+	HASH_DELETE(hh, expanding_templates, &self);
+
+	if (res == SELINT_SUCCESS) {
+		*out = insert_template_expansion(key, key_len, &expansion);
+	} else {
+		free(expansion.names);
+		free(expansion.flavors);
+	}
+	free(key);
+	return res;
+}
+
+enum selint_error add_template_declarations(const char *template_name,
+                                            const struct string_list *args,
+                                            const char *mod_name,
+                                            struct template_expansion *added)
+{
+	const struct template_expansion *expansion;
+
+	// The template map and the expansion cache are shared by all threads
+	// without a lock.  Parse workers stage their map changes, and defer
+	// expansions to the thread replaying them, see defer_template_expansion().
+	assert(!is_staging_map_changes());
+
+	enum selint_error res = expand_template(template_name, args, &expansion);
+	if (res != SELINT_SUCCESS) {
+		return res;
+	}
+
+	for (size_t i = 0; i < expansion->count; i++) {
+		insert_into_decl_map(expansion->names[i], mod_name, expansion->flavors[i]);
+	}
+
+	// The cached expansion is dropped once the template map changes, so
+	// copy it
+	if (added) {
+		memset(added, 0, sizeof(struct template_expansion));
+	}
+	if (added && expansion->count > 0) {
+		added->count = expansion->count;
+		added->names = xmalloc(expansion->count * sizeof(const char *));
+		added->flavors = xmalloc(expansion->count * sizeof(enum decl_flavor));
+		memcpy(added->names, expansion->names, expansion->count * sizeof(const char *));
+		memcpy(added->flavors, expansion->flavors, expansion->count * sizeof(enum decl_flavor));
+	}
+
 	return SELINT_SUCCESS;
 }
+
+void remove_template_declarations(struct template_expansion *added)
+{
+	for (size_t i = 0; i < added->count; i++) {
+		remove_from_decl_map(added->names[i], added->flavors[i]);
+	}
+
+	free(added->names);
+	free(added->flavors);
+	memset(added, 0, sizeof(struct template_expansion));
+}
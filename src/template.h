@@ -30,9 +30,24 @@ char *replace_m4(const char *orig, const struct string_list *args);
 struct string_list *replace_m4_list(const struct string_list *replace_with,
                                     const struct string_list *replace_from);
 
+struct template_expansion;
+
+/* Add the declarations of a template call, including the ones of nested template
+ * calls, to the decl map for the module mod_name.  Expansions are cached per
+ * template and arguments.  Returns SELINT_IF_CALL_LOOP if the template calls
+ * itself, directly or indirectly.
+ * If added is not NULL, it is set to a copy of the declarations added, to
+ * remove them again with remove_template_declarations().
+ * The expansion cache is not locked, so this must not run while map changes
+ * are staged, like in a parse worker: such calls are deferred until the
+ * changes are replayed on the main thread. */
 enum selint_error add_template_declarations(const char *template_name,
                                             const struct string_list *args,
-                                            struct string_list *parent_temp_names,
-                                            const char *mod_name);
+                                            const char *mod_name,
+                                            struct template_expansion *added);
+
+/* Remove the declarations a template call added from the decl map, and free
+ * the copy of them in added */
+void remove_template_declarations(struct template_expansion *added);
 
 #endif
@@ -0,0 +1,153 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+static FILE *trace_stream = NULL;
+static uint64_t trace_start_ns;
+static int trace_pid;
+// Serializes writes, and the assignment of thread IDs
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int trace_threads = 0;
+// The thread ID of the calling thread in the trace, or 0 if not assigned yet
+static _Thread_local unsigned int trace_tid = 0;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// Write str as a JSON string
+static void write_json_string(const char *str)
+{
+	fputc('"', trace_stream);
+	for (const unsigned char *c = (const unsigned char *)str; *c; c++) {
+		if (*c == '"' || *c == '\\') {
+			fprintf(trace_stream, "\\%c", *c);
+		} else if (*c < 0x20) {
+			fprintf(trace_stream, "\\u%04x", *c);
+		} else {
+			fputc(*c, trace_stream);
+		}
+	}
+	fputc('"', trace_stream);
+}
+
+// Give the calling thread the next thread ID, and name it in the trace.
+// Called with trace_lock held.
+static void assign_thread_id(void)
+{
+	trace_tid = ++trace_threads;
+
+	fprintf(trace_stream,
+	        ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+	        "\"args\":{\"name\":\"%s %u\"}}",
+	        trace_pid, trace_tid, trace_tid == 1 ? "main" : "worker", trace_tid);
+}
+
+enum selint_error trace_open(const char *path)
+{
+	FILE *stream = fopen(path, "we");
+	if (!stream) {
+		return SELINT_IO_ERROR;
+	}
+
+	pthread_mutex_lock(&trace_lock);
+	trace_stream = stream;
+	trace_start_ns = now_ns();
+	trace_pid = (int)getpid();
+	trace_threads = 0;
+
+	fprintf(trace_stream,
+	        "[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+	        "\"args\":{\"name\":\"selint\"}}",
+	        trace_pid);
+	// The opening thread goes first
+	assign_thread_id();
+	pthread_mutex_unlock(&trace_lock);
+
+	return SELINT_SUCCESS;
+}
+
+bool is_tracing(void)
+{
+	return trace_stream != NULL;
+}
+
+void trace_begin(struct trace_span *span, const char *name)
+{
+	span->name = name;
+	span->start_ns = trace_stream ? now_ns() : 0;
+}
+
+void trace_end(const struct trace_span *span, const char *file,
+               const char *count_name, size_t count)
+{
+	if (!trace_stream) {
+		return;
+	}
+
+	const uint64_t end_ns = now_ns();
+
+	pthread_mutex_lock(&trace_lock);
+
+	if (trace_tid == 0) {
+		assign_thread_id();
+	}
+
+	// Times are in microseconds
+	fprintf(trace_stream,
+	        ",\n{\"name\":");
+	write_json_string(span->name);
+	fprintf(trace_stream,
+	        ",\"cat\":\"selint\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u,\"args\":{",
+	        (double)(span->start_ns - trace_start_ns) / 1e3,
+	        (double)(end_ns - span->start_ns) / 1e3,
+	        trace_pid,
+	        trace_tid);
+	if (file) {
+		fprintf(trace_stream, "\"file\":");
+		write_json_string(file);
+	}
+	if (count_name) {
+		fprintf(trace_stream, "%s", file ? "," : "");
+		write_json_string(count_name);
+		fprintf(trace_stream, ":%zu", count);
+	}
+	fprintf(trace_stream, "}}");
+
+	pthread_mutex_unlock(&trace_lock);
+}
+
+void trace_close(void)
+{
+	pthread_mutex_lock(&trace_lock);
+	if (trace_stream) {
+		fprintf(trace_stream, "\n]\n");
+		fclose(trace_stream);
+		trace_stream = NULL;
+	}
+	pthread_mutex_unlock(&trace_lock);
+}
@@ -0,0 +1,70 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "selint_error.h"
+
+// A phase of a run being traced, see trace_begin()
+struct trace_span {
+	const char *name;
+	uint64_t start_ns;
+};
+
+/*********************************************
+* Write the spans of the phases of this run to path as trace events,
+* in the JSON array format of the Chrome trace event format.  That format
+* does not need the closing bracket, so a run exiting early still leaves
+* a trace that loads in chrome://tracing or Perfetto.
+* path - The file to write to
+* returns SELINT_SUCCESS or SELINT_IO_ERROR if path cannot be written
+*********************************************/
+enum selint_error trace_open(const char *path);
+
+/*********************************************
+* Return whether spans are written
+*********************************************/
+bool is_tracing(void);
+
+/*********************************************
+* Start a span of the calling thread.  Does nothing unless tracing.
+* span - The span to start
+* name - The name of the phase.  It is not copied
+*********************************************/
+void trace_begin(struct trace_span *span, const char *name);
+
+/*********************************************
+* End a span started by trace_begin() on the same thread, and write it
+* with its thread ID.  Does nothing unless tracing.
+* span - The span to end
+* file - The file the phase worked on, or NULL
+* count_name - The name of something counted in the phase, or NULL
+* count - The count, written if count_name is set
+*********************************************/
+void trace_end(const struct trace_span *span, const char *file,
+               const char *count_name, size_t count);
+
+/*********************************************
+* Finish writing the trace.  Safe to call when not tracing.
+*********************************************/
+void trace_close(void);
+
+#endif
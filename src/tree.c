@@ -15,13 +15,75 @@
 */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+#include "arena.h"
+#include "intern.h"
 #include "tree.h"
 #include "maps.h"
 #include "selint_error.h"
 #include "xalloc.h"
 
+void *node_xmalloc(size_t size)
+{
+	struct arena *arena = get_active_arena();
+
+	if (arena) {
+		return arena_alloc(arena, size);
+	}
+	return xmalloc(size);
+}
+
+void *node_xcalloc(size_t nmemb, size_t size)
+{
+	struct arena *arena = get_active_arena();
+
+	if (arena) {
+		return arena_calloc(arena, nmemb * size);
+	}
+	return xcalloc(nmemb, size);
+}
+
+char *node_xstrdup(const char *str)
+{
+	struct arena *arena = get_active_arena();
+
+	if (arena) {
+		return arena_strdup(arena, str);
+	}
+	return xstrdup(str);
+}
+
+char *node_xstrndup(const char *str, size_t len)
+{
+	struct arena *arena = get_active_arena();
+
+	if (arena) {
+		return arena_strndup(arena, str, len);
+	}
+	return xstrndup(str, len);
+}
+
+void node_free(void *ptr)
+{
+	const struct arena *arena = get_active_arena();
+
+	if (arena && arena_owns(arena, ptr)) {
+		return;
+	}
+	free(ptr);
+}
+
+struct policy_node *alloc_policy_node(void)
+{
+	struct policy_node *node = node_xcalloc(1, sizeof(struct policy_node));
+
+	node->arena_owned = get_active_arena() != NULL;
+
+	return node;
+}
+
 enum selint_error insert_policy_node_child(struct policy_node *parent,
                                            enum node_flavor flavor,
                                            union node_data data, unsigned int lineno)
@@ -31,13 +93,14 @@ enum selint_error insert_policy_node_child(struct policy_node *parent,
 		return SELINT_BAD_ARG;
 	}
 
-	struct policy_node *to_insert = xmalloc(sizeof(struct policy_node));
+	struct policy_node *to_insert = alloc_policy_node();
 	to_insert->parent = parent;
 	to_insert->next = NULL;
 	to_insert->first_child = NULL;
 	to_insert->flavor = flavor;
 	to_insert->data = data;
 	to_insert->exceptions = NULL;
+	to_insert->disabled_checks = 0;
 	to_insert->lineno = lineno;
 
 	if (parent->first_child == NULL) {
@@ -68,7 +131,7 @@ enum selint_error insert_policy_node_next(struct policy_node *prev,
 		return SELINT_BAD_ARG;
 	}
 
-	struct policy_node *to_insert = xmalloc(sizeof(struct policy_node));
+	struct policy_node *to_insert = alloc_policy_node();
 
 	prev->next = to_insert;
 
@@ -79,6 +142,7 @@ enum selint_error insert_policy_node_next(struct policy_node *prev,
 	to_insert->data = data;
 	to_insert->prev = prev;
 	to_insert->exceptions = NULL;
+	to_insert->disabled_checks = 0;
 	to_insert->lineno = lineno;
 
 	return SELINT_SUCCESS;
@@ -137,11 +201,43 @@ const char *decl_flavor_to_string(enum decl_flavor flavor)
 	}
 }
 
-struct name_list *get_names_in_node(const struct policy_node *node)
+// Append a name to the list ending at *tail.  The names are cached in
+// their node, so allocate them like the node and borrow the traits.
+static void append_name(struct name_list ***tail, const char *name, uint8_t interned,
+                        enum name_flavor flavor, struct string_list *traits)
+{
+	struct name_data *data = node_xmalloc(sizeof(struct name_data));
+
+	// Exclusions name the same type, without the "-"
+	if (name[0] == '-') {
+		data->name = intern(name + 1);
+	} else {
+		data->name = interned ? name : intern(name);
+	}
+	data->flavor = flavor;
+	data->traits = traits;
+
+	struct name_list *cell = node_xmalloc(sizeof(struct name_list));
+	cell->data = data;
+	cell->next = NULL;
+
+	**tail = cell;
+	*tail = &cell->next;
+}
+
+static void append_names(struct name_list ***tail, const struct string_list *sl,
+                         enum name_flavor flavor, struct string_list *traits)
+{
+	for (; sl; sl = sl->next) {
+		append_name(tail, sl->string, sl->interned, flavor, traits);
+	}
+}
+
+static struct name_list *compute_names_in_node(const struct policy_node *node)
 {
 
 	struct name_list *ret = NULL;
-	struct name_list *cur = NULL;
+	struct name_list **tail = &ret;
 	const struct av_rule_data *av_data;
 	const struct type_transition_data *tt_data;
 	const struct role_transition_data *rt_data;
@@ -151,71 +247,106 @@ struct name_list *get_names_in_node(const struct policy_node *node)
 	const struct role_types_data *rtyp_data;
 	const struct attribute_data *at_data;
 
+	// The rules of symbols-only parses have no data
+	if (!node->data.str) {
+		return NULL;
+	}
+
 	switch (node->flavor) {
 	case NODE_AV_RULE:
 	case NODE_XAV_RULE:
 		// Since the common elements are ordered identically, we can just look
 		// at the common subset for the XAV rule
 		av_data = node->data.av_data;
-		ret = name_list_from_sl(av_data->sources, NAME_TYPE_OR_ATTRIBUTE);
-		ret = concat_name_lists(ret, name_list_from_sl(av_data->targets, NAME_TYPE_OR_ATTRIBUTE));
-		ret = concat_name_lists(ret, name_list_from_sl_with_traits(av_data->object_classes, NAME_CLASS, av_data->perms));
+		append_names(&tail, av_data->sources, NAME_TYPE_OR_ATTRIBUTE, NULL);
+		append_names(&tail, av_data->targets, NAME_TYPE_OR_ATTRIBUTE, NULL);
+		append_names(&tail, av_data->object_classes, NAME_CLASS, av_data->perms);
 		break;
 
 	case NODE_TT_RULE:
 		tt_data = node->data.tt_data;
-		ret = name_list_from_sl(tt_data->sources, NAME_TYPE_OR_ATTRIBUTE);
-		ret = concat_name_lists(ret, name_list_from_sl(tt_data->targets, NAME_TYPE_OR_ATTRIBUTE));
-		ret = concat_name_lists(ret, name_list_create(tt_data->default_type, NAME_TYPE));
-		ret = concat_name_lists(ret, name_list_from_sl(tt_data->object_classes, NAME_CLASS));
+		append_names(&tail, tt_data->sources, NAME_TYPE_OR_ATTRIBUTE, NULL);
+		append_names(&tail, tt_data->targets, NAME_TYPE_OR_ATTRIBUTE, NULL);
+		append_name(&tail, tt_data->default_type, 0, NAME_TYPE, NULL);
+		append_names(&tail, tt_data->object_classes, NAME_CLASS, NULL);
 		break;
 
 	case NODE_RT_RULE:
 		rt_data = node->data.rt_data;
-		ret = name_list_from_sl(rt_data->sources, NAME_ROLE_OR_ATTRIBUTE);
-		ret = concat_name_lists(ret, name_list_from_sl(rt_data->targets, NAME_TYPE_OR_ATTRIBUTE));
-		ret = concat_name_lists(ret, name_list_create(rt_data->default_role, NAME_ROLE));
-		ret = concat_name_lists(ret, name_list_from_sl(rt_data->object_classes, NAME_CLASS));
+		append_names(&tail, rt_data->sources, NAME_ROLE_OR_ATTRIBUTE, NULL);
+		append_names(&tail, rt_data->targets, NAME_TYPE_OR_ATTRIBUTE, NULL);
+		append_name(&tail, rt_data->default_role, 0, NAME_ROLE, NULL);
+		append_names(&tail, rt_data->object_classes, NAME_CLASS, NULL);
 		break;
 
 	case NODE_DECL:
 		d_data = node->data.d_data;
-		ret = name_list_from_decl(d_data);
+		switch (d_data->flavor) {
+		case DECL_TYPE:
+			append_name(&tail, d_data->name, 0, NAME_TYPE, NULL);
+			append_names(&tail, d_data->attrs, NAME_TYPEATTRIBUTE, NULL);
+			break;
+		case DECL_ATTRIBUTE:
+			append_name(&tail, d_data->name, 0, NAME_TYPEATTRIBUTE, NULL);
+			break;
+		case DECL_ATTRIBUTE_ROLE:
+			append_name(&tail, d_data->name, 0, NAME_ROLEATTRIBUTE, NULL);
+			break;
+		case DECL_ROLE:
+			append_name(&tail, d_data->name, 0, NAME_ROLE, NULL);
+			break;
+		case DECL_USER:
+			append_name(&tail, d_data->name, 0, NAME_USER, NULL);
+			break;
+		case DECL_CLASS:
+			append_name(&tail, d_data->name, 0, NAME_CLASS, d_data->attrs);
+			break;
+		case DECL_PERM:
+			append_name(&tail, d_data->name, 0, NAME_PERM, NULL);
+			break;
+		case DECL_BOOL:
+			append_name(&tail, d_data->name, 0, NAME_BOOL, NULL);
+			break;
+		default:
+			// should never happen
+			append_name(&tail, d_data->name, 0, NAME_UNKNOWN, NULL);
+			break;
+		}
 		break;
 
 	case NODE_IF_CALL:
 		ifc_data = node->data.ic_data;
-		ret = name_list_from_sl(ifc_data->args, NAME_UNKNOWN);
+		append_names(&tail, ifc_data->args, NAME_UNKNOWN, NULL);
 		break;
 
 	case NODE_ROLE_ALLOW:
 		ra_data = node->data.ra_data;
-		ret = name_list_from_sl(ra_data->from, NAME_ROLE_OR_ATTRIBUTE);
-		ret = concat_name_lists(ret, name_list_from_sl(ra_data->to, NAME_ROLE_OR_ATTRIBUTE));
+		append_names(&tail, ra_data->from, NAME_ROLE_OR_ATTRIBUTE, NULL);
+		append_names(&tail, ra_data->to, NAME_ROLE_OR_ATTRIBUTE, NULL);
 		break;
 
 	case NODE_ROLE_TYPES:
 		rtyp_data = node->data.rtyp_data;
-		ret = name_list_create(rtyp_data->role, NAME_ROLE_OR_ATTRIBUTE);
-		ret->next = name_list_from_sl(rtyp_data->types, NAME_TYPE_OR_ATTRIBUTE);
+		append_name(&tail, rtyp_data->role, 0, NAME_ROLE_OR_ATTRIBUTE, NULL);
+		append_names(&tail, rtyp_data->types, NAME_TYPE_OR_ATTRIBUTE, NULL);
 		break;
 
 	case NODE_TYPE_ATTRIBUTE:
 		at_data = node->data.at_data;
-		ret = name_list_create(at_data->type, NAME_TYPE);
-		ret->next = name_list_from_sl(at_data->attrs, NAME_TYPEATTRIBUTE);
+		append_name(&tail, at_data->type, 0, NAME_TYPE, NULL);
+		append_names(&tail, at_data->attrs, NAME_TYPEATTRIBUTE, NULL);
 		break;
 
 	case NODE_ROLE_ATTRIBUTE:
 		at_data = node->data.at_data;
-		ret = name_list_create(at_data->type, NAME_ROLE);
-		ret->next = name_list_from_sl(at_data->attrs, NAME_ROLEATTRIBUTE);
+		append_name(&tail, at_data->type, 0, NAME_ROLE, NULL);
+		append_names(&tail, at_data->attrs, NAME_ROLEATTRIBUTE, NULL);
 		break;
 
 	case NODE_ALIAS:
 	case NODE_TYPE_ALIAS:
 	case NODE_PERMISSIVE:
-		ret = name_list_create(node->data.str, NAME_TYPE);
+		append_name(&tail, node->data.str, 0, NAME_TYPE, NULL);
 		break;
 
 	/*
@@ -252,43 +383,37 @@ struct name_list *get_names_in_node(const struct policy_node *node)
 		break;
 	}
 
-	// Check if any of the types are exclusions
-	cur = ret;
-	while (cur) {
-		char *name = cur->data->name;
-		if (name[0] == '-') {
-			// memmove is safe for overlapping strings
-			// Length is strlen exactly because it doesn't copy the first
-			// character, but does copy the null terminator
-			memmove(name, name + 1, strlen(name));
-		}
-		cur = cur->next;
-	}
-
 	return ret;
 }
 
-struct name_list *get_names_required(const struct policy_node *node)
+static void free_names_in_node(struct name_list *names)
 {
-	struct name_list *ret = NULL;
-	struct name_list *ret_cursor = NULL;
-
-	struct policy_node *cur = node->first_child;
+	while (names) {
+		struct name_list *next = names->next;
+		// The traits are borrowed from the node data
+		node_free(names->data);
+		node_free(names);
+		names = next;
+	}
+}
 
-	while (cur) {
-		if (ret_cursor) {
-			ret_cursor->next = get_names_in_node(cur);
-		} else {
-			ret = ret_cursor = get_names_in_node(cur);
-		}
-		while (ret_cursor && ret_cursor->next) {
-			ret_cursor = ret_cursor->next;
-		}
+void update_names_in_node(struct policy_node *node)
+{
+	free_names_in_node(node->names);
+	node->names = compute_names_in_node(node);
+}
 
-		cur = cur->next;
+void update_names_in_tree(struct policy_node *head)
+{
+	for (struct policy_node *cur = head; cur; cur = cur->next) {
+		update_names_in_node(cur);
+		update_names_in_tree(cur->first_child);
 	}
+}
 
-	return ret;
+const struct name_list *get_names_in_node(const struct policy_node *node)
+{
+	return node->names;
 }
 
 int is_in_require(const struct policy_node *cur)
@@ -332,6 +457,15 @@ struct policy_node *dfs_next(const struct policy_node *node)
 	}
 }
 
+void inherit_disabled_checks(struct policy_node *head)
+{
+	// Parents come before their children in a depth first search
+	for (struct policy_node *cur = dfs_next(head); cur; cur = dfs_next(cur)) {
+		const struct policy_node *scope = cur->parent ? cur->parent : head;
+		cur->disabled_checks |= scope->disabled_checks;
+	}
+}
+
 static void free_single_policy_node_data(struct policy_node *to_free)
 {
 	switch (to_free->flavor) {
@@ -378,12 +512,12 @@ static void free_single_policy_node_data(struct policy_node *to_free)
 		break;
 	default:
 		if (to_free->data.str != NULL) {
-			free(to_free->data.str);
+			node_free(to_free->data.str);
 		}
 		break;
 	}
 
-	free(to_free->exceptions);
+	node_free(to_free->exceptions);
 }
 
 enum selint_error free_policy_node(struct policy_node *to_free)
@@ -392,10 +526,16 @@ enum selint_error free_policy_node(struct policy_node *to_free)
 		return SELINT_BAD_ARG;
 	}
 
+	if (to_free->arena_owned) {
+		// Freed along with the arena of its file
+		return SELINT_SUCCESS;
+	}
+
 	do {
 		struct policy_node *next = to_free->next;
 
 		free_single_policy_node_data(to_free);
+		free_names_in_node(to_free->names);
 
 		free_policy_node(to_free->first_child);
 
@@ -414,9 +554,9 @@ enum selint_error free_header_data(struct header_data *to_free)
 		return SELINT_BAD_ARG;
 	}
 
-	free(to_free->module_name);
+	node_free(to_free->module_name);
 
-	free(to_free);
+	node_free(to_free);
 
 	return SELINT_SUCCESS;
 }
@@ -433,7 +573,7 @@ enum selint_error free_av_rule_data(struct av_rule_data *to_free)
 	free_string_list(to_free->object_classes);
 	free_string_list(to_free->perms);
 
-	free(to_free);
+	node_free(to_free);
 
 	return SELINT_SUCCESS;
 }
@@ -448,10 +588,10 @@ enum selint_error free_xav_rule_data(struct xav_rule_data *to_free)
 	free_string_list(to_free->sources);
 	free_string_list(to_free->targets);
 	free_string_list(to_free->object_classes);
-	free(to_free->operation);
+	node_free(to_free->operation);
 	free_string_list(to_free->perms);
 
-	free(to_free);
+	node_free(to_free);
 
 	return SELINT_SUCCESS;
 }
@@ -465,7 +605,7 @@ enum selint_error free_ra_data(struct role_allow_data *to_free)
 
 	free_string_list(to_free->from);
 	free_string_list(to_free->to);
-	free(to_free);
+	node_free(to_free);
 
 	return SELINT_SUCCESS;
 }
@@ -477,9 +617,9 @@ enum selint_error free_rtyp_data(struct role_types_data *to_free)
 		return SELINT_BAD_ARG;
 	}
 
-	free(to_free->role);
+	node_free(to_free->role);
 	free_string_list(to_free->types);
-	free(to_free);
+	node_free(to_free);
 
 	return SELINT_SUCCESS;
 }
@@ -495,10 +635,10 @@ enum selint_error free_type_transition_data(struct type_transition_data
 	free_string_list(to_free->sources);
 	free_string_list(to_free->targets);
 	free_string_list(to_free->object_classes);
-	free(to_free->default_type);
-	free(to_free->name);
+	node_free(to_free->default_type);
+	node_free(to_free->name);
 
-	free(to_free);
+	node_free(to_free);
 
 	return SELINT_SUCCESS;
 }
@@ -513,9 +653,9 @@ enum selint_error free_role_transition_data(struct role_transition_data
 	free_string_list(to_free->sources);
 	free_string_list(to_free->targets);
 	free_string_list(to_free->object_classes);
-	free(to_free->default_role);
+	node_free(to_free->default_role);
 
-	free(to_free);
+	node_free(to_free);
 
 	return SELINT_SUCCESS;
 }
@@ -527,10 +667,10 @@ enum selint_error free_if_call_data(struct if_call_data *to_free)
 		return SELINT_BAD_ARG;
 	}
 
-	free(to_free->name);
+	node_free(to_free->name);
 	free_string_list(to_free->args);
 
-	free(to_free);
+	node_free(to_free);
 
 	return SELINT_SUCCESS;
 }
@@ -542,9 +682,9 @@ enum selint_error free_declaration_data(struct declaration_data *to_free)
 	}
 
 	free_string_list(to_free->attrs);
-	free(to_free->name);
+	node_free(to_free->name);
 
-	free(to_free);
+	node_free(to_free);
 
 	return SELINT_SUCCESS;
 }
@@ -573,52 +713,54 @@ enum selint_error free_if_call_list(struct if_call_list *to_free)
 	return SELINT_SUCCESS;
 }
 
-void free_fc_entry(struct fc_entry *to_free)
+enum selint_error free_if_call_list_and_data(struct if_call_list *to_free)
 {
-	if (to_free->path) {
-		free(to_free->path);
+
+	while (to_free) {
+		struct if_call_list *tmp = to_free;
+		to_free = to_free->next;
+		free_if_call_data(tmp->call);
+		free(tmp);
 	}
+	return SELINT_SUCCESS;
+}
+
+void free_fc_entry(struct fc_entry *to_free)
+{
+	node_free(to_free->path);
 	if (to_free->context) {
 		free_sel_context(to_free->context);
 	}
-	free(to_free);
+	node_free(to_free);
 }
 
 void free_sel_context(struct sel_context *to_free)
 {
-	if (to_free->user) {
-		free(to_free->user);
-	}
-	if (to_free->role) {
-		free(to_free->role);
-	}
-	if (to_free->type) {
-		free(to_free->type);
-	}
-	if (to_free->range) {
-		free(to_free->range);
-	}
-	free(to_free);
+	node_free(to_free->user);
+	node_free(to_free->role);
+	node_free(to_free->type);
+	node_free(to_free->range);
+	node_free(to_free);
 }
 
 void free_attribute_data(struct attribute_data *to_free)
 {
 	if (to_free->type) {
-		free(to_free->type);
+		node_free(to_free->type);
 	}
 	if (to_free->attrs) {
 		free_string_list(to_free->attrs);
 	}
-	free(to_free);
+	node_free(to_free);
 }
 
 void free_gen_require_data(struct gen_require_data *to_free)
 {
-	free(to_free);
+	node_free(to_free);
 }
 
 void free_cond_declaration_data(struct cond_declaration_data *to_free)
 {
 	free_string_list(to_free->identifiers);
-	free(to_free);
+	node_free(to_free);
 }
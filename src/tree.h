@@ -226,9 +226,33 @@ struct policy_node {
 	enum node_flavor flavor;
 	union node_data data;
 	char *exceptions;
+	// Checks disabled for the node, by its own selint-disable comment or
+	// one of its enclosing scopes.  See check_bit() for the bits.
+	uint64_t disabled_checks;
 	unsigned int lineno;
+	uint8_t arena_owned;    // node and its data are freed with an arena
+	struct name_list *names;        // see update_names_in_node()
 };
 
+/**********************************
+* Allocate memory for a node or its data.
+* While an arena is active (see arena.h) the memory is allocated from it,
+* otherwise from the heap.
+**********************************/
+void *node_xmalloc(size_t size);
+void *node_xcalloc(size_t nmemb, size_t size);
+char *node_xstrdup(const char *str);
+char *node_xstrndup(const char *str, size_t len);
+
+/**********************************
+* Free memory allocated by node_xmalloc() and friends,
+* unless it belongs to the active arena
+**********************************/
+void node_free(void *ptr);
+
+// Return a zeroed node, allocated like node_xmalloc()
+struct policy_node *alloc_policy_node(void);
+
 enum selint_error insert_policy_node_child(struct policy_node *parent,
                                            enum node_flavor flavor, union node_data data,
                                            unsigned int lineno);
@@ -242,9 +266,25 @@ int is_template_call(const struct policy_node *node);
 
 const char *get_name_if_in_template(const struct policy_node *cur);
 
-struct name_list *get_names_in_node(const struct policy_node *node);
+/**********************************
+* Compute the names used by the node from its data and store them in the
+* node, which owns them, replacing the names computed before.  Call it
+* again when the data of the node changes.  The names are atoms, and the
+* traits of classes are borrowed from the node data.
+* The list is allocated like the node, so for a tree allocated from an
+* arena that arena has to be active (see arena.h).
+**********************************/
+void update_names_in_node(struct policy_node *node);
+
+// Update the names of the nodes of the tree starting at head and its siblings
+void update_names_in_tree(struct policy_node *head);
 
-struct name_list *get_names_required(const struct policy_node *node);
+/**********************************
+* Return the names used by the node, as computed by the last call of
+* update_names_in_node().  Do not modify or free them.
+* The parse functions of files compute the names of the trees they return.
+**********************************/
+const struct name_list *get_names_in_node(const struct policy_node *node);
 
 const char *decl_flavor_to_string(enum decl_flavor flavor);
 
@@ -265,6 +305,15 @@ int is_in_if_define(const struct policy_node *cur);
 //Return the next node in a depth first search of the tree
 struct policy_node *dfs_next(const struct policy_node *node);
 
+/**********************************
+* Add the checks disabled for a scope to the disabled_checks of the nodes
+* inside of it.  Nodes inherit the checks disabled for their parent, and
+* top level nodes the checks disabled for the whole file.
+* head - The file node at the head of the tree
+**********************************/
+void inherit_disabled_checks(struct policy_node *head);
+
+// Nodes allocated from an arena are left to the arena
 enum selint_error free_policy_node(struct policy_node *to_free);
 
 enum selint_error free_header_data(struct header_data *to_free);
@@ -292,6 +341,9 @@ enum selint_error free_decl_list(struct decl_list *to_free);
 // Only free the list, not what it's pointing to
 enum selint_error free_if_call_list(struct if_call_list *to_free);
 
+// Free the list and the if call data it is pointing to
+enum selint_error free_if_call_list_and_data(struct if_call_list *to_free);
+
 void free_fc_entry(struct fc_entry *to_free);
 
 void free_sel_context(struct sel_context *to_free);
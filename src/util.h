@@ -39,6 +39,18 @@
 #define IGNORE_CONST_DISCARD_END
 #endif
 
+// disable the sanitizer checks of unsigned integer overflows in functions
+// computing hashes, which overflow on purpose
+#if defined(__clang__) && defined(__clang_major__) && (__clang_major__ >= 4)
+#if (__clang_major__ >= 12)
+#define no_sanitize_unsigned_integer_       __attribute__((no_sanitize("unsigned-integer-overflow", "unsigned-shift-base")))
+#else
+#define no_sanitize_unsigned_integer_       __attribute__((no_sanitize("unsigned-integer-overflow")))
+#endif
+#else
+#define no_sanitize_unsigned_integer_
+#endif
+
 __attribute__((format(printf,1,2)))
 void print_if_verbose(const char *format, ...);
 
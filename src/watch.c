@@ -0,0 +1,794 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config.h"
+
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+#include "call_graph.h"
+#include "color.h"
+#include "parse_functions.h"
+#include "runner.h"
+#include "startup.h"
+#include "util.h"
+#include "watch.h"
+#include "xalloc.h"
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_MOVED_FROM)
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void request_stop(__attribute__((unused)) int sig)
+{
+	stop_requested = 1;
+}
+
+struct watched_dir {
+	int wd;
+	char *prefix;   // the directory with a trailing slash, or "" for the cwd
+	struct watched_dir *next;
+};
+
+struct watch_state {
+	struct checks *ck;
+	struct policy_file_list *te_files;
+	struct policy_file_list *if_files;
+	struct policy_file_list *fc_files;
+	struct policy_file_list *context_te_files;
+	struct policy_file_list *context_if_files;
+	const struct string_list *custom_fc_macros;
+	const struct config_check_data *ccd;
+	int summary_flag;
+	int fd;
+	struct watched_dir *dirs;
+	struct call_graph *graph;       // of the if and context if files
+};
+
+// Where a file is stored in the lists of the watch state
+struct file_location {
+	struct policy_file_list *list;
+	struct policy_file_node *node;
+	struct policy_file_node *prev;
+	enum node_flavor flavor;
+	int checked;
+};
+
+// Return the length of the directory part of path, including the slash
+static size_t dir_prefix_len(const char *path)
+{
+	const char *slash = strrchr(path, '/');
+
+	return slash ? (size_t)(slash - path) + 1 : 0;
+}
+
+static enum node_flavor flavor_of_path(const char *path)
+{
+	const size_t len = strlen(path);
+	const char *suffix = (len > 3) ? path + len - 3 : NULL;
+
+	if (!suffix) {
+		return NODE_ERROR;
+	} else if (0 == strcmp(suffix, ".te")) {
+		return NODE_TE_FILE;
+	} else if (0 == strcmp(suffix, ".if")) {
+		return NODE_IF_FILE;
+	} else if (0 == strcmp(suffix, ".fc")) {
+		return NODE_FC_FILE;
+	}
+
+	return NODE_ERROR;
+}
+
+static enum file_flavor file_flavor_of(enum node_flavor flavor)
+{
+	switch (flavor) {
+	case NODE_TE_FILE:
+		return FILE_TE_FILE;
+	case NODE_IF_FILE:
+		return FILE_IF_FILE;
+	default:
+		return FILE_FC_FILE;
+	}
+}
+
+static enum selint_error watch_directory(struct watch_state *w, const char *path)
+{
+	const size_t len = dir_prefix_len(path);
+
+	for (const struct watched_dir *dir = w->dirs; dir; dir = dir->next) {
+		if (strlen(dir->prefix) == len && 0 == strncmp(dir->prefix, path, len)) {
+			return SELINT_SUCCESS;
+		}
+	}
+
+	char *prefix = xmalloc(len + 1);
+	memcpy(prefix, path, len);
+	prefix[len] = '\0';
+
+	int wd = inotify_add_watch(w->fd, len > 0 ? prefix : ".", WATCH_EVENTS);
+	if (wd < 0) {
+		printf("%sError%s: Failed to watch directory '%s': %s\n", color_error(), color_reset(), len > 0 ? prefix : ".", strerror(errno));
+		free(prefix);
+		return SELINT_IO_ERROR;
+	}
+
+	struct watched_dir *dir = xmalloc(sizeof(struct watched_dir));
+	dir->wd = wd;
+	dir->prefix = prefix;
+	dir->next = w->dirs;
+	w->dirs = dir;
+
+	return SELINT_SUCCESS;
+}
+
+static enum selint_error watch_directories_of(struct watch_state *w,
+                                              const struct policy_file_list *files)
+{
+	for (const struct policy_file_node *cur = files->head; cur; cur = cur->next) {
+		enum selint_error res = watch_directory(w, cur->file->filename);
+		if (res != SELINT_SUCCESS) {
+			return res;
+		}
+	}
+
+	return SELINT_SUCCESS;
+}
+
+static void free_watched_dirs(struct watched_dir *dir)
+{
+	while (dir) {
+		struct watched_dir *tmp = dir;
+		dir = dir->next;
+		free(tmp->prefix);
+		free(tmp);
+	}
+}
+
+static int find_in_list(struct policy_file_list *list, const char *path,
+                        struct file_location *loc)
+{
+	struct policy_file_node *prev = NULL;
+
+	for (struct policy_file_node *cur = list->head; cur; cur = cur->next) {
+		if (0 == strcmp(cur->file->filename, path)) {
+			loc->list = list;
+			loc->node = cur;
+			loc->prev = prev;
+			return 1;
+		}
+		prev = cur;
+	}
+
+	return 0;
+}
+
+// Return 1 and fill loc if path is a parsed file, and 0 otherwise
+static int find_file(const struct watch_state *w, const char *path,
+                     struct file_location *loc)
+{
+	memset(loc, 0, sizeof(struct file_location));
+	loc->flavor = flavor_of_path(path);
+
+	switch (loc->flavor) {
+	case NODE_TE_FILE:
+		loc->checked = 1;
+		if (find_in_list(w->te_files, path, loc)) {
+			return 1;
+		}
+		loc->checked = 0;
+		return find_in_list(w->context_te_files, path, loc);
+	case NODE_IF_FILE:
+		loc->checked = 1;
+		if (find_in_list(w->if_files, path, loc)) {
+			return 1;
+		}
+		loc->checked = 0;
+		return find_in_list(w->context_if_files, path, loc);
+	case NODE_FC_FILE:
+		loc->checked = 1;
+		return find_in_list(w->fc_files, path, loc);
+	default:
+		return 0;
+	}
+}
+
+static int has_file_in_dir(const struct policy_file_list *files, const char *path)
+{
+	const size_t len = dir_prefix_len(path);
+
+	for (const struct policy_file_node *cur = files->head; cur; cur = cur->next) {
+		if (dir_prefix_len(cur->file->filename) == len &&
+		    0 == strncmp(cur->file->filename, path, len)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// Choose the list a new file is added to.  Files next to checked files
+// are checked, other ones are only parsed.
+static void locate_new_file(const struct watch_state *w, const char *path,
+                            struct file_location *loc)
+{
+	loc->checked = has_file_in_dir(w->te_files, path) ||
+	               has_file_in_dir(w->if_files, path) ||
+	               has_file_in_dir(w->fc_files, path);
+
+	switch (loc->flavor) {
+	case NODE_TE_FILE:
+		loc->list = loc->checked ? w->te_files : w->context_te_files;
+		break;
+	case NODE_IF_FILE:
+		loc->list = loc->checked ? w->if_files : w->context_if_files;
+		break;
+	default:
+		loc->list = loc->checked ? w->fc_files : NULL;
+		break;
+	}
+}
+
+static int same_string_lists(const struct string_list *a, const struct string_list *b)
+{
+	while (a && b) {
+		if (0 != strcmp(a->string, b->string)) {
+			return 0;
+		}
+		a = a->next;
+		b = b->next;
+	}
+
+	return !a && !b;
+}
+
+static int same_if_calls(const struct if_call_data *a, const struct if_call_data *b)
+{
+	return 0 == strcmp(a->name, b->name) && same_string_lists(a->args, b->args);
+}
+
+// Return 1 if both change lists make the same insertions into the maps
+static int same_map_changes(const struct map_changes *a, const struct map_changes *b)
+{
+	const struct map_change *ca = first_map_change(a);
+	const struct map_change *cb = first_map_change(b);
+
+	for (; ca && cb; ca = ca->next, cb = cb->next) {
+		// Names and values are atoms
+		if (ca->flavor != cb->flavor || ca->name != cb->name || ca->value != cb->value) {
+			return 0;
+		}
+
+		switch (ca->flavor) {
+		case CHANGE_DECL:
+		case CHANGE_TEMPLATE_DECL:
+			if (ca->data.decl_flavor != cb->data.decl_flavor) {
+				return 0;
+			}
+			break;
+		case CHANGE_IF_FLAG:
+			if (ca->data.if_flag != cb->data.if_flag) {
+				return 0;
+			}
+			break;
+		case CHANGE_TEMPLATE_CALL:
+			if (!same_if_calls(ca->data.call, cb->data.call)) {
+				return 0;
+			}
+			break;
+		case CHANGE_DEFERRED: {
+			const char *mod_a, *mod_b;
+			const struct policy_node *node_a = get_deferred_expansion(ca, &mod_a);
+			const struct policy_node *node_b = get_deferred_expansion(cb, &mod_b);
+			if (!node_a || !node_b ||
+			    0 != strcmp(mod_a, mod_b) ||
+			    !same_if_calls(node_a->data.ic_data, node_b->data.ic_data)) {
+				return 0;
+			}
+			break;
+		}
+		case CHANGE_IF:
+		case CHANGE_TEMPLATE:
+		case CHANGE_CLASS_PERM:
+			break;
+		}
+	}
+
+	return !ca && !cb;
+}
+
+static void reapply_deferred_file_changes(const struct policy_file_list *files)
+{
+	for (const struct policy_file_node *cur = files->head; cur; cur = cur->next) {
+		reapply_deferred_map_changes(cur->file->changes);
+	}
+}
+
+// Parse path into a new policy file, or return NULL if it fails to parse.
+// Context files are parsed for their symbols only, like at startup.
+static struct policy_file *parse_changed_file(const struct watch_state *w,
+                                              const char *path,
+                                              enum node_flavor flavor,
+                                              int context)
+{
+	struct policy_file_list *single = xcalloc(1, sizeof(struct policy_file_list));
+	file_list_push_back(single, make_policy_file(path, NULL));
+
+	enum selint_error res;
+	if (flavor == NODE_FC_FILE) {
+		res = parse_all_fc_files_in_list(single, w->custom_fc_macros);
+	} else {
+		set_symbols_only(context);
+		res = parse_all_files_in_list(single, flavor);
+		set_symbols_only(0);
+	}
+	reset_current_module_name();
+
+	if (res != SELINT_SUCCESS) {
+		printf("%sError%s: Failed to parse %s, keeping the previous version\n", color_error(), color_reset(), path);
+		free_file_list(single);
+		return NULL;
+	}
+
+	struct policy_file *file = single->head->file;
+	free(single->head);
+	free(single);
+
+	return file;
+}
+
+// Append file to list, which only references it
+static void push_reference(struct policy_file_list *list, struct policy_file *file)
+{
+	if (!file_name_in_file_list(file->filename, list)) {
+		file_list_push_back(list, file);
+	}
+}
+
+static void free_references(struct policy_file_list *list)
+{
+	struct policy_file_node *cur = list->head;
+
+	while (cur) {
+		struct policy_file_node *tmp = cur;
+		cur = cur->next;
+		free(tmp);
+	}
+	list->head = list->tail = NULL;
+}
+
+struct watch_round {
+	struct policy_file_list *retired;       // old versions, freed at the end of the round
+	struct policy_file_list te_to_check;
+	struct policy_file_list if_to_check;
+	struct policy_file_list fc_to_check;
+	int maps_changed;
+	int interfaces_changed;         // the transform interfaces are marked again
+	int templates_changed;          // the template calls of te files are expanded again
+	int check_all;
+};
+
+// Note what the maps derive from the insertions of a changed file, which
+// have to be derived again
+static void note_map_changes(struct watch_round *round, enum node_flavor flavor,
+                             const struct map_changes *changes)
+{
+	round->maps_changed = 1;
+	if (flavor == NODE_IF_FILE) {
+		round->interfaces_changed = 1;
+	}
+	if (changes_template_map(changes)) {
+		round->templates_changed = 1;
+	}
+}
+
+static void check_later(struct watch_round *round, enum node_flavor flavor,
+                        struct policy_file *file)
+{
+	switch (flavor) {
+	case NODE_TE_FILE:
+		push_reference(&round->te_to_check, file);
+		break;
+	case NODE_IF_FILE:
+		push_reference(&round->if_to_check, file);
+		break;
+	default:
+		push_reference(&round->fc_to_check, file);
+		break;
+	}
+}
+
+static void update_file(struct watch_state *w, struct watch_round *round, const char *path)
+{
+	struct file_location loc;
+	const int known = find_file(w, path, &loc);
+	struct stat st;
+
+	if (loc.flavor == NODE_ERROR) {
+		return;
+	}
+
+	if (0 != stat(path, &st) || !S_ISREG(st.st_mode)) {
+		if (!known) {
+			return;
+		}
+		print_if_verbose("Removed %s\n", path);
+		if (loc.prev) {
+			loc.prev->next = loc.node->next;
+		} else {
+			loc.list->head = loc.node->next;
+		}
+		if (loc.list->tail == loc.node) {
+			loc.list->tail = loc.prev;
+		}
+		loc.node->next = NULL;
+		if (loc.flavor == NODE_IF_FILE) {
+			remove_file_from_call_graph(w->graph, loc.node->file);
+		}
+		if (loc.flavor != NODE_FC_FILE) {
+			retract_map_changes(loc.node->file->changes);
+			note_map_changes(round, loc.flavor, loc.node->file->changes);
+			round->check_all = 1;
+		}
+		file_list_push_back(round->retired, loc.node->file);
+		free(loc.node);
+		return;
+	}
+
+	if (!known) {
+		locate_new_file(w, path, &loc);
+		if (!loc.list) {
+			return;
+		}
+	}
+
+	// Parsing inserts the names of the new version into the maps
+	struct policy_file *file = parse_changed_file(w, path, loc.flavor, !loc.checked);
+	if (!file) {
+		return;
+	}
+
+	if (known) {
+		const struct policy_file *old = loc.node->file;
+		if (loc.flavor != NODE_FC_FILE) {
+			round->maps_changed = 1;
+			retract_map_changes(old->changes);
+			if (!same_map_changes(old->changes, file->changes)) {
+				note_map_changes(round, loc.flavor, old->changes);
+				note_map_changes(round, loc.flavor, file->changes);
+				round->check_all = 1;
+			} else if (loc.flavor == NODE_IF_FILE) {
+				// The first calls of the interfaces might have changed
+				round->interfaces_changed = 1;
+			}
+		}
+		if (loc.flavor == NODE_IF_FILE) {
+			remove_file_from_call_graph(w->graph, old);
+			add_file_to_call_graph(w->graph, file);
+		}
+		file_list_push_back(round->retired, loc.node->file);
+		loc.node->file = file;
+	} else {
+		print_if_verbose("Added %s\n", path);
+		file_list_push_back(loc.list, file);
+		if (loc.flavor == NODE_IF_FILE) {
+			insert_mod_layer_of_if_file(path);
+			add_file_to_call_graph(w->graph, file);
+		}
+		if (loc.flavor != NODE_FC_FILE) {
+			note_map_changes(round, loc.flavor, file->changes);
+			round->check_all = 1;
+		}
+	}
+
+	if (loc.checked) {
+		check_later(round, loc.flavor, file);
+	}
+}
+
+static unsigned int count_files(const struct policy_file_list *files)
+{
+	unsigned int count = 0;
+
+	for (const struct policy_file_node *cur = files->head; cur; cur = cur->next) {
+		count++;
+	}
+
+	return count;
+}
+
+static double elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double)(now.tv_sec - start->tv_sec) * 1000.0 +
+	       (double)(now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static void report_round(const struct watch_state *w, enum selint_error res,
+                         unsigned int checked, const struct timespec *start)
+{
+	if (res != SELINT_SUCCESS) {
+		printf("%sError%s: Internal error: %d\n", color_error(), color_reset(), res);
+	} else if (w->summary_flag) {
+		display_run_summary(w->ck);
+	}
+
+	printf("Checked %u file%s in %.1f ms, watching for changes\n",
+	       checked, checked == 1 ? "" : "s", elapsed_ms(start));
+	fflush(stdout);
+}
+
+static void run_round(struct watch_state *w, const struct string_list *paths)
+{
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	struct watch_round round;
+	memset(&round, 0, sizeof(struct watch_round));
+	round.retired = xcalloc(1, sizeof(struct policy_file_list));
+
+	for (const struct string_list *cur = paths; cur; cur = cur->next) {
+		update_file(w, &round, cur->string);
+	}
+
+	// Derive what depends on all files again, like parse_analysis_files()
+	if (round.interfaces_changed) {
+		clear_derived_transform_ifs();
+		propagate_transform_interfaces(w->graph);
+	}
+	if (round.templates_changed) {
+		reapply_deferred_file_changes(w->context_te_files);
+		reapply_deferred_file_changes(w->te_files);
+	}
+
+	// Their insertions into the maps, which might reference their ASTs,
+	// got retracted
+	free_file_list(round.retired);
+
+	enum selint_error res = SELINT_SUCCESS;
+	unsigned int checked;
+
+	if (round.check_all) {
+		reset_issue_counts(w->ck);
+		res = check_analysis_files(w->ck, w->te_files, w->if_files, w->fc_files, w->ccd);
+		checked = count_files(w->te_files) + count_files(w->if_files) + count_files(w->fc_files);
+	} else {
+		checked = count_files(&round.te_to_check) + count_files(&round.if_to_check) + count_files(&round.fc_to_check);
+		if (checked > 0) {
+			reset_issue_counts(w->ck);
+			res = check_analysis_files(w->ck, &round.te_to_check, &round.if_to_check, &round.fc_to_check, w->ccd);
+		}
+	}
+
+	free_references(&round.te_to_check);
+	free_references(&round.if_to_check);
+	free_references(&round.fc_to_check);
+
+	if (round.maps_changed || checked > 0) {
+		report_round(w, res, checked, &start);
+	}
+}
+
+// Append the te, if and fc files changed according to the pending inotify
+// events to paths.  Returns 0 if reading the events failed.
+static int read_events(const struct watch_state *w, struct string_list **paths)
+{
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	const ssize_t len = read(w->fd, buf, sizeof(buf));
+	if (len < 0) {
+		return errno == EINTR || errno == EAGAIN;
+	}
+
+	for (const char *ptr = buf; ptr < buf + len;) {
+		const struct inotify_event *event = (const struct inotify_event *)(const void *)ptr;
+		ptr += sizeof(struct inotify_event) + event->len;
+
+		if (event->mask & IN_Q_OVERFLOW) {
+			printf("%sWarning%s: Too many changes at once, some might be missed\n", color_warning(), color_reset());
+			continue;
+		}
+
+		if (event->len == 0 || flavor_of_path(event->name) == NODE_ERROR) {
+			continue;
+		}
+
+		const struct watched_dir *dir = w->dirs;
+		while (dir && dir->wd != event->wd) {
+			dir = dir->next;
+		}
+		if (!dir) {
+			continue;
+		}
+
+		const size_t prefix_len = strlen(dir->prefix);
+		const size_t name_len = strlen(event->name);
+		char *path = xmalloc(prefix_len + name_len + 1);
+		memcpy(path, dir->prefix, prefix_len);
+		memcpy(path + prefix_len, event->name, name_len + 1);
+
+		if (!str_in_sl(path, *paths)) {
+			*paths = concat_string_lists(*paths, sl_from_str_consume(path));
+		} else {
+			free(path);
+		}
+	}
+
+	return 1;
+}
+
+static enum selint_error watch_loop(struct watch_state *w)
+{
+	struct string_list *pending = NULL;
+	enum selint_error res = SELINT_SUCCESS;
+
+	while (!stop_requested) {
+		struct pollfd pfd = { w->fd, POLLIN, 0 };
+
+		// Editors often write a file in several steps, so wait until
+		// the changes settle down
+		const int ready = poll(&pfd, 1, pending ? WATCH_DEBOUNCE_MS : -1);
+		if (ready < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			printf("%sError%s: Failed to wait for changes: %s\n", color_error(), color_reset(), strerror(errno));
+			res = SELINT_IO_ERROR;
+			break;
+		}
+
+		if (ready == 0) {
+			run_round(w, pending);
+			free_string_list(pending);
+			pending = NULL;
+			continue;
+		}
+
+		if (!read_events(w, &pending)) {
+			printf("%sError%s: Failed to read changes: %s\n", color_error(), color_reset(), strerror(errno));
+			res = SELINT_IO_ERROR;
+			break;
+		}
+	}
+
+	free_string_list(pending);
+
+	return res;
+}
+
+enum selint_error watch_analysis(struct checks *ck,
+                                 struct policy_file_list *te_files,
+                                 struct policy_file_list *if_files,
+                                 struct policy_file_list *fc_files,
+                                 struct policy_file_list *context_te_files,
+                                 struct policy_file_list *context_if_files,
+                                 const struct string_list *custom_fc_macros,
+                                 const struct config_check_data *ccd,
+                                 int summary_flag)
+{
+	struct watch_state w = {
+		.ck = ck,
+		.te_files = te_files,
+		.if_files = if_files,
+		.fc_files = fc_files,
+		.context_te_files = context_te_files,
+		.context_if_files = context_if_files,
+		.custom_fc_macros = custom_fc_macros,
+		.ccd = ccd,
+		.summary_flag = summary_flag,
+		.fd = -1,
+		.dirs = NULL,
+		.graph = NULL,
+	};
+	struct sigaction action, old_int, old_term;
+	enum selint_error res;
+
+	memset(&action, 0, sizeof(struct sigaction));
+	action.sa_handler = request_stop;
+	sigemptyset(&action.sa_mask);
+	// No SA_RESTART, so poll() returns on a signal
+	sigaction(SIGINT, &action, &old_int);
+	sigaction(SIGTERM, &action, &old_term);
+
+	w.fd = inotify_init1(IN_CLOEXEC);
+	if (w.fd < 0) {
+		printf("%sError%s: Failed to watch for changes: %s\n", color_error(), color_reset(), strerror(errno));
+		res = SELINT_IO_ERROR;
+		goto out;
+	}
+
+	// Watch before the initial run, to not miss changes made meanwhile
+	struct policy_file_list *lists[] = { te_files, if_files, fc_files, context_te_files, context_if_files };
+	for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+		res = watch_directories_of(&w, lists[i]);
+		if (res != SELINT_SUCCESS) {
+			goto out;
+		}
+	}
+
+	retain_map_changes = 1;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	res = parse_analysis_files(te_files, if_files, fc_files, context_te_files,
+	                           context_if_files, custom_fc_macros);
+	if (res != SELINT_SUCCESS) {
+		goto out;
+	}
+
+	// Kept up to date with the changed if files, to mark the transform
+	// interfaces again without building it each round
+	w.graph = build_call_graph(if_files);
+	for (const struct policy_file_node *cur = context_if_files->head; cur; cur = cur->next) {
+		add_file_to_call_graph(w.graph, cur->file);
+	}
+
+	res = check_analysis_files(ck, te_files, if_files, fc_files, ccd);
+	report_round(&w, res, count_files(te_files) + count_files(if_files) + count_files(fc_files), &start);
+
+	res = watch_loop(&w);
+
+out:
+	retain_map_changes = 0;
+	if (w.fd >= 0) {
+		close(w.fd);
+	}
+	free_watched_dirs(w.dirs);
+	if (w.graph) {
+		free_call_graph(w.graph);
+	}
+	sigaction(SIGINT, &old_int, NULL);
+	sigaction(SIGTERM, &old_term, NULL);
+	cleanup_parsing();
+
+	return res;
+}
+
+#else /* HAVE_SYS_INOTIFY_H */
+
+enum selint_error watch_analysis(__attribute__((unused)) struct checks *ck,
+                                 __attribute__((unused)) struct policy_file_list *te_files,
+                                 __attribute__((unused)) struct policy_file_list *if_files,
+                                 __attribute__((unused)) struct policy_file_list *fc_files,
+                                 __attribute__((unused)) struct policy_file_list *context_te_files,
+                                 __attribute__((unused)) struct policy_file_list *context_if_files,
+                                 __attribute__((unused)) const struct string_list *custom_fc_macros,
+                                 __attribute__((unused)) const struct config_check_data *ccd,
+                                 __attribute__((unused)) int summary_flag)
+{
+	printf("%sError%s: Watching for changes is not supported on this platform\n", color_error(), color_reset());
+	cleanup_parsing();
+
+	return SELINT_IO_ERROR;
+}
+
+#endif /* HAVE_SYS_INOTIFY_H */
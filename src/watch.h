@@ -0,0 +1,62 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "check_hooks.h"
+#include "file_list.h"
+#include "maps.h"
+#include "selint_error.h"
+#include "string_list.h"
+
+/**********************************
+* Watch mode keeps the parsed files and the maps resident after a complete
+* analysis, and re-checks the policy whenever a te, if or fc file in the
+* directory of a parsed file is written, created or removed.  Only the
+* changed files are parsed again.  The map changes recorded for each file
+* (see retain_map_changes in runner.h) are retracted once it changes, so
+* only the insertions of the changed files are undone and made again.  If a
+* changed file inserts exactly the same names as before, only that file is
+* checked again, and otherwise all files are.
+*
+* Changes to the configuration, modules.conf, access_vectors and the other
+* support files are not picked up, and neither are new directories.
+**********************************/
+
+// Time to wait for further changes before re-checking, in milliseconds
+#define WATCH_DEBOUNCE_MS 50
+
+/**********************************
+* Run the complete analysis like run_analysis(), and then keep re-checking
+* changed files until SIGINT or SIGTERM is received
+* summary_flag - Whether to display a summary after each run
+* See run_analysis() for the other parameters.
+* Returns SELINT_SUCCESS once interrupted, or an error code if the
+* initial analysis or watching the files failed
+**********************************/
+enum selint_error watch_analysis(struct checks *ck,
+                                 struct policy_file_list *te_files,
+                                 struct policy_file_list *if_files,
+                                 struct policy_file_list *fc_files,
+                                 struct policy_file_list *context_te_files,
+                                 struct policy_file_list *context_if_files,
+                                 const struct string_list *custom_fc_macros,
+                                 const struct config_check_data *ccd,
+                                 int summary_flag);
+
+#endif
@@ -17,9 +17,17 @@
 #ifndef XALLOC_H
 #define XALLOC_H
 
+#include <stddef.h>
 #include <stdio.h>
 #include <sysexits.h>
 
+// Whether the wrappers below count the bytes requested from them
+extern int xalloc_counting;
+// The bytes requested by the calling thread while xalloc_counting is set.
+// Each xrealloc() counts the whole new size, not just the growth, and
+// nothing is subtracted when memory is freed.
+extern _Thread_local size_t xalloc_counted_bytes;
+
 #define oom_failure()                                             \
 	do {                                                      \
 		fprintf(stderr,                                   \
@@ -29,59 +37,79 @@
 		exit(EX_OSERR);                                   \
 	} while(0)
 
+/*********************************************
+* Count bytes requested from a wrapper, if enabled.  The size is only
+* evaluated while counting, see enable_check_profiling().
+*********************************************/
+#define xalloc_count(size)                                \
+	do {                                              \
+		if (xalloc_counting) {                    \
+			xalloc_counted_bytes += (size);   \
+		}                                         \
+	} while(0)
+
 /*********************************************
 * Checked malloc wrapper.
 *********************************************/
-#define xmalloc(size) ({            \
-	void *ret_ = malloc(size);  \
-	if (!ret_) {                \
-		oom_failure();      \
-	}                           \
-	ret_;                       \
+#define xmalloc(size) ({               \
+	const size_t size_ = (size);   \
+	void *ret_ = malloc(size_);    \
+	if (!ret_) {                   \
+		oom_failure();         \
+	}                              \
+	xalloc_count(size_);           \
+	ret_;                          \
 })
 
 /*********************************************
 * Checked calloc wrapper.
 *********************************************/
-#define xcalloc(nmemb, size) ({            \
-	void *ret_ = calloc(nmemb, size);  \
-	if (!ret_) {                       \
-		oom_failure();             \
-	}                                  \
-	ret_;                              \
+#define xcalloc(nmemb, size) ({                  \
+	const size_t nmemb_ = (nmemb);           \
+	const size_t size_ = (size);             \
+	void *ret_ = calloc(nmemb_, size_);      \
+	if (!ret_) {                             \
+		oom_failure();                   \
+	}                                        \
+	xalloc_count(nmemb_ * size_);            \
+	ret_;                                    \
 })
 
 /*********************************************
 * Checked realloc wrapper.
 *********************************************/
-#define xrealloc(ptr, size) ({            \
-	void *ret_ = realloc(ptr, size);  \
-	if (!ret_) {                      \
-		oom_failure();            \
-	}                                 \
-	ret_;                             \
+#define xrealloc(ptr, size) ({              \
+	const size_t size_ = (size);        \
+	void *ret_ = realloc(ptr, size_);   \
+	if (!ret_) {                        \
+		oom_failure();              \
+	}                                   \
+	xalloc_count(size_);                \
+	ret_;                               \
 })
 
 /*********************************************
 * Checked strdup wrapper.
 *********************************************/
-#define xstrdup(str) ({            \
-	void *ret_ = strdup(str);  \
-	if (!ret_) {               \
-		oom_failure();     \
-	}                          \
-	ret_;                      \
+#define xstrdup(str) ({                       \
+	void *ret_ = strdup(str);             \
+	if (!ret_) {                          \
+		oom_failure();                \
+	}                                     \
+	xalloc_count(strlen(ret_) + 1);       \
+	ret_;                                 \
 })
 
 /*********************************************
 * Checked strndup wrapper.
 *********************************************/
-#define xstrndup(str, size) ({            \
-	void *ret_ = strndup(str, size);  \
-	if (!ret_) {                      \
-		oom_failure();            \
-	}                                 \
-	ret_;                             \
+#define xstrndup(str, size) ({                \
+	void *ret_ = strndup(str, size);      \
+	if (!ret_) {                          \
+		oom_failure();                \
+	}                                     \
+	xalloc_count(strlen(ret_) + 1);       \
+	ret_;                                 \
 })
 
 #endif /* XALLOC_H */
@@ -0,0 +1,52 @@
+#!/bin/sh
+# Copyright 2026 The SELint Contributors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Compare the number of heap allocations of two selint builds on a policy
+# tree, e.g. before and after a change to the checks:
+#
+#   git stash && make && cp src/selint /tmp/selint-before
+#   git stash pop && make && cp src/selint /tmp/selint-after
+#   tests/benchmarks/allocs.sh /tmp/selint-before /tmp/selint-after ~/refpolicy
+#
+# Additional arguments are passed to both builds.  Requires valgrind.
+
+set -eu
+
+if [ $# -lt 3 ]; then
+	echo "Usage: $0 SELINT_A SELINT_B POLICY_DIR [SELINT_ARGS...]" >&2
+	exit 64
+fi
+
+SELINT_A=$1
+SELINT_B=$2
+POLICY_DIR=$3
+shift 3
+CONFIG=$(dirname "$0")/../functional/configs/default.conf
+
+run() {
+	selint=$1
+	shift
+	# The allocation count does not vary between runs, so one is enough
+	summary=$(valgrind --tool=memcheck --leak-check=no \
+		"$selint" -c "$CONFIG" -s -r "$@" "$POLICY_DIR" 2>&1 >/dev/null |
+		grep "total heap usage" || true)
+	allocs=$(echo "$summary" | sed -n 's/.*total heap usage: \([0-9,]*\) allocs.*/\1/p')
+	bytes=$(echo "$summary" | sed -n 's/.* \([0-9,]*\) bytes allocated.*/\1/p')
+	printf "%-40s %15s allocs %18s bytes\n" "$selint" "$allocs" "$bytes"
+}
+
+echo "Heap allocations on $POLICY_DIR:"
+run "$SELINT_A" "$@"
+run "$SELINT_B" "$@"
@@ -0,0 +1,67 @@
+#!/bin/sh
+# Copyright 2026 The SELint Contributors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Compare wall time and peak RSS of two selint builds on a policy tree,
+# usually one configured with the default per-file arenas and one with
+# --disable-arena:
+#
+#   ./configure && make && cp src/selint /tmp/selint-arena
+#   ./configure --disable-arena && make clean all && cp src/selint /tmp/selint-malloc
+#   tests/benchmarks/arena.sh /tmp/selint-arena /tmp/selint-malloc ~/refpolicy
+#
+# Additional arguments are passed to both builds.
+
+set -eu
+
+if [ $# -lt 3 ]; then
+	echo "Usage: $0 SELINT_A SELINT_B POLICY_DIR [RUNS [SELINT_ARGS...]]" >&2
+	exit 64
+fi
+
+SELINT_A=$1
+SELINT_B=$2
+POLICY_DIR=$3
+RUNS=${4:-5}
+shift 3
+[ $# -gt 0 ] && shift
+CONFIG=$(dirname "$0")/../functional/configs/default.conf
+
+TIMEFILE=$(mktemp)
+trap 'rm -f "$TIMEFILE"' EXIT
+
+run() {
+	selint=$1
+	shift
+	best_time=
+	best_rss=
+	i=0
+	while [ "$i" -lt "$RUNS" ]; do
+		/usr/bin/time -f "%e %M" -o "$TIMEFILE" \
+			"$selint" -c "$CONFIG" -s -r "$@" "$POLICY_DIR" >/dev/null 2>&1 || true
+		read -r time rss < "$TIMEFILE"
+		if [ -z "$best_time" ] || [ "$(echo "$time < $best_time" | bc)" -eq 1 ]; then
+			best_time=$time
+		fi
+		if [ -z "$best_rss" ] || [ "$rss" -lt "$best_rss" ]; then
+			best_rss=$rss
+		fi
+		i=$((i + 1))
+	done
+	printf "%-40s %8ss %10s KiB\n" "$selint" "$best_time" "$best_rss"
+}
+
+echo "Best of $RUNS runs on $POLICY_DIR:"
+run "$SELINT_A" "$@"
+run "$SELINT_B" "$@"
@@ -0,0 +1,147 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+// Measure building and freeing the syntax trees of many te files, with
+// each file allocated from an arena of its own or from the heap.  The
+// tokens and rules are handed to the parse functions the way the lexer and
+// the parser do, without scanning any input, so only the allocations of
+// the trees are measured.  Build and run it with
+//
+//   make -C tests ast_alloc_bench && tests/ast_alloc_bench arena|heap [FILES [RULES]]
+//
+// Run each mode in a process of its own, as the peak RSS covers the whole
+// process.  tests/benchmarks/arena.sh compares complete runs of two builds.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "../../src/arena.h"
+#include "../../src/intern.h"
+#include "../../src/maps.h"
+#include "../../src/parse_functions.h"
+#include "../../src/tree.h"
+#include "../../src/xalloc.h"
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// A string list of one token, which the lexer hands over as atom
+static struct string_list *token_list(const char *text)
+{
+	return sl_from_atom(intern(text));
+}
+
+static struct string_list *token_lists(const char *const *texts, size_t count)
+{
+	struct string_list *ret = NULL;
+
+	for (size_t i = 0; i < count; i++) {
+		ret = concat_string_lists(ret, token_list(texts[i]));
+	}
+
+	return ret;
+}
+
+// Build the tree of a te file with a few declarations and rules allow
+// <domain> <type>:<class> { <perms> };
+static struct policy_node *build_file(size_t file, size_t rules)
+{
+	static const char *const classes[] = { "file", "dir", "lnk_file", "sock_file", "process" };
+	static const char *const perms[] = { "getattr", "open", "read", "write", "append", "ioctl", "lock", "search" };
+	char name[64];
+	char domain[64];
+
+	struct policy_node *head = alloc_policy_node();
+	head->flavor = NODE_TE_FILE;
+	struct policy_node *cur = head;
+
+	snprintf(name, sizeof(name), "bench%zu", file);
+	insert_header(&cur, name, HEADER_MACRO, 1);
+
+	snprintf(domain, sizeof(domain), "bench%zu_t", file);
+	insert_declaration(&cur, DECL_TYPE, intern(domain), NULL, 2);
+
+	for (size_t i = 0; i < rules; i++) {
+		snprintf(name, sizeof(name), "bench%zu_%zu_t", file, i % 16);
+		const char *rule_perms[] = { perms[i % 8], perms[(i + 3) % 8], perms[(i + 5) % 8] };
+
+		insert_av_rule(&cur, AV_RULE_ALLOW,
+		               token_list(domain),
+		               token_list(name),
+		               token_list(classes[i % 5]),
+		               token_lists(rule_perms, 1 + i % 3),
+		               (unsigned int)(3 + i));
+	}
+
+	return head;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2 || (0 != strcmp(argv[1], "arena") && 0 != strcmp(argv[1], "heap"))) {
+		fprintf(stderr, "Usage: %s arena|heap [FILES [RULES]]\n", argv[0]);
+		return 64;
+	}
+
+	const int use_arenas = 0 == strcmp(argv[1], "arena");
+	const size_t files = argc > 2 ? strtoul(argv[2], NULL, 10) : 400;
+	const size_t rules = argc > 3 ? strtoul(argv[3], NULL, 10) : 500;
+
+	struct policy_node **asts = xmalloc(files * sizeof(struct policy_node *));
+	struct arena **arenas = xcalloc(files, sizeof(struct arena *));
+
+	// All trees are kept until the end, as in a run checking them
+	double start = now();
+	for (size_t f = 0; f < files; f++) {
+		if (use_arenas) {
+			arenas[f] = alloc_arena();
+			set_active_arena(arenas[f]);
+		}
+		asts[f] = build_file(f, rules);
+		set_active_arena(NULL);
+		reset_current_module_name();
+	}
+	const double build_seconds = now() - start;
+
+	start = now();
+	for (size_t f = 0; f < files; f++) {
+		free_policy_node(asts[f]);
+		free_arena(arenas[f]);
+	}
+	const double free_seconds = now() - start;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	printf("%-5s %zu files of %zu rules: build %.3fs, free %.3fs, peak RSS %ld KiB\n",
+	       argv[1], files, rules, build_seconds, free_seconds, usage.ru_maxrss);
+
+	free(arenas);
+	free(asts);
+	free_all_maps();
+
+	return 0;
+}
@@ -0,0 +1,173 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+// Measure the lookup throughput of the declaration table.  It is filled
+// with synthetic declarations of every flavor, roughly in the proportions of
+// the reference policy, and then looked up by string, by atom, and with
+// names which were never declared.  The lookups by string are also run in
+// several threads at once, like the checks of --jobs.  Build and run it with
+//
+//   make -C tests decl_map_bench && tests/decl_map_bench [TYPES [ROUNDS [THREADS]]]
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../src/intern.h"
+#include "../../src/maps.h"
+#include "../../src/xalloc.h"
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void report(const char *what, size_t lookups, size_t found, double seconds)
+{
+	printf("%-10s %12.0f lookups/s (%zu of %zu found)\n", what,
+	       (double)lookups / seconds, found, lookups);
+}
+
+struct lookups {
+	const char *const *names;
+	const enum decl_flavor *flavors;
+	size_t total;
+	size_t rounds;
+	size_t found;
+};
+
+static void *look_up_strings(void *arg)
+{
+	struct lookups *lookups = arg;
+
+	for (size_t r = 0; r < lookups->rounds; r++) {
+		for (size_t i = 0; i < lookups->total; i++) {
+			lookups->found += look_up_in_decl_map(lookups->names[i], lookups->flavors[i]) != NULL;
+		}
+	}
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t types = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+	const size_t rounds = argc > 2 ? strtoul(argv[2], NULL, 10) : 50;
+	const size_t threads = argc > 3 ? strtoul(argv[3], NULL, 10) : 4;
+
+	// Per flavor, the number of declarations for each type
+	static const struct {
+		enum decl_flavor flavor;
+		const char *suffix;
+		size_t per_100_types;
+	} flavors[] = {
+		{ DECL_TYPE, "_t", 100 },
+		{ DECL_ATTRIBUTE, "_type", 10 },
+		{ DECL_ATTRIBUTE_ROLE, "_roles", 1 },
+		{ DECL_ROLE, "_r", 1 },
+		{ DECL_USER, "_u", 1 },
+		{ DECL_CLASS, "_class", 1 },
+		{ DECL_PERM, "_perm", 2 },
+		{ DECL_BOOL, "_bool", 3 },
+	};
+	const size_t flavor_count = sizeof(flavors) / sizeof(flavors[0]);
+
+	size_t total = 0;
+	for (size_t f = 0; f < flavor_count; f++) {
+		total += types * flavors[f].per_100_types / 100;
+	}
+
+	const char **names = xmalloc(total * sizeof(char *));
+	char **misses = xmalloc(total * sizeof(char *));
+	enum decl_flavor *name_flavors = xmalloc(total * sizeof(enum decl_flavor));
+	char buf[64];
+
+	size_t n = 0;
+	for (size_t f = 0; f < flavor_count; f++) {
+		const size_t count = types * flavors[f].per_100_types / 100;
+		for (size_t i = 0; i < count; i++) {
+			snprintf(buf, sizeof(buf), "bench%zu%s", i, flavors[f].suffix);
+			names[n] = intern(buf);
+			snprintf(buf, sizeof(buf), "missing%zu%s", i, flavors[f].suffix);
+			misses[n] = xstrdup(buf);
+			name_flavors[n] = flavors[f].flavor;
+			insert_into_decl_map(names[n], "bench", name_flavors[n]);
+			n++;
+		}
+	}
+
+	printf("%zu declarations, %zu rounds\n", total, rounds);
+
+	size_t found = 0;
+	double start = now();
+	for (size_t r = 0; r < rounds; r++) {
+		for (size_t i = 0; i < total; i++) {
+			found += look_up_in_decl_map(names[i], name_flavors[i]) != NULL;
+		}
+	}
+	report("string", rounds * total, found, now() - start);
+
+	found = 0;
+	start = now();
+	for (size_t r = 0; r < rounds; r++) {
+		for (size_t i = 0; i < total; i++) {
+			found += look_up_atom_in_decl_map(names[i], name_flavors[i]) != NULL;
+		}
+	}
+	report("atom", rounds * total, found, now() - start);
+
+	found = 0;
+	start = now();
+	for (size_t r = 0; r < rounds; r++) {
+		for (size_t i = 0; i < total; i++) {
+			found += look_up_in_decl_map(misses[i], name_flavors[i]) != NULL;
+		}
+	}
+	report("miss", rounds * total, found, now() - start);
+
+	pthread_t *thread_ids = xmalloc(threads * sizeof(pthread_t));
+	struct lookups *lookups = xmalloc(threads * sizeof(struct lookups));
+	start = now();
+	for (size_t t = 0; t < threads; t++) {
+		lookups[t] = (struct lookups) { names, name_flavors, total, rounds, 0 };
+		pthread_create(&thread_ids[t], NULL, look_up_strings, &lookups[t]);
+	}
+	found = 0;
+	for (size_t t = 0; t < threads; t++) {
+		pthread_join(thread_ids[t], NULL);
+		found += lookups[t].found;
+	}
+	snprintf(buf, sizeof(buf), "string x%zu", threads);
+	report(buf, threads * rounds * total, found, now() - start);
+	free(lookups);
+	free(thread_ids);
+
+	for (size_t i = 0; i < total; i++) {
+		free(misses[i]);
+	}
+	free(misses);
+	free(names);
+	free(name_flavors);
+	free_all_maps();
+
+	return 0;
+}
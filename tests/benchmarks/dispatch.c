@@ -0,0 +1,141 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+// Measure the dispatch overhead saved by selecting the checks of each file
+// flavor.  All checks are registered like for a run at the convention level.
+// For every flavor of files, the checks left out of its selection are then
+// called on nodes of the flavors found in such files, which they return from
+// right away.  That is the work a run did for every such node before.  Build
+// and run it with
+//
+//   make -C tests dispatch_bench && tests/dispatch_bench [ROUNDS]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../src/check_hooks.h"
+#include "../../src/runner.h"
+#include "../../src/xalloc.h"
+
+#define FLAVOR(flavor) (UINT64_C(1) << (flavor))
+
+// The node flavors found in fc files only
+#define FC_NODE_FLAVORS (FLAVOR(NODE_FC_FILE) | FLAVOR(NODE_FC_ENTRY) | \
+                         FLAVOR(NODE_EMPTY) | FLAVOR(NODE_ERROR))
+
+// Return whether nodes of the flavor are found in files of the file flavor
+static int is_in_files(enum node_flavor flavor, enum file_flavor file)
+{
+	if (flavor == NODE_CLEANUP || flavor == NODE_COMMENT) {
+		return 1;
+	}
+
+	return (file == FILE_FC_FILE) == ((FC_NODE_FLAVORS & FLAVOR(flavor)) != 0);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Whether the selected checks contain the check
+static int is_selected(const struct checks *selected, enum node_flavor flavor,
+                       const struct check_node *check)
+{
+	for (unsigned int i = 0; i < selected->check_counts[flavor]; i++) {
+		if (selected->check_nodes[flavor][i].index == check->index) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t rounds = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+	static const char *const file_names[] = { "te", "if", "fc" };
+
+	struct checks *ck = register_checks('C', NULL, NULL, NULL, NULL, 0);
+	struct config_check_data ccd;
+	memset(&ccd, 0, sizeof(ccd));
+
+	suppress_output = 1;
+
+	for (int file = FILE_TE_FILE; file <= FILE_FC_FILE; file++) {
+		struct checks *selected = select_file_checks(ck, (enum file_flavor)file);
+		struct check_node *skipped = xcalloc(ck->check_node_count, sizeof(struct check_node));
+		unsigned int node_flavors = 0;
+		unsigned int total = 0;
+		unsigned int calls = 0;
+		double seconds = 0;
+
+		struct check_data data;
+		memset(&data, 0, sizeof(data));
+		data.flavor = (enum file_flavor)file;
+		data.config_check_data = &ccd;
+
+		for (int flavor = 0; flavor <= NODE_ERROR; flavor++) {
+			unsigned int count = 0;
+			for (unsigned int i = 0; i < ck->check_counts[flavor]; i++) {
+				const struct check_node *check = &ck->check_nodes[flavor][i];
+				if (!is_selected(selected, (enum node_flavor)flavor, check)) {
+					skipped[count++] = *check;
+				}
+			}
+			if (!is_in_files((enum node_flavor)flavor, (enum file_flavor)file)) {
+				continue;
+			}
+			total += ck->check_counts[flavor];
+			if (count == 0) {
+				continue;
+			}
+
+			struct policy_node node;
+			memset(&node, 0, sizeof(node));
+			node.flavor = (enum node_flavor)flavor;
+
+			const double start = now();
+			for (size_t r = 0; r < rounds; r++) {
+				call_checks_for_node_type(skipped, count, &data, &node);
+			}
+			seconds += now() - start;
+
+			node_flavors++;
+			calls += count;
+		}
+
+		printf("%s files: %u of %u checks left out, on %u node flavors\n",
+		       file_names[file], calls, total, node_flavors);
+		if (calls > 0) {
+			printf("%12.2f ns per call left out\n", seconds * 1e9 / ((double)rounds * calls));
+		}
+
+		free(skipped);
+		free_checks(selected);
+	}
+
+	free_checks(ck);
+
+	return 0;
+}
@@ -0,0 +1,67 @@
+#!/bin/sh
+# Copyright 2026 The SELint Contributors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Compare the wall time of a selint build on a policy tree without the parse
+# cache, with an empty cache (cold) and with a filled one (warm):
+#
+#   tests/benchmarks/parse_cache.sh src/selint ~/refpolicy
+#
+# Additional arguments are passed to selint.
+
+set -eu
+
+if [ $# -lt 2 ]; then
+	echo "Usage: $0 SELINT POLICY_DIR [RUNS [SELINT_ARGS...]]" >&2
+	exit 64
+fi
+
+SELINT=$1
+POLICY_DIR=$2
+RUNS=${3:-5}
+shift 2
+[ $# -gt 0 ] && shift
+CONFIG=$(dirname "$0")/../functional/configs/default.conf
+
+TIMEFILE=$(mktemp)
+CACHE_DIR=$(mktemp -d)
+trap 'rm -rf "$TIMEFILE" "$CACHE_DIR"' EXIT
+
+# Print the best wall time of RUNS runs.  With "cold" the cache is emptied
+# before each run, with "warm" it is kept.
+run() {
+	mode=$1
+	shift
+	best_time=
+	i=0
+	while [ "$i" -lt "$RUNS" ]; do
+		if [ "$mode" = cold ]; then
+			rm -rf "${CACHE_DIR:?}"/cache
+		fi
+		/usr/bin/time -f "%e" -o "$TIMEFILE" \
+			"$SELINT" -c "$CONFIG" -s -r "$@" "$POLICY_DIR" >/dev/null 2>&1 || true
+		read -r time < "$TIMEFILE"
+		if [ -z "$best_time" ] || [ "$(echo "$time < $best_time" | bc)" -eq 1 ]; then
+			best_time=$time
+		fi
+		i=$((i + 1))
+	done
+	printf "%-10s %8ss\n" "$mode" "$best_time"
+}
+
+echo "Best of $RUNS runs of $SELINT on $POLICY_DIR:"
+run uncached "$@"
+run cold --cache-dir="$CACHE_DIR/cache" "$@"
+run warm --cache-dir="$CACHE_DIR/cache" "$@"
+printf "%-10s %8s\n" "size" "$(du -sh "$CACHE_DIR/cache" | cut -f1)"
@@ -0,0 +1,69 @@
+#!/bin/sh
+# Copyright 2026 The SELint Contributors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Measure the fc parsing throughput of one or more selint builds, in lines
+# per second.  All .fc files of a policy tree are concatenated REPEAT times
+# into one file, which is checked with no checks enabled, so the run time is
+# dominated by reading and parsing it:
+#
+#   git stash && make && cp src/selint /tmp/selint-old && git stash pop && make
+#   tests/benchmarks/parse_fc.sh ~/refpolicy 100 /tmp/selint-old src/selint
+
+set -eu
+
+if [ $# -lt 3 ]; then
+	echo "Usage: $0 POLICY_DIR REPEAT SELINT [SELINT...]" >&2
+	exit 64
+fi
+
+POLICY_DIR=$1
+REPEAT=$2
+shift 2
+RUNS=${RUNS:-5}
+CONFIG=$(dirname "$0")/../functional/configs/default.conf
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+find "$POLICY_DIR" -name '*.fc' -type f -exec cat {} + > "$WORK_DIR/one.fc"
+i=0
+while [ "$i" -lt "$REPEAT" ]; do
+	cat "$WORK_DIR/one.fc"
+	i=$((i + 1))
+done > "$WORK_DIR/bench.fc"
+LINES=$(wc -l < "$WORK_DIR/bench.fc")
+
+# Print the best wall time of RUNS runs and the resulting throughput
+run() {
+	selint=$1
+	best_time=
+	i=0
+	while [ "$i" -lt "$RUNS" ]; do
+		start=$(date +%s.%N)
+		"$selint" -c "$CONFIG" -s -E "$WORK_DIR/bench.fc" >/dev/null 2>&1 || true
+		time=$(echo "$(date +%s.%N) - $start" | bc)
+		if [ -z "$best_time" ] || [ "$(echo "$time < $best_time" | bc)" -eq 1 ]; then
+			best_time=$time
+		fi
+		i=$((i + 1))
+	done
+	printf "%-40s %8.3fs %12.0f lines/s\n" "$selint" "$best_time" \
+		"$(echo "$LINES / $best_time" | bc -l)"
+}
+
+echo "Best of $RUNS runs on $LINES lines of fc files from $POLICY_DIR:"
+for selint in "$@"; do
+	run "$selint"
+done
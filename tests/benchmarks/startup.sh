@@ -0,0 +1,72 @@
+#!/bin/sh
+# Copyright 2026 The SELint Contributors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Measure the startup time of one or more selint builds on a synthetic tree
+# of FILES small te and if files, passed both as the files to check and as
+# context, so every context file has to be looked up in the checked files.
+# No checks are enabled, so the run time is dominated by scanning the tree,
+# de-duplicating the context files and parsing:
+#
+#   git stash && make && cp src/selint /tmp/selint-old && git stash pop && make
+#   tests/benchmarks/startup.sh 10000 /tmp/selint-old src/selint
+
+set -eu
+
+if [ $# -lt 2 ]; then
+	echo "Usage: $0 FILES SELINT [SELINT...]" >&2
+	exit 64
+fi
+
+FILES=$1
+shift
+RUNS=${RUNS:-5}
+CONFIG=$(dirname "$0")/../functional/configs/default.conf
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+# 100 modules per directory, each with a te and an if file
+i=0
+while [ "$i" -lt $((FILES / 2)) ]; do
+	dir="$WORK_DIR/policy/layer$((i / 100))"
+	mkdir -p "$dir"
+	printf 'policy_module(mod%d, 1.0)\n\ntype mod%d_t;\n' "$i" "$i" > "$dir/mod$i.te"
+	printf 'interface(`mod%d_use'"'"',`\n\tgen_require(`\n\t\ttype mod%d_t;\n\t'"'"')\n\tallow $1 mod%d_t:file read;\n'"'"')\n' \
+		"$i" "$i" "$i" > "$dir/mod$i.if"
+	i=$((i + 1))
+done
+
+# Print the best wall time of RUNS runs
+run() {
+	selint=$1
+	best_time=
+	i=0
+	while [ "$i" -lt "$RUNS" ]; do
+		start=$(date +%s.%N)
+		"$selint" -c "$CONFIG" -s -E -r --context="$WORK_DIR/policy" \
+			"$WORK_DIR/policy" >/dev/null 2>&1 || true
+		time=$(echo "$(date +%s.%N) - $start" | bc)
+		if [ -z "$best_time" ] || [ "$(echo "$time < $best_time" | bc)" -eq 1 ]; then
+			best_time=$time
+		fi
+		i=$((i + 1))
+	done
+	printf "%-40s %8.3fs\n" "$selint" "$best_time"
+}
+
+echo "Best of $RUNS runs on $FILES files:"
+for selint in "$@"; do
+	run "$selint"
+done
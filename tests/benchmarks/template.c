@@ -0,0 +1,108 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+// Measure the expansion throughput of nested template calls.  A chain of
+// templates is built, each declaring a type and calling the next one with a
+// derived argument, like the userdom_*_template chains of the reference
+// policy.  The first template is then called repeatedly with a small set of
+// different arguments.  Build and run it with
+//
+//   make -C tests template_bench && tests/template_bench [DEPTH [CALLS [PREFIXES]]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../src/maps.h"
+#include "../../src/template.h"
+#include "../../src/xalloc.h"
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static struct string_list *make_args(const char *first)
+{
+	struct string_list *args = xcalloc(1, sizeof(struct string_list));
+
+	args->string = xstrdup(first);
+
+	return args;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t depth = argc > 1 ? strtoul(argv[1], NULL, 10) : 20;
+	const size_t calls = argc > 2 ? strtoul(argv[2], NULL, 10) : 20000;
+	const size_t prefixes = argc > 3 ? strtoul(argv[3], NULL, 10) : 50;
+	char name[64];
+	char next[64];
+	char decl[64];
+
+	// bench_template_N($1) declares $1_N_t and calls bench_template_N+1($1_N)
+	struct if_call_data **chain = xcalloc(depth, sizeof(struct if_call_data *));
+	for (size_t i = 0; i < depth; i++) {
+		snprintf(name, sizeof(name), "bench_template_%zu", i);
+		snprintf(decl, sizeof(decl), "$1_%zu_t", i);
+		insert_decl_into_template_map(name, DECL_TYPE, decl);
+		if (i + 1 < depth) {
+			snprintf(next, sizeof(next), "bench_template_%zu", i + 1);
+			snprintf(decl, sizeof(decl), "$1_%zu", i);
+			chain[i] = xmalloc(sizeof(struct if_call_data));
+			chain[i]->name = xstrdup(next);
+			chain[i]->args = make_args(decl);
+			insert_call_into_template_map(name, chain[i]);
+		}
+	}
+
+	struct string_list **args = xmalloc(prefixes * sizeof(struct string_list *));
+	for (size_t p = 0; p < prefixes; p++) {
+		snprintf(name, sizeof(name), "prefix%zu", p);
+		args[p] = make_args(name);
+	}
+
+	printf("depth %zu, %zu calls with %zu different arguments\n", depth, calls, prefixes);
+
+	size_t failed = 0;
+	const double start = now();
+	for (size_t c = 0; c < calls; c++) {
+		failed += add_template_declarations("bench_template_0", args[c % prefixes], "bench", NULL) != SELINT_SUCCESS;
+	}
+	const double seconds = now() - start;
+
+	printf("%12.0f calls/s, %zu declarations, %zu failed\n",
+	       (double)calls / seconds, (size_t)decl_map_count(DECL_TYPE), failed);
+
+	for (size_t p = 0; p < prefixes; p++) {
+		free_string_list(args[p]);
+	}
+	free(args);
+	free_all_maps();
+	for (size_t i = 0; i < depth; i++) {
+		if (chain[i]) {
+			free_if_call_data(chain[i]);
+		}
+	}
+	free(chain);
+
+	return 0;
+}
@@ -0,0 +1,155 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <check.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/arena.h"
+
+START_TEST (test_arena_alloc) {
+
+	struct arena *arena = alloc_arena();
+
+	ck_assert_uint_eq(0, arena_size(arena));
+
+	char *small = arena_alloc(arena, 3);
+	ck_assert_ptr_nonnull(small);
+	ck_assert_int_eq(1, arena_owns(arena, small));
+
+	long long *aligned = arena_alloc(arena, sizeof(long long));
+	ck_assert_uint_eq(0, (uintptr_t)aligned % _Alignof(max_align_t));
+	ck_assert_int_eq(1, arena_owns(arena, aligned));
+
+	int *zeroed = arena_calloc(arena, 16 * sizeof(int));
+	for (int i = 0; i < 16; i++) {
+		ck_assert_int_eq(0, zeroed[i]);
+	}
+
+	const size_t used = arena_size(arena);
+	ck_assert_uint_gt(used, 0);
+
+	// Larger than a chunk
+	char *large = arena_alloc(arena, 1024 * 1024);
+	memset(large, 'a', 1024 * 1024);
+	ck_assert_int_eq(1, arena_owns(arena, large + 1024 * 1024 - 1));
+	ck_assert_uint_gt(arena_size(arena), used + 1024 * 1024 - 1);
+
+	// Small allocations continue in the earlier chunk
+	const size_t size = arena_size(arena);
+	char *next = arena_alloc(arena, 8);
+	ck_assert_int_eq(1, arena_owns(arena, next));
+	ck_assert_uint_eq(size, arena_size(arena));
+
+	char *heap = malloc(8);
+	ck_assert_int_eq(0, arena_owns(arena, heap));
+	free(heap);
+
+	free_arena(arena);
+}
+END_TEST
+
+START_TEST (test_arena_owns_many_chunks) {
+
+	struct arena *arena = alloc_arena();
+	enum { COUNT = 2000 };
+	char *owned[COUNT];
+	char *heap[COUNT];
+
+	// Chunks and heap blocks interleave in memory
+	for (int i = 0; i < COUNT; i++) {
+		owned[i] = arena_alloc(arena, i % 100 == 0 ? 20000 : 1000);
+		heap[i] = malloc(1000);
+	}
+	ck_assert_uint_gt(arena_size(arena), 16 * 64 * 1024);
+
+	for (int i = 0; i < COUNT; i++) {
+		ck_assert_int_eq(1, arena_owns(arena, owned[i]));
+		ck_assert_int_eq(1, arena_owns(arena, owned[i] + 999));
+		ck_assert_int_eq(0, arena_owns(arena, heap[i]));
+		free(heap[i]);
+	}
+
+	free_arena(arena);
+}
+END_TEST
+
+START_TEST (test_arena_strdup) {
+
+	struct arena *arena = alloc_arena();
+
+	char *str = arena_strdup(arena, "foo_t");
+	ck_assert_str_eq("foo_t", str);
+	ck_assert_int_eq(1, arena_owns(arena, str));
+
+	str = arena_strndup(arena, "bar_t baz_t", 5);
+	ck_assert_str_eq("bar_t", str);
+
+	str = arena_strndup(arena, "qux", 10);
+	ck_assert_str_eq("qux", str);
+
+	free_arena(arena);
+}
+END_TEST
+
+START_TEST (test_active_arena) {
+
+	ck_assert_ptr_null(get_active_arena());
+
+	struct arena *arena = alloc_arena();
+	set_active_arena(arena);
+	ck_assert_ptr_eq(arena, get_active_arena());
+	set_active_arena(NULL);
+	ck_assert_ptr_null(get_active_arena());
+
+	free_arena(arena);
+	free_arena(NULL);
+}
+END_TEST
+
+static Suite *arena_suite(void) {
+	Suite *s;
+	TCase *tc_core;
+
+	s = suite_create("Arena");
+
+	tc_core = tcase_create("Core");
+
+	tcase_add_test(tc_core, test_arena_alloc);
+	tcase_add_test(tc_core, test_arena_owns_many_chunks);
+	tcase_add_test(tc_core, test_arena_strdup);
+	tcase_add_test(tc_core, test_active_arena);
+	suite_add_tcase(s, tc_core);
+
+	return s;
+}
+
+int main(void) {
+
+	int number_failed = 0;
+	Suite *s;
+	SRunner *sr;
+
+	s = arena_suite();
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0)? 0 : -1;
+}
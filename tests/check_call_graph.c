@@ -0,0 +1,230 @@
+/*
+ * Copyright 2026 The SELint Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/call_graph.h"
+#include "../src/maps.h"
+
+// Add an interface definition after prev, or as the first node if prev is
+// NULL, whose first statement besides a require block is an interface call
+// if first_call is not NULL, or an allow rule otherwise.  If also_calls is
+// not NULL, a call to it follows.
+static struct policy_node *add_interface(struct policy_node *prev, const char *name,
+                                         const char *first_call, const char *also_calls)
+{
+	union node_data nd;
+	struct policy_node *def;
+
+	nd.str = strdup(name);
+	if (prev) {
+		ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_next(prev, NODE_INTERFACE_DEF, nd, 0));
+		def = prev->next;
+	} else {
+		def = calloc(1, sizeof(struct policy_node));
+		def->flavor = NODE_INTERFACE_DEF;
+		def->data = nd;
+	}
+
+	nd.str = NULL;
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(def, NODE_START_BLOCK, nd, 0));
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(def, NODE_GEN_REQ, nd, 0));
+
+	const char *calls[2] = { first_call, also_calls };
+	for (int i = 0; i < 2; i++) {
+		if (i == 0 && !first_call) {
+			nd.av_data = calloc(1, sizeof(struct av_rule_data));
+			ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(def, NODE_AV_RULE, nd, 0));
+		} else if (calls[i]) {
+			nd.ic_data = calloc(1, sizeof(struct if_call_data));
+			nd.ic_data->name = strdup(calls[i]);
+			ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(def, NODE_IF_CALL, nd, 0));
+		}
+	}
+
+	return def;
+}
+
+static struct policy_file_list *make_files(void)
+{
+	// a calls b first, b calls c first, c calls d but not first, x calls
+	// b but not first, e and f call each other first
+	struct policy_node *first = add_interface(NULL, "a", "b", NULL);
+	struct policy_node *cur = add_interface(first, "b", "c", NULL);
+	cur = add_interface(cur, "c", NULL, "d");
+	add_interface(cur, "x", NULL, "b");
+
+	struct policy_node *second = add_interface(NULL, "e", "f", NULL);
+	add_interface(second, "f", "e", NULL);
+
+	struct policy_file_list *files = calloc(1, sizeof(struct policy_file_list));
+	file_list_push_back(files, make_policy_file("first.if", first));
+	file_list_push_back(files, make_policy_file("second.if", second));
+
+	return files;
+}
+
+static const struct call_graph_node *find_node(const struct call_graph *graph, const char *if_name)
+{
+	for (const struct call_graph_node *node = graph->nodes; node; node = node->hh.next) {
+		if (0 == strcmp(if_name, node->name)) {
+			return node;
+		}
+	}
+
+	return NULL;
+}
+
+START_TEST (test_build_call_graph) {
+	struct policy_file_list *files = make_files();
+	struct call_graph *graph = build_call_graph(files);
+
+	const struct call_graph_node *a = find_node(graph, "a");
+	const struct call_graph_node *b = find_node(graph, "b");
+	const struct call_graph_node *c = find_node(graph, "c");
+
+	ck_assert_ptr_nonnull(a);
+	ck_assert_ptr_nonnull(b);
+	ck_assert_ptr_nonnull(c);
+	ck_assert_ptr_null(find_node(graph, "d"));
+	ck_assert_ptr_null(find_node(graph, "x"));
+	ck_assert_uint_eq(5, HASH_COUNT(graph->nodes));
+
+	ck_assert_ptr_eq(b, a->first_calls->node);
+	ck_assert_ptr_null(a->first_calls->next);
+	ck_assert_ptr_null(a->callers);
+	ck_assert_ptr_eq(c, b->first_calls->node);
+	ck_assert_ptr_eq(a, b->callers->node);
+	ck_assert_ptr_null(b->callers->next);
+	ck_assert_ptr_null(c->first_calls);
+	ck_assert_ptr_eq(b, c->callers->node);
+
+	const struct call_graph_node *e = find_node(graph, "e");
+	ck_assert_ptr_nonnull(e);
+	ck_assert_str_eq("f", e->first_calls->node->name);
+	ck_assert_ptr_eq(e, e->first_calls->node->first_calls->node);
+
+	free_call_graph(graph);
+	free_file_list(files);
+}
+END_TEST
+
+START_TEST (test_add_and_remove_files) {
+	struct policy_file_list *files = make_files();
+	struct call_graph *graph = build_call_graph(files);
+	const struct policy_file *first = files->head->file;
+	const struct policy_file *second = files->tail->file;
+
+	// The nodes only the removed file refers to are dropped
+	remove_file_from_call_graph(graph, second);
+	ck_assert_uint_eq(3, HASH_COUNT(graph->nodes));
+	ck_assert_ptr_null(find_node(graph, "e"));
+	ck_assert_ptr_null(find_node(graph, "f"));
+
+	// A second definition of b calling c first
+	struct policy_node *other_b = add_interface(NULL, "b", "c", NULL);
+	struct policy_file *third = make_policy_file("third.if", other_b);
+	file_list_push_back(files, third);
+	add_file_to_call_graph(graph, third);
+
+	remove_file_from_call_graph(graph, first);
+	ck_assert_uint_eq(2, HASH_COUNT(graph->nodes));
+	ck_assert_ptr_null(find_node(graph, "a"));
+	const struct call_graph_node *b = find_node(graph, "b");
+	ck_assert_ptr_nonnull(b);
+	ck_assert_ptr_eq(other_b, b->first_calls->def);
+	ck_assert_ptr_null(b->first_calls->next);
+	ck_assert_ptr_eq(b, find_node(graph, "c")->callers->node);
+	ck_assert_ptr_null(find_node(graph, "c")->callers->next);
+
+	remove_file_from_call_graph(graph, third);
+	ck_assert_ptr_null(graph->nodes);
+
+	add_file_to_call_graph(graph, second);
+	mark_filetrans_if("f");
+	propagate_to_callers(graph, is_filetrans_if, mark_filetrans_if);
+	ck_assert_int_eq(1, is_filetrans_if("e"));
+
+	free_call_graph(graph);
+	free_file_list(files);
+	free_all_maps();
+}
+END_TEST
+
+START_TEST (test_propagate_to_callers) {
+	struct policy_file_list *files = make_files();
+	struct call_graph *graph = build_call_graph(files);
+
+	// Nothing marked, and the loop between e and f ends
+	propagate_to_callers(graph, is_transform_if, mark_transform_if);
+	ck_assert_int_eq(0, is_transform_if("a"));
+	ck_assert_int_eq(0, is_transform_if("e"));
+
+	mark_transform_if("d");
+	propagate_to_callers(graph, is_transform_if, mark_transform_if);
+	ck_assert_int_eq(0, is_transform_if("c"));
+
+	mark_transform_if("c");
+	propagate_to_callers(graph, is_transform_if, mark_transform_if);
+	ck_assert_int_eq(1, is_transform_if("b"));
+	ck_assert_int_eq(1, is_transform_if("a"));
+	ck_assert_int_eq(0, is_transform_if("x"));
+	ck_assert_int_eq(0, is_transform_if("e"));
+	ck_assert_int_eq(0, is_filetrans_if("a"));
+
+	mark_filetrans_if("f");
+	propagate_to_callers(graph, is_filetrans_if, mark_filetrans_if);
+	ck_assert_int_eq(1, is_filetrans_if("e"));
+	ck_assert_int_eq(0, is_transform_if("e"));
+
+	free_call_graph(graph);
+	free_file_list(files);
+	free_all_maps();
+}
+END_TEST
+
+static Suite *call_graph_suite(void) {
+	Suite *s;
+	TCase *tc_core;
+
+	s = suite_create("Call_graph");
+
+	tc_core = tcase_create("Core");
+
+	tcase_add_test(tc_core, test_build_call_graph);
+	tcase_add_test(tc_core, test_add_and_remove_files);
+	tcase_add_test(tc_core, test_propagate_to_callers);
+	suite_add_tcase(s, tc_core);
+
+	return s;
+}
+
+int main(void) {
+
+	int number_failed = 0;
+	Suite *s;
+	SRunner *sr;
+
+	s = call_graph_suite();
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0)? 0 : -1;
+}
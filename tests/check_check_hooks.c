@@ -15,9 +15,11 @@
 */
 
 #include <check.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "../src/check_hooks.h"
+#include "../src/xalloc.h"
 
 int check_called;
 int check2_called;
@@ -25,6 +27,7 @@ int check2_called;
 struct check_result * example_check(const struct check_data *check_data, const struct policy_node *node);
 struct check_result * example_check2(const struct check_data *check_data, const struct policy_node *node);
 struct check_result * returns_blank_result(const struct check_data *check_data, const struct policy_node *node);
+struct check_result * returns_made_result(const struct check_data *check_data, const struct policy_node *node);
 
 struct check_result * example_check(__attribute__((unused)) const struct check_data *check_data,
 				  __attribute__((unused)) const struct policy_node *node) {
@@ -84,6 +87,19 @@ START_TEST (test_add_check) {
 	ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_ERROR, ck, "E-999", example_check));
 	ck_assert_ptr_nonnull(ck->check_nodes[NODE_ERROR]);
 
+	// Checks are kept in the order they were added
+	for (unsigned int i = 0; i < 9; i++) {
+		ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_AV_RULE, ck, "E-998", example_check2));
+	}
+	ck_assert_uint_eq(10, ck->check_counts[NODE_AV_RULE]);
+	ck_assert_uint_eq(17, ck->check_node_count);
+	ck_assert_str_eq("E-999", ck->check_nodes[NODE_AV_RULE][0].check_id);
+	for (unsigned int i = 1; i < 10; i++) {
+		ck_assert_str_eq("E-998", ck->check_nodes[NODE_AV_RULE][i].check_id);
+		ck_assert_ptr_eq(example_check2, ck->check_nodes[NODE_AV_RULE][i].check_function);
+	}
+	ck_assert_uint_eq(16, ck->check_nodes[NODE_AV_RULE][9].index);
+
 	ck_assert_int_eq(0, check_called);
 
 	free_checks(ck);
@@ -113,7 +129,7 @@ START_TEST (test_call_checks) {
 	ck_assert_int_eq(SELINT_SUCCESS, call_checks(ck, NULL, node));
 
 	ck_assert_int_eq(0, ck->check_nodes[NODE_AV_RULE]->issues_found);
-	ck_assert_int_eq(0, ck->check_nodes[NODE_AV_RULE]->next->issues_found);
+	ck_assert_int_eq(0, ck->check_nodes[NODE_AV_RULE][1].issues_found);
 
 	ck_assert_int_eq(1, check_called);
 	ck_assert_int_eq(1, check2_called);
@@ -125,7 +141,7 @@ START_TEST (test_call_checks) {
 	ck_assert_int_eq(SELINT_SUCCESS, call_checks(ck, NULL, node));
 
 	ck_assert_int_eq(0, ck->check_nodes[NODE_AV_RULE]->issues_found);
-	ck_assert_int_eq(0, ck->check_nodes[NODE_AV_RULE]->next->issues_found);
+	ck_assert_int_eq(0, ck->check_nodes[NODE_AV_RULE][1].issues_found);
 
 	ck_assert_int_eq(0, check_called);
 	ck_assert_int_eq(0, check2_called);
@@ -136,6 +152,49 @@ START_TEST (test_call_checks) {
 }
 END_TEST
 
+START_TEST (test_select_file_checks) {
+	struct checks *ck = calloc(1, sizeof(struct checks));
+
+	ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_AV_RULE, ck, "E-999", example_check));
+	ck_assert_int_eq(SELINT_SUCCESS, add_file_check(NODE_AV_RULE, FILE_FLAVOR_BIT(FILE_IF_FILE), ck, "E-998", example_check2));
+	ck_assert_int_eq(SELINT_SUCCESS, add_file_check(NODE_FC_ENTRY, FILE_FLAVOR_BIT(FILE_FC_FILE), ck, "E-997", returns_blank_result));
+
+	struct checks *te = select_file_checks(ck, FILE_TE_FILE);
+	ck_assert_uint_eq(1, te->check_counts[NODE_AV_RULE]);
+	ck_assert_str_eq("E-999", te->check_nodes[NODE_AV_RULE][0].check_id);
+	ck_assert_uint_eq(0, te->check_counts[NODE_FC_ENTRY]);
+	ck_assert_uint_eq(3, te->check_node_count);
+
+	struct checks *fc = select_file_checks(ck, FILE_FC_FILE);
+	ck_assert_uint_eq(1, fc->check_counts[NODE_AV_RULE]);
+	ck_assert_uint_eq(1, fc->check_counts[NODE_FC_ENTRY]);
+	ck_assert_uint_eq(2, fc->check_nodes[NODE_FC_ENTRY][0].index);
+
+	// Issues found by the selected checks are counted for the checks of ck
+	struct policy_node *node = calloc(1, sizeof(struct policy_node));
+	node->flavor = NODE_FC_ENTRY;
+
+	unsigned int counts[3] = { 0, 0, 0 };
+	suppress_output = 1;
+	set_issue_counters(counts);
+	ck_assert_int_eq(SELINT_SUCCESS, call_checks(fc, NULL, node));
+	set_issue_counters(NULL);
+	suppress_output = 0;
+	add_issue_counts(ck, counts);
+	ck_assert_int_eq(1, ck->check_nodes[NODE_FC_ENTRY][0].issues_found);
+
+	struct checks *in_if = select_file_checks(ck, FILE_IF_FILE);
+	ck_assert_uint_eq(2, in_if->check_counts[NODE_AV_RULE]);
+	ck_assert_ptr_null(in_if->check_nodes[NODE_FC_ENTRY]);
+
+	free(node);
+	free_checks(te);
+	free_checks(fc);
+	free_checks(in_if);
+	free_checks(ck);
+}
+END_TEST
+
 START_TEST (test_disable_check) {
 	struct checks *ck = calloc(1, sizeof(struct checks));
 
@@ -161,6 +220,64 @@ START_TEST (test_disable_check) {
 }
 END_TEST
 
+START_TEST (test_disabled_check_bits) {
+	ck_assert_uint_eq(0, check_id_bit("E-999"));
+	ck_assert_uint_eq(0, check_id_bit("W-01"));
+	ck_assert_uint_eq(0, check_id_bit("W-0010"));
+	ck_assert_uint_eq(0, check_id_bit("Y-001"));
+	ck_assert_uint_eq(check_bit('W', W_ID_NO_EXPLICIT_DECL), check_id_bit("W-001"));
+
+	// Every known check has a bit of its own
+	const char severities[] = "XCSWEF";
+	uint64_t seen = 0;
+	for (const char *sev = severities; *sev; sev++) {
+		ck_assert_uint_eq(0, check_bit(*sev, 0));
+		for (unsigned int id = 1; id < 100; id++) {
+			const uint64_t bit = check_bit(*sev, id);
+			char check_str[6];
+			snprintf(check_str, sizeof(check_str), "%c-%03u", *sev, id);
+			ck_assert_int_eq(is_valid_check(check_str), bit != 0);
+			ck_assert_uint_eq(0, seen & bit);
+			seen |= bit;
+		}
+	}
+
+	ck_assert_uint_eq(0, parse_disabled_checks(NULL));
+	ck_assert_uint_eq(check_id_bit("W-010"), parse_disabled_checks("W-010"));
+	ck_assert_uint_eq(check_id_bit("C-001") | check_id_bit("W-002"),
+	                  parse_disabled_checks(" C-001, W-002\n"));
+}
+END_TEST
+
+START_TEST (test_disable_check_exact_id) {
+	struct checks *ck = calloc(1, sizeof(struct checks));
+
+	ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_AV_RULE, ck, "W-001", example_check));
+	ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_AV_RULE, ck, "E-99", example_check2));
+
+	struct policy_node *node = calloc(1, sizeof(struct policy_node));
+	node->flavor = NODE_AV_RULE;
+	node->exceptions = strdup("W-0010, E-999");
+	node->disabled_checks = parse_disabled_checks(node->exceptions);
+
+	check_called = 0;
+	check2_called = 0;
+	ck_assert_int_eq(SELINT_SUCCESS, call_checks(ck, NULL, node));
+	ck_assert_int_eq(1, check_called);
+	ck_assert_int_eq(1, check2_called);
+
+	// Disabled by an enclosing scope
+	node->disabled_checks |= check_id_bit("W-001");
+
+	check_called = 0;
+	ck_assert_int_eq(SELINT_SUCCESS, call_checks(ck, NULL, node));
+	ck_assert_int_eq(0, check_called);
+
+	free_policy_node(node);
+	free_checks(ck);
+}
+END_TEST
+
 START_TEST (test_is_valid_check) {
 	ck_assert_int_eq(1, is_valid_check("W-001"));
 	ck_assert_int_eq(1, is_valid_check("W-005"));
@@ -175,6 +292,11 @@ START_TEST (test_is_valid_check) {
 }
 END_TEST
 
+struct check_result * returns_made_result(__attribute__((unused)) const struct check_data *check_data,
+                                        __attribute__((unused)) const struct policy_node *node) {
+	return make_check_result('E', 998, "Found %d", 1);
+}
+
 START_TEST (test_increment_issues) {
 	struct checks *ck = calloc(1, sizeof(struct checks));
 	ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_AV_RULE, ck, "E-999", returns_blank_result));
@@ -200,6 +322,143 @@ START_TEST (test_increment_issues) {
 }
 END_TEST
 
+START_TEST (test_issue_counters) {
+	struct checks *ck = calloc(1, sizeof(struct checks));
+	ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_AV_RULE, ck, "E-999", example_check));
+	ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_AV_RULE, ck, "E-998", returns_blank_result));
+	ck_assert_uint_eq(2, ck->check_node_count);
+	ck_assert_uint_eq(1, ck->check_nodes[NODE_AV_RULE][1].index);
+
+	struct check_data *data = calloc(1, sizeof(struct check_data));
+	data->filename = strdup("example.te");
+
+	struct policy_node *node = calloc(1, sizeof(struct policy_node));
+	node->flavor = NODE_AV_RULE;
+
+	unsigned int counts[2] = { 0, 0 };
+	suppress_output = 1;
+	set_issue_counters(counts);
+	ck_assert_int_eq(SELINT_SUCCESS, call_checks(ck, data, node));
+	ck_assert_int_eq(SELINT_SUCCESS, call_checks(ck, data, node));
+	set_issue_counters(NULL);
+	suppress_output = 0;
+
+	ck_assert_uint_eq(0, counts[0]);
+	ck_assert_uint_eq(2, counts[1]);
+	ck_assert_int_eq(0, ck->check_nodes[NODE_AV_RULE][1].issues_found);
+
+	add_issue_counts(ck, counts);
+	ck_assert_int_eq(0, ck->check_nodes[NODE_AV_RULE]->issues_found);
+	ck_assert_int_eq(2, ck->check_nodes[NODE_AV_RULE][1].issues_found);
+
+	free_policy_node(node);
+	free(data->filename);
+	free(data);
+	free_checks(ck);
+}
+END_TEST
+
+START_TEST (test_check_profiles) {
+	struct checks *ck = calloc(1, sizeof(struct checks));
+	ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_AV_RULE, ck, "E-999", example_check));
+	ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_AV_RULE, ck, "E-998", returns_made_result));
+	ck_assert_int_eq(SELINT_SUCCESS, add_check(NODE_TT_RULE, ck, "E-998", returns_made_result));
+	ck_assert_ptr_null(ck->profiles);
+
+	struct check_data *data = calloc(1, sizeof(struct check_data));
+	data->filename = strdup("example.te");
+
+	struct policy_node *node = calloc(1, sizeof(struct policy_node));
+	node->flavor = NODE_AV_RULE;
+
+	suppress_output = 1;
+
+	// Nothing is recorded until the thread sets profiles
+	enable_check_profiling(ck);
+	ck_assert_ptr_nonnull(ck->profiles);
+	ck_assert_int_eq(SELINT_SUCCESS, call_checks(ck, data, node));
+	ck_assert_uint_eq(0, ck->profiles[0].calls);
+
+	set_check_profiles(ck->profiles);
+	ck_assert_int_eq(SELINT_SUCCESS, call_checks(ck, data, node));
+	ck_assert_int_eq(SELINT_SUCCESS, call_checks(ck, data, node));
+	node->flavor = NODE_TT_RULE;
+	ck_assert_int_eq(SELINT_SUCCESS, call_checks(ck, data, node));
+	set_check_profiles(NULL);
+
+	ck_assert_uint_eq(2, ck->profiles[0].calls);
+	ck_assert_uint_eq(0, ck->profiles[0].findings);
+	ck_assert_uint_eq(0, ck->profiles[0].alloc_bytes);
+	ck_assert_uint_eq(2, ck->profiles[1].calls);
+	ck_assert_uint_eq(2, ck->profiles[1].findings);
+	ck_assert_uint_gt(ck->profiles[1].alloc_bytes, 2 * sizeof(struct check_result) - 1);
+	ck_assert(ck->profiles[1].max_ns <= ck->profiles[1].total_ns);
+	ck_assert_uint_eq(1, ck->profiles[2].calls);
+
+	// Profiles of another thread are merged by index
+	struct check_profile other[3];
+	memset(other, 0, sizeof(other));
+	other[2].calls = 4;
+	other[2].findings = 3;
+	other[2].total_ns = 1000000000;
+	other[2].max_ns = 900000000;
+	add_check_profiles(ck, other);
+	ck_assert_uint_eq(5, ck->profiles[2].calls);
+	ck_assert_uint_eq(4, ck->profiles[2].findings);
+	ck_assert_uint_eq(900000000, ck->profiles[2].max_ns);
+
+	// The nodes of E-998 are summed up, and it took longest
+	char *buf = NULL;
+	size_t len = 0;
+	FILE *out = open_memstream(&buf, &len);
+	ck_assert_ptr_nonnull(out);
+	write_check_profiles(ck, out);
+	fclose(out);
+	ck_assert_ptr_nonnull(strstr(buf, "{ \"id\": \"E-998\", \"calls\": 7, "));
+	ck_assert_ptr_nonnull(strstr(buf, "\"findings\": 6, "));
+	ck_assert_ptr_nonnull(strstr(buf, "\"id\": \"E-999\""));
+	ck_assert(strstr(buf, "E-998") < strstr(buf, "E-999"));
+	free(buf);
+
+	suppress_output = 0;
+	xalloc_counting = 0;
+
+	free_policy_node(node);
+	free(data->filename);
+	free(data);
+	free_checks(ck);
+}
+END_TEST
+
+START_TEST (test_display_note_once) {
+	bool shown = false;
+	char *buf = NULL;
+	size_t len = 0;
+
+	FILE *out = open_memstream(&buf, &len);
+	ck_assert_ptr_nonnull(out);
+	set_result_stream(out);
+	fprintf(get_result_stream(), "finding\n");
+	display_note_once(&shown, "Note %d\n", 1);
+	display_note_once(&shown, "Note %d\n", 2);
+	set_result_stream(NULL);
+	fclose(out);
+
+	struct pending_note *notes = take_pending_notes();
+	ck_assert_ptr_nonnull(notes);
+	ck_assert_ptr_null(notes->next);
+	ck_assert_str_eq("Note 1\n", notes->text);
+	ck_assert_int_eq(strlen("finding\n"), notes->pos);
+	ck_assert_ptr_null(take_pending_notes());
+	ck_assert(!shown);
+
+	write_result_buffer(buf, len, notes);
+	ck_assert(shown);
+
+	free(buf);
+}
+END_TEST
+
 static Suite *check_hooks_suite(void) {
 	Suite *s;
 	TCase *tc_core;
@@ -210,9 +469,15 @@ static Suite *check_hooks_suite(void) {
 
 	tcase_add_test(tc_core, test_add_check);
 	tcase_add_test(tc_core, test_call_checks);
+	tcase_add_test(tc_core, test_select_file_checks);
 	tcase_add_test(tc_core, test_disable_check);
+	tcase_add_test(tc_core, test_disabled_check_bits);
+	tcase_add_test(tc_core, test_disable_check_exact_id);
 	tcase_add_test(tc_core, test_is_valid_check);
 	tcase_add_test(tc_core, test_increment_issues);
+	tcase_add_test(tc_core, test_issue_counters);
+	tcase_add_test(tc_core, test_check_profiles);
+	tcase_add_test(tc_core, test_display_note_once);
 	suite_add_tcase(s, tc_core);
 
 	return s;
@@ -0,0 +1,194 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../src/context_snapshot.h"
+#include "../src/maps.h"
+#include "../src/parse_functions.h"
+
+static char devel_dir[] = "/tmp/selint_check_snapshotXXXXXX";
+static char layer_dir[sizeof(devel_dir) + sizeof("/kernel")];
+static char header_path[sizeof(layer_dir) + sizeof("/foo.if")];
+static char snapshot_path[sizeof(devel_dir) + sizeof("/snapshot")];
+
+#define FOO_IF \
+	"## <summary>Foo</summary>\n" \
+	"interface(`foo_read',`\n" \
+	"\tgen_require(`\n" \
+	"\t\ttype foo_t;\n" \
+	"\t')\n" \
+	"\tallow $1 foo_t:file read;\n" \
+	"')\n" \
+	"\n" \
+	"interface(`foo_filetrans',`\n" \
+	"\tfiletrans_pattern($1, foo_t, foo_tmp_t, file)\n" \
+	"')\n" \
+	"\n" \
+	"template(`foo_domain_template',`\n" \
+	"\ttype $1_foo_t;\n" \
+	"\tfoo_read($1_foo_t)\n" \
+	"')\n"
+
+static void write_file(const char *path, const char *content)
+{
+	FILE *f = fopen(path, "w");
+	ck_assert_ptr_nonnull(f);
+	fputs(content, f);
+	fclose(f);
+}
+
+static void make_devel_dir(void)
+{
+	strcpy(devel_dir + strlen(devel_dir) - 6, "XXXXXX");
+	ck_assert_ptr_nonnull(mkdtemp(devel_dir));
+	snprintf(layer_dir, sizeof(layer_dir), "%s/kernel", devel_dir);
+	ck_assert_int_eq(0, mkdir(layer_dir, 0755));
+	snprintf(header_path, sizeof(header_path), "%s/foo.if", layer_dir);
+	write_file(header_path, FOO_IF);
+	snprintf(snapshot_path, sizeof(snapshot_path), "%s/snapshot", devel_dir);
+}
+
+static void remove_devel_dir(void)
+{
+	unlink(snapshot_path);
+	unlink(header_path);
+	ck_assert_int_eq(0, rmdir(layer_dir));
+	ck_assert_int_eq(0, rmdir(devel_dir));
+}
+
+START_TEST (test_context_snapshot_round_trip) {
+
+	make_devel_dir();
+
+	ck_assert_int_eq(SELINT_SUCCESS, build_context_snapshot(snapshot_path, devel_dir));
+
+	// Building leaves the maps empty
+	ck_assert_ptr_null(look_up_in_ifs_map("foo_read"));
+
+	ck_assert_int_eq(SELINT_SUCCESS, load_context_snapshot(snapshot_path, devel_dir));
+
+	ck_assert_str_eq("foo", look_up_in_ifs_map("foo_read"));
+	ck_assert_str_eq("foo", look_up_in_ifs_map("foo_filetrans"));
+	ck_assert_int_eq(1, is_filetrans_if("foo_filetrans"));
+	ck_assert_int_eq(0, is_filetrans_if("foo_read"));
+	ck_assert_str_eq("kernel", look_up_in_mod_layers_map("foo"));
+
+	const struct decl_list *decls = look_up_decl_in_template_map("foo_domain_template");
+	ck_assert_ptr_nonnull(decls);
+	ck_assert_int_eq(DECL_TYPE, decls->decl->flavor);
+	ck_assert_str_eq("$1_foo_t", decls->decl->name);
+	ck_assert_ptr_null(decls->next);
+
+	const struct if_call_list *calls = look_up_call_in_template_map("foo_domain_template");
+	ck_assert_ptr_nonnull(calls);
+	ck_assert_str_eq("foo_read", calls->call->name);
+	ck_assert_str_eq("$1_foo_t", calls->call->args->string);
+	ck_assert_ptr_null(calls->call->args->next);
+	ck_assert_ptr_null(calls->next);
+
+	cleanup_parsing();
+	free_context_snapshot();
+	remove_devel_dir();
+}
+END_TEST
+
+START_TEST (test_context_snapshot_stale) {
+
+	make_devel_dir();
+
+	ck_assert_int_eq(SELINT_SUCCESS, build_context_snapshot(snapshot_path, devel_dir));
+
+	// Snapshots only match the directory they were built from
+	ck_assert_int_eq(SELINT_PARSE_ERROR, load_context_snapshot(snapshot_path, layer_dir));
+
+	write_file(header_path, FOO_IF "\n");
+	ck_assert_int_eq(SELINT_PARSE_ERROR, load_context_snapshot(snapshot_path, devel_dir));
+	ck_assert_ptr_null(look_up_in_ifs_map("foo_read"));
+	ck_assert_ptr_null(look_up_in_mod_layers_map("foo"));
+
+	// Rebuilding picks up the change
+	ck_assert_int_eq(SELINT_SUCCESS, build_context_snapshot(snapshot_path, devel_dir));
+	ck_assert_int_eq(SELINT_SUCCESS, load_context_snapshot(snapshot_path, devel_dir));
+	ck_assert_str_eq("foo", look_up_in_ifs_map("foo_read"));
+
+	cleanup_parsing();
+	free_context_snapshot();
+	remove_devel_dir();
+}
+END_TEST
+
+START_TEST (test_context_snapshot_corrupt) {
+
+	make_devel_dir();
+
+	ck_assert_int_eq(SELINT_IO_ERROR, load_context_snapshot(snapshot_path, devel_dir));
+
+	ck_assert_int_eq(SELINT_SUCCESS, build_context_snapshot(snapshot_path, devel_dir));
+
+	FILE *f = fopen(snapshot_path, "r+");
+	ck_assert_ptr_nonnull(f);
+	ck_assert_int_eq(0, fseek(f, 20, SEEK_SET));
+	const int c = fgetc(f);
+	ck_assert_int_eq(0, fseek(f, 20, SEEK_SET));
+	fputc(c ^ 0x5a, f);
+	fclose(f);
+
+	ck_assert_int_eq(SELINT_PARSE_ERROR, load_context_snapshot(snapshot_path, devel_dir));
+	ck_assert_ptr_null(look_up_in_ifs_map("foo_read"));
+
+	cleanup_parsing();
+	free_context_snapshot();
+	remove_devel_dir();
+}
+END_TEST
+
+static Suite *context_snapshot_suite(void) {
+	Suite *s;
+	TCase *tc_core;
+
+	s = suite_create("Context snapshot");
+
+	tc_core = tcase_create("Core");
+
+	tcase_add_test(tc_core, test_context_snapshot_round_trip);
+	tcase_add_test(tc_core, test_context_snapshot_stale);
+	tcase_add_test(tc_core, test_context_snapshot_corrupt);
+	suite_add_tcase(s, tc_core);
+
+	return s;
+}
+
+int main(void) {
+
+	int number_failed = 0;
+	Suite *s;
+	SRunner *sr;
+
+	s = context_snapshot_suite();
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0)? 0 : -1;
+}
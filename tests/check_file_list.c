@@ -15,7 +15,9 @@
 */
 
 #include <check.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "../src/file_list.h"
 #
@@ -33,6 +35,7 @@ START_TEST (test_file_list_push_back) {
 
 	struct policy_file_list *list = malloc(sizeof(struct policy_file_list));
 	memset(list, 0, sizeof(struct policy_file_list));
+	ck_assert_uint_eq(0, file_list_length(list));
 
 	file_list_push_back(list, make_policy_file("file1", ast1));
 	file_list_push_back(list, make_policy_file("file2", ast2));
@@ -46,6 +49,7 @@ START_TEST (test_file_list_push_back) {
 
 	ck_assert_ptr_eq(list->tail->file->ast, ast4);
 	ck_assert_str_eq(list->tail->file->filename, "file4");
+	ck_assert_uint_eq(4, file_list_length(list));
 
 	free_file_list(list);
 
@@ -78,6 +82,37 @@ START_TEST (test_file_name_in_file_list) {
 }
 END_TEST
 
+START_TEST (test_indexed_file_list) {
+	char path[] = "/tmp/selint_file_list_XXXXXX";
+	int fd = mkstemp(path);
+	ck_assert_int_ne(-1, fd);
+	close(fd);
+
+	// The same file, by another path
+	char other_path[sizeof(path) + 2];
+	snprintf(other_path, sizeof(other_path), "/tmp/.%s", path + 4);
+
+	struct policy_file_list *list = calloc(1, sizeof(struct policy_file_list));
+	file_list_push_back(list, make_policy_file("foo", NULL));
+	index_file_list(list);
+	file_list_push_back(list, make_policy_file(path, NULL));
+
+	ck_assert_int_eq(1, file_name_in_file_list("foo", list));
+	ck_assert_int_eq(1, file_name_in_file_list(path, list));
+	ck_assert_int_eq(1, file_name_in_file_list(other_path, list));
+	ck_assert_int_eq(0, file_name_in_file_list("not_in_list", list));
+
+	unindex_file_list(list);
+	ck_assert_ptr_null(list->index);
+	ck_assert_int_eq(1, file_name_in_file_list(path, list));
+	ck_assert_int_eq(0, file_name_in_file_list(other_path, list));
+
+	index_file_list(list);
+	free_file_list(list);
+	unlink(path);
+}
+END_TEST
+
 static Suite *file_list_suite(void) {
 	Suite *s;
 	TCase *tc_core;
@@ -89,6 +124,7 @@ static Suite *file_list_suite(void) {
 	tcase_add_test(tc_core, test_file_list_push_back);
 	tcase_add_test(tc_core, test_make_policy_file);
 	tcase_add_test(tc_core, test_file_name_in_file_list);
+	tcase_add_test(tc_core, test_indexed_file_list);
 	suite_add_tcase(s, tc_core);
 
 	return s;
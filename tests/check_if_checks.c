@@ -16,6 +16,7 @@
 
 #include <check.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "test_utils.h"
 
@@ -108,8 +109,10 @@ START_TEST(test_check_type_used_but_not_required_in_if) {
 	insert_into_decl_map("baz_t", "test", DECL_TYPE);
 
 	struct av_rule_data *av_data = cur->data.av_data;
-	free(av_data->sources->string);
-	av_data->sources->string = strdup("$1");
+	free_string_list(av_data->sources);
+	av_data->sources = sl_from_str("$1");
+
+	update_names_in_tree(head);
 
 	const struct check_data cdata = { NULL, NULL, NULL, FILE_IF_FILE, NULL };
 
@@ -121,6 +124,12 @@ START_TEST(test_check_type_used_but_not_required_in_if) {
 	ck_assert_str_eq("Type baz_t is used in interface but not required", res->message);
 
 	free_check_result(res);
+
+	struct policy_node cleanup;
+	memset(&cleanup, 0, sizeof(struct policy_node));
+	cleanup.flavor = NODE_CLEANUP;
+	ck_assert_ptr_null(check_name_used_but_not_required_in_if(&cdata, &cleanup));
+
 	free_policy_node(head);
 	free_all_maps();
 
@@ -170,17 +179,39 @@ START_TEST (test_check_type_required_but_not_used_in_if) {
 
 	cur = cur->prev->first_child->next; // the declaration
 
+	update_names_in_tree(head);
+
 	const struct check_data cdata = { NULL, NULL, NULL, FILE_IF_FILE, NULL };
 
 	ck_assert_ptr_null(check_name_required_but_not_used_in_if(&cdata, cur));
 
-	free(data->name);
+	// Require another type
+	cur->next = calloc(1, sizeof(struct policy_node));
+	cur->next->prev = cur;
+	cur->next->parent = cur->parent;
+	cur = cur->next;
+
+	cur->flavor = NODE_DECL;
+
+	data = calloc(1, sizeof(struct declaration_data));
+
+	cur->data.d_data = data;
+
+	data->flavor = DECL_TYPE;
 	data->name = strdup("not_used_t");
+	update_names_in_node(cur);
 
 	struct check_result *res = check_name_required_but_not_used_in_if(&cdata, cur);
 	ck_assert_ptr_nonnull(res);
+	ck_assert_str_eq("Type not_used_t is listed in require block but not used in interface", res->message);
 
 	free_check_result(res);
+
+	struct policy_node cleanup;
+	memset(&cleanup, 0, sizeof(struct policy_node));
+	cleanup.flavor = NODE_CLEANUP;
+	ck_assert_ptr_null(check_name_required_but_not_used_in_if(&cdata, &cleanup));
+
 	free_policy_node(head);
 
 }
@@ -230,10 +261,89 @@ START_TEST (test_system_r_exception) {
 	cur->data.ra_data->from = sl_from_str("system_r");
 	cur->data.ra_data->to = sl_from_str("staff_r");
 
+	update_names_in_tree(head);
+
 	const struct check_data cdata = { NULL, NULL, NULL, FILE_IF_FILE, NULL };
 
 	ck_assert_ptr_null(check_name_used_but_not_required_in_if(&cdata, cur));
 
+	struct policy_node cleanup;
+	memset(&cleanup, 0, sizeof(struct policy_node));
+	cleanup.flavor = NODE_CLEANUP;
+	ck_assert_ptr_null(check_name_used_but_not_required_in_if(&cdata, &cleanup));
+
+	free_policy_node(head);
+	free_all_maps();
+}
+END_TEST
+
+START_TEST (test_require_after_use) {
+
+	insert_into_decl_map("foo_t", "test", DECL_TYPE);
+	insert_into_decl_map("bar_t", "test", DECL_TYPE);
+	insert_into_decl_map("baz_t", "test", DECL_TYPE);
+
+	struct policy_node *head = calloc(1, sizeof(struct policy_node));
+	head->flavor = NODE_INTERFACE_DEF;
+
+	// A rule before the require block
+	struct policy_node *before = head->first_child = calloc(1, sizeof(struct policy_node));
+	before->flavor = NODE_AV_RULE;
+	before->parent = head;
+	before->data.av_data = make_example_av_rule();
+
+	struct policy_node *cur = before->next = calloc(1, sizeof(struct policy_node));
+	cur->flavor = NODE_GEN_REQ;
+	cur->parent = head;
+	cur->prev = before;
+
+	struct policy_node *req = cur;
+
+	cur = cur->first_child = calloc(1, sizeof(struct policy_node));
+	cur->flavor = NODE_START_BLOCK;
+	cur->parent = req;
+
+	const char *types[] = { EXAMPLE_TYPE_1, EXAMPLE_TYPE_2, EXAMPLE_TYPE_3 };
+	for (int i = 0; i < 3; i++) {
+		cur->next = calloc(1, sizeof(struct policy_node));
+		cur->next->prev = cur;
+		cur->next->parent = req;
+		cur = cur->next;
+
+		cur->flavor = NODE_DECL;
+		cur->data.d_data = calloc(1, sizeof(struct declaration_data));
+		cur->data.d_data->flavor = DECL_TYPE;
+		cur->data.d_data->name = strdup(types[i]);
+	}
+
+	// And one after it
+	struct policy_node *after = req->next = calloc(1, sizeof(struct policy_node));
+	after->flavor = NODE_AV_RULE;
+	after->parent = head;
+	after->prev = req;
+	after->data.av_data = make_example_av_rule();
+
+	update_names_in_tree(head);
+
+	const struct check_data cdata = { NULL, NULL, NULL, FILE_IF_FILE, NULL };
+
+	struct check_result *res = check_name_used_but_not_required_in_if(&cdata, before);
+	ck_assert_ptr_nonnull(res);
+	ck_assert_str_eq("Type foo_t is used in interface but not required", res->message);
+	free_check_result(res);
+
+	ck_assert_ptr_null(check_name_used_but_not_required_in_if(&cdata, after));
+
+	// Out of order, the required names are collected again
+	res = check_name_used_but_not_required_in_if(&cdata, before);
+	ck_assert_ptr_nonnull(res);
+	free_check_result(res);
+
+	struct policy_node cleanup;
+	memset(&cleanup, 0, sizeof(struct policy_node));
+	cleanup.flavor = NODE_CLEANUP;
+	ck_assert_ptr_null(check_name_used_but_not_required_in_if(&cdata, &cleanup));
+
 	free_policy_node(head);
 	free_all_maps();
 }
@@ -251,6 +361,7 @@ static Suite *if_checks_suite(void) {
 	tcase_add_test(tc_core, test_check_type_used_but_not_required_in_if);
 	tcase_add_test(tc_core, test_check_type_required_but_not_used_in_if);
 	tcase_add_test(tc_core, test_system_r_exception);
+	tcase_add_test(tc_core, test_require_after_use);
 	suite_add_tcase(s, tc_core);
 
 	return s;
@@ -0,0 +1,191 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <check.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/intern.h"
+
+START_TEST (test_intern) {
+
+	char buf[] = "foo_t";
+
+	const char *atom = intern(buf);
+	ck_assert_str_eq("foo_t", atom);
+	ck_assert_ptr_ne(buf, atom);
+	ck_assert_ptr_eq(atom, intern("foo_t"));
+	ck_assert_ptr_eq(atom, intern_n("foo_t bar_t", 5));
+	ck_assert_ptr_ne(atom, intern("foo"));
+	ck_assert_ptr_eq(intern(""), intern_n("foo", 0));
+
+	// Atoms do not change with the original string
+	buf[0] = 'g';
+	ck_assert_str_eq("foo_t", atom);
+	ck_assert_ptr_ne(atom, intern(buf));
+}
+END_TEST
+
+START_TEST (test_find_atom) {
+
+	ck_assert_ptr_null(find_atom("never_interned_t"));
+
+	const char *atom = intern("now_interned_t");
+	ck_assert_ptr_eq(atom, find_atom("now_interned_t"));
+}
+END_TEST
+
+START_TEST (test_atom_stats) {
+
+	struct atom_stats before, after;
+
+	get_atom_stats(&before);
+
+	intern("stats_t");
+	intern("stats_t");
+	intern("stats_exec_t");
+
+	get_atom_stats(&after);
+
+	ck_assert_uint_eq(before.atoms + 2, after.atoms);
+	ck_assert_uint_eq(before.atom_bytes + strlen("stats_t") + strlen("stats_exec_t") + 2, after.atom_bytes);
+	ck_assert_uint_eq(before.requests + 3, after.requests);
+	ck_assert_uint_eq(before.request_bytes + 2 * strlen("stats_t") + strlen("stats_exec_t") + 3, after.request_bytes);
+}
+END_TEST
+
+#define THREADS 4
+#define NAMES 5000
+
+static void *intern_names(void *arg)
+{
+	const char **atoms = arg;
+	char name[32];
+
+	for (int i = 0; i < NAMES; i++) {
+		snprintf(name, sizeof(name), "type_%d_t", i);
+		atoms[i] = intern(name);
+	}
+
+	return NULL;
+}
+
+START_TEST (test_intern_concurrently) {
+
+	pthread_t threads[THREADS];
+	const char **atoms[THREADS];
+
+	for (int i = 0; i < THREADS; i++) {
+		atoms[i] = calloc(NAMES, sizeof(const char *));
+		ck_assert_int_eq(0, pthread_create(&threads[i], NULL, intern_names, atoms[i]));
+	}
+	for (int i = 0; i < THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	for (int i = 0; i < NAMES; i++) {
+		for (int j = 1; j < THREADS; j++) {
+			ck_assert_ptr_eq(atoms[0][i], atoms[j][i]);
+		}
+	}
+	ck_assert_str_eq("type_4999_t", atoms[0][NAMES - 1]);
+
+	for (int i = 0; i < THREADS; i++) {
+		free(atoms[i]);
+	}
+}
+END_TEST
+
+static int mismatch;
+
+static void *find_names(void *arg)
+{
+	(void)arg;
+	char name[32];
+
+	for (int i = 0; i < NAMES; i++) {
+		snprintf(name, sizeof(name), "found_%d_t", i);
+		// Atoms interned meanwhile are found or not, but never differ
+		const char *atom = find_atom(name);
+		if (atom && 0 != strcmp(atom, name)) {
+			return &mismatch;
+		}
+	}
+
+	return NULL;
+}
+
+START_TEST (test_find_atom_concurrently) {
+
+	pthread_t threads[THREADS];
+	char name[32];
+
+	for (int i = 0; i < THREADS; i++) {
+		ck_assert_int_eq(0, pthread_create(&threads[i], NULL, find_names, NULL));
+	}
+	// Grows the tables while they are read
+	for (int i = 0; i < NAMES; i++) {
+		snprintf(name, sizeof(name), "found_%d_t", i);
+		intern(name);
+	}
+	for (int i = 0; i < THREADS; i++) {
+		void *ret;
+		pthread_join(threads[i], &ret);
+		ck_assert_ptr_null(ret);
+	}
+
+	for (int i = 0; i < NAMES; i++) {
+		snprintf(name, sizeof(name), "found_%d_t", i);
+		ck_assert_ptr_eq(intern(name), find_atom(name));
+	}
+}
+END_TEST
+
+static Suite *intern_suite(void) {
+	Suite *s;
+	TCase *tc_core;
+
+	s = suite_create("Intern");
+
+	tc_core = tcase_create("Core");
+
+	tcase_add_test(tc_core, test_intern);
+	tcase_add_test(tc_core, test_find_atom);
+	tcase_add_test(tc_core, test_atom_stats);
+	tcase_add_test(tc_core, test_intern_concurrently);
+	tcase_add_test(tc_core, test_find_atom_concurrently);
+	suite_add_tcase(s, tc_core);
+
+	return s;
+}
+
+int main(void) {
+
+	int number_failed = 0;
+	Suite *s;
+	SRunner *sr;
+
+	s = intern_suite();
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0)? 0 : -1;
+}
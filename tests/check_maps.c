@@ -15,7 +15,9 @@
 */
 
 #include <check.h>
+#include <stdio.h>
 
+#include "../src/intern.h"
 #include "../src/maps.h"
 
 START_TEST (test_insert_into_type_map) {
@@ -60,6 +62,53 @@ START_TEST (test_insert_into_type_map_dup) {
 }
 END_TEST
 
+static void count_decl(const char *name, const char *module_name, void *ctx)
+{
+	unsigned int *count = ctx;
+
+	ck_assert_ptr_nonnull(look_up_in_decl_map(name, DECL_ATTRIBUTE));
+	ck_assert_str_eq(module_name, "attr_module");
+	(*count)++;
+}
+
+START_TEST (test_decl_map_growth) {
+
+	char name[32];
+
+	for (unsigned int i = 0; i < 5000; i++) {
+		snprintf(name, sizeof(name), "type%u_t", i);
+		insert_into_decl_map(name, "type_module", DECL_TYPE);
+		if (i % 2 == 0) {
+			insert_into_decl_map(name, "attr_module", DECL_ATTRIBUTE);
+		}
+	}
+
+	ck_assert_int_eq(decl_map_count(DECL_TYPE), 5000);
+	ck_assert_int_eq(decl_map_count(DECL_ATTRIBUTE), 2500);
+	ck_assert_int_eq(decl_map_count(DECL_ROLE), 0);
+
+	for (unsigned int i = 0; i < 5000; i++) {
+		snprintf(name, sizeof(name), "type%u_t", i);
+		ck_assert_str_eq(look_up_in_decl_map(name, DECL_TYPE), "type_module");
+		if (i % 2 == 0) {
+			ck_assert_str_eq(look_up_in_decl_map(name, DECL_ATTRIBUTE), "attr_module");
+		} else {
+			ck_assert_ptr_null(look_up_in_decl_map(name, DECL_ATTRIBUTE));
+		}
+		ck_assert_ptr_null(look_up_in_decl_map(name, DECL_ROLE));
+	}
+
+	unsigned int visited = 0;
+	visit_all_in_decl_map(DECL_ATTRIBUTE, count_decl, &visited);
+	ck_assert_int_eq(visited, 2500);
+
+	free_all_maps();
+
+	ck_assert_int_eq(decl_map_count(DECL_TYPE), 0);
+	ck_assert_ptr_null(look_up_in_decl_map("type0_t", DECL_TYPE));
+}
+END_TEST
+
 START_TEST (test_role_and_user_maps) {
 
 	insert_into_decl_map("foo_r", "test_module1", DECL_ROLE);
@@ -121,6 +170,62 @@ START_TEST (test_class_and_perm_maps) {
 }
 END_TEST
 
+START_TEST (test_class_perms) {
+
+	char name[32];
+
+	insert_into_decl_map("file", "class", DECL_CLASS);
+	insert_into_decl_map("dir", "class", DECL_CLASS);
+	insert_into_decl_map("fd", "class", DECL_CLASS);
+
+	// Spread the permission ids over several words
+	for (unsigned int i = 0; i < 200; i++) {
+		snprintf(name, sizeof(name), "perm%u", i);
+		insert_into_decl_map(name, "perm", DECL_PERM);
+		if (i % 3 == 0) {
+			insert_into_class_perms("file", name);
+		} else {
+			insert_into_class_perms("dir", name);
+		}
+	}
+
+	// Undeclared classes and permissions are ignored
+	insert_into_class_perms("socket", "perm1");
+	insert_into_class_perms("file", "unknown");
+
+	for (unsigned int i = 0; i < 200; i++) {
+		snprintf(name, sizeof(name), "perm%u", i);
+		const char *perm = find_atom(name);
+		ck_assert_int_eq(class_has_perm(intern("file"), perm), i % 3 == 0);
+		ck_assert_int_eq(class_has_perm(intern("dir"), perm), i % 3 != 0);
+		// No permissions recorded
+		ck_assert_int_eq(class_has_perm(intern("fd"), perm), -1);
+	}
+
+	ck_assert_int_eq(class_has_perm(intern("socket"), intern("perm1")), -1);
+	ck_assert_int_eq(class_has_perm(intern("file"), intern("unknown")), -1);
+	ck_assert_int_eq(class_has_perm(NULL, intern("perm1")), -1);
+
+	free_all_maps();
+
+	// Staged class permissions are applied in order with the declarations
+	struct map_changes *changes = alloc_map_changes();
+	stage_map_changes(changes);
+	insert_into_decl_map("file", "class", DECL_CLASS);
+	insert_into_decl_map("read", "perm", DECL_PERM);
+	insert_into_class_perms("file", "read");
+	stage_map_changes(NULL);
+
+	ck_assert_int_eq(class_has_perm(intern("file"), intern("read")), -1);
+
+	commit_map_changes(changes);
+
+	ck_assert_int_eq(class_has_perm(intern("file"), intern("read")), 1);
+
+	free_all_maps();
+}
+END_TEST
+
 START_TEST (test_mods_map) {
 
 	insert_into_mods_map("systemd", "base");
@@ -250,6 +355,187 @@ START_TEST (test_permmacro_map) {
 }
 END_TEST
 
+static int test_deferred_change_count = 0;
+
+static void test_deferred_change_apply(void *ctx)
+{
+	// Insertions staged before are visible
+	ck_assert_ptr_nonnull(look_up_in_decl_map("foo_t", DECL_TYPE));
+	test_deferred_change_count += *(int *)ctx;
+}
+
+static void test_deferred_change_retract(void *ctx)
+{
+	test_deferred_change_count -= *(int *)ctx;
+}
+
+static void test_deferred_change_free(void *ctx)
+{
+	free(ctx);
+}
+
+START_TEST (test_staged_map_changes) {
+
+	struct map_changes *changes = alloc_map_changes();
+
+	stage_map_changes(changes);
+	ck_assert_int_eq(is_staging_map_changes(), 1);
+
+	insert_into_decl_map("foo_t", "foo", DECL_TYPE);
+	mark_used_if("foo_read");
+	int *ctx = malloc(sizeof(int));
+	*ctx = 5;
+	defer_map_change(test_deferred_change_apply, test_deferred_change_retract, ctx, test_deferred_change_free);
+
+	stage_map_changes(NULL);
+	ck_assert_int_eq(is_staging_map_changes(), 0);
+
+	ck_assert_ptr_null(look_up_in_decl_map("foo_t", DECL_TYPE));
+	ck_assert_int_eq(is_used_if("foo_read"), 0);
+	ck_assert_int_eq(test_deferred_change_count, 0);
+
+	commit_map_changes(changes);
+
+	ck_assert_str_eq(look_up_in_decl_map("foo_t", DECL_TYPE), "foo");
+	ck_assert_int_eq(is_used_if("foo_read"), 1);
+	ck_assert_int_eq(test_deferred_change_count, 5);
+
+	changes = alloc_map_changes();
+	stage_map_changes(changes);
+	insert_into_decl_map("bar_t", "bar", DECL_TYPE);
+	ctx = malloc(sizeof(int));
+	*ctx = 1;
+	defer_map_change(test_deferred_change_apply, test_deferred_change_retract, ctx, test_deferred_change_free);
+	stage_map_changes(NULL);
+
+	free_map_changes(changes);
+
+	ck_assert_ptr_null(look_up_in_decl_map("bar_t", DECL_TYPE));
+	ck_assert_int_eq(test_deferred_change_count, 5);
+
+	free_all_maps();
+}
+END_TEST
+
+START_TEST (test_replay_map_changes) {
+
+	insert_into_mods_map("foo", "base");
+
+	struct map_changes *changes = alloc_map_changes();
+
+	stage_map_changes(changes);
+	insert_into_decl_map("foo_t", "foo", DECL_TYPE);
+	insert_into_ifs_map("foo_read", "foo");
+	insert_template_into_template_map("foo_domain");
+	insert_decl_into_template_map("foo_domain", DECL_TYPE, "$1_t");
+	stage_map_changes(NULL);
+
+	replay_map_changes(changes);
+
+	ck_assert_str_eq(look_up_in_decl_map("foo_t", DECL_TYPE), "foo");
+	ck_assert_str_eq(look_up_in_ifs_map("foo_read"), "foo");
+	ck_assert_ptr_nonnull(look_up_decl_in_template_map("foo_domain"));
+
+	reset_policy_maps();
+
+	ck_assert_ptr_null(look_up_in_decl_map("foo_t", DECL_TYPE));
+	ck_assert_ptr_null(look_up_in_ifs_map("foo_read"));
+	ck_assert_ptr_null(look_up_in_template_map("foo_domain"));
+	ck_assert_str_eq(look_up_in_mods_map("foo"), "base");
+
+	replay_map_changes(changes);
+
+	ck_assert_str_eq(look_up_in_decl_map("foo_t", DECL_TYPE), "foo");
+	ck_assert_str_eq(look_up_in_ifs_map("foo_read"), "foo");
+	const struct decl_list *decls = look_up_decl_in_template_map("foo_domain");
+	ck_assert_ptr_nonnull(decls);
+	ck_assert_str_eq(decls->decl->name, "$1_t");
+	ck_assert_ptr_null(decls->next);
+
+	free_map_changes(changes);
+	free_all_maps();
+}
+END_TEST
+
+START_TEST (test_retract_map_changes) {
+
+	struct map_changes *first = alloc_map_changes();
+	struct map_changes *second = alloc_map_changes();
+
+	stage_map_changes(first);
+	insert_into_decl_map("foo_t", "foo", DECL_TYPE);
+	insert_into_decl_map("foo_exec_t", "foo", DECL_TYPE);
+	insert_into_ifs_map("foo_read", "foo");
+	mark_used_if("bar_read");
+	insert_template_into_template_map("foo_domain");
+	insert_decl_into_template_map("foo_domain", DECL_TYPE, "$1_t");
+	int *ctx = malloc(sizeof(int));
+	*ctx = 3;
+	defer_map_change(test_deferred_change_apply, test_deferred_change_retract, ctx, test_deferred_change_free);
+	stage_map_changes(second);
+	insert_into_decl_map("foo_t", "other", DECL_TYPE);
+	mark_used_if("bar_read");
+	insert_decl_into_template_map("foo_domain", DECL_TYPE, "$1_exec_t");
+	stage_map_changes(NULL);
+
+	test_deferred_change_count = 0;
+	replay_map_changes(first);
+	replay_map_changes(second);
+
+	ck_assert_uint_eq(decl_map_count(DECL_TYPE), 2);
+	ck_assert_int_eq(test_deferred_change_count, 3);
+
+	retract_map_changes(first);
+
+	// What the second changes inserted too is kept
+	ck_assert_str_eq(look_up_in_decl_map("foo_t", DECL_TYPE), "foo");
+	ck_assert_ptr_null(look_up_in_decl_map("foo_exec_t", DECL_TYPE));
+	ck_assert_uint_eq(decl_map_count(DECL_TYPE), 1);
+	ck_assert_ptr_null(look_up_in_ifs_map("foo_read"));
+	ck_assert_int_eq(is_used_if("bar_read"), 1);
+	ck_assert_int_eq(test_deferred_change_count, 0);
+	const struct decl_list *decls = look_up_decl_in_template_map("foo_domain");
+	ck_assert_ptr_nonnull(decls);
+	ck_assert_str_eq(decls->decl->name, "$1_exec_t");
+	ck_assert_ptr_null(decls->next);
+
+	retract_map_changes(second);
+
+	ck_assert_ptr_null(look_up_in_decl_map("foo_t", DECL_TYPE));
+	ck_assert_uint_eq(decl_map_count(DECL_TYPE), 0);
+	ck_assert_int_eq(is_used_if("bar_read"), 0);
+	ck_assert_ptr_null(look_up_in_template_map("foo_domain"));
+
+	// Declared again, by another module
+	replay_map_changes(second);
+	ck_assert_str_eq(look_up_in_decl_map("foo_t", DECL_TYPE), "other");
+	ck_assert_uint_eq(decl_map_count(DECL_TYPE), 1);
+	ck_assert_int_eq(changes_template_map(second), 1);
+
+	free_map_changes(first);
+	free_map_changes(second);
+	free_all_maps();
+}
+END_TEST
+
+START_TEST (test_derived_transform_ifs) {
+
+	mark_transform_if("foo_transform");
+	mark_derived_transform_if("foo_transform");
+	mark_derived_transform_if("bar_transform");
+
+	ck_assert_int_eq(is_transform_if("foo_transform"), 1);
+	ck_assert_int_eq(is_transform_if("bar_transform"), 1);
+
+	clear_derived_transform_ifs();
+
+	ck_assert_int_eq(is_transform_if("foo_transform"), 1);
+	ck_assert_int_eq(is_transform_if("bar_transform"), 0);
+
+	free_all_maps();
+}
+END_TEST
+
 static Suite *maps_suite(void) {
 	Suite *s;
 	TCase *tc_core;
@@ -260,12 +546,18 @@ static Suite *maps_suite(void) {
 
 	tcase_add_test(tc_core, test_insert_into_type_map);
 	tcase_add_test(tc_core, test_insert_into_type_map_dup);
+	tcase_add_test(tc_core, test_decl_map_growth);
 	tcase_add_test(tc_core, test_role_and_user_maps);
 	tcase_add_test(tc_core, test_class_and_perm_maps);
+	tcase_add_test(tc_core, test_class_perms);
 	tcase_add_test(tc_core, test_mods_map);
 	tcase_add_test(tc_core, test_insert_decl_into_template_map);
 	tcase_add_test(tc_core, test_insert_call_into_template_map);
 	tcase_add_test(tc_core, test_permmacro_map);
+	tcase_add_test(tc_core, test_staged_map_changes);
+	tcase_add_test(tc_core, test_replay_map_changes);
+	tcase_add_test(tc_core, test_retract_map_changes);
+	tcase_add_test(tc_core, test_derived_transform_ifs);
 	suite_add_tcase(s, tc_core);
 
 	return s;
@@ -262,6 +262,57 @@ START_TEST (test_name_list_contains) {
 }
 END_TEST
 
+START_TEST (test_name_set_contains) {
+
+	struct name_list *d;
+	struct name_list *nl = concat_name_lists(
+		name_list_create("foo", NAME_TYPEATTRIBUTE),
+		name_list_create("bar", NAME_ROLE));
+
+	struct name_set *set = alloc_name_set();
+	name_set_add_list(set, nl);
+
+	// Same matches as name_list_contains_name()
+	d = name_list_create("foo", NAME_TYPE_OR_ATTRIBUTE);
+	ck_assert_int_eq(1, name_set_contains(set, d->data));
+	free_name_list(d);
+
+	d = name_list_create("foo", NAME_UNKNOWN);
+	ck_assert_int_eq(1, name_set_contains(set, d->data));
+	free_name_list(d);
+
+	d = name_list_create("foo", NAME_TYPE);
+	ck_assert_int_eq(0, name_set_contains(set, d->data));
+	free_name_list(d);
+
+	d = name_list_create("bar", NAME_ROLE_OR_ATTRIBUTE);
+	ck_assert_int_eq(1, name_set_contains(set, d->data));
+	free_name_list(d);
+
+	d = name_list_create("bar", NAME_ROLEATTRIBUTE);
+	ck_assert_int_eq(0, name_set_contains(set, d->data));
+	free_name_list(d);
+
+	d = name_list_create("baz", NAME_UNKNOWN);
+	ck_assert_int_eq(0, name_set_contains(set, d->data));
+	free_name_list(d);
+
+	// A name added with a second flavor matches both
+	d = name_list_create("foo", NAME_TYPE);
+	name_set_add(set, d->data);
+	ck_assert_int_eq(1, name_set_contains(set, d->data));
+	free_name_list(d);
+
+	d = name_list_create("foo", NAME_TYPEATTRIBUTE);
+	ck_assert_int_eq(1, name_set_contains(set, d->data));
+	free_name_list(d);
+
+	free_name_set(set);
+	free_name_list(nl);
+
+}
+END_TEST
+
 static Suite *name_list_suite(void) {
 	Suite *s;
 	TCase *tc_core;
@@ -276,6 +327,7 @@ static Suite *name_list_suite(void) {
 	tcase_add_test(tc_core, test_name_lists_from_type_decl);
 	tcase_add_test(tc_core, test_name_lists_from_class_decl);
 	tcase_add_test(tc_core, test_name_list_contains);
+	tcase_add_test(tc_core, test_name_set_contains);
 	suite_add_tcase(s, tc_core);
 
 	return s;
@@ -242,25 +242,28 @@ START_TEST (test_get_local_subsection) {
 
 	ck_assert_int_eq(LSS_SELF, get_local_subsection("foo", node, ORDER_REF));
 
-	free(node->data.av_data->targets->string);
+	free_string_list(node->data.av_data->targets);
 	node->data.av_data->sources = calloc(1, sizeof(struct string_list));
 	node->data.av_data->sources->string = strdup("foo_t");
-	node->data.av_data->targets->string = strdup("foo_log_t");
+	node->data.av_data->targets = sl_from_str("foo_log_t");
 
 	insert_into_decl_map("foo_t", "foo", DECL_TYPE);
 	insert_into_decl_map("foo_log_t", "foo", DECL_TYPE);
 	insert_into_decl_map("foo_config", "foo", DECL_ATTRIBUTE);
+	update_names_in_node(node);
 
 	ck_assert_int_eq(LSS_OWN, get_local_subsection("foo", node, ORDER_REF));
 
-	free(node->data.av_data->targets->string);
-	node->data.av_data->targets->string = strdup("foo_config");
+	free_string_list(node->data.av_data->targets);
+	node->data.av_data->targets = sl_from_str("foo_config");
+	update_names_in_node(node);
 
 	ck_assert_int_eq(LSS_OWN, get_local_subsection("foo", node, ORDER_REF));
 
-	free(node->data.av_data->targets->string);
-	node->data.av_data->targets->string = strdup("bar_data_t");
+	free_string_list(node->data.av_data->targets);
+	node->data.av_data->targets = sl_from_str("bar_data_t");
 	insert_into_decl_map("bar_data_t", "bar", DECL_TYPE);
+	update_names_in_node(node);
 
 	// raw allow to other module.  Not mentioned in style guide
 	ck_assert_int_eq(LSS_UNKNOWN, get_local_subsection("foo", node, ORDER_REF));
@@ -0,0 +1,490 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <check.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/maps.h"
+#include "../src/parse.h"
+#include "../src/parse_cache.h"
+#include "../src/parse_functions.h"
+
+#define POLICIES_DIR SAMPLE_POL_DIR
+#define BASIC_TE_FILENAME POLICIES_DIR "basic.te"
+#define DECLARING_TEMPLATE_IF_FILENAME POLICIES_DIR "declaring_template.if"
+#define UNCOMMON_TE_FILENAME POLICIES_DIR "uncommon.te"
+
+static char cache_dir[] = "/tmp/selint_check_cacheXXXXXX";
+
+static void make_cache_dir(void)
+{
+	strcpy(cache_dir + strlen(cache_dir) - 6, "XXXXXX");
+	ck_assert_ptr_nonnull(mkdtemp(cache_dir));
+	ck_assert_int_eq(SELINT_SUCCESS, enable_parse_cache(cache_dir));
+}
+
+// Return the path of the only entry in the cache directory besides the
+// file named except, if not NULL
+static char *only_entry_except(const char *except)
+{
+	char *path = NULL;
+	DIR *dir = opendir(cache_dir);
+	ck_assert_ptr_nonnull(dir);
+
+	const struct dirent *entry;
+	while ((entry = readdir(dir))) {
+		if (entry->d_name[0] == '.' || (except && 0 == strcmp(entry->d_name, except))) {
+			continue;
+		}
+		ck_assert_ptr_null(path);
+		path = malloc(strlen(cache_dir) + strlen(entry->d_name) + 2);
+		sprintf(path, "%s/%s", cache_dir, entry->d_name);
+	}
+
+	closedir(dir);
+	ck_assert_ptr_nonnull(path);
+
+	return path;
+}
+
+// Return the path of the only entry in the cache directory
+static char *only_entry(void)
+{
+	return only_entry_except(NULL);
+}
+
+static void remove_cache_dir(void)
+{
+	DIR *dir = opendir(cache_dir);
+	ck_assert_ptr_nonnull(dir);
+
+	const struct dirent *entry;
+	while ((entry = readdir(dir))) {
+		if (0 == strcmp(entry->d_name, ".") || 0 == strcmp(entry->d_name, "..")) {
+			continue;
+		}
+		char path[256];
+		snprintf(path, sizeof(path), "%s/%s", cache_dir, entry->d_name);
+		ck_assert_int_eq(0, unlink(path));
+	}
+
+	closedir(dir);
+	ck_assert_int_eq(0, rmdir(cache_dir));
+}
+
+// Parse a file recording its map changes, as the runner does on a miss
+static struct policy_node *parse_recording(const char *filename, const char *mod_name,
+                                           enum node_flavor flavor,
+                                           struct map_changes *changes)
+{
+	set_current_module_name(mod_name);
+	stage_map_changes(changes);
+
+	FILE *f = fopen(filename, "r");
+	ck_assert_ptr_nonnull(f);
+	struct policy_node *ast = yyparse_wrapper(f, filename, flavor);
+	fclose(f);
+
+	stage_map_changes(NULL);
+	ck_assert_ptr_nonnull(ast);
+
+	return ast;
+}
+
+static void assert_same_sl(const struct string_list *a, const struct string_list *b)
+{
+	while (a && b) {
+		ck_assert_str_eq(a->string, b->string);
+		ck_assert_int_eq(a->has_incorrect_space, b->has_incorrect_space);
+		ck_assert_int_eq(a->arg_start, b->arg_start);
+		a = a->next;
+		b = b->next;
+	}
+	ck_assert_ptr_null(a);
+	ck_assert_ptr_null(b);
+}
+
+static void assert_same_str(const char *a, const char *b)
+{
+	if (a && b) {
+		ck_assert_str_eq(a, b);
+	} else {
+		ck_assert_ptr_eq(a, b);
+	}
+}
+
+static void assert_same_tree(const struct policy_node *a, const struct policy_node *b)
+{
+	while (a && b) {
+		ck_assert_int_eq(a->flavor, b->flavor);
+		ck_assert_uint_eq(a->lineno, b->lineno);
+		assert_same_str(a->exceptions, b->exceptions);
+
+		switch (a->flavor) {
+		case NODE_HEADER:
+			ck_assert_int_eq(a->data.h_data->flavor, b->data.h_data->flavor);
+			ck_assert_str_eq(a->data.h_data->module_name, b->data.h_data->module_name);
+			break;
+		case NODE_AV_RULE:
+			ck_assert_int_eq(a->data.av_data->flavor, b->data.av_data->flavor);
+			assert_same_sl(a->data.av_data->sources, b->data.av_data->sources);
+			assert_same_sl(a->data.av_data->targets, b->data.av_data->targets);
+			assert_same_sl(a->data.av_data->object_classes, b->data.av_data->object_classes);
+			assert_same_sl(a->data.av_data->perms, b->data.av_data->perms);
+			break;
+		case NODE_IF_CALL:
+			ck_assert_str_eq(a->data.ic_data->name, b->data.ic_data->name);
+			assert_same_sl(a->data.ic_data->args, b->data.ic_data->args);
+			break;
+		case NODE_DECL:
+			ck_assert_int_eq(a->data.d_data->flavor, b->data.d_data->flavor);
+			ck_assert_str_eq(a->data.d_data->name, b->data.d_data->name);
+			assert_same_sl(a->data.d_data->attrs, b->data.d_data->attrs);
+			break;
+		case NODE_TT_RULE:
+			assert_same_sl(a->data.tt_data->sources, b->data.tt_data->sources);
+			ck_assert_str_eq(a->data.tt_data->default_type, b->data.tt_data->default_type);
+			assert_same_str(a->data.tt_data->name, b->data.tt_data->name);
+			break;
+		default:
+			break;
+		}
+
+		if (a->first_child || b->first_child) {
+			ck_assert_ptr_eq(a, a->first_child->parent);
+			ck_assert_ptr_eq(b, b->first_child->parent);
+		}
+		assert_same_tree(a->first_child, b->first_child);
+
+		a = a->next;
+		b = b->next;
+	}
+	ck_assert_ptr_null(a);
+	ck_assert_ptr_null(b);
+}
+
+static void assert_same_changes(const struct map_changes *a, const struct map_changes *b)
+{
+	const struct map_change *ca = first_map_change(a);
+	const struct map_change *cb = first_map_change(b);
+
+	ck_assert_ptr_nonnull(ca);
+
+	while (ca && cb) {
+		ck_assert_int_eq(ca->flavor, cb->flavor);
+		// Names and values are atoms
+		ck_assert_ptr_eq(ca->name, cb->name);
+		ck_assert_ptr_eq(ca->value, cb->value);
+		ca = ca->next;
+		cb = cb->next;
+	}
+	ck_assert_ptr_null(ca);
+	ck_assert_ptr_null(cb);
+}
+
+static void check_round_trip(const char *filename, const char *mod_name, enum node_flavor flavor)
+{
+	struct parse_cache_key key;
+	struct map_changes *parsed_changes = alloc_map_changes();
+
+	ck_assert_ptr_null(load_cached_parse(filename, flavor, &key, parsed_changes));
+	ck_assert_ptr_null(first_map_change(parsed_changes));
+	struct policy_node *parsed = parse_recording(filename, mod_name, flavor, parsed_changes);
+	store_cached_parse(&key, parsed, parsed_changes);
+	free_parse_cache_key(&key);
+
+	struct map_changes *loaded_changes = alloc_map_changes();
+	struct policy_node *loaded = load_cached_parse(filename, flavor, &key, loaded_changes);
+	free_parse_cache_key(&key);
+	ck_assert_ptr_nonnull(loaded);
+
+	assert_same_tree(parsed, loaded);
+	assert_same_changes(parsed_changes, loaded_changes);
+
+	// Interface calls in templates refer to the loaded tree
+	for (const struct map_change *change = first_map_change(loaded_changes); change; change = change->next) {
+		if (change->flavor == CHANGE_TEMPLATE_CALL) {
+			int found = 0;
+			for (const struct policy_node *cur = loaded; cur; cur = dfs_next(cur)) {
+				if (cur->flavor == NODE_IF_CALL && cur->data.ic_data == change->data.call) {
+					found = 1;
+				}
+			}
+			ck_assert_int_eq(1, found);
+		}
+	}
+
+	free_map_changes(parsed_changes);
+	free_map_changes(loaded_changes);
+	free_policy_node(parsed);
+	free_policy_node(loaded);
+}
+
+START_TEST (test_parse_cache_round_trip) {
+
+	make_cache_dir();
+
+	struct parse_cache_stats before, after;
+	get_parse_cache_stats(&before);
+
+	check_round_trip(BASIC_TE_FILENAME, "basic", NODE_TE_FILE);
+	check_round_trip(UNCOMMON_TE_FILENAME, "uncommon", NODE_TE_FILE);
+	check_round_trip(DECLARING_TEMPLATE_IF_FILENAME, "declaring_template", NODE_IF_FILE);
+
+	get_parse_cache_stats(&after);
+	ck_assert_uint_eq(before.hits + 3, after.hits);
+	ck_assert_uint_eq(before.misses + 3, after.misses);
+	ck_assert_uint_eq(before.stores + 3, after.stores);
+
+	remove_cache_dir();
+	cleanup_parsing();
+}
+END_TEST
+
+static void write_file(const char *path, const char *content)
+{
+	FILE *f = fopen(path, "w");
+	ck_assert_ptr_nonnull(f);
+	fputs(content, f);
+	fclose(f);
+}
+
+static struct policy_node *load(const char *filename, enum node_flavor flavor)
+{
+	struct parse_cache_key key;
+	struct map_changes *changes = alloc_map_changes();
+
+	struct policy_node *ast = load_cached_parse(filename, flavor, &key, changes);
+	if (ast) {
+		ck_assert_ptr_nonnull(first_map_change(changes));
+	} else {
+		ck_assert_ptr_null(first_map_change(changes));
+	}
+
+	free_parse_cache_key(&key);
+	free_map_changes(changes);
+
+	return ast;
+}
+
+static void parse_and_store(const char *filename, const char *mod_name, enum node_flavor flavor)
+{
+	struct parse_cache_key key;
+	struct map_changes *changes = alloc_map_changes();
+
+	ck_assert_ptr_null(load_cached_parse(filename, flavor, &key, changes));
+	struct policy_node *ast = parse_recording(filename, mod_name, flavor, changes);
+	store_cached_parse(&key, ast, changes);
+
+	free_parse_cache_key(&key);
+	free_map_changes(changes);
+	free_policy_node(ast);
+}
+
+START_TEST (test_parse_cache_invalidation) {
+
+	make_cache_dir();
+
+	char policy_path[] = "/tmp/selint_check_policyXXXXXX";
+	ck_assert_ptr_nonnull(mkdtemp(policy_path));
+	char te_path[64];
+	snprintf(te_path, sizeof(te_path), "%s/cached.te", policy_path);
+
+	write_file(te_path, "policy_module(cached, 1.0)\ntype cached_t;\n");
+	parse_and_store(te_path, "cached", NODE_TE_FILE);
+
+	struct policy_node *ast = load(te_path, NODE_TE_FILE);
+	ck_assert_ptr_nonnull(ast);
+	free_policy_node(ast);
+
+	// The flavor is part of the key
+	ck_assert_ptr_null(load(te_path, NODE_IF_FILE));
+
+	// So is the content
+	write_file(te_path, "policy_module(cached, 1.0)\ntype changed_t;\n");
+	ck_assert_ptr_null(load(te_path, NODE_TE_FILE));
+
+	write_file(te_path, "policy_module(cached, 1.0)\ntype cached_t;\n");
+	ast = load(te_path, NODE_TE_FILE);
+	ck_assert_ptr_nonnull(ast);
+	ck_assert_str_eq("cached_t", ast->next->next->data.d_data->name);
+	free_policy_node(ast);
+
+	// And the module name
+	char renamed_path[64];
+	snprintf(renamed_path, sizeof(renamed_path), "%s/renamed.te", policy_path);
+	ck_assert_int_eq(0, rename(te_path, renamed_path));
+	ck_assert_ptr_null(load(renamed_path, NODE_TE_FILE));
+
+	// Files that cannot be read are never hits
+	ck_assert_ptr_null(load(te_path, NODE_TE_FILE));
+
+	ck_assert_int_eq(0, unlink(renamed_path));
+	ck_assert_int_eq(0, rmdir(policy_path));
+	remove_cache_dir();
+	cleanup_parsing();
+}
+END_TEST
+
+START_TEST (test_parse_cache_corrupt_entry) {
+
+	make_cache_dir();
+
+	parse_and_store(BASIC_TE_FILENAME, "basic", NODE_TE_FILE);
+
+	char *entry = only_entry();
+	FILE *f = fopen(entry, "r+");
+	ck_assert_ptr_nonnull(f);
+	ck_assert_int_eq(0, fseek(f, 0, SEEK_END));
+	const long len = ftell(f);
+
+	// Flip a byte in the middle
+	ck_assert_int_eq(0, fseek(f, len / 2, SEEK_SET));
+	const int byte = fgetc(f);
+	ck_assert_int_eq(0, fseek(f, len / 2, SEEK_SET));
+	fputc(byte ^ 0x20, f);
+	fclose(f);
+
+	ck_assert_ptr_null(load(BASIC_TE_FILENAME, NODE_TE_FILE));
+
+	// Truncated
+	parse_and_store(BASIC_TE_FILENAME, "basic", NODE_TE_FILE);
+	ck_assert_int_eq(0, truncate(entry, len - 3));
+	ck_assert_ptr_null(load(BASIC_TE_FILENAME, NODE_TE_FILE));
+
+	// Rewritten
+	parse_and_store(BASIC_TE_FILENAME, "basic", NODE_TE_FILE);
+	struct policy_node *ast = load(BASIC_TE_FILENAME, NODE_TE_FILE);
+	ck_assert_ptr_nonnull(ast);
+	free_policy_node(ast);
+
+	free(entry);
+	remove_cache_dir();
+	cleanup_parsing();
+}
+END_TEST
+
+// Create an empty file in the cache directory, last modified age seconds ago
+static void make_cache_file(const char *name, time_t age)
+{
+	char path[256];
+	snprintf(path, sizeof(path), "%s/%s", cache_dir, name);
+
+	FILE *f = fopen(path, "w");
+	ck_assert_ptr_nonnull(f);
+	fclose(f);
+
+	const struct timespec times[2] = {
+		{ .tv_sec = time(NULL) - age, .tv_nsec = 0 },
+		{ .tv_sec = time(NULL) - age, .tv_nsec = 0 },
+	};
+	ck_assert_int_eq(0, utimensat(AT_FDCWD, path, times, 0));
+}
+
+static int cache_file_exists(const char *name)
+{
+	char path[256];
+	snprintf(path, sizeof(path), "%s/%s", cache_dir, name);
+
+	return 0 == access(path, F_OK);
+}
+
+#define ENTRY_NAME(c) #c "000000000000000000000000000000" #c ".ast"
+
+START_TEST (test_parse_cache_prune) {
+
+	make_cache_dir();
+
+	make_cache_file(ENTRY_NAME(1), 300);
+	make_cache_file(ENTRY_NAME(2), 100);
+	make_cache_file(ENTRY_NAME(3), 200);
+	make_cache_file(".tmp-abandoned", 2 * 3600);
+	make_cache_file(".tmp-writing", 10);
+	make_cache_file("unrelated", 1000);
+
+	ck_assert_int_eq(SELINT_SUCCESS, prune_parse_cache(3));
+	ck_assert(cache_file_exists(ENTRY_NAME(1)));
+	ck_assert(!cache_file_exists(".tmp-abandoned"));
+	ck_assert(cache_file_exists(".tmp-writing"));
+
+	// The least recently used entries go first
+	ck_assert_int_eq(SELINT_SUCCESS, prune_parse_cache(1));
+	ck_assert(!cache_file_exists(ENTRY_NAME(1)));
+	ck_assert(cache_file_exists(ENTRY_NAME(2)));
+	ck_assert(!cache_file_exists(ENTRY_NAME(3)));
+	ck_assert(cache_file_exists("unrelated"));
+
+	// Hits make entries recently used
+	parse_and_store(BASIC_TE_FILENAME, "basic", NODE_TE_FILE);
+	char *entry = only_entry_except(ENTRY_NAME(2));
+	const struct timespec times[2] = {
+		{ .tv_sec = time(NULL) - 1000, .tv_nsec = 0 },
+		{ .tv_sec = time(NULL) - 1000, .tv_nsec = 0 },
+	};
+	ck_assert_int_eq(0, utimensat(AT_FDCWD, entry, times, 0));
+	struct policy_node *ast = load(BASIC_TE_FILENAME, NODE_TE_FILE);
+	ck_assert_ptr_nonnull(ast);
+	free_policy_node(ast);
+
+	ck_assert_int_eq(SELINT_SUCCESS, prune_parse_cache(1));
+	ck_assert_int_eq(0, access(entry, F_OK));
+	ck_assert(!cache_file_exists(ENTRY_NAME(2)));
+
+	free(entry);
+	remove_cache_dir();
+	cleanup_parsing();
+}
+END_TEST
+
+static Suite *parse_cache_suite(void) {
+	Suite *s;
+	TCase *tc_core;
+
+	s = suite_create("Parse_cache");
+
+	tc_core = tcase_create("Core");
+
+	tcase_add_test(tc_core, test_parse_cache_round_trip);
+	tcase_add_test(tc_core, test_parse_cache_invalidation);
+	tcase_add_test(tc_core, test_parse_cache_corrupt_entry);
+	tcase_add_test(tc_core, test_parse_cache_prune);
+	suite_add_tcase(s, tc_core);
+
+	return s;
+}
+
+int main(void) {
+
+	int number_failed = 0;
+	Suite *s;
+	SRunner *sr;
+
+	s = parse_cache_suite();
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0)? 0 : -1;
+}
@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "../src/arena.h"
 #include "../src/tree.h"
 #include "../src/parse_fc.h"
 
@@ -248,6 +249,55 @@ START_TEST (test_parse_none_context) {
 }
 END_TEST
 
+START_TEST (test_parse_fc_line_whitespace) {
+	char line[] = "  /usr/bin/foo\t-- \tgen_context(system_u:object_r:foo_exec_t, s0 - s0, c0.c1023)";
+
+	struct fc_entry *out = parse_fc_line(line);
+
+	ck_assert_ptr_nonnull(out);
+	ck_assert_str_eq("/usr/bin/foo", out->path);
+	ck_assert_int_eq('-', out->obj);
+	ck_assert_ptr_nonnull(out->context);
+	ck_assert_str_eq("foo_exec_t", out->context->type);
+	ck_assert_str_eq("s0 - s0:c0.c1023", out->context->range);
+
+	free_fc_entry(out);
+
+	char line2[] = "/usr/bin/foo -";
+
+	ck_assert_ptr_null(parse_fc_line(line2));
+
+	char line3[] = "/usr/bin/foo -ab system_u:object_r:foo_exec_t";
+
+	ck_assert_ptr_null(parse_fc_line(line3));
+}
+END_TEST
+
+START_TEST (test_parse_fc_file_in_arena) {
+	struct arena *arena = alloc_arena();
+
+	set_active_arena(arena);
+	struct policy_node *ast = parse_fc_file(BASIC_FC_FILENAME, NULL);
+	set_active_arena(NULL);
+
+	ck_assert_ptr_nonnull(ast);
+	ck_assert_int_eq(1, ast->arena_owned);
+	ck_assert_ptr_nonnull(ast->next);
+	ck_assert_int_eq(NODE_FC_ENTRY, ast->next->flavor);
+
+	const struct fc_entry *data = ast->next->data.fc_data;
+
+	ck_assert_int_eq(1, arena_owns(arena, data));
+	ck_assert_int_eq(1, arena_owns(arena, data->path));
+	ck_assert_int_eq(1, arena_owns(arena, data->context->type));
+	ck_assert_str_eq("basic_t", data->context->type);
+
+	// A no-op for arena-owned nodes
+	free_policy_node(ast);
+	free_arena(arena);
+}
+END_TEST
+
 START_TEST (test_check_for_fc_macro) {
 	ck_assert_int_eq(0, check_for_fc_macro("foo(`bar')", NULL));
 
@@ -279,6 +329,8 @@ static Suite *parse_fc_suite(void) {
 	tcase_add_test(tc_core, test_parse_basic_fc_file);
 	tcase_add_test(tc_core, test_parse_m4);
 	tcase_add_test(tc_core, test_parse_none_context);
+	tcase_add_test(tc_core, test_parse_fc_line_whitespace);
+	tcase_add_test(tc_core, test_parse_fc_file_in_arena);
 	tcase_add_test(tc_core, test_check_for_fc_macro);
 	suite_add_tcase(s, tc_core);
 
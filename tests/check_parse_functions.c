@@ -319,6 +319,62 @@ START_TEST (test_insert_interface_call) {
 }
 END_TEST
 
+START_TEST (test_deferred_interface_call_retry) {
+
+	struct policy_node *head = calloc(1, sizeof(struct policy_node));
+	head->flavor = NODE_TE_FILE;
+	struct policy_node *cur = head;
+
+	// loop_a calls itself, so expanding calls to it fails
+	struct if_call_data *loop = calloc(1, sizeof(struct if_call_data));
+	loop->name = strdup("loop_a");
+	loop->args = sl_from_str("$1");
+
+	struct map_changes *templates = alloc_map_changes();
+	stage_map_changes(templates);
+	insert_call_into_template_map("loop_a", loop);
+
+	struct map_changes *changes = alloc_map_changes();
+	stage_map_changes(changes);
+	set_current_module_name("foo");
+	ck_assert_int_eq(SELINT_SUCCESS, insert_permissive_statement(&cur, "foo_t", 1));
+	struct policy_node *before = cur;
+	ck_assert_int_eq(SELINT_SUCCESS, insert_interface_call(&cur, "loop_a", sl_from_str("foo"), 2));
+	struct policy_node *call = cur;
+	ck_assert_int_eq(SELINT_SUCCESS, insert_permissive_statement(&cur, "bar_t", 3));
+	struct policy_node *after = cur;
+	stage_map_changes(NULL);
+
+	replay_map_changes(templates);
+	replay_map_changes(changes);
+
+	// Dropped from the tree, like a call failing to expand immediately
+	ck_assert_ptr_eq(before->next, after);
+	ck_assert_ptr_eq(after->prev, before);
+	ck_assert_int_eq(is_used_if("loop_a"), 0);
+
+	// Expanded and linked again once the template no longer loops
+	retract_map_changes(templates);
+	reapply_deferred_map_changes(changes);
+
+	ck_assert_ptr_eq(before->next, call);
+	ck_assert_ptr_eq(call->prev, before);
+	ck_assert_ptr_eq(call->next, after);
+	ck_assert_ptr_eq(after->prev, call);
+	ck_assert_int_eq(is_used_if("loop_a"), 1);
+
+	retract_map_changes(changes);
+	ck_assert_int_eq(is_used_if("loop_a"), 0);
+
+	free_map_changes(changes);
+	free_map_changes(templates);
+	free_policy_node(head);
+	free_if_call_data(loop);
+	free_all_maps();
+	cleanup_parsing();
+}
+END_TEST
+
 START_TEST (test_insert_permissive_statement) {
 	struct policy_node *cur = calloc(1, sizeof(struct policy_node));
 
@@ -423,6 +479,44 @@ START_TEST (test_interface_def) {
 }
 END_TEST
 
+START_TEST (test_symbols_only) {
+
+	struct policy_node *cur = calloc(1, sizeof(struct policy_node));
+
+	cur->flavor = NODE_IF_FILE;
+
+	struct policy_node *head = cur;
+
+	set_current_module_name("test");
+	set_symbols_only(1);
+
+	ck_assert_int_eq(SELINT_SUCCESS, begin_interface_def(&cur, NODE_INTERFACE_DEF, "foo_filetrans_conf", 10));
+	ck_assert_int_eq(SELINT_SUCCESS, insert_av_rule(&cur, AV_RULE_ALLOW, sl_from_str("$1"), sl_from_str("foo_conf_t"), sl_from_str("file"), sl_from_str("read"), 11));
+	ck_assert_int_eq(SELINT_SUCCESS, insert_type_transition(&cur, TT_TT, sl_from_str("$1"), sl_from_str("etc_t"), sl_from_str("file"), "foo_conf_t", NULL, 12));
+	ck_assert_int_eq(SELINT_SUCCESS, insert_role_types(&cur, "$2", sl_from_str("$1"), 13));
+
+	ck_assert_int_eq(NODE_ROLE_TYPES, cur->flavor);
+	ck_assert_ptr_null(cur->data.rtyp_data);
+	ck_assert_int_eq(NODE_TT_RULE, cur->prev->flavor);
+	ck_assert_ptr_null(cur->prev->data.tt_data);
+	ck_assert_int_eq(NODE_AV_RULE, cur->prev->prev->flavor);
+	ck_assert_ptr_null(cur->prev->prev->data.av_data);
+	ck_assert_int_eq(11, cur->prev->prev->lineno);
+
+	ck_assert_int_eq(SELINT_SUCCESS, end_interface_def(&cur));
+
+	ck_assert_int_eq(1, is_filetrans_if("foo_filetrans_conf"));
+	ck_assert_int_eq(1, is_role_if("foo_filetrans_conf"));
+	ck_assert_str_eq("test", look_up_in_ifs_map("foo_filetrans_conf"));
+
+	set_symbols_only(0);
+
+	ck_assert_int_eq(SELINT_SUCCESS, free_policy_node(head));
+
+	cleanup_parsing();
+}
+END_TEST
+
 START_TEST (test_wrong_block_end) {
 
 	struct policy_node *cur = malloc(sizeof(struct policy_node));
@@ -516,6 +610,7 @@ static Suite *parse_functions_suite(void) {
 	tcase_add_test(tc_core, test_insert_type_transition);
 	tcase_add_test(tc_core, test_insert_named_type_transition);
 	tcase_add_test(tc_core, test_insert_interface_call);
+	tcase_add_test(tc_core, test_deferred_interface_call_retry);
 	tcase_add_test(tc_core, test_insert_permissive_statement);
 	tcase_add_test(tc_core, test_save_command);
 	tcase_add_test(tc_core, test_insert_type_attribute);
@@ -523,6 +618,7 @@ static Suite *parse_functions_suite(void) {
 
 	tcase_add_test(tc_blocks, test_optional_policy);
 	tcase_add_test(tc_blocks, test_interface_def);
+	tcase_add_test(tc_blocks, test_symbols_only);
 	tcase_add_test(tc_blocks, test_wrong_block_end);
 	suite_add_tcase(s, tc_blocks);
 
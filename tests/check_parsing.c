@@ -17,10 +17,14 @@
 #include <check.h>
 #include <stdio.h>
 
+#include "../src/check_hooks.h"
 #include "../src/tree.h"
 #include "../src/parse.h"
 #include "../src/parse_functions.h"
 
+// Scanner of the parser, see lex.l
+int yylex(YYSTYPE *yylval_param, YYLTYPE *yylloc_param, yyscan_t yyscanner);
+
 #define POLICIES_DIR SAMPLE_POL_DIR
 #define BASIC_TE_FILENAME POLICIES_DIR "basic.te"
 #define BASIC_IF_FILENAME POLICIES_DIR "basic.if"
@@ -34,6 +38,7 @@
 #define DISABLE_COMMENT_TE_FILENAME POLICIES_DIR "disable_comment.te"
 #define DISABLE_COMMENT_IF_FILENAME POLICIES_DIR "disable_comment.if"
 #define DISABLE_REQUIRE_IF_FILENAME POLICIES_DIR "disable_require.if"
+#define DISABLE_SCOPES_TE_FILENAME POLICIES_DIR "disable_scopes.te"
 #define BOOL_DECLARATION_FILENAME POLICIES_DIR "bool_declarations.te"
 #define EXTENDED_TE_FILENAME POLICIES_DIR "extended_perms.te"
 #define IFDEF_BLOCK_FILENAME POLICIES_DIR "ifdef_block.te"
@@ -473,6 +478,53 @@ START_TEST (test_disable_comment_if) {
 }
 END_TEST
 
+START_TEST (test_disable_scopes_te) {
+
+	set_current_module_name("disable_scopes");
+
+	FILE *f = fopen(DISABLE_SCOPES_TE_FILENAME, "r");
+	ck_assert_ptr_nonnull(f);
+	struct policy_node *ast = yyparse_wrapper(f, DISABLE_SCOPES_TE_FILENAME, NODE_TE_FILE);
+	ck_assert_ptr_nonnull(ast);
+
+	const uint64_t file_bits = check_id_bit("S-001");
+	const uint64_t block_bits = file_bits | check_id_bit("W-001");
+
+	ck_assert_int_eq(NODE_TE_FILE, ast->flavor);
+	ck_assert_str_eq("S-001", ast->exceptions);
+	ck_assert_uint_eq(file_bits, ast->disabled_checks);
+
+	const struct policy_node *cur = ast->next;
+	ck_assert_ptr_nonnull(cur);
+	ck_assert_int_eq(NODE_HEADER, cur->flavor);
+	ck_assert_ptr_null(cur->exceptions);
+	ck_assert_uint_eq(file_bits, cur->disabled_checks);
+
+	cur = cur->next;
+	ck_assert_ptr_nonnull(cur);
+	ck_assert_int_eq(NODE_DECL, cur->flavor);
+	ck_assert_uint_eq(file_bits, cur->disabled_checks);
+
+	cur = cur->next;
+	ck_assert_ptr_nonnull(cur);
+	ck_assert_int_eq(NODE_OPTIONAL_POLICY, cur->flavor);
+	ck_assert_str_eq("W-001,W-0010", cur->exceptions);
+	// W-0010 is not a check ID, and neither disables W-010 nor W-001
+	ck_assert_uint_eq(block_bits, cur->disabled_checks);
+
+	cur = cur->first_child;
+	ck_assert_ptr_nonnull(cur);
+	ck_assert_int_eq(NODE_AV_RULE, cur->flavor);
+	ck_assert_ptr_null(cur->exceptions);
+	ck_assert_uint_eq(block_bits, cur->disabled_checks);
+
+	free_policy_node(ast);
+	cleanup_parsing();
+	fclose(f);
+
+}
+END_TEST
+
 START_TEST (test_disable_require_if) {
 
 	set_current_module_name("disable_require");
@@ -1115,6 +1167,44 @@ START_TEST (test_parse_ifdef) {
 }
 END_TEST
 
+START_TEST (test_scanner_get_line) {
+
+	FILE *f = fopen(BASIC_TE_FILENAME, "r");
+	ck_assert_ptr_nonnull(f);
+
+	yyscan_t scanner = scanner_open(f);
+	ck_assert_ptr_nonnull(scanner);
+
+	char *line = scanner_get_line(scanner, 1);
+	ck_assert_str_eq(line, "policy_module(basic)");
+	free(line);
+
+	// Scanning leaves the lines intact
+	YYSTYPE value;
+	YYLTYPE location;
+	ck_assert_int_eq(POLICY_MODULE, yylex(&value, &location, scanner));
+
+	line = scanner_get_line(scanner, 1);
+	ck_assert_str_eq(line, "policy_module(basic)");
+	free(line);
+
+	line = scanner_get_line(scanner, 2);
+	ck_assert_str_eq(line, "");
+	free(line);
+
+	line = scanner_get_line(scanner, 3);
+	ck_assert_str_eq(line, "type basic_t;");
+	free(line);
+
+	line = scanner_get_line(scanner, 100000);
+	ck_assert_str_eq(line, "");
+	free(line);
+
+	scanner_close(scanner);
+	fclose(f);
+}
+END_TEST
+
 static Suite *parsing_suite(void) {
 	Suite *s;
 	TCase *tc_core;
@@ -1135,10 +1225,12 @@ static Suite *parsing_suite(void) {
 	tcase_add_test(tc_core, test_disable_comment_te);
 	tcase_add_test(tc_core, test_disable_comment_if);
 	tcase_add_test(tc_core, test_disable_require_if);
+	tcase_add_test(tc_core, test_disable_scopes_te);
 	tcase_add_test(tc_core, test_bool_declarations);
 	tcase_add_test(tc_core, test_file_flavor_mismatch);
 	tcase_add_test(tc_core, test_extended_perms);
 	tcase_add_test(tc_core, test_parse_ifdef);
+	tcase_add_test(tc_core, test_scanner_get_line);
 	suite_add_tcase(s, tc_core);
 
 	return s;
@@ -16,10 +16,23 @@
 
 #include <check.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "../src/string_list.h"
 #include "../src/runner.h"
 
+// Return whether the check is called for nodes of the flavor
+static int has_check(const struct checks *ck, enum node_flavor flavor, const char *check_id)
+{
+	for (unsigned int i = 0; i < ck->check_counts[flavor]; i++) {
+		if (0 == strcmp(check_id, ck->check_nodes[flavor][i].check_id)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
 START_TEST (test_is_check_enabled) {
 	struct string_list *con_e = calloc(1, sizeof(struct string_list));
 	con_e->string = strdup("S-001");
@@ -55,6 +68,65 @@ START_TEST (test_is_check_enabled) {
 }
 END_TEST
 
+START_TEST (test_register_checks) {
+	ck_assert_ptr_null(register_checks('Q', NULL, NULL, NULL, NULL, 0));
+
+	struct checks *ck = register_checks('C', NULL, NULL, NULL, NULL, 0);
+	ck_assert_ptr_nonnull(ck);
+	ck_assert_uint_gt(ck->check_counts[NODE_AV_RULE], 1);
+	ck_assert_str_eq("C-001", ck->check_nodes[NODE_AV_RULE][0].check_id);
+	ck_assert_str_eq("C-005", ck->check_nodes[NODE_AV_RULE][1].check_id);
+	ck_assert_int_eq(1, has_check(ck, NODE_CLEANUP, "W-001"));
+	ck_assert_int_eq(1, has_check(ck, NODE_FC_ENTRY, "S-002"));
+	ck_assert_int_eq(0, has_check(ck, NODE_INTERFACE_DEF, "X-001"));
+
+	unsigned int total = 0;
+	for (int i = 0; i <= NODE_ERROR; i++) {
+		total += ck->check_counts[i];
+	}
+	ck_assert_uint_eq(total, ck->check_node_count);
+	free_checks(ck);
+
+	struct string_list *cl_e = calloc(1, sizeof(struct string_list));
+	cl_e->string = strdup("X-001");
+	struct string_list *cl_d = calloc(1, sizeof(struct string_list));
+	cl_d->string = strdup("W-001");
+
+	ck = register_checks('W', NULL, NULL, cl_e, cl_d, 0);
+	ck_assert_ptr_nonnull(ck);
+	ck_assert_int_eq(1, has_check(ck, NODE_INTERFACE_DEF, "X-001"));
+	ck_assert_int_eq(1, has_check(ck, NODE_TEMP_DEF, "X-001"));
+	ck_assert_int_eq(0, has_check(ck, NODE_AV_RULE, "C-001"));
+	ck_assert_int_eq(0, has_check(ck, NODE_AV_RULE, "W-001"));
+	ck_assert_int_eq(1, has_check(ck, NODE_AV_RULE, "W-002"));
+
+	struct checks *te = select_file_checks(ck, FILE_TE_FILE);
+	struct checks *in_if = select_file_checks(ck, FILE_IF_FILE);
+	struct checks *fc = select_file_checks(ck, FILE_FC_FILE);
+	ck_assert_int_eq(0, has_check(te, NODE_AV_RULE, "W-002"));
+	ck_assert_int_eq(1, has_check(te, NODE_AV_RULE, "W-008"));
+	ck_assert_int_eq(1, has_check(in_if, NODE_AV_RULE, "W-002"));
+	ck_assert_int_eq(1, has_check(in_if, NODE_INTERFACE_DEF, "X-001"));
+	ck_assert_int_eq(0, has_check(te, NODE_CLEANUP, "W-003"));
+	ck_assert_int_eq(1, has_check(in_if, NODE_CLEANUP, "W-003"));
+	ck_assert_uint_eq(0, fc->check_counts[NODE_CLEANUP]);
+	ck_assert_uint_eq(0, fc->check_counts[NODE_AV_RULE]);
+	ck_assert_int_eq(1, has_check(fc, NODE_FC_ENTRY, "W-004"));
+	free_checks(te);
+	free_checks(in_if);
+	free_checks(fc);
+	free_checks(ck);
+
+	ck = register_checks('F', NULL, NULL, cl_e, cl_d, 1);
+	ck_assert_ptr_nonnull(ck);
+	ck_assert_uint_eq(2, ck->check_node_count);
+	free_checks(ck);
+
+	free_string_list(cl_e);
+	free_string_list(cl_d);
+}
+END_TEST
+
 static Suite *runner_suite(void) {
 	Suite *s;
 	TCase *tc_core;
@@ -64,6 +136,7 @@ static Suite *runner_suite(void) {
 	tc_core = tcase_create("Core");
 
 	tcase_add_test(tc_core, test_is_check_enabled);
+	tcase_add_test(tc_core, test_register_checks);
 	suite_add_tcase(s, tc_core);
 
 	return s;
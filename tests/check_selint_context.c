@@ -0,0 +1,151 @@
+/*
+ * Copyright 2026 The SELint Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <check.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "../src/selint_context.h"
+#include "../src/check_hooks.h"
+#include "../src/intern.h"
+#include "../src/maps.h"
+#include "../src/parse_functions.h"
+#include "../src/perm_macro.h"
+
+START_TEST (test_context_maps) {
+	struct selint_context *initial = selint_context_current();
+
+	insert_into_decl_map("foo_t", "foo", DECL_TYPE);
+
+	struct selint_context *ctx = selint_context_create();
+	ck_assert_ptr_eq(initial, selint_context_switch(ctx));
+	ck_assert_ptr_eq(ctx, selint_context_current());
+
+	ck_assert_ptr_null(look_up_in_decl_map("foo_t", DECL_TYPE));
+	insert_into_decl_map("bar_t", "bar", DECL_TYPE);
+	found_issue = 1;
+
+	ck_assert_ptr_eq(ctx, selint_context_switch(initial));
+	ck_assert_str_eq("foo", look_up_in_decl_map("foo_t", DECL_TYPE));
+	ck_assert_ptr_null(look_up_in_decl_map("bar_t", DECL_TYPE));
+	ck_assert_int_eq(0, found_issue);
+
+	// The current context can not be freed
+	selint_context_free(initial);
+	ck_assert_str_eq("foo", look_up_in_decl_map("foo_t", DECL_TYPE));
+
+	selint_context_switch(ctx);
+	ck_assert_str_eq("bar", look_up_in_decl_map("bar_t", DECL_TYPE));
+	ck_assert_ptr_null(look_up_in_decl_map("foo_t", DECL_TYPE));
+	ck_assert_int_eq(1, found_issue);
+
+	// The default context stays usable once freed
+	selint_context_free(initial);
+	selint_context_switch(initial);
+	ck_assert_ptr_null(look_up_in_decl_map("foo_t", DECL_TYPE));
+	ck_assert_int_eq(0, found_issue);
+
+	selint_context_free(ctx);
+	free_all_maps();
+}
+END_TEST
+
+START_TEST (test_context_perm_macros) {
+	struct string_list *permissions = sl_from_strs(3, "getattr", "search", "open");
+
+	struct selint_context *ctx = selint_context_create();
+	struct selint_context *initial = selint_context_switch(ctx);
+
+	insert_into_permmacros_map("search_dir_perms", sl_from_strs(3, "getattr", "search", "open"));
+	char *check_str = permmacro_check("dir", permissions);
+	ck_assert_ptr_nonnull(check_str);
+	free(check_str);
+
+	selint_context_switch(initial);
+	ck_assert_ptr_null(permmacro_check("dir", permissions));
+
+	selint_context_free(ctx);
+	free_string_list(permissions);
+	free_permmacros();
+	free_all_maps();
+}
+END_TEST
+
+static void *current_context_of_thread(__attribute__((unused)) void *arg)
+{
+	return selint_context_current();
+}
+
+START_TEST (test_context_parse_state) {
+	struct selint_context *ctx = selint_context_create();
+	struct selint_context *initial = selint_context_switch(ctx);
+
+	set_symbols_only(1);
+	insert_av_common("file", sl_from_strs(2, "read", "write"));
+	insert_av_class("dir", "file", NULL);
+	ck_assert_int_eq(1, class_has_perm(intern("dir"), intern("write")));
+
+	selint_context_switch(initial);
+	ck_assert_int_eq(0, is_symbols_only());
+	insert_av_class("dir", "file", NULL);
+	ck_assert_int_eq(-1, class_has_perm(intern("dir"), intern("write")));
+
+	selint_context_switch(ctx);
+	ck_assert_int_eq(1, is_symbols_only());
+
+	// Other threads start with the default context
+	pthread_t thread;
+	void *thread_context;
+	ck_assert_int_eq(0, pthread_create(&thread, NULL, current_context_of_thread, NULL));
+	ck_assert_int_eq(0, pthread_join(thread, &thread_context));
+	ck_assert_ptr_eq(initial, thread_context);
+
+	selint_context_switch(initial);
+	selint_context_free(ctx);
+	free_all_maps();
+}
+END_TEST
+
+static Suite *selint_context_suite(void) {
+	Suite *s;
+	TCase *tc_core;
+
+	s = suite_create("Selint_context");
+
+	tc_core = tcase_create("Core");
+
+	tcase_add_test(tc_core, test_context_maps);
+	tcase_add_test(tc_core, test_context_perm_macros);
+	tcase_add_test(tc_core, test_context_parse_state);
+	suite_add_tcase(s, tc_core);
+
+	return s;
+}
+
+int main(void) {
+
+	int number_failed = 0;
+	Suite *s;
+	SRunner *sr;
+
+	s = selint_context_suite();
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0)? 0 : -1;
+}
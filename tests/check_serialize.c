@@ -0,0 +1,173 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../src/serialize.h"
+
+#define MAGIC "SELINTTS"
+#define MAGIC_LEN 8
+
+START_TEST (test_varints_and_data) {
+
+	const uint64_t values[] = { 0, 1, 127, 128, 300, UINT32_MAX, UINT64_MAX };
+	struct serial_writer w;
+	memset(&w, 0, sizeof(struct serial_writer));
+
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		serial_put_varint(&w, values[i]);
+	}
+	serial_put_data(&w, "foo", 4);
+	serial_put_data(&w, NULL, 0);
+
+	// 127 takes one byte, 128 two
+	ck_assert_uint_eq(0x7f, w.buf[2]);
+	ck_assert_uint_eq(0x80, w.buf[3]);
+	ck_assert_uint_eq(0x01, w.buf[4]);
+
+	struct serial_reader r = { .pos = w.buf, .end = w.buf + w.len, .failed = 0 };
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		ck_assert_uint_eq(values[i], serial_get_varint(&r));
+	}
+
+	uint64_t len;
+	const unsigned char *data = serial_get_data(&r, &len);
+	ck_assert_uint_eq(4, len);
+	ck_assert_str_eq("foo", (const char *)data);
+	ck_assert_ptr_null(serial_get_data(&r, &len));
+	ck_assert_uint_eq(0, len);
+	ck_assert_int_eq(0, r.failed);
+	ck_assert_ptr_eq(r.end, r.pos);
+
+	// Reading past the end fails
+	serial_get_varint(&r);
+	ck_assert_int_eq(1, r.failed);
+
+	// Data longer than what is left fails
+	free_serial_writer(&w);
+	serial_put_varint(&w, 10);
+	serial_put_bytes(&w, "abc", 3);
+	r = (struct serial_reader) { .pos = w.buf, .end = w.buf + w.len, .failed = 0 };
+	ck_assert_ptr_null(serial_get_data(&r, &len));
+	ck_assert_int_eq(1, r.failed);
+
+	r = (struct serial_reader) { .pos = w.buf, .end = w.buf + w.len, .failed = 0 };
+	ck_assert_uint_eq(0, serial_get_bounded(&r, 9));
+	ck_assert_int_eq(1, r.failed);
+
+	free_serial_writer(&w);
+}
+END_TEST
+
+START_TEST (test_frame) {
+
+	struct serial_writer w;
+	memset(&w, 0, sizeof(struct serial_writer));
+
+	serial_put_bytes(&w, MAGIC, MAGIC_LEN);
+	serial_put_varint(&w, 42);
+	serial_put_checksum(&w);
+	ck_assert_uint_eq(MAGIC_LEN + 1 + SERIAL_CHECKSUM_LEN, w.len);
+
+	int corrupt;
+	struct serial_reader r = { .pos = w.buf, .end = w.buf + w.len, .failed = 0 };
+	ck_assert_int_eq(1, serial_check_frame(&r, MAGIC, MAGIC_LEN, &corrupt));
+	ck_assert_uint_eq(42, serial_get_varint(&r));
+	ck_assert_ptr_eq(r.end, r.pos);
+
+	w.buf[MAGIC_LEN] = 43;
+	r = (struct serial_reader) { .pos = w.buf, .end = w.buf + w.len, .failed = 0 };
+	ck_assert_int_eq(0, serial_check_frame(&r, MAGIC, MAGIC_LEN, &corrupt));
+	ck_assert_int_eq(1, corrupt);
+
+	r = (struct serial_reader) { .pos = w.buf, .end = w.buf + w.len, .failed = 0 };
+	ck_assert_int_eq(0, serial_check_frame(&r, "SELINTXX", MAGIC_LEN, &corrupt));
+	ck_assert_int_eq(0, corrupt);
+
+	// Too short for a checksum
+	r = (struct serial_reader) { .pos = w.buf, .end = w.buf + MAGIC_LEN, .failed = 0 };
+	ck_assert_int_eq(0, serial_check_frame(&r, MAGIC, MAGIC_LEN, NULL));
+
+	free_serial_writer(&w);
+}
+END_TEST
+
+START_TEST (test_write_file) {
+
+	char dir[] = "/tmp/selint_check_serializeXXXXXX";
+	ck_assert_ptr_nonnull(mkdtemp(dir));
+
+	char path[sizeof(dir) + 16];
+	snprintf(path, sizeof(path), "%s/file", dir);
+
+	ck_assert_int_eq(SELINT_SUCCESS, serial_write_file(path, (const unsigned char *)"old", 3));
+	ck_assert_int_eq(SELINT_SUCCESS, serial_write_file(path, (const unsigned char *)"new", 3));
+
+	struct stat st;
+	ck_assert_int_eq(0, stat(path, &st));
+	ck_assert_int_eq(0644, st.st_mode & 0777);
+
+	char buf[8] = { 0 };
+	FILE *f = fopen(path, "r");
+	ck_assert_ptr_nonnull(f);
+	ck_assert_uint_eq(3, fread(buf, 1, sizeof(buf), f));
+	fclose(f);
+	ck_assert_str_eq("new", buf);
+
+	// No temporary files are left, so the directory can be removed
+	ck_assert_int_eq(0, unlink(path));
+	ck_assert_int_eq(0, rmdir(dir));
+
+	ck_assert_int_eq(SELINT_IO_ERROR, serial_write_file("/nonexistent/dir/file", (const unsigned char *)"x", 1));
+}
+END_TEST
+
+static Suite *serialize_suite(void) {
+	Suite *s;
+	TCase *tc_core;
+
+	s = suite_create("Serialize");
+
+	tc_core = tcase_create("Core");
+
+	tcase_add_test(tc_core, test_varints_and_data);
+	tcase_add_test(tc_core, test_frame);
+	tcase_add_test(tc_core, test_write_file);
+	suite_add_tcase(s, tc_core);
+
+	return s;
+}
+
+int main(void) {
+
+	int number_failed = 0;
+	Suite *s;
+	SRunner *sr;
+
+	s = serialize_suite();
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0)? 0 : -1;
+}
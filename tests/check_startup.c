@@ -17,6 +17,7 @@
 #include <check.h>
 
 #include "../src/startup.h"
+#include "../src/intern.h"
 #include "../src/maps.h"
 #include "../src/selint_error.h"
 #include "../src/parse_functions.h"
@@ -40,6 +41,11 @@ START_TEST (test_load_access_vectors_kernel) {
 	ck_assert_str_eq(look_up_in_decl_map("listen", DECL_PERM), "perm");
 	ck_assert_str_eq(look_up_in_decl_map("use", DECL_PERM), "perm");
 
+	ck_assert_int_eq(class_has_perm(intern("file"), intern("append")), 1);
+	ck_assert_int_eq(class_has_perm(intern("x_cursor"), intern("use")), 1);
+	ck_assert_int_eq(class_has_perm(intern("file"), intern("use")), 0);
+	ck_assert_int_eq(class_has_perm(intern("x_cursor"), intern("append")), 0);
+
 	free_all_maps();
 
 }
@@ -56,6 +62,15 @@ START_TEST (test_load_access_vectors_source) {
 	ck_assert_str_eq(look_up_in_decl_map("append", DECL_PERM), "__av_file__");
 	ck_assert_str_eq(look_up_in_decl_map("use", DECL_PERM), "__av_file__");
 
+	// Defined by the class, and inherited from the common
+	ck_assert_int_eq(class_has_perm(intern("file"), intern("entrypoint")), 1);
+	ck_assert_int_eq(class_has_perm(intern("file"), intern("append")), 1);
+	ck_assert_int_eq(class_has_perm(intern("dir"), intern("search")), 1);
+	ck_assert_int_eq(class_has_perm(intern("lnk_file"), intern("read")), 1);
+	ck_assert_int_eq(class_has_perm(intern("file"), intern("search")), 0);
+	ck_assert_int_eq(class_has_perm(intern("lnk_file"), intern("entrypoint")), 0);
+	ck_assert_int_eq(class_has_perm(intern("fd"), intern("read")), 0);
+
 	free_all_maps();
 
 }
@@ -16,7 +16,10 @@
 
 #include <check.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "../src/arena.h"
+#include "../src/intern.h"
 #include "../src/string_list.h"
 
 START_TEST (test_str_in_sl) {
@@ -199,6 +202,55 @@ START_TEST (test_append_to_sl) {
 }
 END_TEST
 
+START_TEST (test_string_list_atoms) {
+	struct string_list *list = sl_from_strs(2, "foo", "bar");
+	struct string_list *other = sl_from_str_consume(strdup("bar"));
+
+	ck_assert_int_eq(1, list->interned);
+	ck_assert_ptr_eq(list->next->string, other->string);
+	ck_assert_int_eq(1, str_in_sl(other->string, list));
+	ck_assert_int_eq(1, str_in_sl("foo", list));
+	ck_assert_int_eq(0, str_in_sl("baz", list));
+
+	struct string_list *from_atom = sl_from_atom(intern("foo"));
+	ck_assert_int_eq(1, from_atom->interned);
+	ck_assert_ptr_eq(list->string, from_atom->string);
+
+	struct string_list *copy = copy_string_list(list);
+	ck_assert_ptr_eq(list->string, copy->string);
+
+	free_string_list(list);
+	free_string_list(other);
+	free_string_list(from_atom);
+	free_string_list(copy);
+}
+END_TEST
+
+START_TEST (test_string_list_in_arena) {
+	struct arena *arena = alloc_arena();
+	set_active_arena(arena);
+
+	struct string_list *list = concat_string_lists(sl_from_str("foo"), sl_from_str_consume(strdup("bar")));
+	struct string_list *copy = copy_string_list(list);
+
+	set_active_arena(NULL);
+
+	ck_assert_int_eq(1, list->arena_owned);
+	ck_assert_int_eq(1, arena_owns(arena, list->next));
+	ck_assert_str_eq("bar", list->next->string);
+	ck_assert_int_eq(1, copy->next->arena_owned);
+	ck_assert_ptr_eq(list->next->string, copy->next->string);
+
+	// Heap cells in the same list are still freed
+	append_to_sl(list, "baz");
+	ck_assert_int_eq(0, list->next->next->arena_owned);
+
+	free_string_list(list);
+	free_string_list(copy);
+	free_arena(arena);
+}
+END_TEST
+
 static Suite *string_list_suite(void) {
 	Suite *s;
 	TCase *tc_core;
@@ -215,6 +267,8 @@ static Suite *string_list_suite(void) {
 	tcase_add_test(tc_core, test_sl_from_strs);
 	tcase_add_test(tc_core, test_concat_string_lists);
 	tcase_add_test(tc_core, test_append_to_sl);
+	tcase_add_test(tc_core, test_string_list_atoms);
+	tcase_add_test(tc_core, test_string_list_in_arena);
 	suite_add_tcase(s, tc_core);
 
 	return s;
@@ -133,9 +133,12 @@ END_TEST
 START_TEST (test_check_no_explicit_declaration) {
 	struct policy_node *cur = calloc(1, sizeof(struct policy_node));
 	struct check_data *cd = calloc(1, sizeof(struct check_data));
+	struct policy_node *cleanup = calloc(1, sizeof(struct policy_node));
+	cleanup->flavor = NODE_CLEANUP;
 
 	cur->flavor = NODE_AV_RULE;
 	cur->data.av_data = make_example_av_rule();
+	update_names_in_node(cur);
 
 	cd->flavor = FILE_IF_FILE;
 	cd->mod_name = strdup("foo");
@@ -174,25 +177,124 @@ START_TEST (test_check_no_explicit_declaration) {
 	nd.d_data->name = strdup("bar_t");
 	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(cur, NODE_DECL, nd, 0));
 
+	// The tree changed, so drop what was indexed so far
+	ck_assert_ptr_null(check_no_explicit_declaration(cd, cleanup));
 	ck_assert_ptr_null(check_no_explicit_declaration(cd, cur->next));
 
 	cur->flavor = NODE_GEN_REQ;
 
+	ck_assert_ptr_null(check_no_explicit_declaration(cd, cleanup));
 	ck_assert_ptr_null(check_no_explicit_declaration(cd, cur->next));
 
 	free(cur->first_child->next->data.d_data->name);
 	cur->first_child->next->data.d_data->name = strdup("baz_t");
 
+	ck_assert_ptr_null(check_no_explicit_declaration(cd, cleanup));
 	res = check_no_explicit_declaration(cd, cur->next);
 
 	ck_assert_ptr_nonnull(res);
 	ck_assert_int_eq(W_ID_NO_EXPLICIT_DECL, res->check_id);
 
 	free_check_result(res);
+	ck_assert_ptr_null(check_no_explicit_declaration(cd, cleanup));
 	free_all_maps();
 	free(cd->mod_name);
 	free(cd);
 	free_policy_node(cur);
+	free_policy_node(cleanup);
+}
+END_TEST
+
+static void add_require_child(struct policy_node *req, const char *name)
+{
+	union node_data nd;
+	nd.d_data = NULL;
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(req, NODE_START_BLOCK, nd, 0));
+	nd.d_data = calloc(1, sizeof(struct declaration_data));
+	nd.d_data->flavor = DECL_TYPE;
+	nd.d_data->name = strdup(name);
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(req, NODE_DECL, nd, 0));
+}
+
+START_TEST (test_check_no_explicit_declaration_scopes) {
+	struct check_data *cd = calloc(1, sizeof(struct check_data));
+	cd->flavor = FILE_TE_FILE;
+	cd->mod_name = strdup("foo");
+
+	insert_into_decl_map("foo_t", "foo", DECL_TYPE);
+	insert_into_decl_map("bar_t", "bar", DECL_TYPE);
+	insert_into_decl_map("baz_t", "bar", DECL_TYPE);
+
+	// optional_policy(`
+	//     require { type bar_t; type baz_t; }
+	//     allow foo_t { bar_t baz_t }:file { read write getattr };
+	// ')
+	// allow foo_t { bar_t baz_t }:file { read write getattr };
+	// require { type bar_t; type baz_t; }
+	// optional_policy(`
+	//     allow foo_t { bar_t baz_t }:file { read write getattr };
+	// ')
+	struct policy_node *head = calloc(1, sizeof(struct policy_node));
+	head->flavor = NODE_OPTIONAL_POLICY;
+	union node_data nd;
+	nd.d_data = NULL;
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(head, NODE_START_BLOCK, nd, 0));
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(head, NODE_REQUIRE, nd, 0));
+	struct policy_node *inner_req = head->first_child->next;
+	add_require_child(inner_req, "bar_t");
+	add_require_child(inner_req, "baz_t");
+	nd.av_data = make_example_av_rule();
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(head, NODE_AV_RULE, nd, 0));
+	struct policy_node *inner_rule = inner_req->next;
+
+	nd.av_data = make_example_av_rule();
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_next(head, NODE_AV_RULE, nd, 0));
+	struct policy_node *outer_rule = head->next;
+	nd.d_data = NULL;
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_next(outer_rule, NODE_REQUIRE, nd, 0));
+	add_require_child(outer_rule->next, "bar_t");
+	add_require_child(outer_rule->next, "baz_t");
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_next(outer_rule->next, NODE_OPTIONAL_POLICY, nd, 0));
+	struct policy_node *last_opt = outer_rule->next->next;
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(last_opt, NODE_START_BLOCK, nd, 0));
+	nd.av_data = make_example_av_rule();
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(last_opt, NODE_AV_RULE, nd, 0));
+	struct policy_node *last_rule = last_opt->first_child->next;
+
+	update_names_in_tree(head);
+
+	// Checked in depth first order, as the runner does
+	for (struct policy_node *cur = head; cur; cur = dfs_next(cur)) {
+		if (cur->flavor != NODE_AV_RULE) {
+			continue;
+		}
+		struct check_result *res = check_no_explicit_declaration(cd, cur);
+		if (cur == outer_rule) {
+			// The require block in the optional is out of scope
+			ck_assert_ptr_nonnull(res);
+			ck_assert_int_eq(W_ID_NO_EXPLICIT_DECL, res->check_id);
+			free_check_result(res);
+		} else {
+			ck_assert_ptr_null(res);
+		}
+	}
+
+	// Checked out of order
+	ck_assert_ptr_null(check_no_explicit_declaration(cd, inner_rule));
+	ck_assert_ptr_null(check_no_explicit_declaration(cd, last_rule));
+	struct check_result *res = check_no_explicit_declaration(cd, outer_rule);
+	ck_assert_ptr_nonnull(res);
+	free_check_result(res);
+
+	struct policy_node *cleanup = calloc(1, sizeof(struct policy_node));
+	cleanup->flavor = NODE_CLEANUP;
+	ck_assert_ptr_null(check_no_explicit_declaration(cd, cleanup));
+
+	free_all_maps();
+	free(cd->mod_name);
+	free(cd);
+	free_policy_node(head);
+	free_policy_node(cleanup);
 }
 END_TEST
 
@@ -281,6 +383,7 @@ static Suite *te_checks_suite(void) {
 	tcase_add_test(tc_core, test_check_require_block);
 	tcase_add_test(tc_core, test_check_useless_semicolon);
 	tcase_add_test(tc_core, test_check_no_explicit_declaration);
+	tcase_add_test(tc_core, test_check_no_explicit_declaration_scopes);
 	tcase_add_test(tc_core, test_check_module_if_call_in_optional);
 	tcase_add_test(tc_core, test_check_attribute_interface_nameclash);
 	suite_add_tcase(s, tc_core);
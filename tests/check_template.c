@@ -185,7 +185,7 @@ START_TEST (test_nested_template_declarations) {
 	called_args->next->next->string = strdup("third");
 	called_args->next->next->next = NULL;
 
-	ck_assert_int_eq(SELINT_SUCCESS, add_template_declarations("outer", called_args, NULL, "nested_interfaces"));
+	ck_assert_int_eq(SELINT_SUCCESS, add_template_declarations("outer", called_args, "nested_interfaces", NULL));
 
 	ck_assert_str_eq("nested_interfaces", look_up_in_decl_map("first_t", DECL_TYPE));
 	ck_assert_str_eq("nested_interfaces", look_up_in_decl_map("third_foo_t", DECL_TYPE));
@@ -254,6 +254,85 @@ START_TEST (test_declaring_template) {
 }
 END_TEST
 
+static struct if_call_data *make_call(const char *name, const char *arg)
+{
+	struct if_call_data *call = calloc(1, sizeof(struct if_call_data));
+	call->name = strdup(name);
+	call->args = calloc(1, sizeof(struct string_list));
+	call->args->string = strdup(arg);
+	return call;
+}
+
+START_TEST (test_template_expansion_cache) {
+
+	// inner($1) declares $1_t, outer($1) calls inner($1_inner) and declares $1_outer_t
+	insert_decl_into_template_map("inner", DECL_TYPE, "$1_t");
+	struct if_call_data *call = make_call("inner", "$1_inner");
+	insert_call_into_template_map("outer", call);
+	insert_decl_into_template_map("outer", DECL_TYPE, "$1_outer_t");
+
+	struct string_list *args = calloc(1, sizeof(struct string_list));
+	args->string = strdup("a");
+
+	ck_assert_int_eq(SELINT_SUCCESS, add_template_declarations("outer", args, "first", NULL));
+	ck_assert_str_eq("first", look_up_in_decl_map("a_inner_t", DECL_TYPE));
+	ck_assert_str_eq("first", look_up_in_decl_map("a_outer_t", DECL_TYPE));
+
+	const char outer_key[] = "outer\0a";
+	const struct template_expansion *expansion = look_up_template_expansion(outer_key, sizeof(outer_key));
+	ck_assert_ptr_nonnull(expansion);
+	ck_assert_uint_eq(2, expansion->count);
+	const char inner_key[] = "inner\0a_inner";
+	ck_assert_ptr_nonnull(look_up_template_expansion(inner_key, sizeof(inner_key)));
+
+	// Expanded again from the cache
+	ck_assert_int_eq(SELINT_SUCCESS, add_template_declarations("outer", args, "first", NULL));
+	ck_assert_ptr_eq(expansion, look_up_template_expansion(outer_key, sizeof(outer_key)));
+	ck_assert_uint_eq(2, decl_map_count(DECL_TYPE));
+
+	// Changing a called template drops the cached expansions
+	insert_decl_into_template_map("inner", DECL_ROLE, "$1_r");
+	ck_assert_ptr_null(look_up_template_expansion(outer_key, sizeof(outer_key)));
+
+	ck_assert_int_eq(SELINT_SUCCESS, add_template_declarations("outer", args, "second", NULL));
+	ck_assert_str_eq("second", look_up_in_decl_map("a_inner_r", DECL_ROLE));
+	ck_assert_str_eq("first", look_up_in_decl_map("a_outer_t", DECL_TYPE));
+
+	free_string_list(args);
+	free_all_maps();
+	free_if_call_data(call);
+}
+END_TEST
+
+START_TEST (test_template_loop) {
+
+	// loop_a calls loop_b, which calls loop_a
+	struct if_call_data *call_b = make_call("loop_b", "$1");
+	insert_call_into_template_map("loop_a", call_b);
+	struct if_call_data *call_a = make_call("loop_a", "$1_again");
+	insert_call_into_template_map("loop_b", call_a);
+	insert_decl_into_template_map("loop_b", DECL_TYPE, "$1_t");
+	insert_decl_into_template_map("no_loop", DECL_TYPE, "$1_t");
+
+	struct string_list *args = calloc(1, sizeof(struct string_list));
+	args->string = strdup("a");
+
+	ck_assert_int_eq(SELINT_IF_CALL_LOOP, add_template_declarations("loop_a", args, "loop", NULL));
+	ck_assert_int_eq(SELINT_IF_CALL_LOOP, add_template_declarations("loop_b", args, "loop", NULL));
+	ck_assert_ptr_null(look_up_in_decl_map("a_t", DECL_TYPE));
+	ck_assert_ptr_null(look_up_in_decl_map("a_again_t", DECL_TYPE));
+
+	// The templates being expanded are forgotten after a loop
+	ck_assert_int_eq(SELINT_SUCCESS, add_template_declarations("no_loop", args, "loop", NULL));
+	ck_assert_str_eq("loop", look_up_in_decl_map("a_t", DECL_TYPE));
+
+	free_string_list(args);
+	free_all_maps();
+	free_if_call_data(call_a);
+	free_if_call_data(call_b);
+}
+END_TEST
+
 static Suite *template_suite(void) {
 	Suite *s;
 	TCase *tc_core;
@@ -270,6 +349,8 @@ static Suite *template_suite(void) {
 	tcase_add_test(tc_core, test_replace_m4_list_too_few_args);
 	tcase_add_test(tc_core, test_nested_template_declarations);
 	tcase_add_test(tc_core, test_declaring_template);
+	tcase_add_test(tc_core, test_template_expansion_cache);
+	tcase_add_test(tc_core, test_template_loop);
 	suite_add_tcase(s, tc_core);
 
 	return s;
@@ -0,0 +1,147 @@
+/*
+* Copyright 2026 The SELint Contributors
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <check.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/trace.h"
+
+// Read a whole file into a new string
+static char *read_file(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	ck_assert_ptr_nonnull(f);
+
+	char *buf = calloc(1, 65536);
+	ck_assert_ptr_nonnull(buf);
+	const size_t len = fread(buf, 1, 65535, f);
+	fclose(f);
+	ck_assert_uint_gt(len, 0);
+
+	return buf;
+}
+
+static void *traced_worker(__attribute__((unused)) void *arg)
+{
+	struct trace_span span;
+	trace_begin(&span, "check file");
+	trace_end(&span, "worker.te", "nodes", 7);
+
+	return NULL;
+}
+
+START_TEST (test_trace_disabled) {
+
+	ck_assert(!is_tracing());
+
+	struct trace_span span;
+	trace_begin(&span, "parse te file");
+	ck_assert_str_eq("parse te file", span.name);
+	ck_assert_uint_eq(0, span.start_ns);
+	trace_end(&span, "a.te", "nodes", 1);
+
+	// Nothing to finish
+	trace_close();
+}
+END_TEST
+
+START_TEST (test_trace_spans) {
+
+	char path[] = "/tmp/selint_trace_XXXXXX";
+	int fd = mkstemp(path);
+	ck_assert_int_ne(-1, fd);
+	close(fd);
+
+	ck_assert_int_eq(SELINT_SUCCESS, trace_open(path));
+	ck_assert(is_tracing());
+
+	struct trace_span outer;
+	struct trace_span inner;
+	trace_begin(&outer, "parse files");
+	trace_begin(&inner, "parse te file");
+	trace_end(&inner, "dir/a\"b.te", "nodes", 3);
+	trace_end(&outer, NULL, "files", 1);
+
+	pthread_t worker;
+	ck_assert_int_eq(0, pthread_create(&worker, NULL, traced_worker, NULL));
+	ck_assert_int_eq(0, pthread_join(worker, NULL));
+
+	trace_close();
+	ck_assert(!is_tracing());
+
+	char *buf = read_file(path);
+
+	ck_assert_int_eq('[', buf[0]);
+	ck_assert_str_eq("\n]\n", buf + strlen(buf) - 3);
+
+	// Spans are complete events with escaped args
+	ck_assert_ptr_nonnull(strstr(buf, "{\"name\":\"parse te file\",\"cat\":\"selint\",\"ph\":\"X\","));
+	ck_assert_ptr_nonnull(strstr(buf, "\"args\":{\"file\":\"dir/a\\\"b.te\",\"nodes\":3}}"));
+	ck_assert_ptr_nonnull(strstr(buf, "\"args\":{\"files\":1}}"));
+	ck_assert(strstr(buf, "parse te file") < strstr(buf, "parse files"));
+
+	// The worker got a thread of its own
+	ck_assert_ptr_nonnull(strstr(buf, "\"tid\":1,\"args\":{\"name\":\"main 1\"}"));
+	ck_assert_ptr_nonnull(strstr(buf, "\"tid\":2,\"args\":{\"name\":\"worker 2\"}"));
+	ck_assert_ptr_nonnull(strstr(buf, "\"tid\":2,\"args\":{\"file\":\"worker.te\",\"nodes\":7}}"));
+
+	free(buf);
+	unlink(path);
+}
+END_TEST
+
+START_TEST (test_trace_open_fails) {
+
+	ck_assert_int_eq(SELINT_IO_ERROR, trace_open("/nonexistent/dir/trace.json"));
+	ck_assert(!is_tracing());
+}
+END_TEST
+
+static Suite *trace_suite(void) {
+	Suite *s;
+	TCase *tc_core;
+
+	s = suite_create("Trace");
+
+	tc_core = tcase_create("Core");
+
+	tcase_add_test(tc_core, test_trace_disabled);
+	tcase_add_test(tc_core, test_trace_spans);
+	tcase_add_test(tc_core, test_trace_open_fails);
+	suite_add_tcase(s, tc_core);
+
+	return s;
+}
+
+int main(void) {
+
+	int number_failed = 0;
+	Suite *s;
+	SRunner *sr;
+
+	s = trace_suite();
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0)? 0 : -1;
+}
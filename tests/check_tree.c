@@ -20,6 +20,7 @@
 
 #include "test_utils.h"
 
+#include "../src/arena.h"
 #include "../src/tree.h"
 #include "../src/maps.h"
 
@@ -75,6 +76,66 @@ START_TEST (test_insert_policy_node_next) {
 }
 END_TEST
 
+START_TEST (test_inherit_disabled_checks) {
+
+	union node_data nd;
+	nd.str = NULL;
+
+	struct policy_node *head = calloc(1, sizeof(struct policy_node));
+	head->flavor = NODE_TE_FILE;
+	head->disabled_checks = 0x1;
+
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_next(head, NODE_OPTIONAL_POLICY, nd, 1));
+	struct policy_node *block = head->next;
+	block->disabled_checks = 0x2;
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(block, NODE_OPTIONAL_POLICY, nd, 2));
+	struct policy_node *inner = block->first_child;
+	inner->disabled_checks = 0x4;
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_child(inner, NODE_DECL, nd, 3));
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_next(inner, NODE_DECL, nd, 4));
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_next(block, NODE_DECL, nd, 5));
+
+	inherit_disabled_checks(head);
+
+	ck_assert_uint_eq(0x1, head->disabled_checks);
+	ck_assert_uint_eq(0x3, block->disabled_checks);
+	ck_assert_uint_eq(0x7, inner->disabled_checks);
+	ck_assert_uint_eq(0x7, inner->first_child->disabled_checks);
+	ck_assert_uint_eq(0x3, inner->next->disabled_checks);
+	ck_assert_uint_eq(0x1, block->next->disabled_checks);
+
+	ck_assert_int_eq(SELINT_SUCCESS, free_policy_node(head));
+}
+END_TEST
+
+START_TEST (test_insert_policy_node_arena) {
+
+	struct arena *arena = alloc_arena();
+	set_active_arena(arena);
+
+	struct policy_node *head = alloc_policy_node();
+	head->flavor = NODE_TE_FILE;
+
+	union node_data nd;
+	nd.av_data = node_xcalloc(1, sizeof(struct av_rule_data));
+	nd.av_data->sources = sl_from_str(EXAMPLE_TYPE_1);
+
+	ck_assert_int_eq(SELINT_SUCCESS, insert_policy_node_next(head, NODE_AV_RULE, nd, 1234));
+
+	set_active_arena(NULL);
+
+	ck_assert_int_eq(1, head->arena_owned);
+	ck_assert_int_eq(1, head->next->arena_owned);
+	ck_assert_int_eq(1, arena_owns(arena, head->next));
+	ck_assert_int_eq(1, arena_owns(arena, head->next->data.av_data->sources));
+
+	// The nodes are released along with the arena
+	ck_assert_int_eq(SELINT_SUCCESS, free_policy_node(head));
+	free_arena(arena);
+
+}
+END_TEST
+
 START_TEST (test_is_template_call) {
 
 	struct policy_node *node = calloc(1, sizeof(struct policy_node));
@@ -108,9 +169,10 @@ START_TEST (test_get_types_in_node_av) {
 
 	node->data.av_data = make_example_av_rule();
 
-	struct name_list *out = get_names_in_node(node);
+	update_names_in_node(node);
+	const struct name_list *out = get_names_in_node(node);
 
-	struct name_list *cur = out;
+	const struct name_list *cur = out;
 
 	ck_assert_ptr_nonnull(cur);
 	ck_assert_str_eq(cur->data->name, EXAMPLE_TYPE_1);
@@ -133,10 +195,20 @@ START_TEST (test_get_types_in_node_av) {
 	ck_assert_ptr_nonnull(cur);
 	ck_assert_str_eq(cur->data->name, "file");
 	ck_assert_int_eq(cur->data->flavor, NAME_CLASS);
+	// The permissions are borrowed from the rule
+	ck_assert_ptr_eq(cur->data->traits, node->data.av_data->perms);
 
 	ck_assert_ptr_null(cur->next);
 
-	free_name_list(out);
+	// Kept until the data changes
+	ck_assert_ptr_eq(get_names_in_node(node), out);
+
+	free_string_list(node->data.av_data->sources);
+	node->data.av_data->sources = sl_from_str("foo_t");
+	update_names_in_node(node);
+	ck_assert_str_eq("foo_t", get_names_in_node(node)->data->name);
+	ck_assert_str_eq(EXAMPLE_TYPE_2, get_names_in_node(node)->next->data->name);
+
 	free_policy_node(node);
 }
 END_TEST
@@ -158,9 +230,10 @@ START_TEST (test_get_types_in_node_tt) {
 
 	tt_data->default_type = strdup(EXAMPLE_TYPE_1);
 
-	struct name_list *out = get_names_in_node(node);
+	update_names_in_node(node);
+	const struct name_list *out = get_names_in_node(node);
 
-	struct name_list *cur = out;
+	const struct name_list *cur = out;
 
 	ck_assert_ptr_nonnull(cur);
 	ck_assert_str_eq(cur->data->name, EXAMPLE_TYPE_3);
@@ -180,7 +253,6 @@ START_TEST (test_get_types_in_node_tt) {
 
 	ck_assert_ptr_null(cur->next);
 
-	free_name_list(out);
 	free_policy_node(node);
 }
 END_TEST
@@ -196,7 +268,8 @@ START_TEST (test_get_types_in_node_dd) {
 
 	d_data->name = strdup(EXAMPLE_TYPE_2);
 
-	struct name_list *out = get_names_in_node(node);
+	update_names_in_node(node);
+	const struct name_list *out = get_names_in_node(node);
 
 	ck_assert_ptr_nonnull(out);
 
@@ -205,7 +278,6 @@ START_TEST (test_get_types_in_node_dd) {
 
 	ck_assert_ptr_null(out->next);
 
-	free_name_list(out);
 	free_policy_node(node);
 }
 END_TEST
@@ -225,7 +297,8 @@ START_TEST (test_get_types_in_node_if_call) {
 	if_data->args->next = calloc(1, sizeof(struct string_list));
 	if_data->args->next->string = strdup("baz_t");
 
-	struct name_list *out = get_names_in_node(node);
+	update_names_in_node(node);
+	const struct name_list *out = get_names_in_node(node);
 
 	ck_assert_ptr_nonnull(out);
 
@@ -236,7 +309,6 @@ START_TEST (test_get_types_in_node_if_call) {
 
 	ck_assert_ptr_null(out->next->next);
 
-	free_name_list(out);
 	free_policy_node(node);
 }
 END_TEST
@@ -246,6 +318,7 @@ START_TEST (test_get_types_in_node_no_types) {
 	struct policy_node *node = calloc(1, sizeof(struct policy_node));
 	node->flavor = NODE_ERROR;
 
+	update_names_in_node(node);
 	ck_assert_ptr_null(get_names_in_node(node));
 
 	free_policy_node(node);
@@ -262,7 +335,8 @@ START_TEST (test_get_types_in_node_exclusion) {
 	node->data.av_data->sources->next = calloc(1, sizeof(struct string_list));
 	node->data.av_data->sources->next->string = strdup("-init_t");
 
-	struct name_list *out = get_names_in_node(node);
+	update_names_in_node(node);
+	const struct name_list *out = get_names_in_node(node);
 	ck_assert_ptr_nonnull(out);
 
 	ck_assert_str_eq(out->data->name, "domain");
@@ -271,7 +345,6 @@ START_TEST (test_get_types_in_node_exclusion) {
 	ck_assert_int_eq(out->next->data->flavor, NAME_TYPE_OR_ATTRIBUTE);
 	ck_assert_ptr_null(out->next->next);
 
-	free_name_list(out);
 	free_policy_node(node);
 }
 END_TEST
@@ -286,6 +359,8 @@ static Suite *tree_suite(void) {
 
 	tcase_add_test(tc_core, test_insert_policy_node_child);
 	tcase_add_test(tc_core, test_insert_policy_node_next);
+	tcase_add_test(tc_core, test_insert_policy_node_arena);
+	tcase_add_test(tc_core, test_inherit_disabled_checks);
 	tcase_add_test(tc_core, test_is_template_call);
 	tcase_add_test(tc_core, test_get_types_in_node_av);
 	tcase_add_test(tc_core, test_get_types_in_node_tt);
@@ -306,7 +306,7 @@ test_report_format_impl() {
 }
 
 @test "E-007" {
-	test_one_check_expect "E-007" "e07.warn.te" 5
+	test_one_check_expect "E-007" "e07.warn.te" 6
 	test_one_check_expect "E-007" "e07.pass.te" 0
 }
 
@@ -469,6 +469,10 @@ test_report_format_impl() {
 	do_test "W-001" "../misc/needs_context.te" 1 "--context=policies/context"
 	do_test "W-001" "../misc/needs_context.te" 1 "--context=policies/context2"
 	do_test "W-001" "../misc/needs_context.te" 2 "--context=policies/context --context=policies/context2"
+	# Templates calling templates of context files are expanded after
+	# the context if files are parsed
+	do_test "W-001" "../misc/needs_context_template.te" 0
+	do_test "W-001" "../misc/needs_context_template.te" 1 "--context=policies/context_templates"
 	rm tmp.conf
 }
 
@@ -494,6 +498,62 @@ test_report_format_impl() {
 	[ "$count" -eq 0 ]
 }
 
+@test "jobs" {
+	run ${SELINT_PATH} -c configs/default.conf -rsS policies/check_triggers
+	serial_output=${output}
+	serial_status=${status}
+	run ${SELINT_PATH} -c configs/default.conf -rsS -j 4 policies/check_triggers
+	[ "$status" -eq "$serial_status" ]
+	[ "$output" = "$serial_output" ]
+
+	run ${SELINT_PATH} -c configs/default.conf -j 0 policies/check_triggers
+	[ "$status" -eq 64 ]
+}
+
+@test "cache_dir" {
+	CACHE_DIR=$(mktemp -d)
+	run ${SELINT_PATH} -c configs/default.conf -rsS policies/check_triggers
+	uncached_output=${output}
+	uncached_status=${status}
+	run ${SELINT_PATH} -c configs/default.conf -rsS --cache-dir="${CACHE_DIR}/cache" policies/check_triggers
+	[ "$status" -eq "$uncached_status" ]
+	[ "$output" = "$uncached_output" ]
+	[ -n "$(ls "${CACHE_DIR}/cache")" ]
+	run ${SELINT_PATH} -c configs/default.conf -rsS -j 4 --cache-dir="${CACHE_DIR}/cache" policies/check_triggers
+	[ "$status" -eq "$uncached_status" ]
+	[ "$output" = "$uncached_output" ]
+	run ${SELINT_PATH} -c configs/default.conf -rsSv --cache-dir="${CACHE_DIR}/cache" policies/check_triggers
+	echo "$output" | grep -q "Parse cache: [1-9][0-9]* hits, 0 misses"
+	rm -rf "${CACHE_DIR}"
+
+	run ${SELINT_PATH} -c configs/default.conf --cache-dir=/dev/null/cache policies/check_triggers
+	[ "$status" -eq 73 ]
+}
+
+@test "watch" {
+	WATCH_DIR=$(mktemp -d)
+	printf 'policy_module(watched, 1.0)\n\nfoo(bar)\n' > "${WATCH_DIR}/watched.te"
+	${SELINT_PATH} -c configs/default.conf -e S-003 --watch "${WATCH_DIR}/watched.te" > "${WATCH_DIR}/log" &
+	pid=$!
+	wait_for_watch_runs() {
+		for _ in $(seq 100); do
+			[ "$(grep -c "watching for changes" "${WATCH_DIR}/log")" -ge "$1" ] && return 0
+			sleep 0.1
+		done
+		return 1
+	}
+	wait_for_watch_runs 1
+	run grep -c "S-003" "${WATCH_DIR}/log"
+	[ "$output" -eq 0 ]
+	printf 'policy_module(watched, 1.0)\n\nfoo(bar);\n' > "${WATCH_DIR}/watched.te"
+	wait_for_watch_runs 2
+	run grep -c "S-003" "${WATCH_DIR}/log"
+	[ "$output" -eq 1 ]
+	kill -INT ${pid}
+	wait ${pid}
+	rm -rf "${WATCH_DIR}"
+}
+
 @test "parse_error_printing" {
 	test_parse_error_run 0
 }